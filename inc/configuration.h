@@ -31,6 +31,16 @@
 // true to enable USB CDC (serial) interface to directly control the maple bus
 #define USB_CDC_ENABLED true
 
+// true to store client mode VMU data in a wear levelled log in flash; false to map it 1:1 onto the
+// last 128 KB of flash (data mapped 1:1 is carried over to the log the first time the log is used)
+// Note: the log takes CLIENT_VMU_LOG_SIZE_BYTES of additional flash, and data written to the log
+//       isn't carried back to the 1:1 region if this is later set back to false
+#define CLIENT_VMU_LOG_STRUCTURED false
+
+// Number of bytes of flash reserved for the client mode VMU log, just below the 1:1 region (only
+// used when CLIENT_VMU_LOG_STRUCTURED is true)
+#define CLIENT_VMU_LOG_SIZE_BYTES (256 * 1024)
+
 // Adjust the CPU clock frequency here (133 MHz is maximum documented stable frequency)
 #define CPU_FREQ_KHZ 133000
 
@@ -29,6 +29,7 @@
 #include "configuration.h"
 #include "utils.h"
 #include "MaplePacket.hpp"
+#include "SerializedMaplePacket.hpp"
 #include <limits>
 
 //! Maple Bus interface class
@@ -80,13 +81,15 @@ class MapleBusInterface
             Phase phase;
             //! Set to failure reason when phase is WRITE_FAILED or READ_FAILED
             FailureReason failureReason;
-            //! A pointer to the bytes read or nullptr if no new data available
+            //! A pointer to the words read or nullptr if no new data available; this points into
+            //! the receive buffer of the bus and remains valid until the following read completes
             const uint32_t* readBuffer;
             //! The number of words received or 0 if no new data available
             uint32_t readBufferLen;
 
             Status() :
                 phase(Phase::INVALID),
+                failureReason(FailureReason::NONE),
                 readBuffer(nullptr),
                 readBufferLen(0)
             {}
@@ -106,6 +109,24 @@ class MapleBusInterface
                            bool autostartRead,
                            uint64_t readTimeoutUs=MAPLE_RESPONSE_TIMEOUT_US) = 0;
 
+        //! Writes an already serialized packet to the maple bus
+        //! @post processEvents() must periodically be called to check status
+        //! @note The default implementation deserializes the packet and passes it to write(); a bus
+        //!       may instead transmit straight from the words of packet, so packet must remain
+        //!       unchanged until the write has completed.
+        //! @param[in] packet  The serialized packet to send
+        //! @param[in] autostartRead  Set to true in order to start receive after send is complete
+        //! @param[in] readTimeoutUs  When autostartRead is true, the read timeout to set
+        //! @returns true iff the bus was "open" and send has started
+        virtual bool writeSerialized(const SerializedMaplePacket& packet,
+                                     bool autostartRead,
+                                     uint64_t readTimeoutUs=MAPLE_RESPONSE_TIMEOUT_US)
+        {
+            MaplePacket deserialized;
+            packet.get(deserialized);
+            return write(deserialized, autostartRead, readTimeoutUs);
+        }
+
         //! Begins waiting for input
         //! @post processEvents() must periodically be called to check status
         //! @note This is NOT meant to be called if bus is setup as a host
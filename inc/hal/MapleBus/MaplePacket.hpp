@@ -26,10 +26,10 @@
 
 #include <stdint.h>
 #include <stddef.h>
-#include <vector>
 #include <utility>
 #include "configuration.h"
 #include "dreamcast_constants.h"
+#include "MaplePayload.hpp"
 
 struct MaplePacket
 {
@@ -163,7 +163,9 @@ struct MaplePacket
     //! @param[in] len  Number of words in payload
     inline MaplePacket(Frame frame, const uint32_t* payload, uint8_t len) :
         frame(frame),
-        payload(payload, payload + len)
+        payload(payload, len),
+        rawPayloadIdx(NO_RAW_PAYLOAD),
+        rawResponseIdx(NO_RAW_PAYLOAD)
     {
         updateFrameLength();
     }
@@ -207,13 +209,17 @@ struct MaplePacket
     //! Copy constructor
     inline MaplePacket(const MaplePacket& rhs) :
         frame(rhs.frame),
-        payload(rhs.payload)
+        payload(rhs.payload),
+        rawPayloadIdx(rhs.rawPayloadIdx),
+        rawResponseIdx(rhs.rawResponseIdx)
     {}
 
     //! Move constructor
     inline MaplePacket(MaplePacket&& rhs) :
         frame(rhs.frame),
-        payload(std::move(rhs.payload))
+        payload(std::move(rhs.payload)),
+        rawPayloadIdx(rhs.rawPayloadIdx),
+        rawResponseIdx(rhs.rawResponseIdx)
     {}
 
     //! Assignment operator
@@ -221,13 +227,20 @@ struct MaplePacket
     {
         frame = rhs.frame;
         payload = rhs.payload;
+        rawPayloadIdx = rhs.rawPayloadIdx;
+        rawResponseIdx = rhs.rawResponseIdx;
         return *this;
     }
 
     //! == operator for this class
     inline bool operator==(const MaplePacket& rhs) const
     {
-        return frame == rhs.frame && payload == rhs.payload;
+        return (
+            frame == rhs.frame
+            && payload == rhs.payload
+            && rawPayloadIdx == rhs.rawPayloadIdx
+            && rawResponseIdx == rhs.rawResponseIdx
+        );
     }
 
     //! @returns frame word value with corrected length
@@ -243,6 +256,8 @@ struct MaplePacket
     {
         frame = Frame::defaultFrame();
         payload.clear();
+        rawPayloadIdx = NO_RAW_PAYLOAD;
+        rawResponseIdx = NO_RAW_PAYLOAD;
         updateFrameLength();
     }
 
@@ -267,9 +282,10 @@ struct MaplePacket
             frame = Frame::defaultFrame();
         }
         payload.clear();
+        rawPayloadIdx = NO_RAW_PAYLOAD;
         if (len > 1)
         {
-            payload.insert(payload.end(), &words[1], &words[1] + (len - 1));
+            payload.append(&words[1], len - 1);
         }
         updateFrameLength();
     }
@@ -281,7 +297,7 @@ struct MaplePacket
     {
         if (len > 0)
         {
-            payload.insert(payload.end(), &words[0], &words[0] + len);
+            payload.append(words, len);
             updateFrameLength();
         }
     }
@@ -299,6 +315,7 @@ struct MaplePacket
     inline void setPayload(const uint32_t* words, uint8_t len)
     {
         payload.clear();
+        rawPayloadIdx = NO_RAW_PAYLOAD;
         appendPayload(words, len);
     }
 
@@ -335,6 +352,7 @@ struct MaplePacket
     inline void setPayloadFlipWords(const uint32_t* words, uint8_t len)
     {
         payload.clear();
+        rawPayloadIdx = NO_RAW_PAYLOAD;
         appendPayloadFlipWords(words, len);
     }
 
@@ -345,6 +363,27 @@ struct MaplePacket
         setPayloadFlipWords(&word, 1);
     }
 
+    //! Append raw bulk data to payload, exactly as it is laid out in memory. The bus sends these
+    //! bytes without swapping them, so this takes the place of appendPayloadFlipWords() for data
+    //! which the peripheral stores byte for byte (storage blocks).
+    //! @note every word appended after this is also treated as raw
+    //! @param[in] words  Payload words to set
+    //! @param[in] len  Number of words in words
+    inline void appendPayloadRaw(const uint32_t* words, uint8_t len)
+    {
+        if (rawPayloadIdx == NO_RAW_PAYLOAD)
+        {
+            rawPayloadIdx = payload.size();
+        }
+        appendPayload(words, len);
+    }
+
+    //! @returns true iff any payload word is held raw
+    inline bool hasRawPayload() const
+    {
+        return (rawPayloadIdx < payload.size());
+    }
+
     //! Update length in frame word with the payload size
     void updateFrameLength()
     {
@@ -393,8 +432,18 @@ struct MaplePacket
 
     //! Packet frame word value
     Frame frame;
-    //! Packet payload
-    std::vector<uint32_t> payload;
+    //! Packet payload (small payloads are held inline)
+    MaplePayload payload;
+    //! Index of the first payload word holding raw bytes (see appendPayloadRaw()) or
+    //! NO_RAW_PAYLOAD; every word from here to the end of payload is raw
+    uint8_t rawPayloadIdx;
+    //! Index of the first payload word of the expected response to be received as raw bytes or
+    //! NO_RAW_PAYLOAD; words of the response from here up to its frame length are left in the
+    //! byte order they arrived in, i.e. the same layout appendPayloadRaw() takes
+    uint8_t rawResponseIdx;
+
+    //! Value of rawPayloadIdx and rawResponseIdx when no words are raw
+    static const uint8_t NO_RAW_PAYLOAD = 0xFF;
 };
 
 #endif // __MAPLE_PACKET_H__
@@ -0,0 +1,124 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __MAPLE_PACKET_VIEW_H__
+#define __MAPLE_PACKET_VIEW_H__
+
+#include <stdint.h>
+#include "MaplePacket.hpp"
+
+//! Read-only view of a Maple packet whose words are owned elsewhere, such as the receive buffer of
+//! a maple bus. The viewed words are only guaranteed to be valid for the duration of the call the
+//! view is passed to; use toPacket() to keep a copy beyond that.
+struct MaplePacketView
+{
+    //! Read-only view of payload words
+    class Payload
+    {
+    public:
+        typedef uint32_t value_type;
+        typedef const uint32_t* const_iterator;
+
+        //! Default constructor - empty payload
+        inline Payload() : mWords(nullptr), mSize(0) {}
+
+        //! Constructor
+        //! @param[in] words  The payload words to view
+        //! @param[in] len  Number of words in words
+        inline Payload(const uint32_t* words, uint32_t len) : mWords(words), mSize(len) {}
+
+        //! @returns the number of payload words
+        inline uint32_t size() const { return mSize; }
+        //! @returns true iff there are no payload words
+        inline bool empty() const { return (mSize == 0); }
+        //! @returns pointer to the first payload word
+        inline const uint32_t* data() const { return mWords; }
+        //! @returns the payload word at the given index
+        inline const uint32_t& operator[](uint32_t idx) const { return mWords[idx]; }
+
+        inline const_iterator begin() const { return mWords; }
+        inline const_iterator end() const { return mWords + mSize; }
+        inline const_iterator cbegin() const { return mWords; }
+        inline const_iterator cend() const { return mWords + mSize; }
+
+    private:
+        //! The viewed words
+        const uint32_t* mWords;
+        //! Number of viewed words
+        uint32_t mSize;
+    };
+
+    //! Default constructor - views an invalid, empty packet
+    inline MaplePacketView() :
+        frame(MaplePacket::Frame::defaultFrame()),
+        payload()
+    {}
+
+    //! Constructor from received words
+    //! @param[in] words  All words where the first is the frame word
+    //! @param[in] len  Number of words in words (must be at least 1 for frame word to be valid)
+    inline MaplePacketView(const uint32_t* words, uint32_t len)
+    {
+        set(words, len);
+    }
+
+    //! Constructor which views an existing packet
+    //! @param[in] packet  The packet to view (must outlive this view)
+    inline explicit MaplePacketView(const MaplePacket& packet) :
+        frame(packet.frame),
+        payload(packet.payload.data(), packet.payload.size())
+    {}
+
+    //! Sets this view to received words
+    //! @param[in] words  All words where the first is the frame word
+    //! @param[in] len  Number of words in words (must be at least 1 for frame word to be valid)
+    inline void set(const uint32_t* words, uint32_t len)
+    {
+        if (len > 0)
+        {
+            frame = MaplePacket::Frame::fromWord(*words);
+            payload = Payload(words + 1, len - 1);
+        }
+        else
+        {
+            frame = MaplePacket::Frame::defaultFrame();
+            payload = Payload();
+        }
+        // Same as MaplePacket, length always reflects the number of payload words
+        frame.length = payload.size();
+    }
+
+    //! @returns a copy of the viewed packet
+    inline MaplePacket toPacket() const
+    {
+        return MaplePacket(frame, payload.data(), payload.size());
+    }
+
+    //! Frame data
+    MaplePacket::Frame frame;
+    //! Payload words
+    Payload payload;
+};
+
+#endif // __MAPLE_PACKET_VIEW_H__
@@ -0,0 +1,266 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __MAPLE_PAYLOAD_H__
+#define __MAPLE_PAYLOAD_H__
+
+#include <stdint.h>
+#include <string.h>
+
+//! Contiguous container of payload words which stores small payloads inline so that the most
+//! common packets (condition requests/responses, block read requests, etc.) never touch the heap.
+//! Only payloads larger than NUM_INLINE_WORDS allocate, and that storage is kept for reuse until
+//! the payload is destroyed. Packets are moved (not copied) into the scheduler's pool, so each large
+//! packet allocates once, where it is built. That is currently:
+//! - Host storage block write phases (34 words each at 4 phases, up to 130 words at 1 phase), built
+//!   in DreamcastStorage::queueWriteChain()
+//! - Host screen writes (50 words), built in EndpointTxScheduler from DreamcastScreen's payload
+//! - Passthrough and flycast commands with more than NUM_INLINE_WORDS payload words
+//! - MapleBusInterface::writeSerialized() for buses which don't override it
+//! Received packets are read through MaplePacketView, and client packets reserve their full size
+//! up front, so neither allocates while running. Inline storage isn't sized for the large packets
+//! because packets are also built on core 1's stack (up to 9 at once for a block write) and every
+//! pooled packet would grow by the same amount.
+class MaplePayload
+{
+public:
+    typedef uint32_t value_type;
+    typedef uint32_t* iterator;
+    typedef const uint32_t* const_iterator;
+
+    //! Number of payload words stored inline
+    static const uint32_t NUM_INLINE_WORDS = 8;
+
+    //! Default constructor - empty payload
+    inline MaplePayload() :
+        mData(mInline),
+        mSize(0),
+        mCapacity(NUM_INLINE_WORDS)
+    {}
+
+    //! Constructor from array
+    //! @param[in] words  The payload words to set
+    //! @param[in] len  Number of words in words
+    inline MaplePayload(const uint32_t* words, uint32_t len) :
+        MaplePayload()
+    {
+        append(words, len);
+    }
+
+    //! Copy constructor
+    inline MaplePayload(const MaplePayload& rhs) :
+        MaplePayload()
+    {
+        append(rhs.mData, rhs.mSize);
+    }
+
+    //! Move constructor
+    inline MaplePayload(MaplePayload&& rhs) :
+        MaplePayload()
+    {
+        takeFrom(rhs);
+    }
+
+    //! Destructor
+    inline ~MaplePayload()
+    {
+        release();
+    }
+
+    //! Assignment operator (keeps any storage already allocated here)
+    MaplePayload& operator=(const MaplePayload& rhs)
+    {
+        if (this != &rhs)
+        {
+            mSize = 0;
+            append(rhs.mData, rhs.mSize);
+        }
+        return *this;
+    }
+
+    //! Move assignment operator
+    MaplePayload& operator=(MaplePayload&& rhs)
+    {
+        if (this != &rhs)
+        {
+            release();
+            mData = mInline;
+            mCapacity = NUM_INLINE_WORDS;
+            takeFrom(rhs);
+        }
+        return *this;
+    }
+
+    //! == operator for this class
+    inline bool operator==(const MaplePayload& rhs) const
+    {
+        return (mSize == rhs.mSize && (mSize == 0 || memcmp(mData, rhs.mData, mSize * sizeof(uint32_t)) == 0));
+    }
+
+    //! != operator for this class
+    inline bool operator!=(const MaplePayload& rhs) const
+    {
+        return !operator==(rhs);
+    }
+
+    //! @returns number of words in the payload
+    inline uint32_t size() const
+    {
+        return mSize;
+    }
+
+    //! @returns true iff payload is empty
+    inline bool empty() const
+    {
+        return (mSize == 0);
+    }
+
+    //! @returns number of words which may be held without allocating
+    inline uint32_t capacity() const
+    {
+        return mCapacity;
+    }
+
+    //! @returns pointer to the first word
+    inline uint32_t* data()
+    {
+        return mData;
+    }
+
+    //! @returns pointer to the first word
+    inline const uint32_t* data() const
+    {
+        return mData;
+    }
+
+    inline uint32_t& operator[](uint32_t idx)
+    {
+        return mData[idx];
+    }
+
+    inline const uint32_t& operator[](uint32_t idx) const
+    {
+        return mData[idx];
+    }
+
+    inline iterator begin() { return mData; }
+    inline iterator end() { return mData + mSize; }
+    inline const_iterator begin() const { return mData; }
+    inline const_iterator end() const { return mData + mSize; }
+    inline const_iterator cbegin() const { return mData; }
+    inline const_iterator cend() const { return mData + mSize; }
+
+    //! Clears all words (storage is kept)
+    inline void clear()
+    {
+        mSize = 0;
+    }
+
+    //! Makes sure the given number of words may be held without further allocation
+    //! @param[in] len  Number of words to reserve
+    inline void reserve(uint32_t len)
+    {
+        if (len > mCapacity)
+        {
+            grow(len);
+        }
+    }
+
+    //! Appends a single word
+    //! @param[in] word  The word to append
+    inline void push_back(uint32_t word)
+    {
+        if (mSize >= mCapacity)
+        {
+            grow(mCapacity * 2);
+        }
+        mData[mSize++] = word;
+    }
+
+    //! Appends words from array
+    //! @param[in] words  The words to append
+    //! @param[in] len  Number of words in words
+    inline void append(const uint32_t* words, uint32_t len)
+    {
+        if (len > 0)
+        {
+            reserve(mSize + len);
+            memcpy(&mData[mSize], words, len * sizeof(uint32_t));
+            mSize += len;
+        }
+    }
+
+private:
+    //! Moves words into newly allocated storage
+    //! @param[in] capacity  The new capacity which must be greater than the current size
+    void grow(uint32_t capacity)
+    {
+        uint32_t* data = new uint32_t[capacity];
+        if (mSize > 0)
+        {
+            memcpy(data, mData, mSize * sizeof(uint32_t));
+        }
+        release();
+        mData = data;
+        mCapacity = capacity;
+    }
+
+    //! Frees allocated storage, if any
+    inline void release()
+    {
+        if (mData != mInline)
+        {
+            delete [] mData;
+        }
+    }
+
+    //! Takes contents of the given payload, leaving it empty (this must be using inline storage)
+    //! @param[in,out] rhs  The payload to take from
+    void takeFrom(MaplePayload& rhs)
+    {
+        if (rhs.mData == rhs.mInline)
+        {
+            memcpy(mInline, rhs.mInline, rhs.mSize * sizeof(uint32_t));
+        }
+        else
+        {
+            mData = rhs.mData;
+            mCapacity = rhs.mCapacity;
+            rhs.mData = rhs.mInline;
+            rhs.mCapacity = NUM_INLINE_WORDS;
+        }
+        mSize = rhs.mSize;
+        rhs.mSize = 0;
+    }
+
+    //! Points to either mInline or allocated storage
+    uint32_t* mData;
+    //! Number of words in the payload
+    uint32_t mSize;
+    //! Number of words which mData may hold
+    uint32_t mCapacity;
+    //! Inline storage for small payloads
+    uint32_t mInline[NUM_INLINE_WORDS];
+};
+
+#endif // __MAPLE_PAYLOAD_H__
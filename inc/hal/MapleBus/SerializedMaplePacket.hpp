@@ -0,0 +1,149 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __SERIALIZED_MAPLE_PACKET_H__
+#define __SERIALIZED_MAPLE_PACKET_H__
+
+#include <stdint.h>
+#include <assert.h>
+#include "MaplePacket.hpp"
+
+//! A small packet held in the exact form which a Maple Bus transmits from (bit count, frame word,
+//! payload, then CRC) so that it may be handed straight to the bus without being copied or having
+//! its CRC computed at send time (see MapleBusInterface::writeSerialized()). Words are stored in
+//! host order since the bus byte swaps them as they are sent; only the bit count is pre-swapped.
+class SerializedMaplePacket
+{
+public:
+    //! Maximum number of payload words this packet may hold
+    static const uint32_t MAX_PAYLOAD_WORDS = 8;
+
+    //! Default constructor - initializes with invalid frame and empty payload
+    inline SerializedMaplePacket() :
+        mWords(),
+        mPayloadLen(0)
+    {
+        set(MaplePacket::Frame::defaultFrame().toWord(), nullptr, 0);
+    }
+
+    //! Constructor from packet
+    //! @param[in] packet  The packet to serialize (must not hold any raw payload)
+    inline SerializedMaplePacket(const MaplePacket& packet) :
+        SerializedMaplePacket()
+    {
+        set(packet);
+    }
+
+    //! Serializes the given packet
+    //! @param[in] packet  The packet to serialize (must not hold any raw payload)
+    inline void set(const MaplePacket& packet)
+    {
+        assert(!packet.hasRawPayload());
+        set(packet.getFrameWord(), packet.payload.data(), packet.payload.size());
+    }
+
+    //! Serializes the given frame word and payload
+    //! @param[in] frameWord  The frame word (length is corrected to len)
+    //! @param[in] payload  The payload words
+    //! @param[in] len  Number of words in payload (no more than MAX_PAYLOAD_WORDS)
+    inline void set(uint32_t frameWord, const uint32_t* payload, uint32_t len)
+    {
+        assert(len <= MAX_PAYLOAD_WORDS);
+        mPayloadLen = len;
+        MaplePacket::Frame frame = MaplePacket::Frame::fromWord(frameWord);
+        frame.length = len;
+        mWords[0] = MaplePacket::flipWordBytes(MaplePacket::getNumTotalBits(len));
+        mWords[1] = frame.toWord();
+        uint32_t crc32 = mWords[1];
+        for (uint32_t i = 0; i < len; ++i)
+        {
+            mWords[i + 2] = payload[i];
+            crc32 ^= payload[i];
+        }
+        mWords[len + 2] = condenseCrc(crc32);
+    }
+
+    //! Sets the sender and recipient addresses, adjusting the CRC to match
+    //! @param[in] senderAddr  The sender address to set
+    //! @param[in] recipientAddr  The recipient address to set
+    inline void setAddresses(uint8_t senderAddr, uint8_t recipientAddr)
+    {
+        uint32_t frameWord = mWords[1];
+        frameWord &= ~((0xFFU << MaplePacket::Frame::SENDER_ADDR_POSITION)
+                       | (0xFFU << MaplePacket::Frame::RECIPIENT_ADDR_POSITION));
+        frameWord |= (static_cast<uint32_t>(senderAddr) << MaplePacket::Frame::SENDER_ADDR_POSITION)
+                     | (static_cast<uint32_t>(recipientAddr) << MaplePacket::Frame::RECIPIENT_ADDR_POSITION);
+        mWords[mPayloadLen + 2] ^= condenseCrc(frameWord ^ mWords[1]);
+        mWords[1] = frameWord;
+    }
+
+    //! Deserializes this packet
+    //! @param[out] packet  The packet to write to
+    inline void get(MaplePacket& packet) const
+    {
+        packet.set(&mWords[1], mPayloadLen + 1);
+    }
+
+    //! @returns the words to be transmitted, starting with the bit count
+    inline const uint32_t* getWords() const { return mWords; }
+
+    //! @returns the number of words to be transmitted, including bit count and CRC
+    inline uint32_t getNumWords() const { return mPayloadLen + 3; }
+
+    //! @returns the frame word
+    inline uint32_t getFrameWord() const { return mWords[1]; }
+
+    //! @returns pointer to the payload words
+    inline const uint32_t* getPayload() const { return &mWords[2]; }
+
+    //! @returns the number of payload words
+    inline uint32_t getPayloadLen() const { return mPayloadLen; }
+
+    //! @returns the CRC byte
+    inline uint8_t getCrc() const { return static_cast<uint8_t>(mWords[mPayloadLen + 2]); }
+
+    //! @returns number of nanoseconds it takes to transmit this packet
+    inline uint32_t getTxTimeNs() const
+    {
+        return MaplePacket::getTxTimeNs(mPayloadLen, MAPLE_NS_PER_BIT);
+    }
+
+private:
+    //! @param[in] crc32  XOR of all words to be covered by CRC
+    //! @returns the 8-bit CRC which is the XOR of each byte of the given word
+    static inline uint32_t condenseCrc(uint32_t crc32)
+    {
+        crc32 ^= (crc32 >> 16);
+        crc32 ^= (crc32 >> 8);
+        return (crc32 & 0xFF);
+    }
+
+private:
+    //! Bit count, frame word, payload, and CRC
+    uint32_t mWords[MAX_PAYLOAD_WORDS + 3];
+    //! Number of words in payload
+    uint32_t mPayloadLen;
+};
+
+#endif // __SERIALIZED_MAPLE_PACKET_H__
@@ -0,0 +1,149 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+//! Fixed capacity byte ring with one consumer, which doesn't need to lock anything to read. Only one
+//! write() may run at a time: when more than one thread or core produces, the producers must be
+//! serialized externally (i.e. by a mutex which the consumer never takes). The producer never waits
+//! on the consumer; data which doesn't fit is dropped instead. Only 32-bit atomic loads and stores
+//! are used (no read-modify-write), so this is safe on cores without atomic instructions.
+//! @tparam capacity  Number of bytes which may be held (must be a power of 2)
+template <uint32_t capacity>
+class ByteRing
+{
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity must be a power of 2");
+
+    public:
+        //! Constructor
+        ByteRing() :
+            mHead(0),
+            mTail(0),
+            mBuffer{}
+        {}
+
+        //! Producer only (serialized): adds all of the given data or none of it so that messages aren't torn
+        //! @param[in] data  The data to add
+        //! @param[in] len  Number of bytes to add
+        //! @returns true iff data was added or false if it was dropped due to lack of space
+        bool write(const void* data, uint32_t len)
+        {
+            uint32_t head = mHead.load(std::memory_order_relaxed);
+            uint32_t tail = mTail.load(std::memory_order_acquire);
+            if (len > capacity - (head - tail))
+            {
+                return false;
+            }
+
+            const uint8_t* src = static_cast<const uint8_t*>(data);
+            uint32_t idx = head & (capacity - 1);
+            uint32_t firstLen = capacity - idx;
+            if (firstLen > len)
+            {
+                firstLen = len;
+            }
+            memcpy(&mBuffer[idx], src, firstLen);
+            memcpy(&mBuffer[0], src + firstLen, len - firstLen);
+
+            mHead.store(head + len, std::memory_order_release);
+            return true;
+        }
+
+        //! Consumer only: gets the next contiguous span of data without removing it
+        //! @param[out] data  Set to the start of the span
+        //! @returns number of bytes in the span (may be less than size() when data wraps around)
+        uint32_t peek(const uint8_t*& data) const
+        {
+            uint32_t tail = mTail.load(std::memory_order_relaxed);
+            uint32_t head = mHead.load(std::memory_order_acquire);
+            uint32_t idx = tail & (capacity - 1);
+            uint32_t len = head - tail;
+            if (len > capacity - idx)
+            {
+                len = capacity - idx;
+            }
+            data = &mBuffer[idx];
+            return len;
+        }
+
+        //! Consumer only: removes data previously returned by peek()
+        //! @param[in] len  Number of bytes to remove
+        void consume(uint32_t len)
+        {
+            mTail.store(mTail.load(std::memory_order_relaxed) + len, std::memory_order_release);
+        }
+
+        //! Consumer only: copies out and removes up to the given number of bytes
+        //! @param[out] data  Destination buffer
+        //! @param[in] maxLen  Maximum number of bytes to read
+        //! @returns number of bytes read
+        uint32_t read(void* data, uint32_t maxLen)
+        {
+            uint8_t* dest = static_cast<uint8_t*>(data);
+            uint32_t numRead = 0;
+            const uint8_t* span = nullptr;
+            uint32_t len = 0;
+            while (numRead < maxLen && (len = peek(span)) > 0)
+            {
+                if (len > maxLen - numRead)
+                {
+                    len = maxLen - numRead;
+                }
+                memcpy(dest + numRead, span, len);
+                consume(len);
+                numRead += len;
+            }
+            return numRead;
+        }
+
+        //! Consumer only: removes all data
+        void clear()
+        {
+            mTail.store(mHead.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        //! @returns number of bytes waiting to be consumed
+        uint32_t size() const
+        {
+            return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire);
+        }
+
+        //! @returns the number of bytes this ring may hold
+        static constexpr uint32_t getCapacity()
+        {
+            return capacity;
+        }
+
+    private:
+        //! Free running count of bytes written (only written by producer)
+        std::atomic<uint32_t> mHead;
+        //! Free running count of bytes consumed (only written by consumer)
+        std::atomic<uint32_t> mTail;
+        //! The ring data
+        uint8_t mBuffer[capacity];
+};
@@ -0,0 +1,57 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __FLASH_INTERFACE_H__
+#define __FLASH_INTERFACE_H__
+
+#include <stdint.h>
+
+//! Interface to NOR flash which is mapped into the address space for reading (XIP on the Pico).
+//! Erase sets every bit in a sector to 1, and programming is only able to flip bits from 1 to 0.
+class FlashInterface
+{
+    public:
+        //! Number of bytes in an erasable sector
+        static const uint32_t SECTOR_SIZE = 4096;
+        //! Number of bytes in a programmable page
+        static const uint32_t PAGE_SIZE = 256;
+
+        //! Virtual destructor
+        virtual ~FlashInterface() {}
+
+        //! @param[in] offset  Byte offset into flash
+        //! @returns pointer to the memory mapped contents of flash at offset (not valid for reading
+        //!          while an erase or program is executing)
+        virtual const uint8_t* read(uint32_t offset) = 0;
+
+        //! Erases a sector, blocking until complete
+        //! @param[in] offset  Byte offset into flash, aligned to SECTOR_SIZE
+        virtual void eraseSector(uint32_t offset) = 0;
+
+        //! Programs a page, blocking until complete
+        //! @param[in] offset  Byte offset into flash, aligned to PAGE_SIZE
+        //! @param[in] data  PAGE_SIZE bytes to program
+        virtual void programPage(uint32_t offset, const uint8_t* data) = 0;
+};
+
+#endif // __FLASH_INTERFACE_H__
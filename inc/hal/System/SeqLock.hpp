@@ -0,0 +1,114 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+//! Holds a small value of T which exactly one writer updates and any number of readers, which may
+//! be on different cores, snapshot. The writer never waits; a reader which overlaps a write simply
+//! tries again, so it only ever sees a whole value. Best suited to values of a few words which
+//! are read far more often than they are written. Only 32-bit atomic loads and stores are used
+//! (no read-modify-write), so this is safe on cores without atomic instructions.
+//! @tparam T  The value type (must be trivially copyable)
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+    public:
+        //! Constructor
+        //! @param[in] initial  The initial value
+        SeqLock(const T& initial = T()) :
+            mSequence(0),
+            mWords()
+        {
+            store(initial);
+        }
+
+        //! Writer only: sets the value
+        //! @param[in] value  The value to set
+        void store(const T& value)
+        {
+            uint32_t words[NUM_WORDS] = {};
+            memcpy(words, &value, sizeof(T));
+
+            // An odd sequence tells readers that a write is in progress
+            const uint32_t sequence = mSequence.load(std::memory_order_relaxed);
+            mSequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (uint32_t i = 0; i < NUM_WORDS; ++i)
+            {
+                mWords[i].store(words[i], std::memory_order_relaxed);
+            }
+            mSequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        //! Reads the value, retrying while it is being written
+        //! @returns the value
+        T load() const
+        {
+            T value;
+            while (!tryLoad(value));
+            return value;
+        }
+
+        //! Reads the value once
+        //! @param[out] value  Set to the value when true is returned
+        //! @returns true iff a whole value was read, or false if it overlapped a write
+        bool tryLoad(T& value) const
+        {
+            const uint32_t sequence = mSequence.load(std::memory_order_acquire);
+            if ((sequence & 1) != 0)
+            {
+                return false;
+            }
+
+            uint32_t words[NUM_WORDS];
+            for (uint32_t i = 0; i < NUM_WORDS; ++i)
+            {
+                words[i] = mWords[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (mSequence.load(std::memory_order_relaxed) != sequence)
+            {
+                return false;
+            }
+
+            memcpy(&value, words, sizeof(T));
+            return true;
+        }
+
+    private:
+        //! Number of words which hold the value
+        static const uint32_t NUM_WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+        //! Incremented before and after each write (only written by writer)
+        std::atomic<uint32_t> mSequence;
+        //! The value
+        std::atomic<uint32_t> mWords[NUM_WORDS];
+};
@@ -0,0 +1,132 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+//! Hands the latest value of T from exactly one producer to exactly one consumer, which may be on
+//! different cores, without either side ever waiting on the other. The producer builds each new
+//! value in a buffer which the consumer can't be holding, then publishes it whole; the consumer
+//! always picks up the most recently published value, skipping any it didn't get to. Only 32-bit
+//! atomic loads and stores are used (no read-modify-write), so this is safe on cores without
+//! atomic instructions.
+//! @tparam T  The value type
+template <typename T>
+class TripleBuffer
+{
+    public:
+        //! Constructor
+        //! @param[in] initial  The value which is initially published
+        TripleBuffer(const T& initial = T()) :
+            mBuffers{initial, initial, initial},
+            mPublished(0),
+            mReading(0),
+            mWriteIdx(1),
+            mLastRead(0)
+        {}
+
+        //! Producer only: gets a buffer to build the next value in; it holds stale data
+        //! @returns the buffer to write to then pass on with publish()
+        T& beginWrite()
+        {
+            const uint32_t publishedIdx = mPublished.load() & IDX_MASK;
+            const uint32_t readingIdx = mReading.load();
+            uint32_t idx = 0;
+            while (idx == publishedIdx || idx == readingIdx)
+            {
+                ++idx;
+            }
+            mWriteIdx = idx;
+            return mBuffers[idx];
+        }
+
+        //! Producer only: publishes the buffer last returned by beginWrite()
+        void publish()
+        {
+            // The count alongside the index lets the consumer tell that something new came in
+            const uint32_t count = (mPublished.load(std::memory_order_relaxed) >> IDX_BITS) + 1;
+            mPublished.store((count << IDX_BITS) | mWriteIdx);
+        }
+
+        //! Producer only: sets and publishes a whole new value
+        //! @param[in] value  The value to publish
+        void write(const T& value)
+        {
+            beginWrite() = value;
+            publish();
+        }
+
+        //! Producer only: gets the most recently published value, for building the next one from
+        //! @returns the last published value (must not be modified)
+        const T& getPublished() const
+        {
+            return mBuffers[mPublished.load(std::memory_order_relaxed) & IDX_MASK];
+        }
+
+        //! Consumer only: takes hold of the most recently published value
+        //! @returns the value, which the producer leaves alone until the next call to read()
+        T& read()
+        {
+            uint32_t published = mPublished.load();
+            mReading.store(published & IDX_MASK);
+            // The producer may have published again and picked this buffer to write into before it
+            // could see the store above; check again until there is one it will leave alone
+            uint32_t recheck;
+            while ((recheck = mPublished.load()) != published)
+            {
+                published = recheck;
+                mReading.store(published & IDX_MASK);
+            }
+            mLastRead = published;
+            return mBuffers[published & IDX_MASK];
+        }
+
+        //! Consumer only
+        //! @returns true iff a value was published since the last call to read()
+        bool isNewDataAvailable() const
+        {
+            return (mPublished.load() != mLastRead);
+        }
+
+    private:
+        //! Number of bits of the published word which hold the buffer index
+        static const uint32_t IDX_BITS = 2;
+        //! Mask of the buffer index within the published word
+        static const uint32_t IDX_MASK = (1 << IDX_BITS) - 1;
+
+        //! The buffers; at any time one is published, one may be held by the consumer, and the other
+        //! is free for the producer to build into
+        T mBuffers[3];
+        //! Index of the most recently published buffer with a count of publishes above it (only
+        //! written by producer)
+        std::atomic<uint32_t> mPublished;
+        //! Index of the buffer held by the consumer (only written by consumer)
+        std::atomic<uint32_t> mReading;
+        //! Index of the buffer being built by the producer (producer only)
+        uint32_t mWriteIdx;
+        //! Value of mPublished when the consumer last read (consumer only)
+        uint32_t mLastRead;
+};
@@ -0,0 +1,220 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Binary frame structure (all multi-byte fields little endian):
+//   [0]        SYNC_BYTE
+//   [1..2]     Number of data bytes (n)
+//   [3]        Command character - selects the CommandParser just like in text mode; TEXT_FLAG is
+//              additionally set when data is text rather than binary
+//   [4..4+n)   Data - Maple packets are sent as raw 32-bit words, frame word first
+//   [4+n..6+n) CRC-16/CCITT-FALSE over bytes [1..4+n)
+
+//! Encoding and decoding of binary frames exchanged over the CDC TTY once binary mode is selected
+class CdcFrame
+{
+public:
+    //! First byte of every frame
+    static const uint8_t SYNC_BYTE = 0xDC;
+    //! Number of bytes before data
+    static const uint32_t HEADER_SIZE = 4;
+    //! Number of bytes after data
+    static const uint32_t CRC_SIZE = 2;
+    //! Number of bytes in a frame which aren't data
+    static const uint32_t OVERHEAD_SIZE = HEADER_SIZE + CRC_SIZE;
+    //! The largest accepted data length (a maximum sized Maple packet plus margin)
+    static const uint32_t MAX_DATA_SIZE = 1040;
+    //! Set in the command byte of a frame whose data is text rather than binary (e.g. a text
+    //! command sent while in binary mode or an error message)
+    static const uint8_t TEXT_FLAG = 0x80;
+    //! Initial CRC value
+    static const uint16_t CRC_INIT = 0xFFFF;
+
+    //! Result of decode()
+    enum DecodeResult
+    {
+        //! More bytes are needed to make up a frame
+        DECODE_INCOMPLETE = 0,
+        //! The bytes don't start with a valid frame - drop the first byte and try again
+        DECODE_INVALID,
+        //! A frame was decoded
+        DECODE_OK
+    };
+
+    //! Continues a CRC-16/CCITT-FALSE calculation
+    //! @param[in] data  Bytes to add to the CRC
+    //! @param[in] len  Number of bytes in data
+    //! @param[in] crc  The CRC of all bytes preceding data
+    //! @returns the updated CRC
+    static inline uint16_t crc16(const void* data, uint32_t len, uint16_t crc = CRC_INIT)
+    {
+        // Nibble table keeps this small while still being much faster than bit by bit
+        static const uint16_t NIBBLE_TABLE[16] = {
+            0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+            0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+        };
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (uint32_t i = 0; i < len; ++i)
+        {
+            crc = (crc << 4) ^ NIBBLE_TABLE[((crc >> 12) ^ (bytes[i] >> 4)) & 0x0F];
+            crc = (crc << 4) ^ NIBBLE_TABLE[((crc >> 12) ^ (bytes[i] & 0x0F)) & 0x0F];
+        }
+        return crc;
+    }
+
+    //! Sets the header of a frame
+    //! @param[out] header  HEADER_SIZE bytes to write
+    //! @param[in] cmd  The command character
+    //! @param[in] dataLen  The number of data bytes which will follow
+    static inline void setHeader(uint8_t* header, char cmd, uint16_t dataLen)
+    {
+        header[0] = SYNC_BYTE;
+        header[1] = dataLen & 0xFF;
+        header[2] = dataLen >> 8;
+        header[3] = static_cast<uint8_t>(cmd);
+    }
+
+    //! Encodes a frame into a buffer
+    //! @param[out] out  Output buffer
+    //! @param[in] outLen  Size of out in bytes
+    //! @param[in] cmd  The command character
+    //! @param[in] data  The data bytes
+    //! @param[in] dataLen  The number of data bytes
+    //! @returns the number of bytes written to out or 0 if out is too small
+    static inline uint32_t encode(uint8_t* out,
+                                  uint32_t outLen,
+                                  char cmd,
+                                  const void* data,
+                                  uint16_t dataLen)
+    {
+        if (outLen < OVERHEAD_SIZE || (outLen - OVERHEAD_SIZE) < dataLen)
+        {
+            return 0;
+        }
+        setHeader(out, cmd, dataLen);
+        if (dataLen > 0)
+        {
+            memcpy(&out[HEADER_SIZE], data, dataLen);
+        }
+        uint16_t crc = crc16(&out[1], HEADER_SIZE - 1 + dataLen);
+        out[HEADER_SIZE + dataLen] = crc & 0xFF;
+        out[HEADER_SIZE + dataLen + 1] = crc >> 8;
+        return OVERHEAD_SIZE + dataLen;
+    }
+
+    //! Writes a frame to stdout, whose data is made of up to two segments; this avoids copying
+    //! a Maple packet into a contiguous buffer first
+    //! @param[in] cmd  The command character
+    //! @param[in] data1  The first segment of data bytes
+    //! @param[in] len1  The number of bytes in data1
+    //! @param[in] data2  The second segment of data bytes
+    //! @param[in] len2  The number of bytes in data2
+    static inline void write(char cmd,
+                             const void* data1,
+                             uint16_t len1,
+                             const void* data2 = nullptr,
+                             uint16_t len2 = 0)
+    {
+        uint8_t header[HEADER_SIZE];
+        setHeader(header, cmd, len1 + len2);
+        uint16_t crc = crc16(&header[1], HEADER_SIZE - 1);
+        crc = crc16(data1, len1, crc);
+        crc = crc16(data2, len2, crc);
+        uint8_t crcBytes[CRC_SIZE] = {static_cast<uint8_t>(crc & 0xFF), static_cast<uint8_t>(crc >> 8)};
+
+        fwrite(header, 1, sizeof(header), stdout);
+        if (len1 > 0)
+        {
+            fwrite(data1, 1, len1, stdout);
+        }
+        if (len2 > 0)
+        {
+            fwrite(data2, 1, len2, stdout);
+        }
+        fwrite(crcBytes, 1, sizeof(crcBytes), stdout);
+        fflush(stdout);
+    }
+
+    //! Writes a frame to stdout whose data is a null terminated string (TEXT_FLAG is set)
+    //! @param[in] cmd  The command character
+    //! @param[in] str  The string to send (without null terminator)
+    static inline void writeString(char cmd, const char* str)
+    {
+        write(static_cast<char>(static_cast<uint8_t>(cmd) | TEXT_FLAG), str, strlen(str));
+    }
+
+    //! Attempts to decode a frame at the beginning of a buffer
+    //! @param[in] buffer  Received bytes
+    //! @param[in] len  Number of bytes in buffer
+    //! @param[out] frameLen  The total number of bytes in the decoded frame
+    //! @param[out] cmd  The command character of the decoded frame
+    //! @param[out] dataOffset  The offset into buffer where data starts
+    //! @param[out] dataLen  The number of data bytes
+    //! @returns DECODE_OK and sets all outputs iff a valid frame is at the beginning of buffer
+    static inline DecodeResult decode(const uint8_t* buffer,
+                                      uint32_t len,
+                                      uint32_t& frameLen,
+                                      char& cmd,
+                                      uint32_t& dataOffset,
+                                      uint32_t& dataLen)
+    {
+        if (len < 1)
+        {
+            return DECODE_INCOMPLETE;
+        }
+        if (buffer[0] != SYNC_BYTE)
+        {
+            return DECODE_INVALID;
+        }
+        if (len < HEADER_SIZE)
+        {
+            return DECODE_INCOMPLETE;
+        }
+        uint32_t n = buffer[1] | (static_cast<uint32_t>(buffer[2]) << 8);
+        if (n > MAX_DATA_SIZE)
+        {
+            return DECODE_INVALID;
+        }
+        if (len < (OVERHEAD_SIZE + n))
+        {
+            return DECODE_INCOMPLETE;
+        }
+        uint16_t crc = crc16(&buffer[1], HEADER_SIZE - 1 + n);
+        uint16_t rxCrc = buffer[HEADER_SIZE + n] | (buffer[HEADER_SIZE + n + 1] << 8);
+        if (crc != rxCrc)
+        {
+            return DECODE_INVALID;
+        }
+        frameLen = OVERHEAD_SIZE + n;
+        cmd = static_cast<char>(buffer[3]);
+        dataOffset = HEADER_SIZE;
+        dataLen = n;
+        return DECODE_OK;
+    }
+};
@@ -43,6 +43,18 @@ public:
     //! Called when newline reached; submit command and reset
     virtual void submit(const char* chars, uint32_t len) = 0;
 
+    //! Called when a binary frame addressed to this parser is received (see CdcFrame.hpp); frames
+    //! flagged as text are passed to submit() instead
+    //! @param[in] data  The frame's data bytes (not word aligned)
+    //! @param[in] len  The number of data bytes
+    //! @returns false iff this parser doesn't accept binary data
+    virtual bool submitBinary(const uint8_t* data, uint32_t len)
+    {
+        (void)data;
+        (void)len;
+        return false;
+    }
+
     //! Prints help message for this command
     virtual void printHelp() = 0;
 };
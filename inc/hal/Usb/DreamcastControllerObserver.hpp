@@ -49,6 +49,16 @@ class DreamcastControllerObserver
 
         //! Called when controller disconnected
         virtual void controllerDisconnected() = 0;
+
+        //! Retrieves when the host last read a report for this controller so that polling may be
+        //! aligned to it
+        //! @param[out] timeUs  Lower 32 bits of the system time in microseconds of the last read
+        //! @param[out] intervalUs  How often the host reads reports in microseconds
+        //! @returns true iff a report has been read and the values above were set
+        virtual bool getHostReadTiming(uint32_t& timeUs, uint32_t& intervalUs)
+        {
+            return false;
+        }
 };
 
 #endif // __DREAMCAST_CONTROLLER_OBSERVER_H__
@@ -26,6 +26,7 @@
 #include <stdint.h>
 #include "hal/Usb/CommandParser.hpp"
 #include "hal/System/MutexInterface.hpp"
+#include "hal/System/ClockInterface.hpp"
 
 //! Command parser for processing commands from a TTY stream
 class TtyParser
@@ -39,4 +40,4 @@ public:
     virtual void process() = 0;
 };
 
-TtyParser* usb_cdc_create_parser(MutexInterface* m, char helpChar);
+TtyParser* usb_cdc_create_parser(MutexInterface* m, char helpChar, ClockInterface* clock);
@@ -50,6 +50,19 @@ class UsbFile
                              void* buffer,
                              uint16_t bufferLen,
                              uint32_t timeoutUs) = 0;
+        //! Non-blocking read (must only be called from the core not operating maple bus)
+        //! Starts fetching the block if it isn't already on its way; call again until data is ready.
+        //! @param[in] blockNum  Block number to read (a block is 512 bytes)
+        //! @param[out] buffer  Buffer output
+        //! @param[in] bufferLen  The length of buffer (only up to 512 bytes will be read)
+        //! @param[in] timeoutUs  Timeout in microseconds for any newly requested maple bus reads
+        //! @returns Positive value indicating how many bytes were read
+        //! @returns Zero if the data is not yet available
+        //! @returns Negative value if read failure occurred
+        virtual int32_t tryRead(uint8_t blockNum,
+                                void* buffer,
+                                uint16_t bufferLen,
+                                uint32_t timeoutUs) = 0;
         //! Blocking write (must only be called from the core not operating maple bus)
         //! @param[in] blockNum  Block number to write (block is 512 bytes)
         //! @param[in] buffer  Buffer
@@ -62,6 +75,28 @@ class UsbFile
                               const void* buffer,
                               uint16_t bufferLen,
                               uint32_t timeoutUs) = 0;
+        //! Non-blocking write (must only be called from the core not operating maple bus)
+        //! @param[in] blockNum  Block number to write (block is 512 bytes)
+        //! @param[in] buffer  Buffer
+        //! @param[in] bufferLen  The length of buffer (but only up to 512 bytes will be written)
+        //! @param[in] timeoutUs  Timeout in microseconds for any newly requested maple bus reads
+        //! @returns Positive value indicating how many bytes were accepted
+        //! @returns Zero if the write may not be accepted yet
+        //! @returns Negative value if the write may not be accepted at all
+        virtual int32_t tryWrite(uint8_t blockNum,
+                                 const void* buffer,
+                                 uint16_t bufferLen,
+                                 uint32_t timeoutUs) = 0;
+        //! Blocking flush of any written data not yet committed (must only be called from the core
+        //! not operating maple bus)
+        //! @param[in] timeoutUs  Timeout in microseconds
+        //! @returns true iff all written data was committed without error
+        virtual bool flush(uint32_t timeoutUs) = 0;
+        //! Non-blocking flush (must only be called from the core not operating maple bus)
+        //! @returns Positive value if all written data was committed without error
+        //! @returns Zero if written data is still waiting to be committed
+        //! @returns Negative value if any write failed since the last flush
+        virtual int32_t tryFlush() = 0;
 };
 
 #endif // __USB_FILE_H__
@@ -0,0 +1,183 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __USB_FILE_TRANSFER_H__
+#define __USB_FILE_TRANSFER_H__
+
+#include <stdint.h>
+
+#include "hal/Usb/UsbFile.hpp"
+#include "hal/System/ClockInterface.hpp"
+
+//! Tracks a single non-blocking UsbFile read, write or flush across repeated calls so that USB processing
+//! may return "busy" and resume later instead of blocking until maple bus data is ready. The same
+//! request is expected to be repeated until a non-zero value is returned. A different request
+//! abandons the pending one and starts over with a new timeout.
+class UsbFileTransfer
+{
+    public:
+        //! Constructor
+        //! @param[in] clock  The clock used to time out pending transfers
+        inline UsbFileTransfer(ClockInterface& clock) :
+            mClock(clock),
+            mDirection(DIRECTION_NONE),
+            mFile(nullptr),
+            mBlockNum(0),
+            mKillTime(0)
+        {}
+
+        //! Starts or resumes a read of the given block
+        //! @param[in] file  The file to read from
+        //! @param[in] blockNum  Block number to read (a block is 512 bytes)
+        //! @param[out] buffer  Buffer output
+        //! @param[in] bufferLen  The length of buffer (only up to 512 bytes will be read)
+        //! @param[in] timeoutUs  Timeout in microseconds, counted from the first call for this block
+        //! @returns Positive value indicating how many bytes were read
+        //! @returns Zero if the read is still pending
+        //! @returns Negative value if read failure occurred or timeout elapsed
+        inline int32_t read(UsbFile* file,
+                            uint8_t blockNum,
+                            void* buffer,
+                            uint16_t bufferLen,
+                            uint32_t timeoutUs)
+        {
+            resume(DIRECTION_READ, file, blockNum, timeoutUs);
+            return update(file->tryRead(blockNum, buffer, bufferLen, timeoutUs));
+        }
+
+        //! Starts or resumes a write of the given block
+        //! @param[in] file  The file to write to
+        //! @param[in] blockNum  Block number to write (a block is 512 bytes)
+        //! @param[in] buffer  Buffer
+        //! @param[in] bufferLen  The length of buffer (only up to 512 bytes will be written)
+        //! @param[in] timeoutUs  Timeout in microseconds, counted from the first call for this block
+        //! @returns Positive value indicating how many bytes were accepted
+        //! @returns Zero if the write is still pending
+        //! @returns Negative value if write failure occurred or timeout elapsed
+        inline int32_t write(UsbFile* file,
+                             uint8_t blockNum,
+                             const void* buffer,
+                             uint16_t bufferLen,
+                             uint32_t timeoutUs)
+        {
+            resume(DIRECTION_WRITE, file, blockNum, timeoutUs);
+            return update(file->tryWrite(blockNum, buffer, bufferLen, timeoutUs));
+        }
+
+        //! Starts or resumes a wait for data written to the given file to be committed
+        //! @param[in] file  The file to flush
+        //! @param[in] timeoutUs  Timeout in microseconds, counted from the first call for this file
+        //! @returns Positive value if all written data was committed without error
+        //! @returns Zero if the flush is still pending
+        //! @returns Negative value if any write failed or timeout elapsed
+        inline int32_t flush(UsbFile* file, uint32_t timeoutUs)
+        {
+            resume(DIRECTION_FLUSH, file, 0, timeoutUs);
+            return update(file->tryFlush());
+        }
+
+        //! Abandons the pending transfer if it targets the given file (call when file is removed)
+        //! @param[in] file  The file being removed
+        inline void cancel(UsbFile* file)
+        {
+            if (mFile == file)
+            {
+                reset();
+            }
+        }
+
+        //! @returns true iff a transfer is waiting on data
+        inline bool isPending() const
+        {
+            return (mDirection != DIRECTION_NONE);
+        }
+
+    private:
+        //! The direction of the pending transfer
+        enum Direction : uint8_t
+        {
+            //! No transfer pending
+            DIRECTION_NONE = 0,
+            //! Read pending
+            DIRECTION_READ,
+            //! Write pending
+            DIRECTION_WRITE,
+            //! Flush pending
+            DIRECTION_FLUSH
+        };
+
+        //! Starts a new transfer unless the given one is already pending
+        inline void resume(Direction direction, UsbFile* file, uint8_t blockNum, uint32_t timeoutUs)
+        {
+            if (mDirection != direction || mFile != file || mBlockNum != blockNum)
+            {
+                mDirection = direction;
+                mFile = file;
+                mBlockNum = blockNum;
+                mKillTime = mClock.getTimeUs() + timeoutUs;
+            }
+        }
+
+        //! Ends the pending transfer once it completes or times out
+        //! @param[in] result  The value returned from the non-blocking file operation
+        //! @returns the value to return to the caller
+        inline int32_t update(int32_t result)
+        {
+            if (result == 0 && mClock.getTimeUs() >= mKillTime)
+            {
+                // Timeout
+                result = -1;
+            }
+
+            if (result != 0)
+            {
+                reset();
+            }
+
+            return result;
+        }
+
+        //! Returns to idle
+        inline void reset()
+        {
+            mDirection = DIRECTION_NONE;
+            mFile = nullptr;
+            mBlockNum = 0;
+            mKillTime = 0;
+        }
+
+    private:
+        //! Clock used to time out pending transfers
+        ClockInterface& mClock;
+        //! The direction of the pending transfer
+        Direction mDirection;
+        //! The file of the pending transfer
+        UsbFile* mFile;
+        //! The block number of the pending transfer
+        uint8_t mBlockNum;
+        //! Time at which the pending transfer is reported as failed
+        uint64_t mKillTime;
+};
+
+#endif // __USB_FILE_TRANSFER_H__
@@ -49,6 +49,7 @@ DreamcastController::DreamcastController() :
 DreamcastController::DreamcastController(EnabledControls enabledControls) :
     DreamcastPeripheralFunction(DEVICE_FN_CONTROLLER),
     mEnabledControls(enabledControls),
+    mConditionResponses(),
     mConditionSamples(0)
 {
     updateConditionMasks();
@@ -159,16 +160,20 @@ bool DreamcastController::handlePacket(const MaplePacket& in, MaplePacket& out)
     const uint8_t cmd = in.frame.command;
     if (cmd == COMMAND_GET_CONDITION)
     {
-        ++mConditionSamples;
+        const SerializedMaplePacket* response = dispenseSerializedCondition();
         out.frame.command = COMMAND_RESPONSE_DATA_XFER;
-        out.reservePayload(3);
-        out.appendPayload(getFunctionCode());
-        out.appendPayload(mCondition, 2);
+        out.setPayload(response->getPayload(), response->getPayloadLen());
         return true;
     }
     return false;
 }
 
+SerializedMaplePacket* DreamcastController::dispenseSerializedCondition()
+{
+    ++mConditionSamples;
+    return &mConditionResponses.read();
+}
+
 void DreamcastController::reset()
 {}
 
@@ -197,10 +202,17 @@ void DreamcastController::setCondition(controller_condition_t condition)
     uint32_t newCondition[2];
     memcpy(newCondition, &condition, sizeof(newCondition));
 
+    uint32_t payload[3];
+    payload[0] = getFunctionCode();
     for (uint32_t i = 0; i < 2; ++i)
     {
-        mCondition[i] = (newCondition[i] & mConditionAndMask[i]) | mConditionOrMask[i];
+        payload[i + 1] = (newCondition[i] & mConditionAndMask[i]) | mConditionOrMask[i];
     }
+
+    MaplePacket::Frame frame = MaplePacket::Frame::defaultFrame();
+    frame.command = COMMAND_RESPONSE_DATA_XFER;
+    mConditionResponses.beginWrite().set(frame.toWord(), payload, 3);
+    mConditionResponses.publish();
 }
 
 void DreamcastController::setControls(const Controls& controls)
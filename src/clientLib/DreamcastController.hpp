@@ -27,6 +27,7 @@
 #include "dreamcast_constants.h"
 #include "dreamcast_structures.h"
 #include "GamepadHost.hpp"
+#include "hal/System/TripleBuffer.hpp"
 
 namespace client
 {
@@ -69,6 +70,9 @@ public:
     //! Inherited from DreamcastPeripheralFunction
     virtual bool handlePacket(const MaplePacket& in, MaplePacket& out) final;
 
+    //! Inherited from DreamcastPeripheralFunction
+    virtual SerializedMaplePacket* dispenseSerializedCondition() final;
+
     //! Inherited from DreamcastPeripheralFunction
     virtual void reset() final;
 
@@ -76,6 +80,8 @@ public:
     virtual uint32_t getFunctionDefinition() final;
 
     //! Sets the raw controller condition
+    //! @note This and setControls() may be called from a different core than the one handling
+    //!       packets; each call serializes a new condition response which is handed over whole.
     void setCondition(controller_condition_t condition);
 
     //! Sets the standard set of gamepad controls to the controller condition
@@ -95,8 +101,8 @@ private:
     uint32_t mConditionAndMask[2];
     //! OR mas to apply to newly set condition
     uint32_t mConditionOrMask[2];
-    //! Last set controller condition
-    uint32_t mCondition[2];
+    //! Condition responses, handed from the setter to the bus
+    TripleBuffer<SerializedMaplePacket> mConditionResponses;
     //! Number of condition samples requested by host
     uint32_t mConditionSamples;
 };
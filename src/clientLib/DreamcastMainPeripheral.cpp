@@ -53,6 +53,7 @@ DreamcastMainPeripheral::DreamcastMainPeripheral(std::shared_ptr<MapleBusInterfa
     mLastSender(0),
     mPacketOut(),
     mLastPacketOut(),
+    mLastSerializedOut(nullptr),
     mPacketSent(false),
     mPacketIn(),
     mPlayerIndexChangedCb(nullptr),
@@ -85,6 +86,7 @@ DreamcastMainPeripheral::DreamcastMainPeripheral(std::shared_ptr<MapleBusInterfa
     mLastSender(0),
     mPacketOut(),
     mLastPacketOut(),
+    mLastSerializedOut(nullptr),
     mPacketSent(false),
     mPacketIn(),
     mPlayerIndexChangedCb(nullptr),
@@ -97,11 +99,13 @@ DreamcastMainPeripheral::DreamcastMainPeripheral(std::shared_ptr<MapleBusInterfa
 
 void DreamcastMainPeripheral::addSubPeripheral(std::shared_ptr<DreamcastPeripheral> subPeripheral)
 {
-    // This sub-peripheral's address must be unique
-    assert(mSubPeripherals.find(subPeripheral->mAddr) == mSubPeripherals.end());
+    // This sub-peripheral's address must be a single sub-peripheral bit and it must be unique
+    const int8_t idx = singleBitIndex(subPeripheral->mAddr);
+    assert(idx >= 0 && idx < MAX_NUMBER_OF_SUB_PERIPHERALS);
+    assert(!mSubPeripherals[idx]);
     assert(subPeripheral->mAddr != mAddr);
     // Add it
-    mSubPeripherals.insert(std::make_pair(subPeripheral->mAddr, subPeripheral));
+    mSubPeripherals[idx] = subPeripheral;
     // Accumulate to my address (main peripheral communicates back what sub peripherals are attached)
     mAddrAugmenter |= subPeripheral->mAddr;
 }
@@ -109,11 +113,11 @@ void DreamcastMainPeripheral::addSubPeripheral(std::shared_ptr<DreamcastPeripher
 bool DreamcastMainPeripheral::removeSubPeripheral(uint8_t addr)
 {
     bool removed = false;
-    std::map<uint8_t, std::shared_ptr<DreamcastPeripheral>>::iterator iter = mSubPeripherals.find(addr);
-    if (iter != mSubPeripherals.end())
+    const int8_t idx = singleBitIndex(addr);
+    if (idx >= 0 && idx < MAX_NUMBER_OF_SUB_PERIPHERALS && mSubPeripherals[idx])
     {
-        mAddrAugmenter &= ~(iter->second->mAddr);
-        mSubPeripherals.erase(iter);
+        mAddrAugmenter &= ~(mSubPeripherals[idx]->mAddr);
+        mSubPeripherals[idx].reset();
         removed = true;
     }
     return removed;
@@ -134,6 +138,7 @@ bool DreamcastMainPeripheral::dispensePacket(const MaplePacket& in, MaplePacket&
     out.reset();
 
     uint8_t rawRecipientAddr = in.frame.recipientAddr & ~PLAYER_ID_ADDR_MASK;
+    DreamcastPeripheral* subPeripheral = nullptr;
     if (rawRecipientAddr == mAddr)
     {
         // This is for me
@@ -144,13 +149,13 @@ bool DreamcastMainPeripheral::dispensePacket(const MaplePacket& in, MaplePacket&
             valid = handlePacket(in, out);
         }
     }
-    else if (mSubPeripherals.find(rawRecipientAddr) != mSubPeripherals.end())
+    else if ((subPeripheral = lookupSubPeripheral(rawRecipientAddr)) != nullptr)
     {
         // This is for one of my sub-peripherals
         if (mIsConnectionAllowed)
         {
             handled = true;
-            valid = mSubPeripherals[rawRecipientAddr]->handlePacket(in, out);
+            valid = subPeripheral->handlePacket(in, out);
         }
     }
     // else: not handled
@@ -170,11 +175,12 @@ void DreamcastMainPeripheral::reset()
 {
     DreamcastPeripheral::reset();
     mPlayerIndex = -1;
-    for (std::map<uint8_t, std::shared_ptr<DreamcastPeripheral>>::iterator iter = mSubPeripherals.begin();
-         iter != mSubPeripherals.end();
-         ++iter)
+    for (uint8_t i = 0; i < MAX_NUMBER_OF_SUB_PERIPHERALS; ++i)
     {
-        iter->second->reset();
+        if (mSubPeripherals[i])
+        {
+            mSubPeripherals[i]->reset();
+        }
     }
 
     if (mPlayerIndexChangedCb != nullptr)
@@ -202,12 +208,13 @@ void DreamcastMainPeripheral::setPlayerIndex(uint8_t idx)
         mPlayerIndex = idx;
         uint8_t augmenterMask = (idx << PLAYER_ID_BIT_SHIFT);
         mAddrAugmenter = (mAddrAugmenter & ~PLAYER_ID_ADDR_MASK) | augmenterMask;
-        for (std::map<uint8_t, std::shared_ptr<DreamcastPeripheral>>::iterator iter = mSubPeripherals.begin();
-             iter != mSubPeripherals.end();
-             ++iter)
+        for (uint8_t i = 0; i < MAX_NUMBER_OF_SUB_PERIPHERALS; ++i)
         {
-            // The only augmenter in sub-peripherals is player index
-            iter->second->setAddrAugmenter(augmenterMask);
+            if (mSubPeripherals[i])
+            {
+                // The only augmenter in sub-peripherals is player index
+                mSubPeripherals[i]->setAddrAugmenter(augmenterMask);
+            }
         }
 
         if (mPlayerIndexChangedCb != nullptr)
@@ -273,27 +280,48 @@ void DreamcastMainPeripheral::task(uint64_t currentTimeUs)
         case MapleBusInterface::Phase::READ_COMPLETE:
         {
             bool writeIt = false;
+            SerializedMaplePacket* serializedOut =
+                handleConditionRequest(status.readBuffer, status.readBufferLen);
 
-            mPacketIn.set(status.readBuffer, status.readBufferLen);
-            mLastSender = mPacketIn.frame.senderAddr;
-
-            if (mPacketIn.frame.command == COMMAND_RESPONSE_REQUEST_RESEND)
+            if (serializedOut != nullptr)
             {
-                if (mPacketSent)
-                {
-                    // Write the previous packet
-                    mPacketOut = mLastPacketOut;
-                    writeIt = true;
-                }
+                mLastSender = MaplePacket::Frame::getFrameSenderAddr(status.readBuffer[0]);
             }
             else
             {
-                writeIt = dispensePacket(mPacketIn, mPacketOut);
+                mPacketIn.set(status.readBuffer, status.readBufferLen);
+                mLastSender = mPacketIn.frame.senderAddr;
+
+                if (mPacketIn.frame.command == COMMAND_RESPONSE_REQUEST_RESEND)
+                {
+                    if (mPacketSent)
+                    {
+                        // Write the previous packet (a serialized response is left unchanged
+                        // until the next one is dispensed)
+                        serializedOut = mLastSerializedOut;
+                        if (serializedOut == nullptr)
+                        {
+                            mPacketOut = mLastPacketOut;
+                            writeIt = true;
+                        }
+                    }
+                }
+                else
+                {
+                    writeIt = dispensePacket(mPacketIn, mPacketOut);
+                }
             }
 
-            if (writeIt)
+            if (serializedOut != nullptr)
             {
                 mPacketSent = true;
+                mLastSerializedOut = serializedOut;
+                (void)mBus->writeSerialized(*serializedOut, true, READ_TIMEOUT_US);
+            }
+            else if (writeIt)
+            {
+                mPacketSent = true;
+                mLastSerializedOut = nullptr;
                 mLastPacketOut = mPacketOut;
                 (void)mBus->write(mPacketOut, true, READ_TIMEOUT_US);
             }
@@ -307,6 +335,33 @@ void DreamcastMainPeripheral::task(uint64_t currentTimeUs)
     }
 }
 
+SerializedMaplePacket* DreamcastMainPeripheral::handleConditionRequest(const uint32_t* words,
+                                                                      uint32_t len)
+{
+    // Only a connected peripheral which keeps its player index would respond with condition data
+    if (len < 2 || !mIsConnectionAllowed || !mConnected)
+    {
+        return nullptr;
+    }
+
+    const MaplePacket::Frame frame = MaplePacket::Frame::fromWord(words[0]);
+    const uint8_t playerIdx = (frame.senderAddr & PLAYER_ID_ADDR_MASK) >> PLAYER_ID_BIT_SHIFT;
+    if (frame.command != COMMAND_GET_CONDITION
+        || (frame.recipientAddr & ~PLAYER_ID_ADDR_MASK) != mAddr
+        || playerIdx != mPlayerIndex)
+    {
+        return nullptr;
+    }
+
+    SerializedMaplePacket* response = dispenseSerializedCondition(words[1]);
+    if (response != nullptr)
+    {
+        ++mReadCount;
+        response->setAddresses(getAddress(), frame.senderAddr);
+    }
+    return response;
+}
+
 void DreamcastMainPeripheral::setPlayerIndexChangedCb(PlayerIndexChangedFn fn)
 {
     mPlayerIndexChangedCb = fn;
@@ -25,7 +25,6 @@
 
 #include <stdint.h>
 #include <memory>
-#include <map>
 
 #include "hal/MapleBus/MapleBusInterface.hpp"
 #include "hal/MapleBus/MaplePacket.hpp"
@@ -110,9 +109,29 @@ private:
     //! Set player index received from interface
     void setPlayerIndex(uint8_t idx);
 
+    //! @param[in] rawAddr  An address with player index bits cleared
+    //! @returns the sub-peripheral with the given address or nullptr if there is none
+    inline DreamcastPeripheral* lookupSubPeripheral(uint8_t rawAddr)
+    {
+        const int8_t idx = singleBitIndex(rawAddr);
+        return (idx >= 0 && idx < MAX_NUMBER_OF_SUB_PERIPHERALS)
+            ? mSubPeripherals[idx].get()
+            : nullptr;
+    }
+
+    //! Answers a condition request for this connected peripheral with the pre-serialized response
+    //! of the addressed function, when it has one; this is equivalent to the response which
+    //! dispensePacket() would build
+    //! @param[in] words  The words read from the bus, starting with the frame word
+    //! @param[in] len  Number of words in words
+    //! @returns the addressed response, ready to send, or nullptr if the packet must be dispensed
+    SerializedMaplePacket* handleConditionRequest(const uint32_t* words, uint32_t len);
+
 public:
     //! Maple Bus read timeout in microseconds
     static const uint64_t READ_TIMEOUT_US = 1000000;
+    //! Sub-peripherals take the lowest address bits, below that of the main peripheral
+    static const uint8_t MAX_NUMBER_OF_SUB_PERIPHERALS = 5;
 
 private:
     //! The bus this main peripheral is connected to
@@ -121,14 +140,17 @@ private:
     bool mIsConnectionAllowed;
     //! The current player index detected [0,3] or -1 if not set
     int16_t mPlayerIndex;
-    //! All of the sub-peripherals attached to this main peripheral
-    std::map<uint8_t, std::shared_ptr<DreamcastPeripheral>> mSubPeripherals;
+    //! All of the sub-peripherals attached to this main peripheral, indexed by the bit index of
+    //! their address
+    std::shared_ptr<DreamcastPeripheral> mSubPeripherals[MAX_NUMBER_OF_SUB_PERIPHERALS];
     //! The sender address of the last received packet
     uint8_t mLastSender;
     //! Output packet buffer data
     MaplePacket mPacketOut;
     //! Last successfully sent packet, used for resend requests from host
     MaplePacket mLastPacketOut;
+    //! Last sent packet when it was a serialized condition response or nullptr otherwise
+    SerializedMaplePacket* mLastSerializedOut;
     //! Initialized to false and set to true once the first packet is sent
     bool mPacketSent;
     //! Input packet buffer
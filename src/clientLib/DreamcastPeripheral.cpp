@@ -46,6 +46,8 @@ DreamcastPeripheral::DreamcastPeripheral(uint8_t addr,
     mConnected(false),
     mAddrAugmenter(0),
     mDevices(),
+    mNumDevices(0),
+    mFunctionTable(),
     mDevInfo{}
 {
     mDevInfo[4] = static_cast<uint32_t>(regionCode) << 24
@@ -204,13 +206,11 @@ bool DreamcastPeripheral::handlePacket(const MaplePacket& in, MaplePacket& out)
             case COMMAND_GET_LAST_ERROR: // FALL THROUGH
             case COMMAND_SET_CONDITION:
             {
-                const uint32_t& fnCode = in.payload[0];
-                std::map<uint32_t, std::shared_ptr<DreamcastPeripheralFunction>>::iterator iter =
-                    mDevices.find(fnCode);
+                DreamcastPeripheralFunction* fn = lookupFunction(in.payload[0]);
 
-                if (iter != mDevices.end())
+                if (fn != nullptr)
                 {
-                    status = iter->second->handlePacket(in, out);
+                    status = fn->handlePacket(in, out);
                 }
                 else
                 {
@@ -236,15 +236,24 @@ bool DreamcastPeripheral::handlePacket(const MaplePacket& in, MaplePacket& out)
     return status;
 }
 
+SerializedMaplePacket* DreamcastPeripheral::dispenseSerializedCondition(uint32_t functionCode)
+{
+    SerializedMaplePacket* response = nullptr;
+    DreamcastPeripheralFunction* fn = lookupFunction(functionCode);
+    if (fn != nullptr)
+    {
+        response = fn->dispenseSerializedCondition();
+    }
+    return response;
+}
+
 void DreamcastPeripheral::reset()
 {
     mConnected = false;
     mAddrAugmenter &= ~PLAYER_ID_ADDR_MASK;
-    for (std::map<uint32_t, std::shared_ptr<DreamcastPeripheralFunction>>::iterator iter = mDevices.begin();
-         iter != mDevices.end();
-         ++iter)
+    for (uint8_t i = 0; i < mNumDevices; ++i)
     {
-        iter->second->reset();
+        mDevices[i]->reset();
     }
 }
 
@@ -254,12 +263,15 @@ void DreamcastPeripheral::shutdown()
 void DreamcastPeripheral::setDevInfoFunctionDefinitions()
 {
     // Set the function definitions
-    // Maps are sorted by key, and the function definition of the peripheral with largest function
-    // code must go into slot 1. Thus reverse_iterator is used to iterate through mDevices.
+    // The function definition of the peripheral with largest function code must go into slot 1.
+    // Thus the function table is walked from its highest bit down.
     uint8_t pt = 1;
-    for (auto iter = mDevices.rbegin(); iter != mDevices.rend() && pt <= MAX_NUMBER_OF_FUNCTIONS; ++iter)
+    for (int8_t idx = NUM_FUNCTION_CODE_BITS - 1; idx >= 0 && pt <= MAX_NUMBER_OF_FUNCTIONS; --idx)
     {
-        mDevInfo[pt++] = iter->second->getFunctionDefinition();
+        if (mFunctionTable[idx] != nullptr)
+        {
+            mDevInfo[pt++] = mFunctionTable[idx]->getFunctionDefinition();
+        }
     }
 
     // Reset the rest of the function definitions
@@ -271,9 +283,18 @@ void DreamcastPeripheral::setDevInfoFunctionDefinitions()
 
 void DreamcastPeripheral::addFunction(std::shared_ptr<DreamcastPeripheralFunction> fn)
 {
-    mDevices.insert(std::make_pair(fn->getFunctionCode(), fn));
+    // Each function is selected by a single bit of function code
+    const int8_t idx = singleBitIndex(fn->getFunctionCode());
+    assert(idx >= 0);
+    if (mFunctionTable[idx] != nullptr)
+    {
+        // A function with this code was already added
+        return;
+    }
     // No more than 3 functions may be added
-    assert(mDevices.size() <= MAX_NUMBER_OF_FUNCTIONS);
+    assert(mNumDevices < MAX_NUMBER_OF_FUNCTIONS);
+    mDevices[mNumDevices++] = fn;
+    mFunctionTable[idx] = fn.get();
     // Accumulate the function codes into the device info array
     mDevInfo[0] |= fn->getFunctionCode();
     // Refresh the function definitions in device info
@@ -283,12 +304,22 @@ void DreamcastPeripheral::addFunction(std::shared_ptr<DreamcastPeripheralFunctio
 bool DreamcastPeripheral::removeFunction(uint32_t functionCode)
 {
     bool removed = false;
-    std::map<uint32_t, std::shared_ptr<DreamcastPeripheralFunction>>::iterator iter =
-        mDevices.find(functionCode);
-    if (iter != mDevices.end())
+    DreamcastPeripheralFunction* fn = lookupFunction(functionCode);
+    if (fn != nullptr)
     {
-        mDevInfo[0] &= ~(iter->second->getFunctionCode());
-        mDevices.erase(iter);
+        mDevInfo[0] &= ~(fn->getFunctionCode());
+        mFunctionTable[singleBitIndex(functionCode)] = nullptr;
+        // Close the gap left in mDevices
+        uint8_t i = 0;
+        while (mDevices[i].get() != fn)
+        {
+            ++i;
+        }
+        while (++i < mNumDevices)
+        {
+            mDevices[i - 1] = std::move(mDevices[i]);
+        }
+        mDevices[--mNumDevices].reset();
         // Refresh the function definitions in device info
         setDevInfoFunctionDefinitions();
 
@@ -24,7 +24,6 @@
 #pragma once
 
 #include <memory>
-#include <map>
 
 #include "hal/MapleBus/MaplePacket.hpp"
 #include "hal/MapleBus/MapleBusInterface.hpp"
@@ -89,7 +88,33 @@ public:
     //! @returns address of this peripheral
     inline uint8_t getAddress() { return (mAddr | mAddrAugmenter); }
 
+protected:
+    //! Dispenses the serialized condition response of a function (see
+    //! DreamcastPeripheralFunction::dispenseSerializedCondition())
+    //! @param[in] functionCode  The function code of the function to dispense from
+    //! @returns the serialized response or nullptr if the function has none ready
+    SerializedMaplePacket* dispenseSerializedCondition(uint32_t functionCode);
+
+    //! @param[in] mask  A function code or address mask
+    //! @returns the index of the only bit set in mask or -1 if not exactly one bit is set
+    static inline int8_t singleBitIndex(uint32_t mask)
+    {
+        if (mask == 0 || (mask & (mask - 1)) != 0)
+        {
+            return -1;
+        }
+        return __builtin_ctz(mask);
+    }
+
 private:
+    //! @param[in] functionCode  A function code
+    //! @returns the added function with the given function code or nullptr if there is none
+    inline DreamcastPeripheralFunction* lookupFunction(uint32_t functionCode)
+    {
+        const int8_t idx = singleBitIndex(functionCode);
+        return (idx >= 0) ? mFunctionTable[idx] : nullptr;
+    }
+
     //! Sets a string in device info array
     //! @param[in] wordIdx  The word index in device info array where string starts
     //! @param[in] offset  The byte offset in the word [0,3]
@@ -105,6 +130,8 @@ public:
     static const uint8_t PLAYER_ID_BIT_SHIFT = 6;
     //! Maximum allowed functions in a Dreamcast peripheral (due to device info message limitations)
     static const uint8_t MAX_NUMBER_OF_FUNCTIONS = 3;
+    //! Number of bits in a function code, each of which may select one function
+    static const uint8_t NUM_FUNCTION_CODE_BITS = 32;
     //! Address (mask) of this peripheral
     const uint8_t mAddr;
 
@@ -115,8 +142,12 @@ protected:
     uint8_t mAddrAugmenter;
 
 private:
-    //! Stores between 1 and 3 peripheral functions
-    std::map<uint32_t, std::shared_ptr<DreamcastPeripheralFunction>> mDevices;
+    //! Stores between 1 and 3 peripheral functions, in the order they were added
+    std::shared_ptr<DreamcastPeripheralFunction> mDevices[MAX_NUMBER_OF_FUNCTIONS];
+    //! Number of functions in mDevices
+    uint8_t mNumDevices;
+    //! The functions of mDevices, indexed by the bit index of their function code
+    DreamcastPeripheralFunction* mFunctionTable[NUM_FUNCTION_CODE_BITS];
     //! Device info array
     uint32_t mDevInfo[48];
 };
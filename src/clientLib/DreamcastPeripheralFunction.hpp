@@ -29,6 +29,7 @@
 #include <assert.h>
 
 #include "hal/MapleBus/MaplePacket.hpp"
+#include "hal/MapleBus/SerializedMaplePacket.hpp"
 
 namespace client
 {
@@ -55,6 +56,13 @@ public:
     //! @returns true iff the packet was handled
     virtual bool handlePacket(const MaplePacket& in, MaplePacket& out) = 0;
 
+    //! Dispenses a ready to send response to COMMAND_GET_CONDITION, counting it as a condition
+    //! sample the same as handlePacket() would. The response has its sender and recipient
+    //! addresses left to be set by the caller, and it must not be modified otherwise. It remains
+    //! unchanged until the next call to this or to handlePacket().
+    //! @returns the serialized response or nullptr if this function has none ready
+    virtual SerializedMaplePacket* dispenseSerializedCondition() { return nullptr; }
+
     //! Called when player index changed or timeout occurred
     virtual void reset() = 0;
 
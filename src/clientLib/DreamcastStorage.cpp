@@ -229,7 +229,8 @@ bool client::DreamcastStorage::handlePacket(const MaplePacket& in, MaplePacket&
                         out.reservePayload(WORDS_PER_BLOCK + 2);
                         out.setPayload(&mFunctionCode, 1);
                         out.appendPayload(locationWord);
-                        out.appendPayloadFlipWords(reinterpret_cast<const uint32_t*>(mem), WORDS_PER_BLOCK);
+                        // Sent raw so that the bus doesn't need to swap what was just flipped
+                        out.appendPayloadRaw(reinterpret_cast<const uint32_t*>(mem), WORDS_PER_BLOCK);
                     }
                     else
                     {
@@ -264,6 +265,8 @@ bool client::DreamcastStorage::handlePacket(const MaplePacket& in, MaplePacket&
                     uint32_t numBytes = sizeof(uint32_t);
                     uint8_t* outPtr = &mDataBlock[byteOffset];
                     const uint32_t* inPtr = &in.payload[2];
+                    // The bus can't know that a block write is coming before it is received, so
+                    // the data can't be received raw like the host does with block reads
                     for (uint32_t i = 0; i < BYTES_PER_WRITE; i+=4, outPtr+=numBytes, ++inPtr)
                     {
                         if (i + numBytes > BYTES_PER_WRITE)
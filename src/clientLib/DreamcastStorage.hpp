@@ -118,6 +118,9 @@ public:
     static const uint16_t NUM_FAT_BLOCKS = 1;
     static const uint16_t FILE_INFO_BLOCK_NO = FAT_BLOCK_NO - NUM_FAT_BLOCKS;
     static const uint16_t NUM_FILE_INFO_BLOCKS = 13;
+    //! Number of bytes at the end of memory holding the media info, FAT, and directory
+    static const uint32_t SYSTEM_AREA_SIZE_BYTES =
+        (NUM_SYSTEM_BLOCKS + NUM_FAT_BLOCKS + NUM_FILE_INFO_BLOCKS) * BYTES_PER_BLOCK;
     static const uint16_t SAVE_AREA_BLOCK_NO = 31;
     static const uint16_t NUM_SAVE_AREA_BLOCKS = 200;
 
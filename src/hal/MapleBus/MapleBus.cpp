@@ -130,9 +130,12 @@ MapleBus::MapleBus(uint32_t pinA, int32_t dirPin, bool dirOutHigh) :
     mSmIn(mPinA),
     mDmaWriteChannel(dma_claim_unused_channel(true)),
     mDmaReadChannel(dma_claim_unused_channel(true)),
+    mDmaWriteConfig(dma_channel_get_default_config(mDmaWriteChannel)),
+    mDmaReadConfig(dma_channel_get_default_config(mDmaReadChannel)),
+    mRawReadIdx(MaplePacket::NO_RAW_PAYLOAD),
     mWriteBuffer(),
-    mReadBuffer(),
-    mLastRead(),
+    mReadBuffers(),
+    mReadBufferIdx(0),
     mCurrentPhase(MapleBus::Phase::IDLE),
     mExpectingResponse(false),
     mProcKillTime(0xFFFFFFFFFFFFFFFFULL),
@@ -154,7 +157,7 @@ MapleBus::MapleBus(uint32_t pinA, int32_t dirPin, bool dirOutHigh) :
     initIsrs();
 
     // Setup DMA to automaticlly put data on the FIFO
-    dma_channel_config c = dma_channel_get_default_config(mDmaWriteChannel);
+    dma_channel_config& c = mDmaWriteConfig;
     channel_config_set_read_increment(&c, true);
     channel_config_set_write_increment(&c, false);
     // Bytes need to be swapped so the least significant byte is sent first
@@ -168,17 +171,17 @@ MapleBus::MapleBus(uint32_t pinA, int32_t dirPin, bool dirOutHigh) :
                             false);
 
     // Setup DMA to automaticlly read data from the FIFO
-    c = dma_channel_get_default_config(mDmaReadChannel);
-    channel_config_set_read_increment(&c, false);
-    channel_config_set_write_increment(&c, true);
+    dma_channel_config& rc = mDmaReadConfig;
+    channel_config_set_read_increment(&rc, false);
+    channel_config_set_write_increment(&rc, true);
     // Bytes need to be swapped since bytes are loaded to the left by default
-    channel_config_set_bswap(&c, true);
-    channel_config_set_dreq(&c, pio_get_dreq(mSmIn.mProgram.mPio, mSmIn.mSmIdx, false));
+    channel_config_set_bswap(&rc, true);
+    channel_config_set_dreq(&rc, pio_get_dreq(mSmIn.mProgram.mPio, mSmIn.mSmIdx, false));
     dma_channel_configure(mDmaReadChannel,
-                            &c,
-                            mReadBuffer,
+                            &rc,
+                            mReadBuffers[mReadBufferIdx],
                             &mSmIn.mProgram.mPio->rxf[mSmIn.mSmIdx],
-                            (sizeof(mReadBuffer) / sizeof(mReadBuffer[0])),
+                            READ_BUFFER_WORDS,
                             false);
 }
 
@@ -294,55 +297,124 @@ bool MapleBus::write(const MaplePacket& packet,
         crc8(frameWord, crc);
         crc8(packet.payload.data(), packet.payload.size(), crc);
 
-        // First 32 bits sent to the state machine is how many bits to output.
-        // Since channel_config_set_bswap is set to make the packet bytes the right order, these
-        // bytes need to be flipped so the PIO state machine can work with it correctly.
         uint32_t len = 0;
-        mWriteBuffer[len++] = flipWordBytes(packet.getNumTotalBits());
-        // Load the frame word and start computing the crc
-        mWriteBuffer[len++] = frameWord;
-        // Load the rest of the packet
-        wordCpy(&mWriteBuffer[len], packet.payload.data(), packet.payload.size());
-        len += packet.payload.size();
-        // Last byte is the CRC
-        mWriteBuffer[len++] = crc;
-
-        if (lineCheck())
+        const bool rawPayload = packet.hasRawPayload();
+        if (!rawPayload)
         {
-            // Update flags before beginning to write
-            mExpectingResponse = autostartRead;
-            mResponseTimeoutUs = readTimeoutUs;
-            mCurrentPhase = Phase::WRITE_IN_PROGRESS;
+            // First 32 bits sent to the state machine is how many bits to output.
+            // Since channel_config_set_bswap is set to make the packet bytes the right order, these
+            // bytes need to be flipped so the PIO state machine can work with it correctly.
+            mWriteBuffer[len++] = flipWordBytes(packet.getNumTotalBits());
+            // Load the frame word and start computing the crc
+            mWriteBuffer[len++] = frameWord;
+            // Load the rest of the packet
+            wordCpy(&mWriteBuffer[len], packet.payload.data(), packet.payload.size());
+            len += packet.payload.size();
+            // Last byte is the CRC
+            mWriteBuffer[len++] = crc;
+        }
+        else
+        {
+            // Byte swap is disabled in DMA for this packet so that raw words go out as they are in
+            // memory; every other word is flipped here instead (bit count is then left as is)
+            const uint32_t rawIdx = packet.rawPayloadIdx;
+            mWriteBuffer[len++] = packet.getNumTotalBits();
+            mWriteBuffer[len++] = flipWordBytes(frameWord);
+            flipWordCpy(&mWriteBuffer[len], packet.payload.data(), rawIdx);
+            len += rawIdx;
+            wordCpy(&mWriteBuffer[len], &packet.payload.data()[rawIdx], packet.payload.size() - rawIdx);
+            len += packet.payload.size() - rawIdx;
+            mWriteBuffer[len++] = flipWordBytes(crc);
+        }
+        rv = startWrite(mWriteBuffer,
+                        len,
+                        !rawPayload,
+                        packet.getTxTimeNs(),
+                        packet.rawResponseIdx,
+                        autostartRead,
+                        readTimeoutUs);
+    }
 
-            if (autostartRead)
-            {
-                // Start read DMA (won't start filling until mSmIn.start() is called)
-                mLastReadTransferCount = sizeof(mReadBuffer) / sizeof(mReadBuffer[0]);
-                dma_channel_transfer_to_buffer_now(
-                    mDmaReadChannel, mReadBuffer, mLastReadTransferCount);
-                // Prestart the input state machine to save time during transition
-                mSmIn.prestart();
-            }
+    return rv;
+}
 
-            // Start the state machine which will stall until DMA is filled
-            mSmOut.start();
+bool MapleBus::writeSerialized(const SerializedMaplePacket& packet,
+                               bool autostartRead,
+                               uint64_t readTimeoutUs)
+{
+    bool rv = false;
 
-            // Switch to output mode
-            setDirection(true);
-            // There will be enough of a delay between now and when data lines on microcontroller
-            // transition to output
+    if (!isBusy())
+    {
+        // Make sure previous DMA instances are killed
+        dma_channel_abort(mDmaWriteChannel);
+        dma_channel_abort(mDmaReadChannel);
+
+        // The packet is already laid out the same as mWriteBuffer would be for a packet without
+        // raw payload, CRC included, so DMA reads straight from it
+        rv = startWrite(packet.getWords(),
+                        packet.getNumWords(),
+                        true,
+                        packet.getTxTimeNs(),
+                        MaplePacket::NO_RAW_PAYLOAD,
+                        autostartRead,
+                        readTimeoutUs);
+    }
+
+    return rv;
+}
+
+bool MapleBus::startWrite(volatile const uint32_t* buffer,
+                          uint32_t len,
+                          bool bswap,
+                          uint32_t txTimeNs,
+                          uint8_t rawResponseIdx,
+                          bool autostartRead,
+                          uint64_t readTimeoutUs)
+{
+    bool rv = false;
 
-            // Start writing
-            dma_channel_transfer_from_buffer_now(mDmaWriteChannel, mWriteBuffer, len);
+    setDmaBswap(mDmaWriteChannel, mDmaWriteConfig, bswap);
 
-            uint32_t totalWriteTimeNs = packet.getTxTimeNs();
-            // Multiply by the extra percentage
-            totalWriteTimeNs *= (1 + (MAPLE_WRITE_TIMEOUT_EXTRA_PERCENT / 100.0));
-            // And then compute the time which the write process should complete
-            mProcKillTime = time_us_64() + INT_DIVIDE_CEILING(totalWriteTimeNs, 1000);
+    if (lineCheck())
+    {
+        // Update flags before beginning to write
+        mExpectingResponse = autostartRead;
+        mResponseTimeoutUs = readTimeoutUs;
+        mCurrentPhase = Phase::WRITE_IN_PROGRESS;
 
-            rv = true;
+        if (autostartRead)
+        {
+            // The response is left unswapped by DMA when it is expected to hold raw words
+            mRawReadIdx = rawResponseIdx;
+            setDmaBswap(
+                mDmaReadChannel, mDmaReadConfig, (mRawReadIdx == MaplePacket::NO_RAW_PAYLOAD));
+            // Start read DMA (won't start filling until mSmIn.start() is called)
+            mLastReadTransferCount = READ_BUFFER_WORDS;
+            dma_channel_transfer_to_buffer_now(
+                mDmaReadChannel, mReadBuffers[mReadBufferIdx], mLastReadTransferCount);
+            // Prestart the input state machine to save time during transition
+            mSmIn.prestart();
         }
+
+        // Start the state machine which will stall until DMA is filled
+        mSmOut.start();
+
+        // Switch to output mode
+        setDirection(true);
+        // There will be enough of a delay between now and when data lines on microcontroller
+        // transition to output
+
+        // Start writing
+        dma_channel_transfer_from_buffer_now(mDmaWriteChannel, buffer, len);
+
+        uint32_t totalWriteTimeNs = txTimeNs;
+        // Multiply by the extra percentage
+        totalWriteTimeNs *= (1 + (MAPLE_WRITE_TIMEOUT_EXTRA_PERCENT / 100.0));
+        // And then compute the time which the write process should complete
+        mProcKillTime = time_us_64() + INT_DIVIDE_CEILING(totalWriteTimeNs, 1000);
+
+        rv = true;
     }
 
     return rv;
@@ -359,9 +431,11 @@ bool MapleBus::startRead(uint64_t readTimeoutUs)
         dma_channel_abort(mDmaReadChannel);
 
         // Start read DMA
-        mLastReadTransferCount = sizeof(mReadBuffer) / sizeof(mReadBuffer[0]);
+        mRawReadIdx = MaplePacket::NO_RAW_PAYLOAD;
+        setDmaBswap(mDmaReadChannel, mDmaReadConfig, true);
+        mLastReadTransferCount = READ_BUFFER_WORDS;
         dma_channel_transfer_to_buffer_now(
-            mDmaReadChannel, mReadBuffer, mLastReadTransferCount);
+            mDmaReadChannel, mReadBuffers[mReadBufferIdx], mLastReadTransferCount);
 
         // Setup state
         if (readTimeoutUs == NO_TIMEOUT)
@@ -402,8 +476,25 @@ MapleBusInterface::Status MapleBus::processEvents(uint64_t currentTimeUs)
                && time_us_64() < timeoutTime);
 
         // transfer_count decrements down to 0, so compute the inverse to get number of words
-        uint32_t dmaWordsRead = (sizeof(mReadBuffer) / sizeof(mReadBuffer[0]))
+        uint32_t dmaWordsRead = READ_BUFFER_WORDS
                                 - dma_channel_hw_addr(mDmaReadChannel)->transfer_count;
+        volatile uint32_t* readBuffer = mReadBuffers[mReadBufferIdx];
+
+        if (mRawReadIdx != MaplePacket::NO_RAW_PAYLOAD && dmaWordsRead > 0)
+        {
+            // DMA didn't swap bytes, so flip everything except raw payload words here (the CRC
+            // is unaffected by byte order)
+            readBuffer[0] = flipWordBytes(static_cast<uint32_t>(readBuffer[0]));
+            uint32_t rawStart = 1 + mRawReadIdx;
+            uint32_t rawEnd = 1 + (readBuffer[0] & 0xFF);
+            for (uint32_t i = 1; i < dmaWordsRead; ++i)
+            {
+                if (i < rawStart || i >= rawEnd)
+                {
+                    readBuffer[i] = flipWordBytes(static_cast<uint32_t>(readBuffer[i]));
+                }
+            }
+        }
 
         // Should have at least frame and CRC words
         if (dmaWordsRead > 1)
@@ -412,18 +503,20 @@ MapleBusInterface::Status MapleBus::processEvents(uint64_t currentTimeUs)
             // For at least 1 instance (VMU extended device info) the number of words received will
             // not match len. For this reason, the following allows for more words to be read than
             // specified by the frame word as long as the CRC is still correct.
-            uint32_t len = mReadBuffer[0] & 0xFF;
+            uint32_t len = readBuffer[0] & 0xFF;
             if (len <= (dmaWordsRead - 2))
             {
-                // Copy what was read and compute CRC
-                wordCpy(&mLastRead[0], &mReadBuffer[0], dmaWordsRead - 1);
+                // Compute CRC in place
                 uint8_t crc = 0;
-                crc8(&mLastRead[0], dmaWordsRead - 1, crc);
+                crc8(readBuffer, dmaWordsRead - 1, crc);
                 // Data is only valid if the CRC is correct
-                if (crc == mReadBuffer[dmaWordsRead - 1])
+                if (crc == readBuffer[dmaWordsRead - 1])
                 {
-                    status.readBuffer = mLastRead;
+                    // DMA is done with this buffer, so it is handed out as is; it stays untouched
+                    // through the next read, which is armed on the other buffer
+                    status.readBuffer = const_cast<const uint32_t*>(readBuffer);
                     status.readBufferLen = dmaWordsRead - 1;
+                    mReadBufferIdx ^= 1;
                 }
                 else
                 {
@@ -549,6 +642,22 @@ void MapleBus::wordCpy(volatile uint32_t* dest,
     }
 }
 
+void MapleBus::flipWordCpy(volatile uint32_t* dest,
+                           volatile const uint32_t* source,
+                           uint32_t len)
+{
+    for (; len > 0; --len, ++source, ++dest)
+    {
+        *dest = flipWordBytes(static_cast<uint32_t>(*source));
+    }
+}
+
+void MapleBus::setDmaBswap(int channel, dma_channel_config& config, bool bswap)
+{
+    channel_config_set_bswap(&config, bswap);
+    dma_channel_set_config(channel, &config, false);
+}
+
 uint32_t MapleBus::flipWordBytes(const uint32_t& word)
 {
     return (word << 24) | (word << 8 & 0xFF0000) | (word >> 8 & 0xFF00) | (word >> 24);
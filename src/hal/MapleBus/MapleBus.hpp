@@ -58,6 +58,17 @@ class MapleBus : public MapleBusInterface
                    bool autostartRead,
                    uint64_t readTimeoutUs=MAPLE_RESPONSE_TIMEOUT_US);
 
+        //! Writes an already serialized packet to the maple bus, straight from its words
+        //! @post processEvents() must periodically be called to check status
+        //! @param[in] packet  The serialized packet to send (must remain unchanged until the write
+        //!                    has completed)
+        //! @param[in] autostartRead  Set to true in order to start receive after send is complete
+        //! @param[in] readTimeoutUs  When autostartRead is true, the read timeout to set
+        //! @returns true iff the bus was "open" and send has started
+        bool writeSerialized(const SerializedMaplePacket& packet,
+                             bool autostartRead,
+                             uint64_t readTimeoutUs=MAPLE_RESPONSE_TIMEOUT_US) override;
+
         //! Begins waiting for input
         //! @post processEvents() must periodically be called to check status
         //! @note This is NOT meant to be called if bus is setup as a host
@@ -89,6 +100,23 @@ class MapleBus : public MapleBusInterface
         //! Ensures that the bus is open
         bool lineCheck();
 
+        //! Starts writing the given buffer once the bus is found to be open
+        //! @param[in] buffer  The words to send, starting with the bit count
+        //! @param[in] len  Number of words in buffer
+        //! @param[in] bswap  True to byte swap each word as it is sent
+        //! @param[in] txTimeNs  Number of nanoseconds it takes to transmit the packet
+        //! @param[in] rawResponseIdx  Index of the first raw payload word in the expected response
+        //! @param[in] autostartRead  Set to true in order to start receive after send is complete
+        //! @param[in] readTimeoutUs  When autostartRead is true, the read timeout to set
+        //! @returns true iff the bus was "open" and send has started
+        bool startWrite(volatile const uint32_t* buffer,
+                        uint32_t len,
+                        bool bswap,
+                        uint32_t txTimeNs,
+                        uint8_t rawResponseIdx,
+                        bool autostartRead,
+                        uint64_t readTimeoutUs);
+
         //! Set direction
         //! @param[in] output  True for output from this device or false for input to this device
         void setDirection(bool output);
@@ -112,15 +140,31 @@ class MapleBus : public MapleBusInterface
                                    volatile const uint32_t* source,
                                    uint32_t len);
 
+        //! Copies words from source to dest, flipping the endianness of each
+        //! @param[out] dest  The destination array to write to
+        //! @param[in] source  The source array to read from
+        //! @param[in] len  Number of words to copy
+        static void flipWordCpy(volatile uint32_t* dest,
+                                volatile const uint32_t* source,
+                                uint32_t len);
+
         //! Flips the endianness of a word
         //! @param[in] word  Input word
         //! @returns output word
         static uint32_t flipWordBytes(const uint32_t& word);
 
+        //! Sets whether the given DMA channel swaps the bytes of each word it transfers
+        //! @param[in] channel  The DMA channel
+        //! @param[in,out] config  The configuration of channel
+        //! @param[in] bswap  True to swap bytes
+        static void setDmaBswap(int channel, dma_channel_config& config, bool bswap);
+
         //! Initializes all interrupt service routines for all Maple Busses
         static void initIsrs();
 
     public:
+        //! Number of words in each input buffer - 256 + 1 extra word for CRC + 1 for overflow
+        static const uint32_t READ_BUFFER_WORDS = 258;
         //! Timeout value to use when no timeout is desired
         static const uint64_t NO_TIMEOUT = std::numeric_limits<uint64_t>::max();
 
@@ -147,13 +191,20 @@ class MapleBus : public MapleBusInterface
         const int mDmaWriteChannel;
         //! The DMA channel used for reading by this bus
         const int mDmaReadChannel;
+        //! Configuration of mDmaWriteChannel (byte swap is toggled for packets with raw payload)
+        dma_channel_config mDmaWriteConfig;
+        //! Configuration of mDmaReadChannel (byte swap is toggled for responses with raw payload)
+        dma_channel_config mDmaReadConfig;
+        //! Index of the first raw payload word of the current read or MaplePacket::NO_RAW_PAYLOAD
+        uint8_t mRawReadIdx;
 
         //! The output word buffer - 256 + 2 extra words for bit count and CRC
         volatile uint32_t mWriteBuffer[258];
-        //! The input word buffer - 256 + 1 extra word for CRC + 1 for overflow
-        volatile uint32_t mReadBuffer[258];
-        //! Persistent storage for external use after processEvents call
-        uint32_t mLastRead[256];
+        //! The input word buffers; a completed read is handed out of processEvents() in place while
+        //! the next read is armed on the other buffer
+        volatile uint32_t mReadBuffers[2][READ_BUFFER_WORDS];
+        //! Index into mReadBuffers which the next or current read DMA targets
+        uint32_t mReadBufferIdx;
         //! Current phase of the state machine
         Phase mCurrentPhase;
         //! True if read should be started immediately after write has completed
@@ -0,0 +1,709 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "LogStructuredSystemMemory.hpp"
+
+#include "hal/System/LockGuard.hpp"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+LogStructuredSystemMemory::LogStructuredSystemMemory(FlashInterface& flash,
+                                                     MutexInterface& mutex,
+                                                     ClockInterface& clock,
+                                                     uint32_t flashOffset,
+                                                     uint32_t regionSize,
+                                                     uint32_t size,
+                                                     const uint8_t* initialImage,
+                                                     uint32_t pinnedSize) :
+    SystemMemory(),
+    mFlash(flash),
+    mMutex(mutex),
+    mClock(clock),
+    mOffset(flashOffset),
+    mNumSectors(regionSize / SECTOR_SIZE),
+    mSize(size),
+    mNumBlocks(size / BLOCK_SIZE),
+    mInitialImage(initialImage),
+    mNumPinnedBlocks((pinnedSize + BLOCK_SIZE - 1) / BLOCK_SIZE),
+    mNumCacheEntries(NUM_CACHED_BLOCKS + mNumPinnedBlocks),
+    mDirtyBlocks(new uint32_t[(mNumBlocks + 31) / 32]),
+    mCachedBlocks(),
+    mCacheData(),
+    mErasedBlock(),
+    mIndex(new uint16_t[mNumBlocks]),
+    mEraseCounts(new uint32_t[mNumSectors]),
+    mBlockBuffer(),
+    mPageBuffer(),
+    mHead(NO_SECTOR),
+    mHeadSlot(0),
+    mTail(0),
+    mGcSlot(0),
+    mSectorSequence(0),
+    mNextBlockSequence(1),
+    mNextDirtyBlock(0),
+    mFlashBusy(false),
+    mLastReadTime(0),
+    mLastActivityTime(0)
+{
+    assert(flashOffset % SECTOR_SIZE == 0);
+    assert(regionSize % SECTOR_SIZE == 0);
+    assert(size % BLOCK_SIZE == 0);
+    assert(mNumPinnedBlocks <= MAX_PINNED_BLOCKS && mNumPinnedBlocks <= mNumBlocks);
+    // Garbage collection needs a free sector to move live blocks into, and the head may be
+    // partially used; the rest of the log must be able to hold every block
+    assert((mNumSectors - 2) * SLOTS_PER_SECTOR >= mNumBlocks);
+    assert(mNumSectors * SLOTS_PER_SECTOR < NO_LOCATION);
+    static_assert(sizeof(SectorHeader) + SLOTS_PER_SECTOR * sizeof(SlotHeader) <= PAGE_SIZE,
+                  "Headers must fit in the first page of a sector");
+    static_assert((1 + SLOTS_PER_SECTOR * (BLOCK_SIZE / PAGE_SIZE)) * PAGE_SIZE <= SECTOR_SIZE,
+                  "Slots must fit in a sector");
+
+    for (uint8_t i = 0; i < NUM_CACHE_ENTRIES; ++i)
+    {
+        mCachedBlocks[i] = NO_BLOCK;
+    }
+    memset(mErasedBlock, 0xFF, sizeof(mErasedBlock));
+
+    scan();
+
+    // Pinned blocks stay in the cache for good
+    for (uint8_t i = 0; i < mNumPinnedBlocks; ++i)
+    {
+        const uint16_t blockNum = mNumBlocks - mNumPinnedBlocks + i;
+        bool inFlash = false;
+        memcpy(mCacheData[NUM_CACHED_BLOCKS + i], locateBlock(blockNum, inFlash), BLOCK_SIZE);
+        mCachedBlocks[NUM_CACHED_BLOCKS + i] = blockNum;
+    }
+}
+
+uint32_t LogStructuredSystemMemory::getMemorySize()
+{
+    return mSize;
+}
+
+const uint8_t* LogStructuredSystemMemory::read(uint32_t offset, uint32_t& size)
+{
+    LockGuard lock(mMutex, true);
+
+    mLastActivityTime = mClock.getTimeUs();
+    if (offset >= mSize)
+    {
+        size = 0;
+        return nullptr;
+    }
+    // Each block may be in a different place
+    uint32_t max = BLOCK_SIZE - (offset % BLOCK_SIZE);
+    size = (max >= size) ? size : max;
+
+    bool inFlash = false;
+    const uint8_t* block = locateBlock(offset / BLOCK_SIZE, inFlash);
+    if (inFlash)
+    {
+        if (mFlashBusy)
+        {
+            // Nothing can be read from flash while it's being erased or programmed
+            size = 0;
+            return nullptr;
+        }
+        mLastReadTime = mLastActivityTime;
+    }
+    return &block[offset % BLOCK_SIZE];
+}
+
+bool LogStructuredSystemMemory::write(uint32_t offset, const void* data, uint32_t& size)
+{
+    // This entire function is serialized with process()
+    LockGuard lock(mMutex, true);
+
+    mLastActivityTime = mClock.getTimeUs();
+
+    bool success = true;
+    if (offset >= mSize)
+    {
+        size = 0;
+        success = false;
+    }
+    else if (size > (mSize - offset))
+    {
+        size = mSize - offset;
+        success = false;
+    }
+
+    // Store this data into the cache, only marking blocks which actually changed
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    uint32_t pos = offset;
+    const uint32_t end = offset + size;
+    while (pos < end)
+    {
+        uint32_t blockEnd = (pos / BLOCK_SIZE + 1) * BLOCK_SIZE;
+        uint32_t len = ((blockEnd < end) ? blockEnd : end) - pos;
+        const uint16_t blockNum = pos / BLOCK_SIZE;
+        bool changed = false;
+        uint8_t entry = findCacheEntry(blockNum);
+        if (entry == NO_ENTRY)
+        {
+            bool inFlash = false;
+            const uint8_t* current = locateBlock(blockNum, inFlash);
+            if ((!inFlash || !mFlashBusy) && memcmp(&current[pos % BLOCK_SIZE], in, len) == 0)
+            {
+                // Already holds this, so there is no need to cache anything
+                pos += len;
+                in += len;
+                continue;
+            }
+
+            // Only a partial block write needs the rest of the block copied in
+            entry = loadCacheEntry(blockNum, (len != BLOCK_SIZE));
+            if (entry == NO_ENTRY)
+            {
+                // Not able to take on any more right now
+                size = pos - offset;
+                success = false;
+                break;
+            }
+            changed = true;
+        }
+
+        uint8_t* cached = &mCacheData[entry][pos % BLOCK_SIZE];
+        if (changed || memcmp(cached, in, len) != 0)
+        {
+            memcpy(cached, in, len);
+            mDirtyBlocks[blockNum / 32] |= (1UL << (blockNum % 32));
+        }
+        pos += len;
+        in += len;
+    }
+
+    return success;
+}
+
+uint64_t LogStructuredSystemMemory::getLastActivityTime()
+{
+    // WARNING: Not an atomic read, but this isn't a critical thing anyway
+    return mLastActivityTime;
+}
+
+void LogStructuredSystemMemory::process()
+{
+    if (mHead != NO_SECTOR && getNumFreeSectors() < GC_START_FREE_SECTORS && mTail != mHead)
+    {
+        collectGarbage();
+    }
+    else
+    {
+        commitNextBlock();
+    }
+}
+
+bool LogStructuredSystemMemory::isCommitPending()
+{
+    LockGuard lock(mMutex, true);
+    for (uint16_t i = 0; i < (mNumBlocks + 31) / 32; ++i)
+    {
+        if (mDirtyBlocks[i] != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint16_t LogStructuredSystemMemory::getNumFreeSectors() const
+{
+    if (mHead == NO_SECTOR)
+    {
+        return mNumSectors;
+    }
+    return (mTail + mNumSectors - mHead - 1) % mNumSectors;
+}
+
+uint32_t LogStructuredSystemMemory::sectorToFlashByte(uint16_t sector) const
+{
+    return mOffset + (sector * SECTOR_SIZE);
+}
+
+uint32_t LogStructuredSystemMemory::slotDataFlashByte(uint16_t location) const
+{
+    const uint16_t slot = location % SLOTS_PER_SECTOR;
+    return sectorToFlashByte(location / SLOTS_PER_SECTOR) + PAGE_SIZE + (slot * BLOCK_SIZE);
+}
+
+const LogStructuredSystemMemory::SlotHeader* LogStructuredSystemMemory::readSlotHeader(
+    uint16_t location)
+{
+    const uint16_t slot = location % SLOTS_PER_SECTOR;
+    const uint8_t* headerPage = mFlash.read(sectorToFlashByte(location / SLOTS_PER_SECTOR));
+    return reinterpret_cast<const SlotHeader*>(
+        &headerPage[sizeof(SectorHeader) + (slot * sizeof(SlotHeader))]);
+}
+
+bool LogStructuredSystemMemory::isSlotValid(uint16_t location,
+                                            uint16_t& blockNum,
+                                            uint32_t& sequence)
+{
+    SlotHeader header;
+    memcpy(&header, readSlotHeader(location), sizeof(header));
+    if (header.check != slotCheck(header)
+        || static_cast<uint16_t>(~header.blockNum) != header.blockNumInv
+        || header.blockNum >= mNumBlocks
+        || header.dataHash != hash(mFlash.read(slotDataFlashByte(location)), BLOCK_SIZE))
+    {
+        return false;
+    }
+    blockNum = header.blockNum;
+    sequence = header.sequence;
+    return true;
+}
+
+bool LogStructuredSystemMemory::readSectorHeader(uint16_t sector, SectorHeader& header)
+{
+    memcpy(&header, mFlash.read(sectorToFlashByte(sector)), sizeof(header));
+    return (header.magic == SECTOR_MAGIC && header.check == sectorCheck(header));
+}
+
+void LogStructuredSystemMemory::scan()
+{
+    memset(mDirtyBlocks.get(), 0, ((mNumBlocks + 31) / 32) * sizeof(mDirtyBlocks[0]));
+    memset(mIndex.get(), 0xFF, mNumBlocks * sizeof(mIndex[0]));
+
+    // The head is the sector opened last
+    std::vector<uint32_t> sectorSequences(mNumSectors, 0);
+    std::vector<bool> sectorValid(mNumSectors, false);
+    for (uint16_t sector = 0; sector < mNumSectors; ++sector)
+    {
+        SectorHeader header;
+        mEraseCounts[sector] = 0;
+        if (readSectorHeader(sector, header))
+        {
+            sectorValid[sector] = true;
+            sectorSequences[sector] = header.sequence;
+            mEraseCounts[sector] = header.eraseCount;
+            if (mHead == NO_SECTOR || header.sequence > mSectorSequence)
+            {
+                mHead = sector;
+                mSectorSequence = header.sequence;
+            }
+        }
+    }
+
+    if (mHead != NO_SECTOR)
+    {
+        scanLog(sectorValid, sectorSequences);
+    }
+
+    // Whatever was never logged is carried over from the initial image
+    if (mInitialImage != nullptr)
+    {
+        for (uint16_t block = 0; block < mNumBlocks; ++block)
+        {
+            if (mIndex[block] == NO_LOCATION
+                && !isErased(&mInitialImage[block * BLOCK_SIZE], BLOCK_SIZE))
+            {
+                mDirtyBlocks[block / 32] |= (1UL << (block % 32));
+            }
+        }
+    }
+}
+
+void LogStructuredSystemMemory::scanLog(const std::vector<bool>& sectorValid,
+                                        const std::vector<uint32_t>& sectorSequences)
+{
+    // The tail is found by walking back from the head for as long as sectors are older
+    mTail = mHead;
+    while (true)
+    {
+        uint16_t prev = (mTail + mNumSectors - 1) % mNumSectors;
+        if (prev == mHead
+            || !sectorValid[prev]
+            || sectorSequences[prev] >= sectorSequences[mTail])
+        {
+            break;
+        }
+        mTail = prev;
+    }
+
+    // The newest valid copy of each block wins; sectors outside of the log may only hold old
+    // copies, so it doesn't hurt to look at every sector
+    std::vector<uint32_t> blockSequences(mNumBlocks, 0);
+    for (uint16_t sector = 0; sector < mNumSectors; ++sector)
+    {
+        if (!sectorValid[sector])
+        {
+            continue;
+        }
+        for (uint16_t slot = 0; slot < SLOTS_PER_SECTOR; ++slot)
+        {
+            const uint16_t location = (sector * SLOTS_PER_SECTOR) + slot;
+            uint16_t blockNum;
+            uint32_t sequence;
+            if (isSlotValid(location, blockNum, sequence))
+            {
+                if (mIndex[blockNum] == NO_LOCATION || sequence > blockSequences[blockNum])
+                {
+                    mIndex[blockNum] = location;
+                    blockSequences[blockNum] = sequence;
+                }
+                if (sequence >= mNextBlockSequence)
+                {
+                    mNextBlockSequence = sequence + 1;
+                }
+            }
+        }
+    }
+
+    // Anything programmed into a slot of the head, even if it didn't complete, uses that slot up
+    mHeadSlot = 0;
+    for (uint16_t slot = 0; slot < SLOTS_PER_SECTOR; ++slot)
+    {
+        const uint16_t location = (mHead * SLOTS_PER_SECTOR) + slot;
+        if (!isErased(reinterpret_cast<const uint8_t*>(readSlotHeader(location)),
+                      sizeof(SlotHeader))
+            || !isErased(mFlash.read(slotDataFlashByte(location)), BLOCK_SIZE))
+        {
+            mHeadSlot = slot + 1;
+        }
+    }
+}
+
+const uint8_t* LogStructuredSystemMemory::locateBlock(uint16_t blockNum, bool& inFlash)
+{
+    uint8_t entry = findCacheEntry(blockNum);
+    if (entry != NO_ENTRY)
+    {
+        inFlash = false;
+        return mCacheData[entry];
+    }
+
+    inFlash = true;
+    if (mIndex[blockNum] != NO_LOCATION)
+    {
+        return mFlash.read(slotDataFlashByte(mIndex[blockNum]));
+    }
+    else if (mInitialImage != nullptr)
+    {
+        return &mInitialImage[blockNum * BLOCK_SIZE];
+    }
+
+    inFlash = false;
+    return mErasedBlock;
+}
+
+uint8_t LogStructuredSystemMemory::findCacheEntry(uint16_t blockNum)
+{
+    for (uint8_t i = 0; i < mNumCacheEntries; ++i)
+    {
+        if (mCachedBlocks[i] == blockNum)
+        {
+            return i;
+        }
+    }
+    return NO_ENTRY;
+}
+
+uint8_t LogStructuredSystemMemory::loadCacheEntry(uint16_t blockNum, bool copy)
+{
+    const uint8_t* current = nullptr;
+    if (copy)
+    {
+        bool inFlash = false;
+        current = locateBlock(blockNum, inFlash);
+        if (inFlash && mFlashBusy)
+        {
+            // Can't copy from flash right now
+            return NO_ENTRY;
+        }
+    }
+
+    for (uint8_t i = 0; i < NUM_CACHED_BLOCKS; ++i)
+    {
+        if (mCachedBlocks[i] == NO_BLOCK)
+        {
+            mCachedBlocks[i] = blockNum;
+            if (current != nullptr)
+            {
+                memcpy(mCacheData[i], current, BLOCK_SIZE);
+            }
+            return i;
+        }
+    }
+    return NO_ENTRY;
+}
+
+void LogStructuredSystemMemory::setCommitted(uint16_t blockNum, uint16_t location)
+{
+    if (location != NO_LOCATION)
+    {
+        mIndex[blockNum] = location;
+    }
+
+    uint8_t entry = findCacheEntry(blockNum);
+    if (entry != NO_ENTRY
+        && entry < NUM_CACHED_BLOCKS
+        && (mDirtyBlocks[blockNum / 32] & (1UL << (blockNum % 32))) == 0)
+    {
+        // Reads may go to flash now
+        mCachedBlocks[entry] = NO_BLOCK;
+    }
+}
+
+bool LogStructuredSystemMemory::canAppend(bool forGc) const
+{
+    if (mHead != NO_SECTOR && mHeadSlot < SLOTS_PER_SECTOR)
+    {
+        return true;
+    }
+    // Opening a new sector for anything other than garbage collection must leave one free so that
+    // garbage collection can always make progress
+    return (getNumFreeSectors() > (forGc ? 0 : 1));
+}
+
+void LogStructuredSystemMemory::openNextSector()
+{
+    uint16_t sector = 0;
+    if (mHead == NO_SECTOR)
+    {
+        mTail = 0;
+        mGcSlot = 0;
+    }
+    else
+    {
+        sector = (mHead + 1) % mNumSectors;
+    }
+
+    const uint32_t flashByte = sectorToFlashByte(sector);
+    if (!isErased(mFlash.read(flashByte), SECTOR_SIZE))
+    {
+        mFlash.eraseSector(flashByte);
+        ++mEraseCounts[sector];
+    }
+
+    SectorHeader header;
+    header.magic = SECTOR_MAGIC;
+    header.sequence = ++mSectorSequence;
+    header.eraseCount = mEraseCounts[sector];
+    header.check = sectorCheck(header);
+    memset(mPageBuffer, 0xFF, PAGE_SIZE);
+    memcpy(mPageBuffer, &header, sizeof(header));
+    mFlash.programPage(flashByte, mPageBuffer);
+
+    mHead = sector;
+    mHeadSlot = 0;
+}
+
+uint16_t LogStructuredSystemMemory::appendBlock(uint16_t blockNum)
+{
+    if (mHead == NO_SECTOR || mHeadSlot >= SLOTS_PER_SECTOR)
+    {
+        openNextSector();
+    }
+
+    const uint16_t location = (mHead * SLOTS_PER_SECTOR) + mHeadSlot;
+    ++mHeadSlot;
+
+    // Data goes in first; the slot doesn't count until its header is programmed after it
+    const uint32_t dataFlashByte = slotDataFlashByte(location);
+    for (uint32_t pageOffset = 0; pageOffset < BLOCK_SIZE; pageOffset += PAGE_SIZE)
+    {
+        if (!isErased(&mBlockBuffer[pageOffset], PAGE_SIZE))
+        {
+            mFlash.programPage(dataFlashByte + pageOffset, &mBlockBuffer[pageOffset]);
+        }
+    }
+
+    SlotHeader header;
+    header.blockNum = blockNum;
+    header.blockNumInv = ~blockNum;
+    header.sequence = mNextBlockSequence++;
+    header.dataHash = hash(mBlockBuffer, BLOCK_SIZE);
+    header.check = slotCheck(header);
+    // Bits already programmed in the header page are programmed again as they are
+    memcpy(mPageBuffer, mFlash.read(sectorToFlashByte(mHead)), PAGE_SIZE);
+    memcpy(&mPageBuffer[sizeof(SectorHeader) + ((location % SLOTS_PER_SECTOR) * sizeof(header))],
+           &header,
+           sizeof(header));
+    mFlash.programPage(sectorToFlashByte(mHead), mPageBuffer);
+
+    return location;
+}
+
+void LogStructuredSystemMemory::collectGarbage()
+{
+    while (mGcSlot < SLOTS_PER_SECTOR)
+    {
+        const uint16_t location = (mTail * SLOTS_PER_SECTOR) + mGcSlot;
+        const uint16_t blockNum = readSlotHeader(location)->blockNum;
+        if (blockNum < mNumBlocks && mIndex[blockNum] == location)
+        {
+            if (!canAppend(true))
+            {
+                // Can't happen as long as the region is large enough for all blocks
+                return;
+            }
+
+            {
+                LockGuard lock(mMutex, true);
+                if (mClock.getTimeUs() < mLastReadTime + READ_HOLD_US)
+                {
+                    // Whoever last read may still be copying out of flash
+                    return;
+                }
+                // Whatever is cached is the newest copy, so it is what gets moved
+                uint8_t entry = findCacheEntry(blockNum);
+                if (entry != NO_ENTRY)
+                {
+                    memcpy(mBlockBuffer, mCacheData[entry], BLOCK_SIZE);
+                    mDirtyBlocks[blockNum / 32] &= ~(1UL << (blockNum % 32));
+                }
+                else
+                {
+                    memcpy(mBlockBuffer, mFlash.read(slotDataFlashByte(location)), BLOCK_SIZE);
+                }
+                mFlashBusy = true;
+            }
+
+            uint16_t newLocation = appendBlock(blockNum);
+            ++mGcSlot;
+
+            {
+                LockGuard lock(mMutex, true);
+                mFlashBusy = false;
+                setCommitted(blockNum, newLocation);
+            }
+            return;
+        }
+        ++mGcSlot;
+    }
+
+    // Nothing left alive in the tail, so it may be reused
+    mTail = (mTail + 1) % mNumSectors;
+    mGcSlot = 0;
+}
+
+bool LogStructuredSystemMemory::commitNextBlock()
+{
+    if (!canAppend(false))
+    {
+        return false;
+    }
+
+    uint16_t blockNum = mNumBlocks;
+
+    {
+        LockGuard lock(mMutex, true);
+
+        uint64_t currentTimeUs = mClock.getTimeUs();
+        if (currentTimeUs < mLastReadTime + READ_HOLD_US)
+        {
+            // Whoever last read may still be copying out of flash
+            return false;
+        }
+
+        for (uint16_t i = 0; i < mNumBlocks; ++i)
+        {
+            uint16_t block = (mNextDirtyBlock + i) % mNumBlocks;
+            if ((mDirtyBlocks[block / 32] & (1UL << (block % 32))) != 0)
+            {
+                blockNum = block;
+                break;
+            }
+        }
+
+        if (blockNum >= mNumBlocks)
+        {
+            return false;
+        }
+
+        // Take a snapshot so that the lock doesn't need to be held while flash is busy; anything
+        // written to this block from here on will mark it dirty again
+        mDirtyBlocks[blockNum / 32] &= ~(1UL << (blockNum % 32));
+        bool inFlash = false;
+        memcpy(mBlockBuffer, locateBlock(blockNum, inFlash), BLOCK_SIZE);
+        mNextDirtyBlock = (blockNum + 1) % mNumBlocks;
+        mLastActivityTime = currentTimeUs;
+        mFlashBusy = true;
+    }
+
+    // Data may have been set back to what is already logged
+    bool unchanged = false;
+    if (mIndex[blockNum] == NO_LOCATION)
+    {
+        unchanged = isErased(mBlockBuffer, BLOCK_SIZE)
+                    && (mInitialImage == nullptr
+                        || isErased(&mInitialImage[blockNum * BLOCK_SIZE], BLOCK_SIZE));
+    }
+    else
+    {
+        unchanged = (memcmp(mFlash.read(slotDataFlashByte(mIndex[blockNum])),
+                            mBlockBuffer,
+                            BLOCK_SIZE) == 0);
+    }
+
+    uint16_t location = NO_LOCATION;
+    if (!unchanged)
+    {
+        location = appendBlock(blockNum);
+    }
+
+    {
+        LockGuard lock(mMutex, true);
+        mFlashBusy = false;
+        setCommitted(blockNum, location);
+    }
+
+    return true;
+}
+
+bool LogStructuredSystemMemory::isErased(const uint8_t* data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        if (data[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t LogStructuredSystemMemory::hash(const uint8_t* data, uint32_t len, uint32_t h)
+{
+    for (uint32_t i = 0; i < len; ++i)
+    {
+        h = (h ^ data[i]) * 16777619UL;
+    }
+    return h;
+}
+
+uint32_t LogStructuredSystemMemory::sectorCheck(const SectorHeader& header)
+{
+    return hash(reinterpret_cast<const uint8_t*>(&header), offsetof(SectorHeader, check));
+}
+
+uint32_t LogStructuredSystemMemory::slotCheck(const SlotHeader& header)
+{
+    // Seeded differently than sectorCheck() so that one may never pass for the other
+    return hash(reinterpret_cast<const uint8_t*>(&header), offsetof(SlotHeader, check), SECTOR_MAGIC);
+}
@@ -0,0 +1,297 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "hal/System/SystemMemory.hpp"
+#include "hal/System/FlashInterface.hpp"
+#include "hal/System/MutexInterface.hpp"
+#include "hal/System/ClockInterface.hpp"
+
+#include <memory>
+#include <vector>
+
+// Mapping the VMU image 1:1 onto flash (see NonVolatilePicoSystemMemory) means that every save
+// erases the same FAT and directory sectors. This class instead appends each written 512 byte block
+// to a circular log that spans a larger region of flash. The newest copy of a block is the one with
+// the highest sequence number, and a RAM index points at it. As the head of the log approaches the
+// tail, the tail sector's live blocks are copied to the head, and the tail sector is released for
+// reuse. Every sector is therefore erased in turn, regardless of which blocks are written.
+//
+// Sector layout (16 pages of 256 bytes):
+// - Page 0: sector header (16 bytes) followed by a 16 byte header for each slot
+// - Pages 1-14: 7 slots of 512 bytes of block data
+// - Page 15: unused
+//
+// Commits are power-fail safe: block data is programmed before its slot header, and a slot header
+// is only accepted when its check word and the hash of its data match. A block which was being
+// written when power was lost therefore reads back as its previous copy. Live blocks are copied
+// out of a sector before it is ever erased.
+//
+// Like NonVolatilePicoSystemMemory, reads are served straight out of flash, and only blocks which
+// are waiting to be committed are held in RAM. process() is meant to be called from the other core.
+// While it has flash busy, read() fails for blocks which aren't cached, and it leaves flash alone
+// for READ_HOLD_US after a read so that the caller may copy data out. The blocks at the end of
+// memory (media info, FAT, and directory) may be pinned in the cache so that they can always be
+// read.
+
+//! SystemMemory class storing blocks in a wear levelled log in flash
+class LogStructuredSystemMemory : public SystemMemory
+{
+public:
+    //! Constructor - scans the log to restore memory
+    //! @param[in] flash  The flash to store memory in
+    //! @param[in] mutex  Mutex used to serialize write() and flash programming
+    //! @param[in] clock  Clock used for activity time
+    //! @param[in] flashOffset  Offset of the log region in flash, must align to SECTOR_SIZE
+    //! @param[in] regionSize  Number of bytes of flash the log may use, multiple of SECTOR_SIZE
+    //! @param[in] size  Number of bytes to allow read/write, multiple of BLOCK_SIZE
+    //! @param[in] initialImage  If not nullptr, size bytes of memory previously mapped 1:1 in flash;
+    //!                          blocks which were never logged are read from and logged from here
+    //! @param[in] pinnedSize  Number of bytes at the end of memory to always hold in RAM so that
+    //!                        they may be read while flash is busy; rounded up to whole blocks,
+    //!                        which may be no more than MAX_PINNED_BLOCKS
+    LogStructuredSystemMemory(FlashInterface& flash,
+                              MutexInterface& mutex,
+                              ClockInterface& clock,
+                              uint32_t flashOffset,
+                              uint32_t regionSize,
+                              uint32_t size,
+                              const uint8_t* initialImage = nullptr,
+                              uint32_t pinnedSize = 0);
+
+    //! @returns number of bytes reserved in memory
+    virtual uint32_t getMemorySize() final;
+
+    //! Reads from memory - must return within 500 microseconds
+    //! @param[in] offset  Offset into memory in bytes
+    //! @param[in,out] size  Number of bytes to read, set with the number of bytes read (a read
+    //!                      never crosses a block boundary and fails while flash is busy unless
+    //!                      the block is cached or pinned)
+    //! @returns a pointer containing the number of bytes returned in size
+    virtual const uint8_t* read(uint32_t offset, uint32_t& size) final;
+
+    //! Writes to memory - must return within 500 microseconds
+    //! @param[in] offset  Offset into memory in bytes
+    //! @param[in] data  The data to write
+    //! @param[in,out] size  Number of bytes to write, set with number of bytes written (fewer are
+    //!                      written when the cache is full)
+    //! @returns true iff all bytes were written or at least queued for write
+    virtual bool write(uint32_t offset, const void* data, uint32_t& size) final;
+
+    //! Used to determine read/write status for status LED
+    //! @returns the time of last read/write activity
+    virtual uint64_t getLastActivityTime() final;
+
+    //! Must be called to periodically commit written blocks and collect garbage; each call does at
+    //! most 1 slot write or 1 sector erase
+    //! @warning this may block for up to 400 ms
+    void process();
+
+    //! @returns true iff any written data is waiting to be committed to flash
+    bool isCommitPending();
+
+    //! @returns the number of sectors which are neither holding log data nor the head
+    uint16_t getNumFreeSectors() const;
+
+public:
+    //! Number of bytes in a VMU block
+    static const uint32_t BLOCK_SIZE = 512;
+    //! Number of block slots in each sector
+    static const uint32_t SLOTS_PER_SECTOR = 7;
+    //! Number of blocks which may be held in RAM waiting to be committed
+    static const uint8_t NUM_CACHED_BLOCKS = 16;
+    //! Maximum number of blocks which may be pinned in RAM
+    static const uint8_t MAX_PINNED_BLOCKS = 16;
+    //! Time in microseconds that process() leaves flash alone after a read
+    static const uint32_t READ_HOLD_US = 1000;
+
+private:
+    //! Header at the start of each sector in use
+    struct SectorHeader
+    {
+        uint32_t magic;
+        //! Order in which sectors were opened
+        uint32_t sequence;
+        //! Number of times this sector has been erased
+        uint32_t eraseCount;
+        uint32_t check;
+    };
+
+    //! Header of each committed slot
+    struct SlotHeader
+    {
+        uint16_t blockNum;
+        uint16_t blockNumInv;
+        //! Order in which blocks were written
+        uint32_t sequence;
+        //! Hash of the slot's block data
+        uint32_t dataHash;
+        uint32_t check;
+    };
+
+    //! @returns the flash offset of the given sector
+    uint32_t sectorToFlashByte(uint16_t sector) const;
+
+    //! @returns the flash offset of the data of the given slot location
+    uint32_t slotDataFlashByte(uint16_t location) const;
+
+    //! @returns the slot header of the given slot location as it is in flash
+    const SlotHeader* readSlotHeader(uint16_t location);
+
+    //! @returns true iff the given slot header and data are valid
+    bool isSlotValid(uint16_t location, uint16_t& blockNum, uint32_t& sequence);
+
+    //! @returns true iff the sector header in flash is valid
+    bool readSectorHeader(uint16_t sector, SectorHeader& header);
+
+    //! Restores state from flash
+    void scan();
+
+    //! Restores the index and the head from flash once the head sector is found
+    //! @param[in] sectorValid  true for each sector with a valid header
+    //! @param[in] sectorSequences  Sequence number of each sector with a valid header
+    void scanLog(const std::vector<bool>& sectorValid,
+                 const std::vector<uint32_t>& sectorSequences);
+
+    //! @returns where the given block currently is, which is in the cache if written and not yet
+    //!          committed, then the log, then initial image, then mErasedBlock if never written
+    //! @param[out] inFlash  Set to true iff the returned pointer is into flash
+    const uint8_t* locateBlock(uint16_t blockNum, bool& inFlash);
+
+    //! @returns the index into mCachedBlocks holding the given block or NO_ENTRY
+    uint8_t findCacheEntry(uint16_t blockNum);
+
+    //! Puts a block into the cache, copying it from where it currently is when copy is set
+    //! @returns the index into mCachedBlocks now holding the block or NO_ENTRY if not possible now
+    uint8_t loadCacheEntry(uint16_t blockNum, bool copy);
+
+    //! Marks the given block as committed at the given location
+    void setCommitted(uint16_t blockNum, uint16_t location);
+
+    //! @returns true iff there is room to append a block, keeping a sector in reserve unless
+    //!          the append is for garbage collection
+    bool canAppend(bool forGc) const;
+
+    //! Erases (if needed) and opens the sector after the head
+    void openNextSector();
+
+    //! Appends the block held in mBlockBuffer to the head of the log
+    //! @returns the location that the block was written to
+    uint16_t appendBlock(uint16_t blockNum);
+
+    //! Relocates one live block from the tail or releases the tail once nothing is live in it
+    void collectGarbage();
+
+    //! Commits the next dirty block
+    //! @returns true iff something was done
+    bool commitNextBlock();
+
+    //! @returns true iff len bytes at data are all 0xFF
+    static bool isErased(const uint8_t* data, uint32_t len);
+
+    //! @returns FNV-1a hash of data
+    static uint32_t hash(const uint8_t* data, uint32_t len, uint32_t h = 2166136261UL);
+
+    //! @returns the check word of a sector header
+    static uint32_t sectorCheck(const SectorHeader& header);
+
+    //! @returns the check word of a slot header
+    static uint32_t slotCheck(const SlotHeader& header);
+
+private:
+    //! Value of the magic word in each sector header
+    static const uint32_t SECTOR_MAGIC = 0x564D554C;
+    //! Number of bytes in a sector
+    static const uint32_t SECTOR_SIZE = FlashInterface::SECTOR_SIZE;
+    //! Page size in bytes
+    static const uint32_t PAGE_SIZE = FlashInterface::PAGE_SIZE;
+    //! Number of free sectors below which garbage collection starts
+    static const uint16_t GC_START_FREE_SECTORS = 4;
+    //! Value for an unknown sector
+    static const uint16_t NO_SECTOR = 0xFFFF;
+    //! Value in mIndex for a block which has never been committed
+    static const uint16_t NO_LOCATION = 0xFFFF;
+    //! Value for no block
+    static const uint16_t NO_BLOCK = 0xFFFF;
+    //! Value for no cache entry
+    static const uint8_t NO_ENTRY = 0xFF;
+    //! Number of cache entries; pinned blocks follow the NUM_CACHED_BLOCKS entries
+    static const uint8_t NUM_CACHE_ENTRIES = NUM_CACHED_BLOCKS + MAX_PINNED_BLOCKS;
+    //! The flash to store memory in
+    FlashInterface& mFlash;
+    //! Mutex to serialize write() and flash programming
+    MutexInterface& mMutex;
+    //! Clock used for activity time
+    ClockInterface& mClock;
+    //! Offset of the log region in flash
+    const uint32_t mOffset;
+    //! Number of sectors in the log region
+    const uint16_t mNumSectors;
+    //! Number of bytes in memory
+    const uint32_t mSize;
+    //! Number of blocks in memory
+    const uint16_t mNumBlocks;
+    //! Memory previously mapped 1:1 or nullptr
+    const uint8_t* const mInitialImage;
+    //! Number of blocks at the end of memory which are always held in RAM
+    const uint8_t mNumPinnedBlocks;
+    //! Number of entries in use in mCachedBlocks
+    const uint8_t mNumCacheEntries;
+    //! Bit for each block written by write() or found only in mInitialImage and not yet committed
+    std::unique_ptr<uint32_t[]> mDirtyBlocks;
+    //! Block held by each cache entry or NO_BLOCK if the entry is free
+    uint16_t mCachedBlocks[NUM_CACHE_ENTRIES];
+    //! Data of each cache entry
+    uint8_t mCacheData[NUM_CACHE_ENTRIES][BLOCK_SIZE];
+    //! What a block which was never written reads as
+    uint8_t mErasedBlock[BLOCK_SIZE];
+    //! Slot location (sector * SLOTS_PER_SECTOR + slot) of the newest copy of each block
+    std::unique_ptr<uint16_t[]> mIndex;
+    //! Erase count of each sector
+    std::unique_ptr<uint32_t[]> mEraseCounts;
+    //! Copy of the block being appended, so that write() may continue while flash is busy
+    uint8_t mBlockBuffer[BLOCK_SIZE];
+    //! Page buffer used to program headers
+    uint8_t mPageBuffer[PAGE_SIZE];
+    //! The sector being appended to or NO_SECTOR when the log is empty
+    uint16_t mHead;
+    //! Next free slot in mHead
+    uint16_t mHeadSlot;
+    //! The oldest sector of the log
+    uint16_t mTail;
+    //! Next slot of mTail to check during garbage collection
+    uint16_t mGcSlot;
+    //! Sequence number of the head sector
+    uint32_t mSectorSequence;
+    //! Sequence number to give the next appended block
+    uint32_t mNextBlockSequence;
+    //! Block to start looking for dirty blocks from
+    uint16_t mNextDirtyBlock;
+    //! True while process() is erasing or programming flash
+    bool mFlashBusy;
+    //! Last system time that a pointer into flash was returned by read()
+    uint64_t mLastReadTime;
+    //! Last system time of read/write activity
+    uint64_t mLastActivityTime;
+};
@@ -25,30 +25,52 @@
 
 #include "hal/System/LockGuard.hpp"
 
-#include "hardware/flash.h"
-#include "pico/stdlib.h"
-
 #include <assert.h>
 #include <string.h>
-#include <algorithm>
-
 
-NonVolatilePicoSystemMemory::NonVolatilePicoSystemMemory(uint32_t flashOffset, uint32_t size) :
+NonVolatilePicoSystemMemory::NonVolatilePicoSystemMemory(FlashInterface& flash,
+                                                         MutexInterface& mutex,
+                                                         ClockInterface& clock,
+                                                         uint32_t flashOffset,
+                                                         uint32_t size,
+                                                         uint32_t pinnedSize) :
     SystemMemory(),
+    mFlash(flash),
+    mMutex(mutex),
+    mClock(clock),
     mOffset(flashOffset),
     mSize(size),
-    mLocalMem(size),
-    mMutex(),
-    mProgrammingState(ProgrammingState::WAITING_FOR_JOB),
-    mSectorQueue(),
+    mNumSectors(size / SECTOR_SIZE),
+    mNumPinnedSectors((pinnedSize + SECTOR_SIZE - 1) / SECTOR_SIZE),
+    mNumCacheEntries(NUM_CACHED_SECTORS + mNumPinnedSectors),
+    mCache(),
+    mCacheData(),
+    mSectorBuffer(),
+    mFlashBusy(false),
+    mLastReadTime(0),
+    mLastWrittenSector(NO_SECTOR),
     mDelayedWriteTime(0),
     mLastActivityTime(0)
 {
     assert(flashOffset % SECTOR_SIZE == 0);
+    assert(size % SECTOR_SIZE == 0);
+    assert(mNumPinnedSectors <= MAX_PINNED_SECTORS && mNumPinnedSectors <= mNumSectors);
+    static_assert(PAGES_PER_SECTOR <= 16, "Dirty page mask must fit a sector's pages");
+
+    for (uint8_t i = 0; i < NUM_CACHED_SECTORS; ++i)
+    {
+        mCache[i].sector = NO_SECTOR;
+        mCache[i].dirtyPages = 0;
+    }
 
-    // Copy all of flash into volatile memory
-    const uint8_t* const readFlash = (const uint8_t *)(XIP_BASE + mOffset);
-    mLocalMem.write(0, readFlash, size);
+    // Pinned sectors stay in the cache for good
+    for (uint8_t i = 0; i < mNumPinnedSectors; ++i)
+    {
+        const uint8_t entry = NUM_CACHED_SECTORS + i;
+        mCache[entry].sector = mNumSectors - mNumPinnedSectors + i;
+        mCache[entry].dirtyPages = 0;
+        memcpy(mCacheData[entry], mFlash.read(sectorToFlashByte(mCache[entry].sector)), SECTOR_SIZE);
+    }
 }
 
 uint32_t NonVolatilePicoSystemMemory::getMemorySize()
@@ -58,10 +80,33 @@ uint32_t NonVolatilePicoSystemMemory::getMemorySize()
 
 const uint8_t* NonVolatilePicoSystemMemory::read(uint32_t offset, uint32_t& size)
 {
-    mLastActivityTime = time_us_64();
-    // A copy of memory is kept in RAM because nothing can be read from flash while erase is
-    // processing which takes way too long for this to return within 500 microseconds
-    return mLocalMem.read(offset, size);
+    LockGuard lock(mMutex, true);
+
+    mLastActivityTime = mClock.getTimeUs();
+    if (offset >= mSize)
+    {
+        size = 0;
+        return nullptr;
+    }
+    // The cache and flash are only contiguous within a sector
+    uint32_t max = SECTOR_SIZE - (offset % SECTOR_SIZE);
+    size = (max >= size) ? size : max;
+
+    const uint16_t sector = offset / SECTOR_SIZE;
+    uint8_t entry = findCacheEntry(sector);
+    if (entry != NO_ENTRY)
+    {
+        return &mCacheData[entry][offset % SECTOR_SIZE];
+    }
+    else if (mFlashBusy)
+    {
+        // Nothing can be read from flash while it's being erased or programmed
+        size = 0;
+        return nullptr;
+    }
+
+    mLastReadTime = mLastActivityTime;
+    return mFlash.read(mOffset + offset);
 }
 
 bool NonVolatilePicoSystemMemory::write(uint32_t offset, const void* data, uint32_t& size)
@@ -69,44 +114,67 @@ bool NonVolatilePicoSystemMemory::write(uint32_t offset, const void* data, uint3
     // This entire function is serialized with process()
     LockGuard lock(mMutex, true);
 
-    mLastActivityTime = time_us_64();
+    mLastActivityTime = mClock.getTimeUs();
 
-    // First, store this data into local RAM
-    bool success = mLocalMem.write(offset, data, size);
+    bool success = true;
+    if (offset >= mSize)
+    {
+        size = 0;
+        success = false;
+    }
+    else if (size > (mSize - offset))
+    {
+        size = mSize - offset;
+        success = false;
+    }
 
-    if (size > 0)
+    // Store this data into the cache, only marking pages which actually changed
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    uint32_t pos = offset;
+    const uint32_t end = offset + size;
+    while (pos < end)
     {
-        uint16_t firstSector = offset / SECTOR_SIZE;
-        uint16_t lastSector = (offset + size - 1) / SECTOR_SIZE;
-        bool delayWrite = false;
-        bool itemAdded = false;
-        for (uint32_t i = firstSector; i <= lastSector; ++i)
+        uint32_t pageEnd = (pos / PAGE_SIZE + 1) * PAGE_SIZE;
+        uint32_t len = ((pageEnd < end) ? pageEnd : end) - pos;
+        const uint16_t sector = pos / SECTOR_SIZE;
+        uint8_t entry = findCacheEntry(sector);
+        if (entry == NO_ENTRY)
         {
-            std::list<uint16_t>::iterator it =
-                std::find(mSectorQueue.begin(), mSectorQueue.end(), i);
-
-            if (it == mSectorQueue.end())
+            if (!mFlashBusy && memcmp(mFlash.read(mOffset + pos), in, len) == 0)
             {
-                // Add this sector
-                mSectorQueue.push_back(i);
-                itemAdded = true;
+                // Flash already holds this, so there is no need to cache anything
+                pos += len;
+                in += len;
+                continue;
             }
-            else if (it == mSectorQueue.begin())
+
+            entry = loadCacheEntry(sector);
+            if (entry == NO_ENTRY)
             {
-                // Currently processing this sector - delay write even further
-                delayWrite = true;
+                // Not able to take on any more right now
+                size = pos - offset;
+                success = false;
+                break;
             }
         }
 
-        if (itemAdded)
-        {
-            // No longer need to delay write because caller moved on to another sector
-            mDelayedWriteTime = 0;
-        }
-        else if (delayWrite)
+        uint8_t* cached = &mCacheData[entry][pos % SECTOR_SIZE];
+        if (memcmp(cached, in, len) != 0)
         {
-            setWriteDelay();
+            memcpy(cached, in, len);
+            uint32_t page = (pos % SECTOR_SIZE) / PAGE_SIZE;
+            mCache[entry].dirtyPages |= (1 << page);
         }
+        pos += len;
+        in += len;
+    }
+
+    if (size > 0)
+    {
+        // Commit of the last sector written is delayed in case more writes come in for it, but any
+        // other sector with pending writes may be committed right away since the writer moved on
+        mLastWrittenSector = (offset + size - 1) / SECTOR_SIZE;
+        mDelayedWriteTime = mLastActivityTime + WRITE_DELAY_US;
     }
 
     return success;
@@ -120,75 +188,106 @@ uint64_t NonVolatilePicoSystemMemory::getLastActivityTime()
 
 void NonVolatilePicoSystemMemory::process()
 {
-    mMutex.lock();
-    bool unlock = true;
+    uint8_t entry = NO_ENTRY;
+    uint16_t sector = NO_SECTOR;
+    uint16_t dirtyPages = 0;
 
-    switch (mProgrammingState)
     {
-        case ProgrammingState::WAITING_FOR_JOB:
+        LockGuard lock(mMutex, true);
+
+        uint64_t currentTimeUs = mClock.getTimeUs();
+        if (currentTimeUs < mLastReadTime + READ_HOLD_US)
+        {
+            // Whoever last read may still be copying out of flash
+            return;
+        }
+
+        for (uint8_t i = 0; i < mNumCacheEntries; ++i)
         {
-            if (!mSectorQueue.empty())
+            if (mCache[i].dirtyPages != 0
+                && (mCache[i].sector != mLastWrittenSector || currentTimeUs >= mDelayedWriteTime))
             {
-                uint16_t sector = *mSectorQueue.begin();
-                uint32_t flashByte = sectorToFlashByte(sector);
-
-                mLastActivityTime = time_us_64();
-                setWriteDelay();
-                mProgrammingState = ProgrammingState::SECTOR_ERASING;
-
-                // flash_range_erase blocks until erase is complete, so don't hold the lock
-                // TODO: It should be possible to execute a non-blocking erase command then
-                //       periodically check status within SECTOR_ERASING state until complete.
-                //       It's not that important at the moment because this is the only process
-                //       running in core 1.
-                mMutex.unlock();
-                unlock = false;
-                flash_range_erase(flashByte, SECTOR_SIZE);
+                entry = i;
+                break;
             }
         }
-        break;
 
-        case ProgrammingState::SECTOR_ERASING:
+        if (entry == NO_ENTRY)
         {
-            // Nothing to do in this state
-            mProgrammingState = ProgrammingState::DELAYING_WRITE;
+            return;
         }
-        // Fall through
 
-        case ProgrammingState::DELAYING_WRITE:
-        {
-            mLastActivityTime = time_us_64();
-            // Write is delayed until the host moves on to writing another sector or if timeout
-            // is reached. This helps ensure that the same sector isn't written multiple times.
-            if (time_us_64() >= mDelayedWriteTime)
-            {
-                uint16_t sector = *mSectorQueue.begin();
-                uint32_t localByte = sector * SECTOR_SIZE;
-                uint32_t size = SECTOR_SIZE;
-                const uint8_t* mem = mLocalMem.read(localByte, size);
+        // Take a snapshot so that the lock doesn't need to be held while flash is busy; anything
+        // written to this sector from here on will mark it dirty again
+        sector = mCache[entry].sector;
+        dirtyPages = mCache[entry].dirtyPages;
+        mCache[entry].dirtyPages = 0;
+        memcpy(mSectorBuffer, mCacheData[entry], SECTOR_SIZE);
+        mLastActivityTime = currentTimeUs;
+        mFlashBusy = true;
+    }
 
-                assert(mem != nullptr);
+    // Erase and program block until complete, so don't hold the lock
+    // TODO: It should be possible to execute a non-blocking erase command then periodically check
+    //       status until complete. It's not that important at the moment because this is the only
+    //       process running in core 1.
+    commitSector(sector, dirtyPages);
 
-                uint32_t flashByte = sectorToFlashByte(sector);
-                flash_range_program(flashByte, mem, SECTOR_SIZE);
+    {
+        LockGuard lock(mMutex, true);
+        mFlashBusy = false;
+        if (mCache[entry].dirtyPages == 0 && entry < NUM_CACHED_SECTORS)
+        {
+            // Flash now holds what's cached, so reads may go back to flash
+            mCache[entry].sector = NO_SECTOR;
+        }
+    }
+}
 
-                mSectorQueue.pop_front();
-                mProgrammingState = ProgrammingState::WAITING_FOR_JOB;
-            }
+bool NonVolatilePicoSystemMemory::isCommitPending()
+{
+    LockGuard lock(mMutex, true);
+    for (uint8_t i = 0; i < mNumCacheEntries; ++i)
+    {
+        if (mCache[i].dirtyPages != 0)
+        {
+            return true;
         }
-        break;
+    }
+    return false;
+}
 
-        default:
+uint8_t NonVolatilePicoSystemMemory::findCacheEntry(uint16_t sector)
+{
+    for (uint8_t i = 0; i < mNumCacheEntries; ++i)
+    {
+        if (mCache[i].sector == sector)
         {
-            assert(false);
+            return i;
         }
-        break;
     }
+    return NO_ENTRY;
+}
 
-    if (unlock)
+uint8_t NonVolatilePicoSystemMemory::loadCacheEntry(uint16_t sector)
+{
+    if (mFlashBusy)
     {
-        mMutex.unlock();
+        // Can't copy from flash right now
+        return NO_ENTRY;
     }
+
+    for (uint8_t i = 0; i < NUM_CACHED_SECTORS; ++i)
+    {
+        if (mCache[i].sector == NO_SECTOR)
+        {
+            mCache[i].sector = sector;
+            mCache[i].dirtyPages = 0;
+            memcpy(mCacheData[i], mFlash.read(sectorToFlashByte(sector)), SECTOR_SIZE);
+            return i;
+        }
+    }
+    return NO_ENTRY;
 }
 
 uint32_t NonVolatilePicoSystemMemory::sectorToFlashByte(uint16_t sector)
@@ -196,7 +295,71 @@ uint32_t NonVolatilePicoSystemMemory::sectorToFlashByte(uint16_t sector)
     return mOffset + (sector * SECTOR_SIZE);
 }
 
-void NonVolatilePicoSystemMemory::setWriteDelay()
+void NonVolatilePicoSystemMemory::commitSector(uint16_t sector, uint16_t dirtyPages)
 {
-    mDelayedWriteTime = time_us_64() + WRITE_DELAY_US;
+    const uint32_t flashByte = sectorToFlashByte(sector);
+    const uint8_t* flash = mFlash.read(flashByte);
+
+    // Compare against flash before touching it
+    uint16_t changedPages = 0;
+    bool eraseNeeded = false;
+    for (uint32_t page = 0; page < PAGES_PER_SECTOR; ++page)
+    {
+        const uint32_t pageOffset = page * PAGE_SIZE;
+        if ((dirtyPages & (1 << page)) != 0
+            && memcmp(&flash[pageOffset], &mSectorBuffer[pageOffset], PAGE_SIZE) != 0)
+        {
+            changedPages |= (1 << page);
+            if (!isProgrammable(&flash[pageOffset], &mSectorBuffer[pageOffset]))
+            {
+                eraseNeeded = true;
+            }
+        }
+    }
+
+    if (changedPages == 0)
+    {
+        // Data was set back to what flash already holds
+        return;
+    }
+
+    if (eraseNeeded)
+    {
+        mFlash.eraseSector(flashByte);
+    }
+
+    for (uint32_t page = 0; page < PAGES_PER_SECTOR; ++page)
+    {
+        const uint32_t pageOffset = page * PAGE_SIZE;
+        // After erase, every page that isn't blank needs to be programmed again
+        if (eraseNeeded ? !isErased(&mSectorBuffer[pageOffset]) : ((changedPages & (1 << page)) != 0))
+        {
+            mFlash.programPage(flashByte + pageOffset, &mSectorBuffer[pageOffset]);
+        }
+    }
+}
+
+bool NonVolatilePicoSystemMemory::isProgrammable(const uint8_t* flash, const uint8_t* data)
+{
+    for (uint32_t i = 0; i < PAGE_SIZE; ++i)
+    {
+        // Programming can only flip a 1 to a 0
+        if ((flash[i] & data[i]) != data[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool NonVolatilePicoSystemMemory::isErased(const uint8_t* data)
+{
+    for (uint32_t i = 0; i < PAGE_SIZE; ++i)
+    {
+        if (data[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
 }
@@ -24,11 +24,10 @@
 #pragma once
 
 #include "hal/System/SystemMemory.hpp"
-#include "VolatileSystemMemory.hpp"
-#include "Mutex.hpp"
+#include "hal/System/FlashInterface.hpp"
+#include "hal/System/MutexInterface.hpp"
+#include "hal/System/ClockInterface.hpp"
 
-#include <memory>
-#include <list>
 
 // The Raspberry Pi Pico uses an external flash chip, the W25Q16JV, to store code. There are some
 // limitations which make it difficult to use as storage space.
@@ -43,11 +42,21 @@
 // code from RAM while accessing the flash in code. The time that it takes to erase memory also puts
 // a damper on things. The only way that I could think to make this work is to enable copy_to_ram
 // for the executable so that the entire program loads into RAM before executing. Then the second
-// core can be used to do erase and write in the background. Because nothing can be read from flash
-// while erase is executing, a copy of memory is also stored in RAM so that read() returns quickly.
-// Ultimately, this limits program size up to 128 KB (assuming 128 KB in RAM is used for
-// the local copy of non-volatile memory). That size of course becomes more limited the more RAM is
-// used for the program itself.
+// core can be used to do erase and write in the background.
+
+// Reads are served straight out of the XIP mapped flash, so memory costs no RAM and nothing needs
+// to be copied at boot. Only sectors with written data that isn't committed yet are held in a small
+// write-back cache in RAM. Because nothing can be read from flash while it is being erased or
+// programmed, read() fails for sectors which aren't cached while process() has flash busy. The
+// caller is expected to copy data out right away, and process() won't start on flash until
+// READ_HOLD_US after the last read. The sectors at the end of memory, which hold the VMU's media
+// info, FAT, and directory, may be pinned in the cache so that they can always be read; these are
+// what the console reads most, including in the middle of a save.
+
+// To keep both save latency and flash wear down, only the 256 byte pages which were written are
+// considered when a sector is committed. Pages which still match flash are skipped, and the sector
+// is only erased when a page needs a bit flipped from "0" to "1". Otherwise, just the changed pages
+// are programmed over what's already there.
 
 //! SystemMemory class using Pico's onboard flash
 //! In order for this to work properly, entire program must be running from RAM. No other component
@@ -58,35 +67,38 @@
 class NonVolatilePicoSystemMemory : public SystemMemory
 {
 public:
-    //! Flash memory write states
-    enum class ProgrammingState
-    {
-        //! Waiting for write()
-        WAITING_FOR_JOB = 0,
-        //! Sector erase sent, waiting for erase to complete
-        SECTOR_ERASING,
-        //! Delaying write to erased sector in case more writes come in for same sector
-        DELAYING_WRITE,
-    };
-
     //! Constructor
+    //! @param[in] flash  The flash to store memory in
+    //! @param[in] mutex  Mutex used to serialize write() and flash programming
+    //! @param[in] clock  Clock used to time write back
     //! @param[in] flashOffset  Offset into flash, must align to SECTOR_SIZE
-    //! @param[in] size  Number of bytes to allow read/write
-    NonVolatilePicoSystemMemory(uint32_t flashOffset, uint32_t size);
+    //! @param[in] size  Number of bytes to allow read/write, must be a multiple of SECTOR_SIZE
+    //! @param[in] pinnedSize  Number of bytes at the end of memory to always hold in RAM so that
+    //!                        they may be read while flash is busy; rounded up to whole sectors,
+    //!                        which may be no more than MAX_PINNED_SECTORS
+    NonVolatilePicoSystemMemory(FlashInterface& flash,
+                                MutexInterface& mutex,
+                                ClockInterface& clock,
+                                uint32_t flashOffset,
+                                uint32_t size,
+                                uint32_t pinnedSize = 0);
 
     //! @returns number of bytes reserved in memory
     virtual uint32_t getMemorySize() final;
 
     //! Reads from memory - must return within 500 microseconds
     //! @param[in] offset  Offset into memory in bytes
-    //! @param[in,out] size  Number of bytes to read, set with the number of bytes read
+    //! @param[in,out] size  Number of bytes to read, set with the number of bytes read (a read
+    //!                      never crosses a sector boundary and fails while flash is busy unless
+    //!                      the sector is cached or pinned)
     //! @returns a pointer containing the number of bytes returned in size
     virtual const uint8_t* read(uint32_t offset, uint32_t& size) final;
 
     //! Writes to memory - must return within 500 microseconds
     //! @param[in] offset  Offset into memory in bytes
     //! @param[in] data  The data to write
-    //! @param[in,out] size  Number of bytes to write, set with number of bytes written
+    //! @param[in,out] size  Number of bytes to write, set with number of bytes written (fewer are
+    //!                      written when the cache is full)
     //! @returns true iff all bytes were written or at least queued for write
     virtual bool write(uint32_t offset, const void* data, uint32_t& size) final;
 
@@ -94,38 +106,99 @@ public:
     //! @returns the time of last read/write activity
     virtual uint64_t getLastActivityTime() final;
 
-    //! Must be called to periodically process flash access
+    //! Must be called to periodically process flash access; commits at most 1 sector per call
     //! @warning this may block for up to 400 ms
     void process();
 
+    //! @returns true iff any written data is waiting to be committed to flash
+    bool isCommitPending();
+
+public:
+    //! Number of sectors which may be held in RAM waiting to be committed
+    static const uint8_t NUM_CACHED_SECTORS = 4;
+    //! Maximum number of sectors which may be pinned in RAM
+    static const uint8_t MAX_PINNED_SECTORS = 2;
+    //! Time in microseconds that process() leaves flash alone after a read
+    static const uint32_t READ_HOLD_US = 1000;
+
 private:
+    //! A sector held in RAM
+    struct CacheEntry
+    {
+        //! Local index of the sector or NO_SECTOR if the entry is free
+        uint16_t sector;
+        //! A bit for each page which was changed by write() and not yet committed
+        uint16_t dirtyPages;
+    };
+
+    //! @returns the index into mCache holding the given sector or NO_ENTRY
+    uint8_t findCacheEntry(uint16_t sector);
+
+    //! Puts a sector into the cache, copying it from flash
+    //! @returns the index into mCache now holding the sector or NO_ENTRY if that isn't possible now
+    uint8_t loadCacheEntry(uint16_t sector);
+
     //! Converts a local sector index to flash byte offset
     uint32_t sectorToFlashByte(uint16_t sector);
 
-    //! Set the write delay using the current time
-    void setWriteDelay();
+    //! Writes the sector held in mSectorBuffer to flash
+    //! @param[in] sector  Local index of the sector
+    //! @param[in] dirtyPages  Bit mask of the pages within the sector which were written
+    void commitSector(uint16_t sector, uint16_t dirtyPages);
+
+    //! @param[in] flash  Current contents of a page in flash
+    //! @param[in] data  Data to put in the page
+    //! @returns true iff data may be programmed over flash without erasing first
+    static bool isProgrammable(const uint8_t* flash, const uint8_t* data);
+
+    //! @param[in] data  Page data
+    //! @returns true iff the page is all 0xFF, which is what erase leaves behind
+    static bool isErased(const uint8_t* data);
 
 private:
     //! Number of bytes in a sector
-    static const uint32_t SECTOR_SIZE = 4096;
+    static const uint32_t SECTOR_SIZE = FlashInterface::SECTOR_SIZE;
     //! Page size in bytes
-    static const uint32_t PAGE_SIZE = 256;
+    static const uint32_t PAGE_SIZE = FlashInterface::PAGE_SIZE;
+    //! Number of pages in each sector (one bit per page in mDirtyPages)
+    static const uint32_t PAGES_PER_SECTOR = SECTOR_SIZE / PAGE_SIZE;
     //! How long to delay before committing to the last sector write
     static const uint32_t WRITE_DELAY_US = 200000;
+    //! Value for no sector
+    static const uint16_t NO_SECTOR = 0xFFFF;
+    //! Value for no cache entry
+    static const uint8_t NO_ENTRY = 0xFF;
+    //! Number of cache entries; pinned sectors follow the NUM_CACHED_SECTORS entries
+    static const uint8_t NUM_CACHE_ENTRIES = NUM_CACHED_SECTORS + MAX_PINNED_SECTORS;
+    //! The flash to store memory in
+    FlashInterface& mFlash;
+    //! Mutex to serialize write() and flash programming
+    MutexInterface& mMutex;
+    //! Clock used to time write back
+    ClockInterface& mClock;
     //! Flash memory offset
     const uint32_t mOffset;
     //! Number of bytes in volatile memory
     const uint32_t mSize;
-    //! Because erase takes so long which prevents read, the entire flash range is copied locally
-    VolatileSystemMemory mLocalMem;
-    //! Mutex to serialize write() and flash programming
-    Mutex mMutex;
-    //! Keeps track of the state in process()
-    ProgrammingState mProgrammingState;
-    //! Queue of sectors which needs to be written to flash
-    std::list<uint16_t> mSectorQueue;
-    //! The time at which write should execute after erase has completed
-    //! (or 0 to execute on next process())
+    //! Number of sectors in memory
+    const uint16_t mNumSectors;
+    //! Number of sectors at the end of memory which are always held in RAM
+    const uint8_t mNumPinnedSectors;
+    //! Number of entries in use in mCache
+    const uint8_t mNumCacheEntries;
+    //! Sectors held in RAM
+    CacheEntry mCache[NUM_CACHE_ENTRIES];
+    //! Data of each sector held in RAM
+    uint8_t mCacheData[NUM_CACHE_ENTRIES][SECTOR_SIZE];
+    //! Copy of the sector being committed, so that write() may continue while flash is busy
+    uint8_t mSectorBuffer[SECTOR_SIZE];
+    //! True while process() is erasing or programming flash
+    bool mFlashBusy;
+    //! Last system time that a pointer into flash was returned by read()
+    uint64_t mLastReadTime;
+    //! The sector which was last written; its commit is delayed in case more writes come in
+    uint16_t mLastWrittenSector;
+    //! The time at which mLastWrittenSector may be committed
     uint64_t mDelayedWriteTime;
     //! Last system time of read/write activity
     uint64_t mLastActivityTime;
@@ -0,0 +1,42 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef __PICO_FLASH_H__
+#define __PICO_FLASH_H__
+
+#include "hal/System/FlashInterface.hpp"
+
+//! Access to the Pico's onboard flash
+//! @warning nothing may execute from flash while erasing or programming; see
+//!          NonVolatilePicoSystemMemory for how this is handled
+class PicoFlash : public FlashInterface
+{
+    public:
+        virtual const uint8_t* read(uint32_t offset) final;
+
+        virtual void eraseSector(uint32_t offset) final;
+
+        virtual void programPage(uint32_t offset, const uint8_t* data) final;
+};
+
+#endif // __PICO_FLASH_H__
@@ -23,6 +23,7 @@
 
 #include "UsbCdcTtyParser.hpp"
 #include "hal/System/LockGuard.hpp"
+#include "hal/Usb/CdcFrame.hpp"
 
 #include <limits>
 #include <string.h>
@@ -34,14 +35,28 @@ const char* UsbCdcTtyParser::INPUT_EOL_CHARS = "\r\n";
 const char UsbCdcTtyParser::RX_EOL_CHAR = '\n';
 const char* UsbCdcTtyParser::BACKSPACE_CHARS = "\x08\x7F";
 
-UsbCdcTtyParser::UsbCdcTtyParser(MutexInterface& m, char helpChar) :
-    mParserRx(),
+UsbCdcTtyParser::UsbCdcTtyParser(MutexInterface& m,
+                                 char helpChar,
+                                 ClockInterface& clock,
+                                 ModeChangeFn modeChangeFn) :
+    mRx(),
+    mWriteIdx(0),
+    mRxHead(0),
+    mRxTail(0),
+    mLineEnds(),
+    mLineHead(0),
+    mLineTail(0),
+    mIncompleteHead(0),
     mLastIsEol(false),
     mParserMutex(m),
-    mCommandReady(false),
     mHelpChar(helpChar),
+    mClock(clock),
+    mProcessBudgetUs(DEFAULT_PROCESS_BUDGET_US),
     mParsers(),
-    mOverflowDetected(false)
+    mOverflowDetected(false),
+    mBinaryMode(false),
+    mTextModeRequested(false),
+    mModeChangeFn(modeChangeFn)
 {}
 
 void UsbCdcTtyParser::addCommandParser(std::shared_ptr<CommandParser> parser)
@@ -51,21 +66,35 @@ void UsbCdcTtyParser::addCommandParser(std::shared_ptr<CommandParser> parser)
 
 void UsbCdcTtyParser::addChars(const char* chars, uint32_t len)
 {
-    // Entire function is locked
+    // Entire function is locked so that process() may safely reset everything on mode change
     LockGuard lockGuard(mParserMutex);
 
-    // Reserve space for new characters
-    uint32_t newCapacity = mParserRx.size() + len;
-    if (newCapacity > MAX_QUEUE_SIZE)
+    uint32_t tail = mRxTail.load(std::memory_order_acquire);
+
+    if (mBinaryMode)
     {
-        newCapacity = MAX_QUEUE_SIZE;
+        // No character processing in binary mode; anything beyond capacity is dropped, and the
+        // frame it belonged to will fail its CRC check
+        uint32_t numFree = RX_BUFFER_SIZE - (mWriteIdx - tail);
+        uint32_t numToAdd = (len > numFree) ? numFree : len;
+        for (uint32_t i = 0; i < numToAdd; ++i, ++chars)
+        {
+            pushChar(*chars);
+        }
+        mRxHead.store(mWriteIdx, std::memory_order_release);
+        return;
     }
-    mParserRx.reserve(newCapacity);
 
     for (uint32_t i = 0; i < len; ++i, ++chars)
     {
+        if ((mWriteIdx - tail) >= RX_BUFFER_SIZE)
+        {
+            // The consumer may have freed up some space since
+            tail = mRxTail.load(std::memory_order_acquire);
+        }
+
         // Flag overflow - next command will be ignored
-        if (mParserRx.size() >= MAX_QUEUE_SIZE && *chars != 0x08)
+        if ((mWriteIdx - tail) >= RX_BUFFER_SIZE && *chars != 0x08)
         {
             mOverflowDetected = true;
         }
@@ -74,20 +103,11 @@ void UsbCdcTtyParser::addChars(const char* chars, uint32_t len)
         {
             if (strchr(INPUT_EOL_CHARS, *chars) != NULL)
             {
-                printf("Error: Command input overflow %lu\n", (long unsigned int)mParserRx.size());
-                // Remove only command that overflowed
-                std::vector<char>::reverse_iterator lastEnd =
-                    std::find(mParserRx.rbegin(), mParserRx.rend(), RX_EOL_CHAR);
-                if (lastEnd == mParserRx.rend())
-                {
-                    mParserRx.clear();
-                }
-                else
-                {
-                    // We still captured a full command, so at least leave that for processing
-                    mParserRx.erase((lastEnd + 1).base(), mParserRx.end());
-                }
+                printf("Error: Command input overflow %lu\n", (long unsigned int)(mWriteIdx - tail));
+                // Remove only command that overflowed; complete commands are left for processing
+                mWriteIdx = mRxHead.load(std::memory_order_relaxed);
                 mOverflowDetected = false;
+                mLastIsEol = true;
             }
             else
             {
@@ -96,103 +116,320 @@ void UsbCdcTtyParser::addChars(const char* chars, uint32_t len)
         }
         else if (strchr(BACKSPACE_CHARS, *chars) != NULL)
         {
-            // Can't backspace before EOL character or if list is empty
-            if (!mLastIsEol && !mParserRx.empty())
+            // Can't backspace into a complete command
+            if (!mLastIsEol && mWriteIdx != mRxHead.load(std::memory_order_relaxed))
             {
                 // Backspace
-                mParserRx.pop_back();
+                --mWriteIdx;
             }
         }
         else if (strchr(INPUT_EOL_CHARS, *chars) != NULL)
         {
             if (!mLastIsEol)
             {
-                mCommandReady = true;
-                mParserRx.push_back(RX_EOL_CHAR);
+                uint32_t lineHead = mLineHead.load(std::memory_order_relaxed);
+                if ((lineHead - mLineTail.load(std::memory_order_acquire)) >= MAX_LINES)
+                {
+                    printf("Error: Command input overflow %lu\n", (long unsigned int)MAX_LINES);
+                    mWriteIdx = mRxHead.load(std::memory_order_relaxed);
+                }
+                else
+                {
+                    // Publish the command along with its EOL position
+                    mLineEnds[lineHead & (MAX_LINES - 1)] = mWriteIdx;
+                    pushChar(RX_EOL_CHAR);
+                    mRxHead.store(mWriteIdx, std::memory_order_release);
+                    mLineHead.store(lineHead + 1, std::memory_order_release);
+                }
                 mLastIsEol = true;
             }
         }
         else
         {
-            mParserRx.push_back(*chars);
+            pushChar(*chars);
             mLastIsEol = false;
         }
     }
 }
 
-void UsbCdcTtyParser::process()
+bool UsbCdcTtyParser::isBinaryMode() const
+{
+    return mBinaryMode;
+}
+
+void UsbCdcTtyParser::requestTextMode()
+{
+    mTextModeRequested = true;
+}
+
+void UsbCdcTtyParser::setProcessBudgetUs(uint32_t budgetUs)
+{
+    mProcessBudgetUs = budgetUs;
+}
+
+void UsbCdcTtyParser::clearRx()
+{
+    mRxHead.store(mWriteIdx, std::memory_order_relaxed);
+    mRxTail.store(mWriteIdx, std::memory_order_relaxed);
+    mLineTail.store(mLineHead.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    mIncompleteHead = mWriteIdx;
+    mLastIsEol = false;
+    mOverflowDetected = false;
+}
+
+void UsbCdcTtyParser::setBinaryMode(bool binaryMode)
 {
-    // Only do something if a command is ready
-    if (mCommandReady)
+    mBinaryMode = binaryMode;
+    if (mModeChangeFn != nullptr)
     {
-        // Begin lock guard context
-        LockGuard lockGuard(mParserMutex);
+        mModeChangeFn(binaryMode);
+    }
+}
 
-        // End of command is at the new line character
-        std::vector<char>::iterator eol =
-            std::find(mParserRx.begin(), mParserRx.end(), RX_EOL_CHAR);
+void UsbCdcTtyParser::printHelp()
+{
+    printf("HELP\n"
+           "Command structure: [whitespace]<command-char>[command]<\\n>\n"
+           "\n"
+           "COMMANDS:\n");
+    printf("%c: Prints this help\n", mHelpChar);
+    printf("%c%c: Switches to binary framed mode\n", MODE_CHAR, BINARY_MODE_CMD);
+    // Print help for all commands
+    for (std::vector<std::shared_ptr<CommandParser>>::iterator iter = mParsers.begin();
+        iter != mParsers.end();
+        ++iter)
+    {
+        (*iter)->printHelp();
+    }
+}
 
-        if (eol == mParserRx.end()
-            || std::find(eol + 1, mParserRx.end(), RX_EOL_CHAR) == mParserRx.end())
+void UsbCdcTtyParser::process()
+{
+    if (mTextModeRequested)
+    {
+        LockGuard lockGuard(mParserMutex);
+        mTextModeRequested = false;
+        if (mBinaryMode)
         {
-            // No further commands found
-            mCommandReady = false;
+            // Whatever is left is a partial frame from the previous connection
+            clearRx();
+            setBinaryMode(false);
         }
+    }
 
-        if (eol != mParserRx.end())
+    // Handle everything that is ready unless that takes too long; the rest is left for next time
+    uint64_t startUs = mClock.getTimeUs();
+    bool processed = false;
+    do
+    {
+        processed = mBinaryMode ? processBinary() : processText();
+    } while (processed && (mClock.getTimeUs() - startUs) < mProcessBudgetUs);
+}
+
+bool UsbCdcTtyParser::processBinary()
+{
+    uint32_t head = mRxHead.load(std::memory_order_acquire);
+    uint32_t tail = mRxTail.load(std::memory_order_relaxed);
+    if (tail == head || head == mIncompleteHead)
+    {
+        // Nothing new since last time
+        return false;
+    }
+
+    // Drop anything preceding the next sync byte
+    uint8_t* data = reinterpret_cast<uint8_t*>(rxAt(tail));
+    uint32_t len = head - tail;
+    const uint8_t* sync = static_cast<const uint8_t*>(memchr(data, CdcFrame::SYNC_BYTE, len));
+    uint32_t numSkipped = (sync == nullptr) ? len : (sync - data);
+    data += numSkipped;
+    len -= numSkipped;
+    tail += numSkipped;
+
+    CdcFrame::DecodeResult result = CdcFrame::DECODE_INCOMPLETE;
+    uint32_t frameLen = 0;
+    char cmd = '\0';
+    uint32_t dataOffset = 0;
+    uint32_t dataLen = 0;
+    if (len > 0)
+    {
+        result = CdcFrame::decode(data, len, frameLen, cmd, dataOffset, dataLen);
+    }
+
+    bool consumed = (numSkipped > 0);
+    switch (result)
+    {
+        case CdcFrame::DECODE_OK:
         {
-            // Just in case it gets parsed as a string, changed EOL to NULL
-            *eol = '\0';
-            // Move past whitespace characters
-            const char* ptr = &mParserRx[0];
-            uint32_t len = eol - mParserRx.begin();
-            while (len > 0 && strchr(WHITESPACE_CHARS, *ptr) != NULL)
+            processFrame(cmd, data + dataOffset, dataLen);
+            if (!mBinaryMode)
             {
-                --len;
-                ++ptr;
+                // Switched to text mode which already dropped everything
+                return true;
             }
+            tail += frameLen;
+            consumed = true;
+        }
+        break;
+
+        case CdcFrame::DECODE_INVALID:
+        {
+            // Resynchronize starting at the next sync byte
+            ++tail;
+            consumed = true;
+        }
+        break;
 
-            if (len > 0)
+        case CdcFrame::DECODE_INCOMPLETE: // Fall through
+        default:
+        {
+            // Wait for more data
+            mIncompleteHead = head;
+        }
+        break;
+    }
+
+    mRxTail.store(tail, std::memory_order_release);
+    return consumed;
+}
+
+void UsbCdcTtyParser::processFrame(char cmd, uint8_t* data, uint32_t len)
+{
+    bool isText = ((static_cast<uint8_t>(cmd) & CdcFrame::TEXT_FLAG) != 0);
+    cmd = static_cast<char>(static_cast<uint8_t>(cmd) & ~CdcFrame::TEXT_FLAG);
+
+    if (cmd == MODE_CHAR)
+    {
+        if (len == 1 && data[0] == TEXT_MODE_CMD)
+        {
+            // Acknowledge in binary before switching
+            const char ack = TEXT_MODE_CMD;
+            CdcFrame::write(MODE_CHAR, &ack, 1);
+            LockGuard lockGuard(mParserMutex);
+            // Anything else received was sent before the switch was acknowledged
+            clearRx();
+            setBinaryMode(false);
+        }
+        else if (len == 1 && data[0] == BINARY_MODE_CMD)
+        {
+            // Already in binary mode
+            const char ack = BINARY_MODE_CMD;
+            CdcFrame::write(MODE_CHAR, &ack, 1);
+        }
+        else
+        {
+            CdcFrame::writeString(MODE_CHAR, "Error: Invalid command");
+        }
+    }
+    else if (cmd == mHelpChar)
+    {
+        printHelp();
+    }
+    else
+    {
+        // Find command parser that can process this command
+        bool processed = false;
+        for (std::vector<std::shared_ptr<CommandParser>>::iterator iter = mParsers.begin();
+            iter != mParsers.end() && !processed;
+            ++iter)
+        {
+            if (cmd != '\0' && strchr((*iter)->getCommandChars(), cmd) != NULL)
             {
-                if (*ptr == mHelpChar)
+                if (isText)
                 {
-                    printf("HELP\n"
-                           "Command structure: [whitespace]<command-char>[command]<\\n>\n"
-                           "\n"
-                           "COMMANDS:\n");
-                    printf("%c: Prints this help\n", mHelpChar);
-                    // Print help for all commands
-                    for (std::vector<std::shared_ptr<CommandParser>>::iterator iter = mParsers.begin();
-                        iter != mParsers.end();
-                        ++iter)
-                    {
-                        (*iter)->printHelp();
-                    }
+                    // The command byte directly precedes the data, making up a text command once
+                    // the flag is cleared; the first CRC byte is no longer needed, so that is
+                    // replaced with a terminator
+                    *(data - 1) = static_cast<uint8_t>(cmd);
+                    data[len] = '\0';
+                    (*iter)->submit(reinterpret_cast<const char*>(data - 1), len + 1);
                 }
-                else
+                else if (!(*iter)->submitBinary(data, len))
                 {
-                    // Find command parser that can process this command
-                    bool processed = false;
-                    for (std::vector<std::shared_ptr<CommandParser>>::iterator iter = mParsers.begin();
-                        iter != mParsers.end() && !processed;
-                        ++iter)
-                    {
-                        if (strchr((*iter)->getCommandChars(), *ptr) != NULL)
-                        {
-                            (*iter)->submit(ptr, len);
-                            processed = true;
-                        }
-                    }
-
-                    if (!processed)
-                    {
-                        printf("Error: Invalid command\n");
-                    }
+                    CdcFrame::writeString(cmd, "Error: Binary data not supported");
                 }
+                processed = true;
             }
-            // Else: empty string - do nothing
+        }
 
-            mParserRx.erase(mParserRx.begin(), eol + 1);
+        if (!processed)
+        {
+            CdcFrame::writeString(MODE_CHAR, "Error: Invalid command");
         }
-    } // End lock guard context
+    }
+}
+
+bool UsbCdcTtyParser::processText()
+{
+    uint32_t lineTail = mLineTail.load(std::memory_order_relaxed);
+    if (lineTail == mLineHead.load(std::memory_order_acquire))
+    {
+        // No further commands found
+        return false;
+    }
+
+    // End of command is at the new line character, and the command is contiguous from the tail
+    uint32_t tail = mRxTail.load(std::memory_order_relaxed);
+    uint32_t eolPos = mLineEnds[lineTail & (MAX_LINES - 1)];
+    char* ptr = rxAt(tail);
+    uint32_t len = eolPos - tail;
+
+    // Just in case it gets parsed as a string, changed EOL to NULL
+    ptr[len] = '\0';
+    // Move past whitespace characters
+    while (len > 0 && strchr(WHITESPACE_CHARS, *ptr) != NULL)
+    {
+        --len;
+        ++ptr;
+    }
+
+    if (len > 0)
+    {
+        if (*ptr == mHelpChar)
+        {
+            printHelp();
+        }
+        else if (*ptr == MODE_CHAR)
+        {
+            if (len >= 2 && ptr[1] == BINARY_MODE_CMD)
+            {
+                LockGuard lockGuard(mParserMutex);
+                // Anything left in the queue was sent before the switch was acknowledged
+                clearRx();
+                setBinaryMode(true);
+                // Acknowledge with a frame so the host knows binary mode is supported
+                const char ack = BINARY_MODE_CMD;
+                CdcFrame::write(MODE_CHAR, &ack, 1);
+                return true;
+            }
+            else
+            {
+                printf("Error: Invalid command\n");
+            }
+        }
+        else
+        {
+            // Find command parser that can process this command
+            bool processed = false;
+            for (std::vector<std::shared_ptr<CommandParser>>::iterator iter = mParsers.begin();
+                iter != mParsers.end() && !processed;
+                ++iter)
+            {
+                if (strchr((*iter)->getCommandChars(), *ptr) != NULL)
+                {
+                    (*iter)->submit(ptr, len);
+                    processed = true;
+                }
+            }
+
+            if (!processed)
+            {
+                printf("Error: Invalid command\n");
+            }
+        }
+    }
+    // Else: empty string - do nothing
+
+    mRxTail.store(eolPos + 1, std::memory_order_release);
+    mLineTail.store(lineTail + 1, std::memory_order_release);
+    return true;
 }
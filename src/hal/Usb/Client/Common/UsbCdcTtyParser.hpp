@@ -29,27 +29,96 @@
 #include <atomic>
 
 #include "hal/System/MutexInterface.hpp"
+#include "hal/System/ClockInterface.hpp"
 #include "hal/Usb/TtyParser.hpp"
 #include "hal/Usb/CommandParser.hpp"
 
 // Command structure: [whitespace]<command-char>[command]<\n>
+// Sending the text command "#B" switches to binary mode where each command is instead a frame as
+// defined in CdcFrame.hpp; a '#' frame with data "T" (or closing the port) switches back to text.
 
 //! Command parser for processing commands from a TTY stream
+//! Received characters are held in a fixed size ring buffer. addChars() is the only producer and
+//! process() is the only consumer; the mutex only serializes addChars() with mode changes, so
+//! process() doesn't lock while handling commands.
 class UsbCdcTtyParser : public TtyParser
 {
 public:
+    //! Function called whenever binary mode is entered or exited
+    typedef void (*ModeChangeFn)(bool binaryMode);
+
     //! Constructor
-    UsbCdcTtyParser(MutexInterface& m, char helpChar);
+    //! @param[in] m  Mutex used to serialize addChars with mode changes
+    //! @param[in] helpChar  The command character which prints help for all commands
+    //! @param[in] clock  Clock used to limit the amount of time spent in each process() call
+    //! @param[in] modeChangeFn  Optional function called from process() when binary mode changes
+    UsbCdcTtyParser(MutexInterface& m,
+                    char helpChar,
+                    ClockInterface& clock,
+                    ModeChangeFn modeChangeFn = nullptr);
     //! Adds a command parser to my list of parsers - must be done before any other function called
     virtual void addCommandParser(std::shared_ptr<CommandParser> parser) final;
     //! Called from the process receiving characters on the TTY
     void addChars(const char* chars, uint32_t len);
     //! Called from the process handling maple bus execution
+    //! Handles all complete commands, stopping early only once the process budget elapses
     virtual void process() final;
+    //! @returns true iff received characters are currently parsed as binary frames
+    bool isBinaryMode() const;
+    //! Requests to return to text mode on the next call to process() (e.g. on disconnect)
+    void requestTextMode();
+    //! Sets the amount of time process() may keep handling commands before returning
+    //! @param[in] budgetUs  Budget in microseconds (at least 1 command is always handled)
+    void setProcessBudgetUs(uint32_t budgetUs);
+
+private:
+    //! Processes the next text command, if any
+    //! @returns true iff a command was consumed
+    bool processText();
+    //! Processes the next binary frame, if any
+    //! @returns true iff any data was consumed
+    bool processBinary();
+    //! Dispatches a decoded binary frame
+    //! @param[in] cmd  The frame's command character
+    //! @param[in,out] data  The frame's data, preceded and followed by 1 byte which may be overwritten
+    //! @param[in] len  The number of data bytes
+    void processFrame(char cmd, uint8_t* data, uint32_t len);
+    //! Prints help for all commands
+    void printHelp();
+    //! Drops everything received so far (must be locked)
+    void clearRx();
+    //! Sets binary mode and notifies the mode change function (must be locked)
+    void setBinaryMode(bool binaryMode);
+    //! Producer only: adds a character at the current write position
+    //! @param[in] c  The character to add
+    inline void pushChar(char c)
+    {
+        uint32_t idx = mWriteIdx++ & (RX_BUFFER_SIZE - 1);
+        mRx[idx] = c;
+        mRx[idx + RX_BUFFER_SIZE] = c;
+    }
+    //! Consumer only: @returns pointer to contiguous received data starting at the given position
+    inline char* rxAt(uint32_t pos)
+    {
+        return &mRx[pos & (RX_BUFFER_SIZE - 1)];
+    }
+
+public:
+    //! The default amount of time process() may keep handling commands
+    static const uint32_t DEFAULT_PROCESS_BUDGET_US = 250;
 
 private:
-    //! Max of 2 KB of memory to use for tty RX queue
-    static const uint32_t MAX_QUEUE_SIZE = 2048;
+    //! The command character used to select text or binary mode
+    static const char MODE_CHAR = '#';
+    //! Mode command which selects binary mode
+    static const char BINARY_MODE_CMD = 'B';
+    //! Mode command which selects text mode
+    static const char TEXT_MODE_CMD = 'T';
+    //! Number of characters the tty RX queue may hold (must be a power of 2); mRx mirrors each one,
+    //! so the queue takes 4 KB of RAM
+    static const uint32_t RX_BUFFER_SIZE = 2048;
+    //! Maximum number of complete text commands which may be waiting (must be a power of 2)
+    static const uint32_t MAX_LINES = 64;
     //! String of characters that are considered whitespace
     static const char* WHITESPACE_CHARS;
     //! String of characters that are considered end of line characters
@@ -58,18 +127,42 @@ private:
     static const char RX_EOL_CHAR;
     //! String of characters that are treated as a backspace
     static const char* BACKSPACE_CHARS;
-    //! Receive queue
-    std::vector<char> mParserRx;
+    //! Receive ring - each character is written twice, RX_BUFFER_SIZE apart, so that any span of
+    //! waiting data may be read contiguously starting in the first half
+    char mRx[RX_BUFFER_SIZE * 2];
+    //! Free running position where the next character will be written (only accessed by producer)
+    uint32_t mWriteIdx;
+    //! Free running position up to which data is complete and visible to the consumer (text mode:
+    //! end of the last complete command, binary mode: end of data)
+    std::atomic<uint32_t> mRxHead;
+    //! Free running position up to which data has been consumed
+    std::atomic<uint32_t> mRxTail;
+    //! Positions of the EOL character of each complete text command
+    uint32_t mLineEnds[MAX_LINES];
+    //! Free running count of complete text commands added
+    std::atomic<uint32_t> mLineHead;
+    //! Free running count of complete text commands consumed
+    std::atomic<uint32_t> mLineTail;
+    //! Value of mRxHead when a binary frame was last found incomplete (only accessed by consumer)
+    uint32_t mIncompleteHead;
     //! Flag that is set to true if the last read character is an EOL (used to ignore further EOL)
     bool mLastIsEol;
-    //! Mutex used to serialize addChars and process
+    //! Mutex used to serialize addChars with mode changes
     MutexInterface& mParserMutex;
-    //! Flag when end of line detected on add
-    std::atomic<bool> mCommandReady;
     //! The command character which prints help for all commands
     const char mHelpChar;
+    //! Clock used to limit the amount of time spent in each process() call
+    ClockInterface& mClock;
+    //! The amount of time process() may keep handling commands
+    uint32_t mProcessBudgetUs;
     //! Parsers that may handle data
     std::vector<std::shared_ptr<CommandParser>> mParsers;
-    //! true when overflow in mParserRx
+    //! true when overflow of the current text command is detected (only accessed by producer)
     bool mOverflowDetected;
+    //! true when mRx holds binary frames rather than text (only changed while locked)
+    std::atomic<bool> mBinaryMode;
+    //! Set by requestTextMode() and cleared by process()
+    std::atomic<bool> mTextModeRequested;
+    //! Function called when binary mode changes
+    const ModeChangeFn mModeChangeFn;
 };
@@ -40,15 +40,18 @@
 #include "class/cdc/cdc_device.h"
 
 #include "UsbCdcTtyParser.hpp"
+#include "hal/System/ByteRing.hpp"
 
 
 UsbCdcTtyParser* ttyParser = nullptr;
 
-TtyParser* usb_cdc_create_parser(MutexInterface* m, char helpChar)
+static void tty_mode_changed(bool binaryMode);
+
+TtyParser* usb_cdc_create_parser(MutexInterface* m, char helpChar, ClockInterface* clock)
 {
     if (ttyParser == nullptr)
     {
-        ttyParser = new UsbCdcTtyParser(*m, helpChar);
+        ttyParser = new UsbCdcTtyParser(*m, helpChar, *clock, tty_mode_changed);
     }
     return ttyParser;
 }
@@ -58,6 +61,15 @@ TtyParser* usb_cdc_create_parser(MutexInterface* m, char helpChar)
 
 static MutexInterface* stdioMutex = nullptr;
 
+// Number of bytes of output which may be waiting for the host to read (must be a power of 2)
+#define CDC_TX_RING_SIZE 8192
+
+// All output is queued here and sent from cdc_task() on core0 so that printing from the maple bus
+// core never waits on USB. Both cores produce, so every write to the ring must hold stdioMutex,
+// which is only held for the copy. cdc_tx_task() is the only consumer and doesn't need the lock.
+// Output which doesn't fit is dropped.
+static ByteRing<CDC_TX_RING_SIZE> txRing;
+
 // Can't use stdio_usb_init() because it checks tud_cdc_connected(), and that doesn't always return
 // true when a connection is made. Not all terminal client set this when making connection.
 
@@ -69,43 +81,13 @@ static void stdio_usb_out_chars2(const char *buf, int length)
 {
     if (length <= 0) return;
 
-    static uint64_t last_avail_time;
-
     LockGuard lockGuard(*stdioMutex);
     if (!lockGuard.isLocked())
     {
         return; // would deadlock otherwise
     }
 
-    for (uint32_t i = 0; i < (uint32_t)length;)
-    {
-        uint32_t n = length - i;
-        uint32_t avail = tud_cdc_write_available();
-
-        if (n > avail)
-        {
-            n = (int)avail;
-        }
-
-        if (n)
-        {
-            uint32_t n2 = tud_cdc_write(buf + i, n);
-            tud_task();
-            tud_cdc_write_flush();
-            i += n2;
-            last_avail_time = time_us_64();
-        }
-        else
-        {
-            tud_task();
-            tud_cdc_write_flush();
-            if (!tud_cdc_connected() ||
-                (!tud_cdc_write_available() && time_us_64() > last_avail_time + 500000))
-            {
-                break;
-            }
-        }
-    }
+    txRing.write(buf, (uint32_t)length);
 }
 
 int stdio_usb_in_chars2(char *buf, int length)
@@ -144,6 +126,34 @@ void cdc_init(MutexInterface* cdcStdioMutex)
     stdio_set_driver_enabled(&stdio_usb2, true);
 }
 
+// Moves as much queued output into the CDC TX FIFO as will fit (must only be called from core0)
+static void cdc_tx_task()
+{
+    const uint8_t* data = nullptr;
+    uint32_t len = 0;
+    bool written = false;
+    while ((len = txRing.peek(data)) > 0)
+    {
+        uint32_t n = tud_cdc_write(data, len);
+        if (n == 0)
+        {
+            break;
+        }
+        txRing.consume(n);
+        written = true;
+    }
+
+    if (written)
+    {
+        tud_cdc_write_flush();
+    }
+    else if (len > 0 && !tud_cdc_connected())
+    {
+        // Nobody is reading - don't hold on to stale output
+        txRing.clear();
+    }
+}
+
 void cdc_task()
 {
 #if USB_CDC_ENABLED
@@ -160,8 +170,11 @@ void cdc_task()
 
             if (count > 0)
             {
-                // Echo back (no crlf processing since calling directly)
-                stdio_usb_out_chars2(buf, count);
+                if (!ttyParser->isBinaryMode())
+                {
+                    // Echo back (no crlf processing since calling directly)
+                    stdio_usb_out_chars2(buf, count);
+                }
                 // Add to parser
                 ttyParser->addChars(buf, count);
             }
@@ -173,6 +186,8 @@ void cdc_task()
         }
     }
 #endif
+
+    cdc_tx_task();
 }
 
 // Invoked when cdc when line state changed e.g connected/disconnected
@@ -180,6 +195,12 @@ void tud_cdc_line_state_cb(uint8_t itf, bool dtr, bool rts)
 {
   (void) itf;
   (void) rts;
+
+  if (!dtr && ttyParser)
+  {
+    // Next connection always starts in text mode
+    ttyParser->requestTextMode();
+  }
 }
 
 // Invoked when CDC interface received data from host
@@ -188,4 +209,21 @@ void tud_cdc_rx_cb(uint8_t itf)
   (void) itf;
 }
 
+static void tty_mode_changed(bool binaryMode)
+{
+#if PICO_STDIO_ENABLE_CRLF_SUPPORT
+  // Binary frames must be sent without any LF to CRLF replacement
+  stdio_set_translate_crlf(&stdio_usb2, !binaryMode);
+#else
+  (void) binaryMode;
+#endif
+}
+
+#else // #if CFG_TUD_CDC
+
+static void tty_mode_changed(bool binaryMode)
+{
+  (void) binaryMode;
+}
+
 #endif // #if CFG_TUD_CDC
@@ -35,9 +35,13 @@
 #include "hal/Usb/usb_interface.hpp"
 #include "hal/Usb/UsbFileSystem.hpp"
 #include "hal/Usb/UsbFile.hpp"
+#include "hal/Usb/UsbFileTransfer.hpp"
+#include "hal/System/ClockInterface.hpp"
 #include "hal/System/MutexInterface.hpp"
 #include "hal/System/LockGuard.hpp"
 
+#include "pico/time.h"
+
 #include <mutex>
 
 #define MAX_FILE_SIZE_BYTES (128 * 1024)
@@ -59,6 +63,21 @@ struct FileEntry
 static FileEntry fileEntries[8] = {};
 static uint32_t numFileEntries = 0;
 
+class MscClock : public ClockInterface
+{
+  public:
+    virtual uint64_t getTimeUs() const final
+    {
+      return time_us_64();
+    }
+};
+
+static MscClock mscClock;
+
+// READ10/WRITE10 callbacks return 0 (busy) while waiting on maple bus data, and tinyusb calls them
+// again with the same parameters on a later tud_task(); this keeps HID and CDC going meanwhile
+static UsbFileTransfer fileTransfer(mscClock);
+
 // whether host does safe-eject
 static bool ejected = true;
 static bool new_data = false;
@@ -67,6 +86,18 @@ static uint8_t errorCount = 0;
 // Once this threshold is reached, drive will be forcibly ejected
 #define MAX_ERROR_COUNT 50
 
+// Amount of time written data may take to be committed to each memory unit before a flush fails
+#define FLUSH_TIMEOUT_US 2000000
+
+// Amount of time to wait for a single block to be read from a memory unit
+#define READ_TIMEOUT_US 20000
+
+// Amount of time to wait for a single block write to be accepted (written back in the background)
+#define WRITE_TIMEOUT_US 250000
+
+// Not defined by tinyusb since it isn't one of its built-in commands
+#define SCSI_CMD_SYNCHRONIZE_CACHE_10 0x35
+
 // 1 README included in root directory
 #define NUM_INTERNAL_FILES 1
 
@@ -619,6 +650,7 @@ void usb_msc_remove(UsbFile* file)
   {
       if (fileEntries[i].handle == file)
       {
+        fileTransfer.cancel(file);
         fileEntries[i].handle = nullptr;
         fileEntries[i].filename = nullptr;
         fileEntries[i].size = 0;
@@ -659,6 +691,43 @@ void msc_init(MutexInterface* mutex)
   fileMutex = mutex;
 }
 
+// Checks if all data written to files has been committed without waiting for it
+// Returns positive value iff all data was committed without error
+// Returns zero if data is still being committed - call again until non-zero is returned
+// Returns negative value if any write failed or the flush timed out
+static int32_t try_flush_files()
+{
+  // Failure of a file which finished before the one still pending (only reported once by the file)
+  static bool flushFailed = false;
+
+  // Serialize this section with file add/remove
+  LockGuard lockGuard(*fileMutex);
+  assert(lockGuard.isLocked());
+
+  for (uint32_t i = 0;
+       i < (sizeof(fileEntries) / sizeof(fileEntries[0]));
+       ++i)
+  {
+    if (fileEntries[i].handle != nullptr && !fileEntries[i].isReadOnly)
+    {
+      int32_t result = fileTransfer.flush(fileEntries[i].handle, FLUSH_TIMEOUT_US);
+      if (result == 0)
+      {
+        // Only one transfer is tracked at a time, so stop at the first one still pending
+        return 0;
+      }
+      else if (result < 0)
+      {
+        flushFailed = true;
+      }
+    }
+  }
+
+  int32_t result = flushFailed ? -1 : 1;
+  flushFailed = false;
+  return result;
+}
+
 // Invoked when received SCSI_CMD_INQUIRY
 // Application fill vendor id, product id and revision with string up to 8, 16, 4 characters respectively
 void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4])
@@ -742,7 +811,20 @@ bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start, boo
     }
     else
     {
-      // unload disk storage
+      // unload disk storage - make sure everything written actually made it first without blocking
+      // USB processing; the host retries this command while the unit reports not ready
+      int32_t flushResult = try_flush_files();
+      if (flushResult == 0)
+      {
+        // Logical unit is in process of becoming ready
+        tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x04, 0x01);
+        return false;
+      }
+      else if (flushResult < 0 && errorCount < MAX_ERROR_COUNT)
+      {
+        // Nothing more can be done for what was lost, so eject anyway
+        ++errorCount;
+      }
       ejected = true;
     }
   }
@@ -791,7 +873,8 @@ int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void* buff
         {
           // Found the matching file!
           uint32_t vmuAddr = realAddr & 0xFF;
-          numRead = fileEntries[i].handle->read(vmuAddr, buffer, bufsize, 20000);
+          // Returns 0 while the block is still on its way
+          numRead = fileTransfer.read(fileEntries[i].handle, vmuAddr, buffer, bufsize, READ_TIMEOUT_US);
           if (numRead < 0)
           {
             // timeout
@@ -921,7 +1004,8 @@ int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t*
           uint32_t vmuAddr = realAddr & 0xFF;
           if (!fileEntries[i].isReadOnly)
           {
-            numWrite = fileEntries[i].handle->write(vmuAddr, buffer, bufsize, 250000);
+            // Returns 0 until the data is cached; it is written back in the background
+            numWrite = fileTransfer.write(fileEntries[i].handle, vmuAddr, buffer, bufsize, WRITE_TIMEOUT_US);
             if (numWrite < 0)
             {
               // timeout
@@ -984,6 +1068,33 @@ int32_t tud_msc_scsi_cb (uint8_t lun, uint8_t const scsi_cmd[16], void* buffer,
       resplen = 0;
     break;
 
+    case SCSI_CMD_SYNCHRONIZE_CACHE_10:
+    {
+      // Writes are acknowledged before they reach the memory unit - don't block USB processing
+      // while they are committed; the host retries this command while the unit reports not ready
+      int32_t flushResult = try_flush_files();
+      if (flushResult > 0)
+      {
+        resplen = 0;
+      }
+      else if (flushResult == 0)
+      {
+        // Logical unit is in process of becoming ready
+        tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x04, 0x01);
+        resplen = -1;
+      }
+      else
+      {
+        tud_msc_set_sense(lun, SCSI_SENSE_HARDWARE_ERROR, 0x44, 0x00);
+        if (errorCount < MAX_ERROR_COUNT)
+        {
+          ++errorCount;
+        }
+        resplen = -1;
+      }
+    }
+    break;
+
     default:
       // Set Sense = Invalid Command Operation
       tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);
@@ -25,12 +25,21 @@
 #include <stdint.h>
 #include "class/hid/hid_device.h"
 
-UsbControllerDevice::UsbControllerDevice() : mIsUsbConnected(false), mIsControllerConnected(false) {}
+UsbControllerDevice::UsbControllerDevice() :
+  mIsUsbConnected(false),
+  mIsControllerConnected(false),
+  mLastReportReadUs(0),
+  mReportRead(false)
+{}
 UsbControllerDevice::~UsbControllerDevice() {}
 
 void UsbControllerDevice::updateUsbConnected(bool connected)
 {
   mIsUsbConnected = connected;
+  if (!connected)
+  {
+    mReportRead = false;
+  }
 }
 
 bool UsbControllerDevice::isUsbConnected()
@@ -52,6 +61,22 @@ bool UsbControllerDevice::isControllerConnected()
   return mIsControllerConnected;
 }
 
+void UsbControllerDevice::updateReportRead(uint32_t timeUs)
+{
+  mLastReportReadUs = timeUs;
+  mReportRead = true;
+}
+
+bool UsbControllerDevice::getLastReportRead(uint32_t& timeUs)
+{
+  if (!mReportRead)
+  {
+    return false;
+  }
+  timeUs = mLastReportReadUs;
+  return true;
+}
+
 bool UsbControllerDevice::sendReport(uint8_t instance, uint8_t report_id)
 {
   bool sent = false;
@@ -25,6 +25,7 @@
 #define __USB_CONTROLLER_DEVICE_H__
 
 #include <stdint.h>
+#include <atomic>
 
 //! Base class for a USB controller device
 class UsbControllerDevice
@@ -71,6 +72,19 @@ class UsbControllerDevice
     //! @returns the current controller connected state
     virtual bool isControllerConnected();
 
+    //! Called only from callbacks when the host has read a report from this device
+    //! @param[in] timeUs  Lower 32 bits of the system time in microseconds
+    void updateReportRead(uint32_t timeUs);
+
+    //! Retrieves when the host last read a report from this device (safe to call from any core)
+    //! @param[out] timeUs  Lower 32 bits of the system time in microseconds of the last read
+    //! @returns true iff a report has been read since USB connected
+    bool getLastReportRead(uint32_t& timeUs);
+
+  public:
+    //! How often the host reads reports in microseconds (bInterval of 1 at full speed)
+    static const uint32_t REPORT_READ_INTERVAL_US = 1000;
+
   protected:
     //! Helper function which retrieves and sends report to tiny USB
     //! @param[in] instance The USB instance number (0-based)
@@ -83,6 +97,12 @@ class UsbControllerDevice
 
     //! True when this controller is connected
     bool mIsControllerConnected;
+
+    //! Lower 32 bits of the system time that the host last read a report
+    std::atomic<uint32_t> mLastReportReadUs;
+
+    //! True once mLastReportReadUs is valid
+    std::atomic<bool> mReportRead;
 };
 
 #endif // __USB_CONTROLLER_DEVICE_H__
@@ -35,27 +35,35 @@
 
 UsbGamepad::UsbGamepad(uint8_t playerIdx) :
   playerIdx(playerIdx),
-  currentDpad(),
-  currentButtons(0),
-  buttonsUpdated(true)
+  currentState(),
+  stateUpdated(true),
+  publishedState(),
+  buttonsUpdated(false)
 {
-  updateAllReleased();
+  currentState.leftAnalog[2] = MIN_TRIGGER_VALUE;
+  currentState.rightAnalog[2] = MIN_TRIGGER_VALUE;
+  publishState();
 }
 
 bool UsbGamepad::isButtonPressed()
+{
+  return isButtonPressed(publishedState.load());
+}
+
+bool UsbGamepad::isButtonPressed(const State& state)
 {
   return (
-    currentDpad[DPAD_UP]
-    || currentDpad[DPAD_DOWN]
-    || currentDpad[DPAD_LEFT]
-    || currentDpad[DPAD_RIGHT]
-    || currentButtons != 0
-    || isAnalogPressed(currentLeftAnalog[0])
-    || isAnalogPressed(currentLeftAnalog[1])
-    || isTriggerPressed(currentLeftAnalog[2])
-    || isAnalogPressed(currentRightAnalog[0])
-    || isAnalogPressed(currentRightAnalog[1])
-    || isTriggerPressed(currentRightAnalog[2])
+    state.dpad[DPAD_UP]
+    || state.dpad[DPAD_DOWN]
+    || state.dpad[DPAD_LEFT]
+    || state.dpad[DPAD_RIGHT]
+    || state.buttons != 0
+    || isAnalogPressed(state.leftAnalog[0])
+    || isAnalogPressed(state.leftAnalog[1])
+    || isTriggerPressed(state.leftAnalog[2])
+    || isAnalogPressed(state.rightAnalog[0])
+    || isAnalogPressed(state.rightAnalog[1])
+    || isTriggerPressed(state.rightAnalog[2])
   );
 }
 
@@ -68,15 +76,15 @@ void UsbGamepad::setAnalogThumbX(bool isLeft, int8_t x)
   int8_t lastX = 0;
   if (isLeft)
   {
-    lastX = currentLeftAnalog[0];
-    currentLeftAnalog[0] = x;
+    lastX = currentState.leftAnalog[0];
+    currentState.leftAnalog[0] = x;
   }
   else
   {
-    lastX = currentRightAnalog[0];
-    currentRightAnalog[0] = x;
+    lastX = currentState.rightAnalog[0];
+    currentState.rightAnalog[0] = x;
   }
-  buttonsUpdated = buttonsUpdated || (x != lastX);
+  stateUpdated = stateUpdated || (x != lastX);
 }
 
 void UsbGamepad::setAnalogThumbY(bool isLeft, int8_t y)
@@ -85,15 +93,15 @@ void UsbGamepad::setAnalogThumbY(bool isLeft, int8_t y)
   int8_t lastY = 0;
   if (isLeft)
   {
-    lastY = currentLeftAnalog[1];
-    currentLeftAnalog[1] = y;
+    lastY = currentState.leftAnalog[1];
+    currentState.leftAnalog[1] = y;
   }
   else
   {
-    lastY = currentRightAnalog[1];
-    currentRightAnalog[1] = y;
+    lastY = currentState.rightAnalog[1];
+    currentState.rightAnalog[1] = y;
   }
-  buttonsUpdated = buttonsUpdated || (y != lastY);
+  stateUpdated = stateUpdated || (y != lastY);
 }
 
 void UsbGamepad::setAnalogTrigger(bool isLeft, int8_t z)
@@ -102,26 +110,26 @@ void UsbGamepad::setAnalogTrigger(bool isLeft, int8_t z)
   int8_t lastZ = 0;
   if (isLeft)
   {
-    lastZ = currentLeftAnalog[2];
-    currentLeftAnalog[2] = z;
+    lastZ = currentState.leftAnalog[2];
+    currentState.leftAnalog[2] = z;
   }
   else
   {
-    lastZ = currentRightAnalog[2];
-    currentRightAnalog[2] = z;
+    lastZ = currentState.rightAnalog[2];
+    currentState.rightAnalog[2] = z;
   }
-  buttonsUpdated = buttonsUpdated || (z != lastZ);
+  stateUpdated = stateUpdated || (z != lastZ);
 }
 
 int8_t UsbGamepad::getAnalogThumbX(bool isLeft)
 {
   if (isLeft)
   {
-    return currentLeftAnalog[0];
+    return currentState.leftAnalog[0];
   }
   else
   {
-    return currentRightAnalog[0];
+    return currentState.rightAnalog[0];
   }
 }
 
@@ -129,11 +137,11 @@ int8_t UsbGamepad::getAnalogThumbY(bool isLeft)
 {
   if (isLeft)
   {
-    return currentLeftAnalog[1];
+    return currentState.leftAnalog[1];
   }
   else
   {
-    return currentRightAnalog[1];
+    return currentState.rightAnalog[1];
   }
 }
 
@@ -141,33 +149,33 @@ int8_t UsbGamepad::getAnalogTrigger(bool isLeft)
 {
   if (isLeft)
   {
-    return currentLeftAnalog[2];
+    return currentState.leftAnalog[2];
   }
   else
   {
-    return currentRightAnalog[2];
+    return currentState.rightAnalog[2];
   }
 }
 
 void UsbGamepad::setDigitalPad(UsbGamepad::DpadButtons button, bool isPressed)
 {
-  bool oldValue = currentDpad[button];
-  currentDpad[button] = isPressed;
-  buttonsUpdated = buttonsUpdated || (oldValue != currentDpad[button]);
+  bool oldValue = currentState.dpad[button];
+  currentState.dpad[button] = isPressed;
+  stateUpdated = stateUpdated || (oldValue != currentState.dpad[button]);
 }
 
 void UsbGamepad::setButtonMask(uint32_t mask, bool isPressed)
 {
-  uint32_t lastButtons = currentButtons;
+  uint32_t lastButtons = currentState.buttons;
   if (isPressed)
   {
-    currentButtons |= mask;
+    currentState.buttons |= mask;
   }
   else
   {
-    currentButtons &= ~mask;
+    currentState.buttons &= ~mask;
   }
-  buttonsUpdated = buttonsUpdated || (lastButtons != currentButtons);
+  stateUpdated = stateUpdated || (lastButtons != currentState.buttons);
 }
 
 void UsbGamepad::setButton(uint8_t button, bool isPressed)
@@ -177,32 +185,44 @@ void UsbGamepad::setButton(uint8_t button, bool isPressed)
 
 void UsbGamepad::updateAllReleased()
 {
-  if (isButtonPressed())
+  if (isButtonPressed(currentState))
+  {
+    currentState.leftAnalog[0] = 0;
+    currentState.leftAnalog[1] = 0;
+    currentState.leftAnalog[2] = MIN_TRIGGER_VALUE;
+    currentState.rightAnalog[0] = 0;
+    currentState.rightAnalog[1] = 0;
+    currentState.rightAnalog[2] = MIN_TRIGGER_VALUE;
+    currentState.dpad[DPAD_UP] = false;
+    currentState.dpad[DPAD_DOWN] = false;
+    currentState.dpad[DPAD_LEFT] = false;
+    currentState.dpad[DPAD_RIGHT] = false;
+    currentState.buttons = 0;
+    stateUpdated = true;
+  }
+}
+
+void UsbGamepad::publishState()
+{
+  if (stateUpdated)
   {
-    currentLeftAnalog[0] = 0;
-    currentLeftAnalog[1] = 0;
-    currentLeftAnalog[2] = MIN_TRIGGER_VALUE;
-    currentRightAnalog[0] = 0;
-    currentRightAnalog[1] = 0;
-    currentRightAnalog[2] = MIN_TRIGGER_VALUE;
-    currentDpad[DPAD_UP] = false;
-    currentDpad[DPAD_DOWN] = false;
-    currentDpad[DPAD_LEFT] = false;
-    currentDpad[DPAD_RIGHT] = false;
-    currentButtons = 0;
-    buttonsUpdated = true;
+    publishedState.store(currentState);
+    stateUpdated = false;
+    // Set only after the state is published so that a send from the other core which clears this
+    // either reports the new state or leaves this set for the next send
+    buttonsUpdated.store(true);
   }
 }
 
-uint8_t UsbGamepad::getHatValue()
+uint8_t UsbGamepad::getHatValue(const bool (&dpad)[DPAD_COUNT])
 {
-  if (currentDpad[DPAD_UP])
+  if (dpad[DPAD_UP])
   {
-    if (currentDpad[DPAD_LEFT])
+    if (dpad[DPAD_LEFT])
     {
       return GAMEPAD_HAT_UP_LEFT;
     }
-    else if (currentDpad[DPAD_RIGHT])
+    else if (dpad[DPAD_RIGHT])
     {
       return GAMEPAD_HAT_UP_RIGHT;
     }
@@ -211,13 +231,13 @@ uint8_t UsbGamepad::getHatValue()
       return GAMEPAD_HAT_UP;
     }
   }
-  else if (currentDpad[DPAD_DOWN])
+  else if (dpad[DPAD_DOWN])
   {
-    if (currentDpad[DPAD_LEFT])
+    if (dpad[DPAD_LEFT])
     {
       return GAMEPAD_HAT_DOWN_LEFT;
     }
-    else if (currentDpad[DPAD_RIGHT])
+    else if (dpad[DPAD_RIGHT])
     {
       return GAMEPAD_HAT_DOWN_RIGHT;
     }
@@ -226,11 +246,11 @@ uint8_t UsbGamepad::getHatValue()
       return GAMEPAD_HAT_DOWN;
     }
   }
-  else if (currentDpad[DPAD_LEFT])
+  else if (dpad[DPAD_LEFT])
   {
     return GAMEPAD_HAT_LEFT;
   }
-  else if (currentDpad[DPAD_RIGHT])
+  else if (dpad[DPAD_RIGHT])
   {
     return GAMEPAD_HAT_RIGHT;
   }
@@ -242,12 +262,14 @@ uint8_t UsbGamepad::getHatValue()
 
 bool UsbGamepad::send(bool force)
 {
-  if (buttonsUpdated || force)
+  if (buttonsUpdated.load() || force)
   {
+    // Cleared before the report is built so that a state published meanwhile isn't missed
+    buttonsUpdated.store(false);
     bool sent = sendReport(ITF_NUM_GAMEPAD(playerIdx), GAMEPAD_MAIN_REPORT_ID);
-    if (sent)
+    if (!sent)
     {
-      buttonsUpdated = false;
+      buttonsUpdated.store(true);
     }
     return sent;
   }
@@ -277,16 +299,17 @@ uint8_t UsbGamepad::getReportSize()
 
 uint16_t UsbGamepad::getReport(uint8_t *buffer, uint16_t reqlen)
 {
-  // Build the report
+  // Build the report from a consistent snapshot of the published state
+  const State state = publishedState.load();
   hid_dc_gamepad_report_t report;
-  report.x = currentLeftAnalog[0];
-  report.y = currentLeftAnalog[1];
-  report.z = currentLeftAnalog[2];
-  report.rz = currentRightAnalog[2];
-  report.rx = currentRightAnalog[0];
-  report.ry = currentRightAnalog[1];
-  report.hat = getHatValue();
-  report.buttons = currentButtons;
+  report.x = state.leftAnalog[0];
+  report.y = state.leftAnalog[1];
+  report.z = state.leftAnalog[2];
+  report.rz = state.rightAnalog[2];
+  report.rx = state.rightAnalog[0];
+  report.ry = state.rightAnalog[1];
+  report.hat = getHatValue(state.dpad);
+  report.buttons = state.buttons;
   report.pad = playerIdx; // Just put player index in this padding
   // Copy report into buffer
   uint16_t setLen = (sizeof(report) <= reqlen) ? sizeof(report) : reqlen;
@@ -27,8 +27,13 @@
 #include <stdint.h>
 #include "UsbControllerDevice.h"
 #include "usb_descriptors.h"
+#include "hal/System/SeqLock.hpp"
+
+#include <atomic>
 
 //! This class is designed to work with the setup code in usb_descriptors.c
+//! Controls are set and published from one core (see publishState()) while the USB stack may build
+//! reports from the published state on the other.
 class UsbGamepad : public UsbControllerDevice
 {
   public:
@@ -80,7 +85,7 @@ class UsbGamepad : public UsbControllerDevice
   public:
     //! UsbKeyboard constructor
     UsbGamepad(uint8_t playerIdx);
-    //! @returns true iff any button is currently "pressed"
+    //! @returns true iff any button is "pressed" in the published state
     bool isButtonPressed() final;
     //! Sets the analog stick for the X direction
     //! @param[in] isLeft true for left, false for right
@@ -117,31 +122,53 @@ class UsbGamepad : public UsbControllerDevice
     void setButton(uint8_t button, bool isPressed);
     //! Release all currently pressed keys
     void updateAllReleased() final;
-    //! Updates the host with any newly pressed keys
+    //! Publishes the controls set since the last call, to be reported to the host by send() and
+    //! getReport(); must be called from the same core that sets controls
+    void publishState();
+    //! Updates the host with any newly published keys
     //! @param[in] force  Set to true to update host regardless if key state has changed since last
     //!                   update
     //! @returns true if data has been successfully sent or if keys didn't need to be updated
     bool send(bool force = false) final;
     //! @returns the size of the report for this device
     virtual uint8_t getReportSize();
-    //! Gets the report for the currently pressed keys
+    //! Gets the report for the published keys
     //! @param[out] buffer  Where the report is written
     //! @param[in] reqlen  The length of buffer
     uint16_t getReport(uint8_t *buffer, uint16_t reqlen) final;
 
+  private:
+    //! Everything a report is built from
+    struct State
+    {
+      //! Left analog states (x,y,z)
+      int8_t leftAnalog[3];
+      //! Right analog states (x,y,z)
+      int8_t rightAnalog[3];
+      //! D-pad buttons
+      bool dpad[DPAD_COUNT];
+      //! Button states
+      uint32_t buttons;
+    };
+
   protected:
-    //! @returns the hat value based on current dpad state
-    uint8_t getHatValue();
+    //! @param[in] dpad  The dpad state
+    //! @returns the hat value based on the given dpad state
+    static uint8_t getHatValue(const bool (&dpad)[DPAD_COUNT]);
 
   private:
+    //! @param[in] state  The state to check
+    //! @returns true iff any button is "pressed" in the given state
+    static bool isButtonPressed(const State& state);
+
     //! @param[in] analog  The analog value to check
     //! @returns true if the given analog is considered "pressed"
-    inline bool isAnalogPressed(int16_t analog)
+    static inline bool isAnalogPressed(int16_t analog)
     {
       return (analog > ANALOG_PRESSED_TOL || analog < -ANALOG_PRESSED_TOL);
     }
 
-    inline bool isTriggerPressed(int16_t analog)
+    static inline bool isTriggerPressed(int16_t analog)
     {
       return (analog > (MIN_TRIGGER_VALUE + ANALOG_PRESSED_TOL));
     }
@@ -152,16 +179,14 @@ class UsbGamepad : public UsbControllerDevice
 
   private:
     const uint8_t playerIdx;
-    //! Current left analog states (x,y,z)
-    int8_t currentLeftAnalog[3];
-    //! Current right analog states (x,y,z)
-    int8_t currentRightAnalog[3];
-    //! Current d-pad buttons
-    bool currentDpad[DPAD_COUNT];
-    //! Current button states
-    uint32_t currentButtons;
-    //! True when something has been updated since the last successful send
-    bool buttonsUpdated;
+    //! Current state, as set by the setters (only accessed from the core which sets controls)
+    State currentState;
+    //! True when currentState has been updated since it was last published
+    bool stateUpdated;
+    //! The last published state which reports are built from
+    SeqLock<State> publishedState;
+    //! True when a state has been published since the last successful send
+    std::atomic<bool> buttonsUpdated;
 };
 
 #endif // __USB_CONTROLLER_H__
@@ -57,6 +57,7 @@ void UsbGamepadDreamcastControllerObserver::setControllerCondition(const Control
     mUsbController.setAnalogThumbX(false, static_cast<int32_t>(controllerCondition.rAnalogLR) - 128);
     mUsbController.setAnalogThumbY(false, static_cast<int32_t>(controllerCondition.rAnalogUD) - 128);
 
+    mUsbController.publishState();
     mUsbController.send();
 }
 
@@ -70,18 +71,30 @@ void UsbGamepadDreamcastControllerObserver::setSecondaryControllerCondition(
     mUsbController.setButton(UsbGamepad::BUTTON18, 0 == secondaryControllerCondition.left);
     mUsbController.setButton(UsbGamepad::BUTTON19, 0 == secondaryControllerCondition.right);
 
-    // Don't bother USB with this update - only update within setControllerCondition()
+    // Don't bother USB with this update - only publish and update within setControllerCondition()
     //mUsbController.send();
 }
 
 void UsbGamepadDreamcastControllerObserver::controllerConnected()
 {
     mUsbController.updateControllerConnected(true);
+    mUsbController.publishState();
     mUsbController.send(true);
 }
 
 void UsbGamepadDreamcastControllerObserver::controllerDisconnected()
 {
     mUsbController.updateControllerConnected(false);
+    mUsbController.publishState();
     mUsbController.send(true);
 }
+
+bool UsbGamepadDreamcastControllerObserver::getHostReadTiming(uint32_t& timeUs, uint32_t& intervalUs)
+{
+    if (!mUsbController.getLastReportRead(timeUs))
+    {
+        return false;
+    }
+    intervalUs = UsbControllerDevice::REPORT_READ_INTERVAL_US;
+    return true;
+}
@@ -52,6 +52,12 @@ class UsbGamepadDreamcastControllerObserver : public DreamcastControllerObserver
         //! Called when controller disconnected
         virtual void controllerDisconnected() final;
 
+        //! Retrieves when the host last read a report for this controller
+        //! @param[out] timeUs  Lower 32 bits of the system time in microseconds of the last read
+        //! @param[out] intervalUs  How often the host reads reports in microseconds
+        //! @returns true iff a report has been read and the values above were set
+        virtual bool getHostReadTiming(uint32_t& timeUs, uint32_t& intervalUs) final;
+
     private:
         //! The USB controller I update
         UsbGamepad& mUsbController;
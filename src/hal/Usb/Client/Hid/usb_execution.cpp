@@ -269,6 +269,18 @@ uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_t
   }
 }
 
+// Invoked when a report was successfully read by the host on the IN endpoint
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len)
+{
+  (void) report;
+  (void) len;
+  if (instance < numUsbDevices)
+  {
+    // Used to align controller polling to when the host reads reports
+    pAllUsbDevices[instance]->updateReportRead(static_cast<uint32_t>(time_us_64()));
+  }
+}
+
 // Invoked when received SET_REPORT control request or
 // received data on OUT endpoint ( Report ID = 0, Type = 0 )
 void tud_hid_set_report_cb(uint8_t instance,
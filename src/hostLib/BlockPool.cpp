@@ -0,0 +1,104 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BlockPool.hpp"
+#include "utils.h"
+#include <hal/System/LockGuard.hpp>
+
+BlockPool::BlockPool(MutexInterface& m, uint32_t blockSize, uint32_t numBlocks) :
+    mMutex(m),
+    mBlockSize(INT_DIVIDE_CEILING(blockSize, sizeof(max_align_t)) * sizeof(max_align_t)),
+    mNumBlocks(numBlocks),
+    mStorage(new max_align_t[INT_DIVIDE_CEILING(blockSize, sizeof(max_align_t)) * numBlocks]),
+    mFreeHead(nullptr),
+    mNumInUse(0),
+    mHighWaterMark(0),
+    mNumFailures(0)
+{
+    // Link all blocks into the free list, in order
+    uint8_t* storage = reinterpret_cast<uint8_t*>(mStorage.get());
+    for (uint32_t i = mNumBlocks; i > 0; --i)
+    {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(storage + (i - 1) * mBlockSize);
+        block->next = mFreeHead;
+        mFreeHead = block;
+    }
+}
+
+BlockPool::~BlockPool() {}
+
+void* BlockPool::allocate(uint32_t size)
+{
+    {
+        LockGuard lock(mMutex);
+
+        if (size <= mBlockSize && mFreeHead != nullptr)
+        {
+            FreeBlock* block = mFreeHead;
+            mFreeHead = block->next;
+            if (++mNumInUse > mHighWaterMark)
+            {
+                mHighWaterMark = mNumInUse;
+            }
+            return block;
+        }
+
+        ++mNumFailures;
+    }
+
+    DEBUG_PRINT("pool exhausted (%lu bytes)\n", (long unsigned int)size);
+    return ::operator new(size);
+}
+
+void BlockPool::deallocate(void* p)
+{
+    if (owns(p))
+    {
+        LockGuard lock(mMutex);
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        block->next = mFreeHead;
+        mFreeHead = block;
+        --mNumInUse;
+    }
+    else
+    {
+        ::operator delete(p);
+    }
+}
+
+bool BlockPool::owns(const void* p) const
+{
+    const uint8_t* storage = reinterpret_cast<const uint8_t*>(mStorage.get());
+    const uint8_t* ptr = static_cast<const uint8_t*>(p);
+    return (ptr >= storage && ptr < storage + (mBlockSize * mNumBlocks));
+}
+
+BlockPool::Stats BlockPool::getStats() const
+{
+    Stats stats;
+    stats.numBlocks = mNumBlocks;
+    stats.numInUse = mNumInUse;
+    stats.highWaterMark = mHighWaterMark;
+    stats.numFailures = mNumFailures;
+    return stats;
+}
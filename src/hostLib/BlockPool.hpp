@@ -0,0 +1,150 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "hal/System/MutexInterface.hpp"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+
+//! Fixed-size block allocator used to keep frequently allocated objects off of the general heap.
+//! When all blocks are in use (or a request is larger than a block), allocation falls back to the
+//! heap and the failure is counted so that pool sizing may be tuned.
+class BlockPool
+{
+public:
+    //! Pool usage statistics
+    struct Stats
+    {
+        //! Total number of blocks in the pool
+        uint32_t numBlocks;
+        //! Number of blocks currently allocated
+        uint32_t numInUse;
+        //! Maximum number of blocks that were allocated at once
+        uint32_t highWaterMark;
+        //! Number of allocations which could not be served by the pool
+        uint32_t numFailures;
+    };
+
+public:
+    //! Constructor
+    //! @param[in] m  Mutex used to serialize allocation and deallocation
+    //! @param[in] blockSize  Size of each block in bytes
+    //! @param[in] numBlocks  Number of blocks in the pool
+    BlockPool(MutexInterface& m, uint32_t blockSize, uint32_t numBlocks);
+
+    //! Destructor
+    virtual ~BlockPool();
+
+    //! Allocates a block
+    //! @param[in] size  Number of bytes needed
+    //! @returns a block from the pool or from the heap if pool can't fit the request
+    void* allocate(uint32_t size);
+
+    //! Deallocates memory previously returned from allocate()
+    //! @param[in] p  The pointer to deallocate
+    void deallocate(void* p);
+
+    //! @returns true iff the given pointer points to a block within this pool
+    bool owns(const void* p) const;
+
+    //! @returns usage statistics for this pool
+    Stats getStats() const;
+
+    //! @returns the size of each block in bytes
+    inline uint32_t getBlockSize() const
+    {
+        return mBlockSize;
+    }
+
+private:
+    //! Free blocks are linked together through their own storage
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    //! Mutex used to serialize allocation and deallocation
+    MutexInterface& mMutex;
+    //! Size of each block in bytes (rounded up for alignment)
+    const uint32_t mBlockSize;
+    //! Number of blocks in the pool
+    const uint32_t mNumBlocks;
+    //! Block storage
+    std::unique_ptr<max_align_t[]> mStorage;
+    //! First free block
+    FreeBlock* mFreeHead;
+    //! Number of blocks currently allocated
+    uint32_t mNumInUse;
+    //! Maximum number of blocks that were allocated at once
+    uint32_t mHighWaterMark;
+    //! Number of allocations which could not be served by the pool
+    uint32_t mNumFailures;
+};
+
+//! STL allocator which allocates from a BlockPool; this is meant to be used with
+//! std::allocate_shared so that both the object and its control block reside in a single block.
+//! The allocator keeps the pool alive for as long as anything allocated from it exists.
+template <typename T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    //! Constructor
+    //! @param[in] pool  The pool to allocate from
+    PoolAllocator(std::shared_ptr<BlockPool> pool) : mPool(pool) {}
+
+    //! Rebind constructor
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& rhs) : mPool(rhs.mPool) {}
+
+    //! Allocates storage for n objects
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(mPool->allocate(n * sizeof(T)));
+    }
+
+    //! Deallocates storage previously returned from allocate()
+    void deallocate(T* p, size_t n)
+    {
+        mPool->deallocate(p);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& rhs) const
+    {
+        return mPool == rhs.mPool;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& rhs) const
+    {
+        return mPool != rhs.mPool;
+    }
+
+    //! The pool to allocate from
+    std::shared_ptr<BlockPool> mPool;
+};
@@ -0,0 +1,109 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "BusStats.hpp"
+
+#include <string.h>
+
+BusStats::BusStats()
+{
+    reset();
+}
+
+void BusStats::writeStarted(uint64_t releaseTimeUs, uint64_t deadlineUs, uint64_t currentTimeUs)
+{
+    if (mFirstWriteTimeUs == 0)
+    {
+        mFirstWriteTimeUs = currentTimeUs;
+        mLastEndTimeUs = currentTimeUs;
+    }
+    mWriteTimeUs = currentTimeUs;
+
+    uint64_t latenessUs = (currentTimeUs > releaseTimeUs) ? (currentTimeUs - releaseTimeUs) : 0;
+    lateness.add((latenessUs > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(latenessUs));
+
+    if (currentTimeUs > deadlineUs)
+    {
+        ++mNumDeadlineMisses;
+    }
+}
+
+void BusStats::transferEnded(MapleBusInterface::Phase phase,
+                             MapleBusInterface::FailureReason reason,
+                             uint64_t currentTimeUs)
+{
+    if (mWriteTimeUs > 0)
+    {
+        if (currentTimeUs > mWriteTimeUs)
+        {
+            mBusyUs += (currentTimeUs - mWriteTimeUs);
+        }
+        mWriteTimeUs = 0;
+        mLastEndTimeUs = currentTimeUs;
+    }
+
+    if (phase == MapleBusInterface::Phase::WRITE_FAILED)
+    {
+        ++mWriteFailures[reasonIndex(reason)];
+    }
+    else if (phase == MapleBusInterface::Phase::READ_FAILED)
+    {
+        ++mReadFailures[reasonIndex(reason)];
+    }
+}
+
+void BusStats::reset()
+{
+    lateness.reset();
+    mFirstWriteTimeUs = 0;
+    mWriteTimeUs = 0;
+    mLastEndTimeUs = 0;
+    mBusyUs = 0;
+    mNumDeadlineMisses = 0;
+    memset(mWriteFailures, 0, sizeof(mWriteFailures));
+    memset(mReadFailures, 0, sizeof(mReadFailures));
+}
+
+uint64_t BusStats::getIdleUs() const
+{
+    // Measured up to the end of the last transmission
+    uint64_t elapsedUs = mLastEndTimeUs - mFirstWriteTimeUs;
+    return (elapsedUs > mBusyUs) ? (elapsedUs - mBusyUs) : 0;
+}
+
+uint32_t BusStats::getNumWriteFailures(MapleBusInterface::FailureReason reason) const
+{
+    return mWriteFailures[reasonIndex(reason)];
+}
+
+uint32_t BusStats::getNumReadFailures(MapleBusInterface::FailureReason reason) const
+{
+    return mReadFailures[reasonIndex(reason)];
+}
+
+uint32_t BusStats::reasonIndex(MapleBusInterface::FailureReason reason)
+{
+    uint32_t idx = static_cast<uint32_t>(reason);
+    return (idx < NUM_FAILURE_REASONS) ? idx : 0;
+}
@@ -0,0 +1,103 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "LatencyHistogram.hpp"
+#include "hal/MapleBus/MapleBusInterface.hpp"
+
+#include <stdint.h>
+
+//! Utilization, lateness and failure statistics of a single Maple Bus
+//!
+//! Each transmission is timestamped when its write started and when the bus was done with it
+//! (written, read or failed). Time in between is counted as busy and everything else since the
+//! first write after the last reset as idle. Adding to these is constant time and never allocates.
+class BusStats
+{
+public:
+    //! Number of MapleBusInterface::FailureReason values
+    static const uint32_t NUM_FAILURE_REASONS =
+        static_cast<uint32_t>(MapleBusInterface::FailureReason::TIMEOUT) + 1;
+
+    //! Release time to write start of each transmission
+    LatencyHistogram lateness;
+
+public:
+    //! Constructor
+    BusStats();
+
+    //! Called when the write of a transmission started
+    //! @param[in] releaseTimeUs  The time the transmission became ready to be sent
+    //! @param[in] deadlineUs  The latest time the transmission should have started
+    //! @param[in] currentTimeUs  The current time
+    void writeStarted(uint64_t releaseTimeUs, uint64_t deadlineUs, uint64_t currentTimeUs);
+
+    //! Called when the bus completed or failed the current transmission
+    //! @param[in] phase  The terminal phase of the bus
+    //! @param[in] reason  The reason of failure when phase is WRITE_FAILED or READ_FAILED
+    //! @param[in] currentTimeUs  The current time
+    void transferEnded(MapleBusInterface::Phase phase,
+                       MapleBusInterface::FailureReason reason,
+                       uint64_t currentTimeUs);
+
+    //! Clears all statistics
+    void reset();
+
+    //! @returns the time the bus spent on transmissions since the first write after reset
+    inline uint64_t getBusyUs() const { return mBusyUs; }
+
+    //! @returns the time the bus spent idle since the first write after reset
+    uint64_t getIdleUs() const;
+
+    //! @returns the number of transmissions which started after their deadline
+    inline uint32_t getNumDeadlineMisses() const { return mNumDeadlineMisses; }
+
+    //! @param[in] reason  A failure reason
+    //! @returns the number of writes which failed for the given reason
+    uint32_t getNumWriteFailures(MapleBusInterface::FailureReason reason) const;
+
+    //! @param[in] reason  A failure reason
+    //! @returns the number of reads which failed for the given reason
+    uint32_t getNumReadFailures(MapleBusInterface::FailureReason reason) const;
+
+private:
+    //! @returns index into failure counts for the given reason (unknown reasons count as NONE)
+    static uint32_t reasonIndex(MapleBusInterface::FailureReason reason);
+
+    //! Time of the first write since reset or 0 if none
+    uint64_t mFirstWriteTimeUs;
+    //! Time the current transmission started or 0 if the bus is idle
+    uint64_t mWriteTimeUs;
+    //! Time the last transmission ended
+    uint64_t mLastEndTimeUs;
+    //! Total busy time
+    uint64_t mBusyUs;
+    //! Number of transmissions which started after their deadline
+    uint32_t mNumDeadlineMisses;
+    //! Number of write failures by reason
+    uint32_t mWriteFailures[NUM_FAILURE_REASONS];
+    //! Number of read failures by reason
+    uint32_t mReadFailures[NUM_FAILURE_REASONS];
+};
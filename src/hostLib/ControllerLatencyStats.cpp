@@ -0,0 +1,96 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "ControllerLatencyStats.hpp"
+
+ControllerLatencyStats::ControllerLatencyStats() :
+    mScheduledTimeUs(0),
+    mWriteTimeUs(0),
+    mReadTimeUs(0),
+    mLastWriteTimeUs(0),
+    mInFlight(false)
+{}
+
+void ControllerLatencyStats::writeStarted(uint64_t scheduledTimeUs,
+                                          uint32_t periodUs,
+                                          uint64_t currentTimeUs)
+{
+    if (mLastWriteTimeUs > 0)
+    {
+        uint32_t intervalUs = elapsed(mLastWriteTimeUs, currentTimeUs);
+        jitter.add((intervalUs > periodUs) ? (intervalUs - periodUs) : (periodUs - intervalUs));
+    }
+    mLastWriteTimeUs = currentTimeUs;
+
+    // A poll may start before its scheduled time if it was scheduled ASAP
+    mScheduledTimeUs = (scheduledTimeUs < currentTimeUs) ? scheduledTimeUs : currentTimeUs;
+    mWriteTimeUs = currentTimeUs;
+    mInFlight = true;
+    lag.add(elapsed(mScheduledTimeUs, mWriteTimeUs));
+}
+
+void ControllerLatencyStats::readComplete(uint64_t currentTimeUs)
+{
+    if (mInFlight)
+    {
+        mReadTimeUs = currentTimeUs;
+        bus.add(elapsed(mWriteTimeUs, mReadTimeUs));
+    }
+}
+
+void ControllerLatencyStats::hidSent(uint64_t currentTimeUs)
+{
+    if (mInFlight)
+    {
+        mInFlight = false;
+        hid.add(elapsed(mReadTimeUs, currentTimeUs));
+        total.add(elapsed(mScheduledTimeUs, currentTimeUs));
+    }
+}
+
+void ControllerLatencyStats::failed()
+{
+    mInFlight = false;
+}
+
+void ControllerLatencyStats::reset()
+{
+    lag.reset();
+    bus.reset();
+    hid.reset();
+    total.reset();
+    jitter.reset();
+    mLastWriteTimeUs = 0;
+    mInFlight = false;
+}
+
+uint32_t ControllerLatencyStats::elapsed(uint64_t startUs, uint64_t endUs)
+{
+    if (endUs <= startUs)
+    {
+        return 0;
+    }
+    uint64_t durationUs = endUs - startUs;
+    return (durationUs > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(durationUs);
+}
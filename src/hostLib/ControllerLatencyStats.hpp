@@ -0,0 +1,89 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "LatencyHistogram.hpp"
+
+#include <stdint.h>
+
+//! Latency and jitter statistics for the condition poll of a single player's controller
+//!
+//! Each poll is timestamped when it was scheduled, when its write started, when its response was
+//! read, and when the resulting condition was handed off to the gamepad observer. On this
+//! firmware, the USB gamepad observer sends its HID report before returning, so the final
+//! timestamp is also when the report left for the USB stack.
+class ControllerLatencyStats
+{
+public:
+    //! Schedule to write start (time spent waiting for the bus)
+    LatencyHistogram lag;
+    //! Write start to read complete (time on the bus)
+    LatencyHistogram bus;
+    //! Read complete to HID send (parsing, observer update and HID report)
+    LatencyHistogram hid;
+    //! Schedule to HID send
+    LatencyHistogram total;
+    //! Deviation of the time between consecutive write starts from the poll period
+    LatencyHistogram jitter;
+
+public:
+    //! Constructor
+    ControllerLatencyStats();
+
+    //! Called when the write of a poll started
+    //! @param[in] scheduledTimeUs  The time the poll was scheduled for
+    //! @param[in] periodUs  The poll period
+    //! @param[in] currentTimeUs  The current time
+    void writeStarted(uint64_t scheduledTimeUs, uint32_t periodUs, uint64_t currentTimeUs);
+
+    //! Called when the response of a poll was read
+    //! @param[in] currentTimeUs  The current time
+    void readComplete(uint64_t currentTimeUs);
+
+    //! Called once the condition of a poll was sent to the gamepad
+    //! @param[in] currentTimeUs  The current time
+    void hidSent(uint64_t currentTimeUs);
+
+    //! Called when a poll failed; its timestamps are discarded
+    void failed();
+
+    //! Clears all statistics
+    void reset();
+
+private:
+    //! @returns the time between start and end, saturated to fit 32 bits
+    static uint32_t elapsed(uint64_t startUs, uint64_t endUs);
+
+    //! Time the current poll was scheduled for
+    uint64_t mScheduledTimeUs;
+    //! Time the write of the current poll started
+    uint64_t mWriteTimeUs;
+    //! Time the response of the current poll was read
+    uint64_t mReadTimeUs;
+    //! Time the write of the previous poll started or 0 if none
+    uint64_t mLastWriteTimeUs;
+    //! True while a poll is being timestamped
+    bool mInFlight;
+};
@@ -0,0 +1,64 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <stdint.h>
+
+//! Runtime settings for how often a player's controller condition is polled
+class ControllerPollSettings
+{
+public:
+    //! Constructor
+    ControllerPollSettings();
+
+    //! Sets the poll period; the controller may lengthen it further to fit the bus budget
+    //! @param[in] periodUs  The period in microseconds, limited to [MIN_PERIOD_US, MAX_PERIOD_US]
+    void setPeriodUs(uint32_t periodUs);
+
+    //! @returns the requested poll period in microseconds
+    inline uint32_t getPeriodUs() const { return mPeriodUs; }
+
+    //! Enables or disables phase lock. When enabled, polls are scheduled so that each response
+    //! is received just before the USB host reads the next HID report.
+    //! @param[in] phaseLock  true to enable phase lock
+    void setPhaseLock(bool phaseLock);
+
+    //! @returns true iff phase lock is enabled
+    inline bool isPhaseLocked() const { return mPhaseLock; }
+
+public:
+    //! Default poll period (about once per 60 Hz video frame)
+    static const uint32_t DEFAULT_PERIOD_US = 16000;
+    //! Shortest allowed poll period (one USB full speed frame)
+    static const uint32_t MIN_PERIOD_US = 1000;
+    //! Longest allowed poll period
+    static const uint32_t MAX_PERIOD_US = 1000000;
+
+private:
+    //! The requested poll period in microseconds
+    uint32_t mPeriodUs;
+    //! True when phase lock is enabled
+    bool mPhaseLock;
+};
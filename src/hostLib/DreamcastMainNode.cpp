@@ -27,6 +27,8 @@
 #include "DreamcastController.hpp"
 #include "EndpointTxScheduler.hpp"
 
+#include <algorithm>
+
 DreamcastMainNode::DreamcastMainNode(MapleBusInterface& bus,
                                      PlayerData playerData,
                                      std::shared_ptr<PrioritizedTxScheduler> prioritizedTxScheduler) :
@@ -39,8 +41,13 @@ DreamcastMainNode::DreamcastMainNode(MapleBusInterface& bus,
                   ),
                   playerData),
     mSubNodes(),
-    mTransmissionTimeliner(bus, prioritizedTxScheduler),
+    mTransmissionTimeliner(bus, prioritizedTxScheduler, playerData.busStats),
     mScheduleId(-1),
+    mProbeSentTimeUs(0),
+    mNumFailedProbes(0),
+    mSuspendedPeripherals(),
+    mDeviceInfo(),
+    mDeviceInfoLen(0),
     mCommFailCount(0),
     mPrintSummary(false)
 {
@@ -62,7 +69,7 @@ DreamcastMainNode::DreamcastMainNode(MapleBusInterface& bus,
 DreamcastMainNode::~DreamcastMainNode()
 {}
 
-void DreamcastMainNode::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastMainNode::txComplete(const MaplePacketView* packet,
                                    std::shared_ptr<const Transmission> tx)
 {
     // Handle device info from main peripheral
@@ -70,10 +77,23 @@ void DreamcastMainNode::txComplete(std::shared_ptr<const MaplePacket> packet,
     {
         if (packet->payload.size() > 3)
         {
-            uint32_t mask = peripheralFactory(packet->payload);
+            uint32_t mask = 0;
+            if (!restorePeripherals(packet->payload))
+            {
+                // A different device was connected
+                mSuspendedPeripherals.clear();
+                mask = peripheralFactory(packet->payload);
+                mDeviceInfoLen = std::min(packet->payload.size(),
+                                          (uint32_t)EXPECTED_DEVICE_INFO_PAYLOAD_WORDS);
+                for (uint32_t i = 0; i < mDeviceInfoLen; ++i)
+                {
+                    mDeviceInfo[i] = packet->payload[i];
+                }
+            }
+
             if (mPeripherals.size() > 0)
             {
-                // Remove the auto reload device info request transmission from schedule
+                // Stop probing
                 if (mScheduleId >= 0)
                 {
                     mEndpointTxScheduler->cancelById(mScheduleId);
@@ -99,18 +119,68 @@ void DreamcastMainNode::txComplete(std::shared_ptr<const MaplePacket> packet,
 
 void DreamcastMainNode::disconnectMainPeripheral(uint64_t currentTimeUs)
 {
-    mPeripherals.clear();
     mEndpointTxScheduler->cancelByRecipient(getRecipientAddress());
+    suspendPeripherals();
     for (std::vector<std::shared_ptr<DreamcastSubNode>>::iterator iter = mSubNodes.begin();
             iter != mSubNodes.end();
             ++iter)
     {
         (*iter)->mainPeripheralDisconnected();
     }
-    addInfoRequestToSchedule(currentTimeUs);
+    // The device may come right back, so probe quickly for a while
+    mNumFailedProbes = 0;
+    addInfoRequestToSchedule(currentTimeUs + getProbePeriodUs());
     DEBUG_PRINT("P%lu disconnected\n", mPlayerData.playerIndex + 1);
 }
 
+bool DreamcastMainNode::restorePeripherals(const MaplePacketView::Payload& deviceInfoPayload)
+{
+    if (mSuspendedPeripherals.empty() || deviceInfoPayload.size() != mDeviceInfoLen)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < mDeviceInfoLen; ++i)
+    {
+        if (deviceInfoPayload[i] != mDeviceInfo[i])
+        {
+            return false;
+        }
+    }
+
+    mPeripherals.swap(mSuspendedPeripherals);
+    for (std::vector<std::shared_ptr<DreamcastPeripheral>>::iterator iter = mPeripherals.begin();
+            iter != mPeripherals.end();
+            ++iter)
+    {
+        (*iter)->resume();
+    }
+    return true;
+}
+
+void DreamcastMainNode::suspendPeripherals()
+{
+    bool suspended = !mPeripherals.empty();
+    for (std::vector<std::shared_ptr<DreamcastPeripheral>>::iterator iter = mPeripherals.begin();
+            iter != mPeripherals.end();
+            ++iter)
+    {
+        // Every peripheral is given the chance to release its connection
+        suspended = (*iter)->suspend() && suspended;
+    }
+
+    mSuspendedPeripherals.clear();
+    if (suspended)
+    {
+        mSuspendedPeripherals.swap(mPeripherals);
+    }
+    else
+    {
+        mPeripherals.clear();
+        mDeviceInfoLen = 0;
+    }
+}
+
 void DreamcastMainNode::printSummary()
 {
     mPrintSummary = true;
@@ -195,6 +265,18 @@ void DreamcastMainNode::readTask(uint64_t currentTimeUs)
             mCommFailCount = 0;
         }
     }
+
+    // Keep probing until a peripheral answers the device info request
+    if (mScheduleId >= 0
+        && readStatus.transmission != nullptr
+        && readStatus.transmission->transmissionId == mScheduleId)
+    {
+        if (getProbePeriodUs() < PROBE_PERIOD_MAX_US)
+        {
+            ++mNumFailedProbes;
+        }
+        addInfoRequestToSchedule(mProbeSentTimeUs + getProbePeriodUs());
+    }
 }
 
 void DreamcastMainNode::runDependentTasks(uint64_t currentTimeUs)
@@ -225,6 +307,11 @@ void DreamcastMainNode::runDependentTasks(uint64_t currentTimeUs)
                 EXPECTED_DEVICE_INFO_PAYLOAD_WORDS);
         }
     }
+    else if (mScheduleId < 0)
+    {
+        // The schedule was full when the probe was last added
+        addInfoRequestToSchedule(currentTimeUs + getProbePeriodUs());
+    }
 
     // Summary is printed here for safety
     if (mPrintSummary)
@@ -252,6 +339,11 @@ void DreamcastMainNode::writeTask(uint64_t currentTimeUs)
 
     if (sentTx != nullptr)
     {
+        if (sentTx->transmissionId == mScheduleId)
+        {
+            mProbeSentTimeUs = currentTimeUs;
+        }
+
         // Send this off to the one who transmitted this
         Transmitter* transmitter = sentTx->transmitter;
         if (transmitter != nullptr)
@@ -268,20 +360,31 @@ void DreamcastMainNode::task(uint64_t currentTimeUs)
     writeTask(currentTimeUs);
 }
 
-void DreamcastMainNode::addInfoRequestToSchedule(uint64_t currentTimeUs)
+void DreamcastMainNode::addInfoRequestToSchedule(uint64_t txTimeUs)
 {
-    uint64_t txTime = PrioritizedTxScheduler::TX_TIME_ASAP;
-    if (currentTimeUs > 0)
-    {
-        txTime = PrioritizedTxScheduler::computeNextTimeCadence(currentTimeUs, US_PER_CHECK);
-    }
-    mScheduleId = mEndpointTxScheduler->add(
-        txTime,
+    // Sent once, then added again from readTask() if nothing answers
+    uint32_t id = mEndpointTxScheduler->add(
+        txTimeUs,
         this,
         COMMAND_DEVICE_INFO_REQUEST,
         nullptr,
         0,
         true,
-        EXPECTED_DEVICE_INFO_PAYLOAD_WORDS,
-        US_PER_CHECK);
+        EXPECTED_DEVICE_INFO_PAYLOAD_WORDS);
+    mScheduleId = (id == PrioritizedTxScheduler::INVALID_TX_ID) ? -1 : static_cast<int64_t>(id);
+}
+
+uint32_t DreamcastMainNode::getProbePeriodUs() const
+{
+    uint32_t numSteps = mNumFailedProbes / PROBES_PER_BACKOFF_STEP;
+    uint32_t periodUs = PROBE_PERIOD_MIN_US;
+    while (numSteps-- > 0 && periodUs < PROBE_PERIOD_MAX_US)
+    {
+        periodUs *= 2;
+    }
+    if (periodUs > PROBE_PERIOD_MAX_US)
+    {
+        periodUs = PROBE_PERIOD_MAX_US;
+    }
+    return periodUs;
 }
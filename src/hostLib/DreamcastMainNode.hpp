@@ -62,7 +62,7 @@ class DreamcastMainNode : public DreamcastNode
         {}
 
         //! Inherited from DreamcastNode
-        virtual void txComplete(std::shared_ptr<const MaplePacket> packet,
+        virtual void txComplete(const MaplePacketView* packet,
                                 std::shared_ptr<const Transmission> tx) final;
 
         //! Called when the main peripheral needs to be disconnected
@@ -85,12 +85,34 @@ class DreamcastMainNode : public DreamcastNode
         //! @param[in] currentTimeUs  The current time in microseconds
         void writeTask(uint64_t currentTimeUs);
 
-        //! Adds an auto reload info request to the transmission schedule
-        void addInfoRequestToSchedule(uint64_t currentTimeUs = 0);
+        //! Adds a device info request to the transmission schedule which probes for a main
+        //! peripheral
+        //! @param[in] txTimeUs  The time to send the request
+        void addInfoRequestToSchedule(uint64_t txTimeUs = PrioritizedTxScheduler::TX_TIME_ASAP);
+
+        //! @returns the time between each device info request while no peripheral is detected;
+        //!          this starts short after a disconnect and backs off while the port stays empty
+        uint32_t getProbePeriodUs() const;
+
+        //! Restores the peripherals that were suspended on the last disconnect if the given device
+        //! info matches the device info they were created from
+        //! @param[in] deviceInfoPayload  The payload within the received device info packet
+        //! @returns true iff the peripherals were restored
+        bool restorePeripherals(const MaplePacketView::Payload& deviceInfoPayload);
+
+        //! Suspends the connected peripherals so they may be restored by restorePeripherals(),
+        //! deleting them if any can't be suspended
+        void suspendPeripherals();
 
     public:
-        //! Number of microseconds in between each info request when no peripheral is detected
+        //! Number of microseconds in between each info request sent to a connected peripheral
         static const uint32_t US_PER_CHECK = 16000;
+        //! Number of microseconds in between each info request right after a disconnect
+        static const uint32_t PROBE_PERIOD_MIN_US = 4000;
+        //! Number of microseconds in between each info request once a port has been empty a while
+        static const uint32_t PROBE_PERIOD_MAX_US = 128000;
+        //! Number of failed info requests before the probe period doubles
+        static const uint32_t PROBES_PER_BACKOFF_STEP = 16;
         //! Number of communication failures before main peripheral is disconnected
         static const uint32_t MAX_FAILURE_DISCONNECT_COUNT = 3;
 
@@ -99,8 +121,18 @@ class DreamcastMainNode : public DreamcastNode
         std::vector<std::shared_ptr<DreamcastSubNode>> mSubNodes;
         //! Executes transmissions from the schedule
         TransmissionTimeliner mTransmissionTimeliner;
-        //! ID of the device info request auto reload transmission this object added to the schedule
+        //! ID of the device info request transmission this object added to the schedule or -1
         int64_t mScheduleId;
+        //! Time at which the last device info request was sent
+        uint64_t mProbeSentTimeUs;
+        //! Number of device info requests which failed since the last disconnect
+        uint32_t mNumFailedProbes;
+        //! Peripherals of the last disconnected device which may be restored on reconnect
+        std::vector<std::shared_ptr<DreamcastPeripheral>> mSuspendedPeripherals;
+        //! Device info payload which the connected or suspended peripherals were created from
+        uint32_t mDeviceInfo[EXPECTED_DEVICE_INFO_PAYLOAD_WORDS];
+        //! Number of valid words in mDeviceInfo
+        uint32_t mDeviceInfoLen;
         //! Current count of number of communication failures
         uint32_t mCommFailCount;
         //! Print summary on next cycle when true
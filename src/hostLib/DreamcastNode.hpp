@@ -121,7 +121,7 @@ class DreamcastNode : public Transmitter
         //! Factory function which generates peripheral objects for the given function code mask
         //! @param[in] deviceInfoPayload  The payload within the received device info packet
         //! @returns mask items not handled
-        virtual uint32_t peripheralFactory(const std::vector<uint32_t>& deviceInfoPayload)
+        virtual uint32_t peripheralFactory(const MaplePacketView::Payload& deviceInfoPayload)
         {
             uint32_t functionCode = 0;
             if (deviceInfoPayload.size() > 3)
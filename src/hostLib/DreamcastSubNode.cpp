@@ -30,18 +30,20 @@ DreamcastSubNode::DreamcastSubNode(uint8_t addr,
                                    PlayerData playerData) :
     DreamcastNode(addr, scheduler, playerData),
     mConnected(false),
-    mScheduleId(-1)
+    mScheduleId(-1),
+    mAwaitingInfo(false)
 {
 }
 
 DreamcastSubNode::DreamcastSubNode(const DreamcastSubNode& rhs) :
     DreamcastNode(rhs),
     mConnected(rhs.mConnected),
-    mScheduleId(rhs.mScheduleId)
+    mScheduleId(rhs.mScheduleId),
+    mAwaitingInfo(rhs.mAwaitingInfo)
 {
 }
 
-void DreamcastSubNode::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastSubNode::txComplete(const MaplePacketView* packet,
                                   std::shared_ptr<const Transmission> tx)
 {
     // If device info received, add the sub peripheral
@@ -69,6 +71,7 @@ void DreamcastSubNode::txComplete(std::shared_ptr<const MaplePacket> packet,
 
             // Remove the auto reload device info request transmission from schedule
             // This is done even if no known peripheral detected
+            mAwaitingInfo = false;
             if (mScheduleId >= 0)
             {
                 mEndpointTxScheduler->cancelById(mScheduleId);
@@ -80,6 +83,12 @@ void DreamcastSubNode::txComplete(std::shared_ptr<const MaplePacket> packet,
 
 void DreamcastSubNode::task(uint64_t currentTimeUs)
 {
+    if (mAwaitingInfo && mScheduleId < 0)
+    {
+        // The schedule was full when this was last tried
+        addInfoRequestToSchedule(currentTimeUs);
+    }
+
     if (mConnected)
     {
         // Handle operations for peripherals (run task() of all peripherals)
@@ -103,23 +112,12 @@ void DreamcastSubNode::setConnected(bool connected, uint64_t currentTimeUs)
         mConnected = connected;
         mPeripherals.clear();
         mEndpointTxScheduler->cancelByRecipient(getRecipientAddress());
+        mScheduleId = -1;
+        mAwaitingInfo = mConnected;
         if (mConnected)
         {
             // Keep asking for info until valid response is heard
-            uint64_t txTime = PrioritizedTxScheduler::TX_TIME_ASAP;
-            if (currentTimeUs > 0)
-            {
-                txTime = PrioritizedTxScheduler::computeNextTimeCadence(currentTimeUs, US_PER_CHECK);
-            }
-            mScheduleId = mEndpointTxScheduler->add(
-                txTime,
-                this,
-                COMMAND_DEVICE_INFO_REQUEST,
-                nullptr,
-                0,
-                true,
-                EXPECTED_DEVICE_INFO_PAYLOAD_WORDS,
-                US_PER_CHECK);
+            addInfoRequestToSchedule(currentTimeUs);
         }
         else
         {
@@ -128,4 +126,23 @@ void DreamcastSubNode::setConnected(bool connected, uint64_t currentTimeUs)
                         DreamcastPeripheral::subPeripheralIndex(mAddr) + 1);
         }
     }
-}
\ No newline at end of file
+}
+
+void DreamcastSubNode::addInfoRequestToSchedule(uint64_t currentTimeUs)
+{
+    uint64_t txTime = PrioritizedTxScheduler::TX_TIME_ASAP;
+    if (currentTimeUs > 0)
+    {
+        txTime = PrioritizedTxScheduler::computeNextTimeCadence(currentTimeUs, US_PER_CHECK);
+    }
+    uint32_t id = mEndpointTxScheduler->add(
+        txTime,
+        this,
+        COMMAND_DEVICE_INFO_REQUEST,
+        nullptr,
+        0,
+        true,
+        EXPECTED_DEVICE_INFO_PAYLOAD_WORDS,
+        US_PER_CHECK);
+    mScheduleId = (id == PrioritizedTxScheduler::INVALID_TX_ID) ? -1 : static_cast<int64_t>(id);
+}
@@ -51,7 +51,7 @@ class DreamcastSubNode : public DreamcastNode
         {}
 
         //! Inherited from DreamcastNode
-        virtual void txComplete(std::shared_ptr<const MaplePacket> packet,
+        virtual void txComplete(const MaplePacketView* packet,
                                 std::shared_ptr<const Transmission> tx);
 
         //! Inherited from DreamcastNode
@@ -64,12 +64,20 @@ class DreamcastSubNode : public DreamcastNode
         //! Called from the main node to update the connection state of peripherals on this sub node
         virtual void setConnected(bool connected, uint64_t currentTimeUs = 0);
 
+    private:
+        //! Adds an auto reload info request to the transmission schedule
+        //! @param[in] currentTimeUs  The current time in microseconds
+        void addInfoRequestToSchedule(uint64_t currentTimeUs);
+
     protected:
         //! Number of microseconds in between each info request when no peripheral is detected
         static const uint32_t US_PER_CHECK = 16000;
         //! Detected peripheral connection state
         bool mConnected;
         //! ID of the device info request auto reload transmission this object added to the schedule
+        //! or -1 if not scheduled
         int64_t mScheduleId;
+        //! True while connected and waiting for device info
+        bool mAwaitingInfo;
 
 };
@@ -56,6 +56,54 @@ uint32_t EndpointTxScheduler::add(uint64_t txTime,
                                       autoRepeatEndTimeUs);
 }
 
+uint32_t EndpointTxScheduler::add(uint64_t txTime,
+                                  Transmitter* transmitter,
+                                  MaplePacket& packet,
+                                  bool expectResponse,
+                                  uint32_t expectedResponseNumPayloadWords,
+                                  uint32_t autoRepeatUs,
+                                  uint64_t autoRepeatEndTimeUs)
+{
+    packet.frame.recipientAddr = mRecipientAddr;
+    return mPrioritizedScheduler->add(mFixedPriority,
+                                      txTime,
+                                      transmitter,
+                                      packet,
+                                      expectResponse,
+                                      expectedResponseNumPayloadWords,
+                                      autoRepeatUs,
+                                      autoRepeatEndTimeUs);
+}
+
+uint32_t EndpointTxScheduler::addLatest(uint64_t txTime,
+                                        Transmitter* transmitter,
+                                        uint8_t command,
+                                        uint32_t* payload,
+                                        uint8_t payloadLen,
+                                        bool expectResponse,
+                                        uint32_t expectedResponseNumPayloadWords)
+{
+    MaplePacket packet({.command=command, .recipientAddr=mRecipientAddr}, payload, payloadLen);
+    return mPrioritizedScheduler->addLatest(mFixedPriority,
+                                            txTime,
+                                            transmitter,
+                                            packet,
+                                            expectResponse,
+                                            expectedResponseNumPayloadWords);
+}
+
+uint32_t EndpointTxScheduler::addChain(uint64_t txTime,
+                                       Transmitter* transmitter,
+                                       TransmissionChainStep* steps,
+                                       uint32_t numSteps)
+{
+    for (uint32_t i = 0; i < numSteps; ++i)
+    {
+        steps[i].packet->frame.recipientAddr = mRecipientAddr;
+    }
+    return mPrioritizedScheduler->addChain(mFixedPriority, txTime, transmitter, steps, numSteps);
+}
+
 uint32_t EndpointTxScheduler::cancelById(uint32_t transmissionId)
 {
     return mPrioritizedScheduler->cancelById(transmissionId);
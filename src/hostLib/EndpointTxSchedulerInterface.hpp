@@ -26,6 +26,7 @@
 #include "hal/MapleBus/MaplePacket.hpp"
 #include "dreamcast_constants.h"
 #include "Transmitter.hpp"
+#include "Transmission.hpp"
 
 class EndpointTxSchedulerInterface
 {
@@ -57,6 +58,56 @@ public:
                          uint32_t autoRepeatUs=0,
                          uint64_t autoRepeatEndTimeUs=0) = 0;
 
+    //! Add a transmission of a prebuilt packet to the schedule; use this when the packet holds or
+    //! expects raw payload words
+    //! @param[in] txTime  Time at which this should transmit in microseconds
+    //! @param[in] transmitter  Pointer to transmitter that is adding this
+    //! @param[in] packet  The packet to send (recipient address will be overloaded)
+    //! @param[in] expectResponse  true iff a response is expected after transmission
+    //! @param[in] expectedResponseNumPayloadWords  Number of payload words to expect in response
+    //! @param[in] autoRepeatUs  How often to repeat this transmission in microseconds
+    //! @param[in] autoRepeatEndTimeUs  If not 0, auto repeat will cancel after this time
+    //! @returns transmission ID
+    virtual uint32_t add(uint64_t txTime,
+                         Transmitter* transmitter,
+                         MaplePacket& packet,
+                         bool expectResponse,
+                         uint32_t expectedResponseNumPayloadWords=0,
+                         uint32_t autoRepeatUs=0,
+                         uint64_t autoRepeatEndTimeUs=0) = 0;
+
+    //! Add a transmission to the schedule which replaces any unsent transmission with the same
+    //! command and function code (the first payload word) in place
+    //! @param[in] txTime  Time at which this should transmit in microseconds
+    //! @param[in] transmitter  Pointer to transmitter that is adding this
+    //! @param[in] command  The command to send
+    //! @param[in] payload  The payload of the above command
+    //! @param[in] payloadLen  The length of the above payload
+    //! @param[in] expectResponse  true iff a response is expected after transmission
+    //! @param[in] expectedResponseNumPayloadWords  Number of payload words to expect in response
+    //! @returns transmission ID (the ID of the replaced transmission if one was replaced)
+    virtual uint32_t addLatest(uint64_t txTime,
+                               Transmitter* transmitter,
+                               uint8_t command,
+                               uint32_t* payload,
+                               uint8_t payloadLen,
+                               bool expectResponse,
+                               uint32_t expectedResponseNumPayloadWords=0) = 0;
+
+    //! Add a chain of dependent transmissions to the schedule; each step after the first is sent
+    //! only once the step before it completes with its continue command, and the rest of the
+    //! chain is dropped otherwise
+    //! @param[in] txTime  Time at which the first step should transmit in microseconds
+    //! @param[in] transmitter  Pointer to transmitter that is adding this
+    //! @param[in,out] steps  The steps of the chain (recipient address of each packet will be
+    //!                       overloaded and packet data is moved upon calling this)
+    //! @param[in] numSteps  Number of steps (must be > 0)
+    //! @returns transmission ID shared by every step of the chain
+    virtual uint32_t addChain(uint64_t txTime,
+                              Transmitter* transmitter,
+                              TransmissionChainStep* steps,
+                              uint32_t numSteps) = 0;
+
     //! Cancels scheduled transmission by transmission ID
     //! @param[in] transmissionId  The transmission ID of the transmissions to cancel
     //! @returns number of transmissions successfully canceled
@@ -0,0 +1,73 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "LatencyHistogram.hpp"
+
+#include <string.h>
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::add(uint32_t durationUs)
+{
+    ++mBuckets[getBucketIndex(durationUs)];
+    ++mCount;
+    mSum += durationUs;
+    if (durationUs < mMin)
+    {
+        mMin = durationUs;
+    }
+    if (durationUs > mMax)
+    {
+        mMax = durationUs;
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    memset(mBuckets, 0, sizeof(mBuckets));
+    mCount = 0;
+    mMin = UINT32_MAX;
+    mMax = 0;
+    mSum = 0;
+}
+
+uint32_t LatencyHistogram::getAverage() const
+{
+    return (mCount > 0) ? static_cast<uint32_t>(mSum / mCount) : 0;
+}
+
+uint32_t LatencyHistogram::getBucketIndex(uint32_t durationUs)
+{
+    if (durationUs == 0)
+    {
+        return 0;
+    }
+
+    // Number of significant bits is the bucket index
+    uint32_t idx = 32 - __builtin_clz(durationUs);
+    return (idx < NUM_BUCKETS) ? idx : (NUM_BUCKETS - 1);
+}
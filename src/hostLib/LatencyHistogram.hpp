@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <stdint.h>
+
+//! Fixed-size histogram of durations in microseconds. Bucket 0 counts durations of 0, and each
+//! bucket n > 0 counts durations in the range [2^(n-1), 2^n) with the last bucket also holding
+//! everything larger. Adding a sample is constant time and never allocates.
+class LatencyHistogram
+{
+public:
+    //! Number of buckets; the last bucket begins at 65536 us
+    static const uint32_t NUM_BUCKETS = 18;
+
+public:
+    //! Constructor
+    LatencyHistogram();
+
+    //! Adds a sample
+    //! @param[in] durationUs  The duration to count
+    void add(uint32_t durationUs);
+
+    //! Clears all samples
+    void reset();
+
+    //! @returns the number of samples added since last reset
+    inline uint32_t getCount() const { return mCount; }
+
+    //! @returns the smallest sample or 0 if no samples were added
+    inline uint32_t getMin() const { return (mCount > 0) ? mMin : 0; }
+
+    //! @returns the largest sample
+    inline uint32_t getMax() const { return mMax; }
+
+    //! @returns the mean of all samples or 0 if no samples were added
+    uint32_t getAverage() const;
+
+    //! @param[in] idx  Bucket index [0, NUM_BUCKETS)
+    //! @returns the number of samples counted in the given bucket
+    inline uint32_t getBucket(uint32_t idx) const { return mBuckets[idx]; }
+
+    //! @param[in] durationUs  A duration
+    //! @returns the index of the bucket the given duration is counted in
+    static uint32_t getBucketIndex(uint32_t durationUs);
+
+private:
+    //! Sample count for each bucket
+    uint32_t mBuckets[NUM_BUCKETS];
+    //! Total number of samples
+    uint32_t mCount;
+    //! Smallest sample
+    uint32_t mMin;
+    //! Largest sample
+    uint32_t mMax;
+    //! Sum of all samples
+    uint64_t mSum;
+};
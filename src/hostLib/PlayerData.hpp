@@ -27,6 +27,9 @@
 #include "hal/System/ClockInterface.hpp"
 #include "ScreenData.hpp"
 #include "hal/Usb/UsbFileSystem.hpp"
+#include "ControllerLatencyStats.hpp"
+#include "ControllerPollSettings.hpp"
+#include "BusStats.hpp"
 
 //! Contains data that is tied to a specific player
 struct PlayerData
@@ -36,16 +39,25 @@ struct PlayerData
     ScreenData& screenData;
     ClockInterface& clock;
     UsbFileSystem& fileSystem;
+    ControllerLatencyStats* const latencyStats;
+    ControllerPollSettings* const pollSettings;
+    BusStats* const busStats;
 
     PlayerData(uint32_t playerIndex,
                DreamcastControllerObserver& gamepad,
                ScreenData& screenData,
                ClockInterface& clock,
-               UsbFileSystem& fileSystem) :
+               UsbFileSystem& fileSystem,
+               ControllerLatencyStats* latencyStats = nullptr,
+               ControllerPollSettings* pollSettings = nullptr,
+               BusStats* busStats = nullptr) :
         playerIndex(playerIndex),
         gamepad(gamepad),
         screenData(screenData),
         clock(clock),
-        fileSystem(fileSystem)
+        fileSystem(fileSystem),
+        latencyStats(latencyStats),
+        pollSettings(pollSettings),
+        busStats(busStats)
     {}
 };
\ No newline at end of file
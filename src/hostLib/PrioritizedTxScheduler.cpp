@@ -28,38 +28,273 @@
 
 #include <assert.h>
 
-// STL
-#include <algorithm>
+const PrioritizedTxScheduler::NodeIndex PrioritizedTxScheduler::INVALID_NODE_INDEX;
 
-PrioritizedTxScheduler::PrioritizedTxScheduler(MutexInterface& m, uint8_t senderAddress, uint32_t max) :
+PrioritizedTxScheduler::PrioritizedTxScheduler(MutexInterface& m,
+                                               uint8_t senderAddress,
+                                               uint32_t max,
+                                               uint32_t capacity,
+                                               uint32_t poolSize) :
     mScheduleMutex(m),
     mSenderAddress(senderAddress),
     mNextId(1),
-    mSchedule()
+    mNodePool(),
+    mFreeHead(INVALID_NODE_INDEX),
+    mSchedule(),
+    mClasses(),
+    mQueueDepths(),
+    mLastPeekTimeUs(0),
+    mNumCoalesced(0),
+    mIdBuckets(),
+    mIdBucketMask(0),
+    mTransmissionPool(std::make_shared<BlockPool>(m, sizeof(Transmission) + POOL_BLOCK_OVERHEAD, poolSize)),
+    mPacketPool(std::make_shared<BlockPool>(m, sizeof(MaplePacket) + POOL_BLOCK_OVERHEAD, poolSize))
 {
-    mSchedule.resize(max + 1);
+    assert(capacity > 0 && capacity < INVALID_NODE_INDEX);
+
+    mSchedule.resize(max + 1, NodeList{INVALID_NODE_INDEX, INVALID_NODE_INDEX});
+    mClasses.resize(max + 1, PriorityClass{0, 0, 0, 0, 0});
+    mQueueDepths.resize(max + 1, QueueDepth{0, 0});
+
+    // Controller polls keep their cadence no matter how much external traffic is queued
+    if (MAIN_TRANSMISSION_PRIORITY <= max)
+    {
+        PriorityClass& mainClass = mClasses[MAIN_TRANSMISSION_PRIORITY];
+        mainClass.reservedUs = DEFAULT_MAIN_RESERVED_US;
+        mainClass.reservationPeriodUs = DEFAULT_RESERVATION_PERIOD_US;
+        mainClass.budgetUs = DEFAULT_MAIN_RESERVED_US;
+    }
+
+    // Sub peripheral traffic (mostly storage) may wait for everything else, but only for so long
+    if (SUB_TRANSMISSION_PRIORITY <= max)
+    {
+        mClasses[SUB_TRANSMISSION_PRIORITY].relativeDeadlineUs = DEFAULT_SUB_RELATIVE_DEADLINE_US;
+    }
+
+    // Chain all nodes into the free list
+    mNodePool.resize(capacity);
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        mNodePool[i].next = i + 1;
+    }
+    mNodePool[capacity - 1].next = INVALID_NODE_INDEX;
+    mFreeHead = 0;
+
+    for (uint32_t i = 0; i < NUM_RECIPIENT_ADDRESSES; ++i)
+    {
+        mRecipientHeads[i] = INVALID_NODE_INDEX;
+        mRecipientCounts[i] = 0;
+    }
+
+    // Use a power of 2 number of buckets which is at least the capacity
+    uint32_t numBuckets = 1;
+    while (numBuckets < capacity)
+    {
+        numBuckets <<= 1;
+    }
+    mIdBuckets.resize(numBuckets, INVALID_NODE_INDEX);
+    mIdBucketMask = numBuckets - 1;
 }
 
 PrioritizedTxScheduler::~PrioritizedTxScheduler() {}
 
+void PrioritizedTxScheduler::linkByTime(NodeIndex idx)
+{
+    Node& node = mNodePool[idx];
+    NodeList& schedule = mSchedule[node.tx->priority];
+    const uint64_t time = node.tx->nextTxTimeUs;
+
+    // Find the node to insert after - most items are either ASAP or repeating, so check the
+    // tail and head before walking backwards from the tail
+    NodeIndex after = schedule.tail;
+    if (after != INVALID_NODE_INDEX && time < nodeTime(after))
+    {
+        if (time < nodeTime(schedule.head))
+        {
+            after = INVALID_NODE_INDEX;
+        }
+        else
+        {
+            while (time < nodeTime(after))
+            {
+                after = mNodePool[after].prev;
+            }
+        }
+    }
+
+    node.prev = after;
+    if (after == INVALID_NODE_INDEX)
+    {
+        node.next = schedule.head;
+    }
+    else
+    {
+        node.next = mNodePool[after].next;
+    }
+
+    if (node.next == INVALID_NODE_INDEX)
+    {
+        schedule.tail = idx;
+    }
+    else
+    {
+        mNodePool[node.next].prev = idx;
+    }
+
+    if (after == INVALID_NODE_INDEX)
+    {
+        schedule.head = idx;
+    }
+    else
+    {
+        mNodePool[after].next = idx;
+    }
+}
+
+void PrioritizedTxScheduler::unlinkByTime(NodeIndex idx)
+{
+    Node& node = mNodePool[idx];
+    NodeList& schedule = mSchedule[node.tx->priority];
+
+    if (node.prev == INVALID_NODE_INDEX)
+    {
+        schedule.head = node.next;
+    }
+    else
+    {
+        mNodePool[node.prev].next = node.next;
+    }
+
+    if (node.next == INVALID_NODE_INDEX)
+    {
+        schedule.tail = node.prev;
+    }
+    else
+    {
+        mNodePool[node.next].prev = node.prev;
+    }
+}
+
+void PrioritizedTxScheduler::removeNode(NodeIndex idx)
+{
+    Node& node = mNodePool[idx];
+
+    unlinkByTime(idx);
+
+    // Unlink from recipient list
+    if (node.recipientPrev == INVALID_NODE_INDEX)
+    {
+        mRecipientHeads[node.recipientAddr] = node.recipientNext;
+    }
+    else
+    {
+        mNodePool[node.recipientPrev].recipientNext = node.recipientNext;
+    }
+
+    if (node.recipientNext != INVALID_NODE_INDEX)
+    {
+        mNodePool[node.recipientNext].recipientPrev = node.recipientPrev;
+    }
+
+    --mRecipientCounts[node.recipientAddr];
+    --mQueueDepths[node.tx->priority].current;
+
+    // Unlink from ID bucket
+    NodeIndex* pIdx = &mIdBuckets[node.tx->transmissionId & mIdBucketMask];
+    while (*pIdx != idx)
+    {
+        pIdx = &mNodePool[*pIdx].idNext;
+    }
+    *pIdx = node.idNext;
+
+    // Release the transmission and return this node to the free list
+    node.tx.reset();
+    node.next = mFreeHead;
+    mFreeHead = idx;
+}
+
 uint32_t PrioritizedTxScheduler::add(std::shared_ptr<Transmission> tx)
 {
     assert(tx->priority < mSchedule.size());
 
     LockGuard lock(mScheduleMutex);
 
-    std::list<std::shared_ptr<Transmission>>& schedule = mSchedule[tx->priority];
-    // Keep iterating until correct position is found
-    std::list<std::shared_ptr<Transmission>>::const_iterator iter = schedule.cbegin();
-    while(iter != schedule.cend() && tx->nextTxTimeUs >= (*iter)->nextTxTimeUs)
+    if (mFreeHead == INVALID_NODE_INDEX)
+    {
+        // Schedule is full
+        return INVALID_TX_ID;
+    }
+
+    NodeIndex idx = mFreeHead;
+    Node& node = mNodePool[idx];
+    mFreeHead = node.next;
+
+    node.tx = tx;
+    node.recipientAddr = tx->packet->frame.recipientAddr;
+
+    // Link to front of recipient list
+    node.recipientPrev = INVALID_NODE_INDEX;
+    node.recipientNext = mRecipientHeads[node.recipientAddr];
+    if (node.recipientNext != INVALID_NODE_INDEX)
+    {
+        mNodePool[node.recipientNext].recipientPrev = idx;
+    }
+    mRecipientHeads[node.recipientAddr] = idx;
+    ++mRecipientCounts[node.recipientAddr];
+
+    QueueDepth& queueDepth = mQueueDepths[tx->priority];
+    if (++queueDepth.current > queueDepth.highWaterMark)
     {
-        ++iter;
+        queueDepth.highWaterMark = queueDepth.current;
     }
-    schedule.insert(iter, tx);
+
+    // ASAP and late transmissions are released now
+    uint64_t releaseUs = (tx->nextTxTimeUs > mLastPeekTimeUs) ? tx->nextTxTimeUs : mLastPeekTimeUs;
+    tx->deadlineUs = releaseUs + mClasses[tx->priority].relativeDeadlineUs;
+
+    // Link to front of ID bucket
+    NodeIndex& bucket = mIdBuckets[tx->transmissionId & mIdBucketMask];
+    node.idNext = bucket;
+    bucket = idx;
+
+    // Link into the schedule last so that everything is set once it is visible to peekNext()
+    linkByTime(idx);
 
     return tx->transmissionId;
 }
 
+std::shared_ptr<Transmission> PrioritizedTxScheduler::makeTransmission(
+    uint32_t transmissionId,
+    uint8_t priority,
+    uint64_t txTime,
+    Transmitter* transmitter,
+    MaplePacket& packet,
+    bool expectResponse,
+    uint32_t expectedResponseNumPayloadWords,
+    uint32_t autoRepeatUs,
+    uint64_t autoRepeatEndTimeUs)
+{
+    uint32_t pktDurationUs = computeTxDurationUs(packet.payload.size(),
+                                                 expectResponse,
+                                                 expectedResponseNumPayloadWords);
+
+    // Update the sender address to my address
+    packet.frame.senderAddr = mSenderAddress;
+
+    return std::allocate_shared<Transmission>(PoolAllocator<Transmission>(mTransmissionPool),
+                                              transmissionId,
+                                              priority,
+                                              expectResponse,
+                                              pktDurationUs,
+                                              autoRepeatUs,
+                                              autoRepeatEndTimeUs,
+                                              txTime,
+                                              std::allocate_shared<MaplePacket>(
+                                                  PoolAllocator<MaplePacket>(mPacketPool),
+                                                  std::move(packet)),
+                                              transmitter);
+}
+
 uint32_t PrioritizedTxScheduler::add(uint8_t priority,
                                     uint64_t txTime,
                                     Transmitter* transmitter,
@@ -69,36 +304,248 @@ uint32_t PrioritizedTxScheduler::add(uint8_t priority,
                                     uint32_t autoRepeatUs,
                                     uint64_t autoRepeatEndTimeUs)
 {
-    uint32_t pktDurationNs = MAPLE_OPEN_LINE_CHECK_TIME_US + packet.getTxTimeNs();
-
-    if (expectResponse)
+    if (mFreeHead == INVALID_NODE_INDEX)
     {
-        uint32_t expectedReadDurationUs = MaplePacket::getTxTimeNs(expectedResponseNumPayloadWords, MAPLE_RESPONSE_NS_PER_BIT);
-        pktDurationNs += MAPLE_RESPONSE_DELAY_NS + expectedReadDurationUs;
+        // Schedule is full - don't bother allocating anything
+        return INVALID_TX_ID;
     }
 
-    uint32_t pktDurationUs = INT_DIVIDE_CEILING(pktDurationNs, 1000);
-
     // This will happen if minimal communication is made constantly for 20 days
     assert(mNextId != INVALID_TX_ID);
 
-    // Update the sender address to my address
-    packet.frame.senderAddr = mSenderAddress;
+    return add(makeTransmission(mNextId++,
+                                priority,
+                                txTime,
+                                transmitter,
+                                packet,
+                                expectResponse,
+                                expectedResponseNumPayloadWords,
+                                autoRepeatUs,
+                                autoRepeatEndTimeUs));
+}
 
-    std::shared_ptr<Transmission> tx =
-        std::make_shared<Transmission>(mNextId++,
-                                       priority,
-                                       expectResponse,
-                                       pktDurationUs,
-                                       autoRepeatUs,
-                                       autoRepeatEndTimeUs,
-                                       txTime,
-                                       std::make_shared<MaplePacket>(std::move(packet)),
-                                       transmitter);
+uint32_t PrioritizedTxScheduler::addLatest(uint8_t priority,
+                                           uint64_t txTime,
+                                           Transmitter* transmitter,
+                                           MaplePacket& packet,
+                                           bool expectResponse,
+                                           uint32_t expectedResponseNumPayloadWords)
+{
+    const uint64_t coalesceKey = Transmission::makeCoalesceKey(packet);
+
+    // Held for the lookup and the replacement so that the superseded transmission can't be sent in
+    // between (nested locks from the pools on this core are skipped)
+    LockGuard lock(mScheduleMutex);
 
+    NodeIndex idx = mRecipientHeads[packet.frame.recipientAddr];
+    while (idx != INVALID_NODE_INDEX
+           && (mNodePool[idx].tx->coalesceKey != coalesceKey
+               || mNodePool[idx].tx->priority != priority))
+    {
+        idx = mNodePool[idx].recipientNext;
+    }
+
+    if (idx != INVALID_NODE_INDEX)
+    {
+        // Replace in place - the ID, time, and deadline carry over so that a steady stream of
+        // updates can't keep pushing this back
+        Node& node = mNodePool[idx];
+        std::shared_ptr<Transmission> tx = makeTransmission(node.tx->transmissionId,
+                                                            priority,
+                                                            node.tx->nextTxTimeUs,
+                                                            transmitter,
+                                                            packet,
+                                                            expectResponse,
+                                                            expectedResponseNumPayloadWords,
+                                                            0,
+                                                            0);
+        tx->deadlineUs = node.tx->deadlineUs;
+        tx->coalesceKey = coalesceKey;
+        tx->numCoalesced = node.tx->numCoalesced + 1;
+        node.tx = tx;
+        ++mNumCoalesced;
+        return tx->transmissionId;
+    }
+
+    if (mFreeHead == INVALID_NODE_INDEX)
+    {
+        // Schedule is full - don't bother allocating anything
+        return INVALID_TX_ID;
+    }
+
+    assert(mNextId != INVALID_TX_ID);
+
+    std::shared_ptr<Transmission> tx = makeTransmission(mNextId++,
+                                                        priority,
+                                                        txTime,
+                                                        transmitter,
+                                                        packet,
+                                                        expectResponse,
+                                                        expectedResponseNumPayloadWords,
+                                                        0,
+                                                        0);
+    tx->coalesceKey = coalesceKey;
     return add(tx);
 }
 
+uint32_t PrioritizedTxScheduler::addChain(uint8_t priority,
+                                          uint64_t txTime,
+                                          Transmitter* transmitter,
+                                          TransmissionChainStep* steps,
+                                          uint32_t numSteps)
+{
+    assert(numSteps > 0);
+
+    if (mFreeHead == INVALID_NODE_INDEX)
+    {
+        // Schedule is full - don't bother allocating anything
+        return INVALID_TX_ID;
+    }
+
+    assert(mNextId != INVALID_TX_ID);
+    const uint32_t transmissionId = mNextId++;
+
+    // Built from the last step back so that each step can point to the one which follows it; only
+    // the first step is linked into the schedule here, and it holds on to the rest
+    std::shared_ptr<Transmission> nextStep = nullptr;
+    for (uint32_t i = numSteps; i-- > 0;)
+    {
+        TransmissionChainStep& step = steps[i];
+        assert(step.packet->frame.recipientAddr == steps[0].packet->frame.recipientAddr);
+
+        std::shared_ptr<Transmission> tx = makeTransmission(transmissionId,
+                                                            priority,
+                                                            (i == 0) ? txTime : TX_TIME_HELD,
+                                                            transmitter,
+                                                            *step.packet,
+                                                            step.expectResponse,
+                                                            step.expectedResponseNumPayloadWords,
+                                                            0,
+                                                            0);
+        tx->nextStep = nextStep;
+        tx->stepGapUs = step.minGapUs;
+        tx->continueCommand = step.continueCommand;
+        nextStep = tx;
+    }
+
+    return add(nextStep);
+}
+
+PrioritizedTxScheduler::NodeIndex PrioritizedTxScheduler::findHeldStep(const Transmission* step) const
+{
+    NodeIndex idx = mIdBuckets[step->transmissionId & mIdBucketMask];
+    while (idx != INVALID_NODE_INDEX && mNodePool[idx].tx.get() != step)
+    {
+        idx = mNodePool[idx].idNext;
+    }
+    return idx;
+}
+
+void PrioritizedTxScheduler::continueChain(const Transmission& tx, uint64_t completionTime)
+{
+    if (tx.nextStep == nullptr)
+    {
+        return;
+    }
+
+    LockGuard lock(mScheduleMutex);
+
+    // Not found if the chain was canceled while this step was on the bus
+    NodeIndex idx = findHeldStep(tx.nextStep.get());
+    if (idx != INVALID_NODE_INDEX)
+    {
+        Transmission& nextStep = *mNodePool[idx].tx;
+        unlinkByTime(idx);
+        nextStep.nextTxTimeUs = completionTime + nextStep.stepGapUs;
+        nextStep.deadlineUs = nextStep.nextTxTimeUs + mClasses[nextStep.priority].relativeDeadlineUs;
+        linkByTime(idx);
+    }
+}
+
+void PrioritizedTxScheduler::abortChain(const Transmission& tx)
+{
+    if (tx.nextStep == nullptr)
+    {
+        return;
+    }
+
+    LockGuard lock(mScheduleMutex);
+
+    NodeIndex idx = findHeldStep(tx.nextStep.get());
+    if (idx != INVALID_NODE_INDEX)
+    {
+        // Releases every step after it as well
+        removeNode(idx);
+    }
+}
+
+std::shared_ptr<MaplePacket> PrioritizedTxScheduler::makePacket()
+{
+    return std::allocate_shared<MaplePacket>(PoolAllocator<MaplePacket>(mPacketPool));
+}
+
+BlockPool::Stats PrioritizedTxScheduler::getTransmissionPoolStats() const
+{
+    return mTransmissionPool->getStats();
+}
+
+BlockPool::Stats PrioritizedTxScheduler::getPacketPoolStats() const
+{
+    return mPacketPool->getStats();
+}
+
+void PrioritizedTxScheduler::resetQueueDepthHighWaterMarks()
+{
+    LockGuard lock(mScheduleMutex);
+    for (QueueDepth& queueDepth : mQueueDepths)
+    {
+        queueDepth.highWaterMark = queueDepth.current;
+    }
+}
+
+void PrioritizedTxScheduler::setRelativeDeadline(uint8_t priority, uint32_t relativeDeadlineUs)
+{
+    assert(priority < mClasses.size());
+
+    LockGuard lock(mScheduleMutex);
+    mClasses[priority].relativeDeadlineUs = relativeDeadlineUs;
+}
+
+void PrioritizedTxScheduler::setReservation(uint8_t priority, uint32_t reservedUs, uint32_t periodUs)
+{
+    assert(priority < mClasses.size());
+    assert(reservedUs == 0 || periodUs > 0);
+
+    LockGuard lock(mScheduleMutex);
+    PriorityClass& priorityClass = mClasses[priority];
+    priorityClass.reservedUs = reservedUs;
+    priorityClass.reservationPeriodUs = periodUs;
+    priorityClass.budgetUs = reservedUs;
+    priorityClass.periodStartUs = mLastPeekTimeUs;
+}
+
+void PrioritizedTxScheduler::replenish(PriorityClass& priorityClass, uint64_t time)
+{
+    if (priorityClass.reservedUs > 0
+        && time >= priorityClass.periodStartUs + priorityClass.reservationPeriodUs)
+    {
+        uint64_t numPeriods = (time - priorityClass.periodStartUs) / priorityClass.reservationPeriodUs;
+        priorityClass.periodStartUs += numPeriods * priorityClass.reservationPeriodUs;
+
+        // Unused time doesn't carry over, but overdrawn time is paid back first
+        uint64_t owedUs = priorityClass.reservedUs - priorityClass.budgetUs;
+        uint64_t grantedUs = numPeriods * priorityClass.reservedUs;
+        if (grantedUs >= owedUs)
+        {
+            priorityClass.budgetUs = priorityClass.reservedUs;
+        }
+        else
+        {
+            priorityClass.budgetUs += grantedUs;
+        }
+    }
+}
+
 uint64_t PrioritizedTxScheduler::computeNextTimeCadence(uint64_t currentTime,
                                                         uint64_t period,
                                                         uint64_t offset)
@@ -121,71 +568,114 @@ uint64_t PrioritizedTxScheduler::computeNextTimeCadence(uint64_t currentTime,
     }
 }
 
+uint32_t PrioritizedTxScheduler::computeTxDurationUs(uint32_t numPayloadWords,
+                                                     bool expectResponse,
+                                                     uint32_t expectedResponseNumPayloadWords)
+{
+    uint32_t pktDurationNs =
+        MAPLE_OPEN_LINE_CHECK_TIME_US + MaplePacket::getTxTimeNs(numPayloadWords, MAPLE_NS_PER_BIT);
+
+    if (expectResponse)
+    {
+        uint32_t expectedReadDurationUs = MaplePacket::getTxTimeNs(expectedResponseNumPayloadWords, MAPLE_RESPONSE_NS_PER_BIT);
+        pktDurationNs += MAPLE_RESPONSE_DELAY_NS + expectedReadDurationUs;
+    }
+
+    return INT_DIVIDE_CEILING(pktDurationNs, 1000);
+}
+
 PrioritizedTxScheduler::ScheduleItem PrioritizedTxScheduler::peekNext(uint64_t time)
 {
     ScheduleItem scheduleItem;
-
-    // Find a priority list with item ready to be popped
-    std::vector<std::list<std::shared_ptr<Transmission>>>::iterator scheduleIter = mSchedule.begin();
-    while (scheduleIter != mSchedule.end()
-           && (scheduleIter->empty() || (*scheduleIter->begin())->nextTxTimeUs > time))
+    mLastPeekTimeUs = time;
+
+    // Find the earliest deadlines of the first pending transmission of each priority, and of
+    // those which have reserved time left
+    const uint32_t numPriorities = mSchedule.size();
+    EarliestDeadlines pending;
+    EarliestDeadlines reservedPending;
+    for (uint32_t priority = 0; priority < numPriorities; ++priority)
     {
-        ++scheduleIter;
+        replenish(mClasses[priority], time);
+        NodeIndex headIdx = mSchedule[priority].head;
+        if (headIdx != INVALID_NODE_INDEX && nodeTime(headIdx) > time)
+        {
+            uint64_t deadline = mNodePool[headIdx].tx->deadlineUs;
+            pending.add(deadline, priority);
+            if (isReserved(priority))
+            {
+                reservedPending.add(deadline, priority);
+            }
+        }
     }
 
-    if (scheduleIter != mSchedule.end())
+    NodeIndex selectedIdx = INVALID_NODE_INDEX;
+    bool selectedReserved = false;
+    uint64_t selectedDeadline = 0;
+    for (uint32_t priority = 0; priority < numPriorities; ++priority)
     {
-        std::list<std::shared_ptr<Transmission>>::iterator itemIter = scheduleIter->begin();
+        NodeIndex idx = mSchedule[priority].head;
+        if (idx == INVALID_NODE_INDEX || nodeTime(idx) > time)
+        {
+            // Nothing is ready at this priority
+            continue;
+        }
 
-        bool found = true;
-        if (scheduleIter != mSchedule.begin())
+        const bool reserved = isReserved(priority);
+        if (selectedReserved && !reserved)
         {
-            std::list<uint8_t> recipients;
-            found = false;
-            do
+            // Nothing here can take precedence over what was already selected
+            continue;
+        }
+
+        const uint64_t pendingDeadline = pending.excluding(priority);
+        const uint64_t reservedDeadline = reservedPending.excluding(priority);
+
+        // Bit field of recipient addresses which were skipped
+        uint32_t skippedRecipients[NUM_RECIPIENT_ADDRESSES / 32] = {};
+        do
+        {
+            // Something is ready, so make sure it won't make a more urgent or reserved pending
+            // transmission miss its deadline
+            const Node& node = mNodePool[idx];
+            uint32_t word = node.recipientAddr / 32;
+            uint32_t mask = 1 << (node.recipientAddr % 32);
+            uint64_t limit = reservedDeadline;
+            if (pendingDeadline < node.tx->deadlineUs && pendingDeadline < limit)
             {
-                // Something was found, so make sure it won't be executing while something of higher
-                // priority is scheduled to run
-                uint64_t completionTime = (*itemIter)->getNextCompletionTime(time);
-                uint8_t recipientAddr = (*itemIter)->packet->frame.recipientAddr;
-
-                // Preserve order for each recipient
-                // (don't use this if we already skipped one for the same recipient)
-                if (std::find(recipients.begin(), recipients.end(), recipientAddr) == recipients.end())
-                {
-                    found = true;
-                    std::vector<std::list<std::shared_ptr<Transmission>>>::iterator scheduleIter2 = scheduleIter;
-                    do
-                    {
-                        --scheduleIter2;
-                        if (!scheduleIter2->empty() && (*scheduleIter2->begin())->nextTxTimeUs < completionTime)
-                        {
-                            // Something found - don't use this lower priority item
-                            found = false;
-                            break;
-                        }
-                    } while (scheduleIter2 != mSchedule.begin());
-                }
+                limit = pendingDeadline;
+            }
 
-                if (!found)
-                {
-                    recipients.push_back(recipientAddr);
-                    ++itemIter;
-                }
-                else
+            // Preserve order for each recipient
+            // (don't use this if we already skipped one for the same recipient)
+            if ((skippedRecipients[word] & mask) == 0
+                && node.tx->getNextCompletionTime(time) <= limit)
+            {
+                // Earliest deadline first within the reserved and unreserved groups
+                if (selectedIdx == INVALID_NODE_INDEX
+                    || (reserved && !selectedReserved)
+                    || node.tx->deadlineUs < selectedDeadline)
                 {
-                    break;
+                    selectedIdx = idx;
+                    selectedReserved = reserved;
+                    selectedDeadline = node.tx->deadlineUs;
                 }
-            } while (itemIter != scheduleIter->end() && (*itemIter)->nextTxTimeUs <= time);
-        }
+                break;
+            }
 
-        if (found)
-        {
-            scheduleItem.mScheduleIter = scheduleIter;
-            scheduleItem.mItemIter = itemIter;
-            scheduleItem.mTime = time;
-            scheduleItem.mIsValid = true;
-        }
+            skippedRecipients[word] |= mask;
+            idx = node.next;
+        } while (idx != INVALID_NODE_INDEX && nodeTime(idx) <= time);
+    }
+
+    if (selectedIdx != INVALID_NODE_INDEX)
+    {
+        scheduleItem.mNode = &mNodePool[selectedIdx];
+        scheduleItem.mTx = scheduleItem.mNode->tx.get();
+        scheduleItem.mTxId = scheduleItem.mTx->transmissionId;
+        scheduleItem.mNumCoalesced = scheduleItem.mTx->numCoalesced;
+        scheduleItem.mTime = time;
+        scheduleItem.mIsValid = true;
     }
 
     return scheduleItem;
@@ -199,111 +689,114 @@ std::shared_ptr<Transmission> PrioritizedTxScheduler::popItem(ScheduleItem& sche
     {
         LockGuard lock(mScheduleMutex);
 
-        // Save the transmission
-        item = scheduleItem.getTx();
-
-        // Pop it!
-        scheduleItem.mScheduleIter->erase(scheduleItem.mItemIter);
-        scheduleItem.mIsValid = false;
-
-        // Reschedule this if auto repeat settings are valid
-        if (item != nullptr
-            && item->autoRepeatUs > 0
-            && (item->autoRepeatEndTimeUs == 0 || scheduleItem.mTime <= item->autoRepeatEndTimeUs))
+        Node& node = *scheduleItem.mNode;
+        if (node.tx != nullptr
+            && node.tx.get() != scheduleItem.mTx
+            && node.tx->transmissionId == scheduleItem.mTxId
+            && node.tx->coalesceKey != Transmission::NO_COALESCE_KEY)
         {
-            item->nextTxTimeUs = computeNextTimeCadence(scheduleItem.mTime,
-                                                        item->autoRepeatUs,
-                                                        item->nextTxTimeUs);
-            add(item);
+            // Replaced just after it was peeked, so what was replaced is already out on the bus
+            // and accounts for everything it replaced; its replacement stays scheduled
+            node.tx->numCoalesced -= (scheduleItem.mNumCoalesced + 1);
         }
-    }
+        // Make sure the item wasn't canceled since it was peeked
+        else if (node.tx.get() == scheduleItem.mTx)
+        {
+            // Save the transmission
+            item = scheduleItem.mNode->tx;
+            NodeIndex idx = scheduleItem.mNode - &mNodePool[0];
 
-    return item;
-}
+            // Charge the bus time against any reservation of this priority
+            PriorityClass& priorityClass = mClasses[item->priority];
+            if (priorityClass.reservedUs > 0)
+            {
+                priorityClass.budgetUs -= item->txDurationUs;
+            }
 
-uint32_t PrioritizedTxScheduler::cancelById(uint32_t transmissionId)
-{
-    LockGuard lock(mScheduleMutex);
-    uint32_t n = 0;
-    for (std::vector<std::list<std::shared_ptr<Transmission>>>::iterator scheduleIter = mSchedule.begin();
-         scheduleIter != mSchedule.end();
-         ++scheduleIter)
-    {
-        std::list<std::shared_ptr<Transmission>>::iterator iter2 = scheduleIter->begin();
-        while (iter2 != scheduleIter->end())
-        {
-            if ((*iter2)->transmissionId == transmissionId)
+            if (item->nextStep != nullptr)
             {
-                iter2 = scheduleIter->erase(iter2);
-                ++n;
+                // Node is reused to hold the next step of the chain until this one completes, so
+                // it remains cancelable along with the rest of the chain
+                unlinkByTime(idx);
+                mNodePool[idx].tx = item->nextStep;
+                mNodePool[idx].tx->deadlineUs = UINT64_MAX;
+                linkByTime(idx);
+            }
+            // Reschedule this if auto repeat settings are valid
+            else if (item->autoRepeatUs > 0
+                && (item->autoRepeatEndTimeUs == 0 || scheduleItem.mTime <= item->autoRepeatEndTimeUs))
+            {
+                // Node is reused; just move it to its new place in time
+                unlinkByTime(idx);
+                item->nextTxTimeUs = computeNextTimeCadence(scheduleItem.mTime,
+                                                            item->autoRepeatUs,
+                                                            item->nextTxTimeUs);
+                item->deadlineUs = item->nextTxTimeUs + priorityClass.relativeDeadlineUs;
+                linkByTime(idx);
             }
             else
             {
-                ++iter2;
+                // Pop it!
+                removeNode(idx);
             }
         }
+
+        scheduleItem.mIsValid = false;
     }
 
-    return n;
+    return item;
 }
 
-uint32_t PrioritizedTxScheduler::cancelByRecipient(uint8_t recipientAddr)
+uint32_t PrioritizedTxScheduler::cancelById(uint32_t transmissionId)
 {
     LockGuard lock(mScheduleMutex);
     uint32_t n = 0;
-    for (std::vector<std::list<std::shared_ptr<Transmission>>>::iterator scheduleIter = mSchedule.begin();
-         scheduleIter != mSchedule.end();
-         ++scheduleIter)
+    NodeIndex idx = mIdBuckets[transmissionId & mIdBucketMask];
+    while (idx != INVALID_NODE_INDEX)
     {
-        std::list<std::shared_ptr<Transmission>>::iterator iter = scheduleIter->begin();
-        while (iter != scheduleIter->end())
+        NodeIndex nextIdx = mNodePool[idx].idNext;
+        if (mNodePool[idx].tx->transmissionId == transmissionId)
         {
-            if ((*iter)->packet->frame.recipientAddr == recipientAddr)
-            {
-                iter = scheduleIter->erase(iter);
-                ++n;
-            }
-            else
-            {
-                ++iter;
-            }
+            removeNode(idx);
+            ++n;
         }
+        idx = nextIdx;
     }
+
     return n;
 }
 
-uint32_t PrioritizedTxScheduler::countRecipients(uint8_t recipientAddr)
+uint32_t PrioritizedTxScheduler::cancelByRecipient(uint8_t recipientAddr)
 {
     LockGuard lock(mScheduleMutex);
     uint32_t n = 0;
-    for (std::vector<std::list<std::shared_ptr<Transmission>>>::iterator scheduleIter = mSchedule.begin();
-         scheduleIter != mSchedule.end();
-         ++scheduleIter)
+    while (mRecipientHeads[recipientAddr] != INVALID_NODE_INDEX)
     {
-        for (std::list<std::shared_ptr<Transmission>>::iterator iter = scheduleIter->begin();
-            iter != scheduleIter->end();
-            ++iter)
-        {
-            if ((*iter)->packet->frame.recipientAddr == recipientAddr)
-            {
-                ++n;
-            }
-        }
+        removeNode(mRecipientHeads[recipientAddr]);
+        ++n;
     }
     return n;
 }
 
+uint32_t PrioritizedTxScheduler::countRecipients(uint8_t recipientAddr) const
+{
+    // Single counter read - no need to lock
+    return mRecipientCounts[recipientAddr];
+}
+
 uint32_t PrioritizedTxScheduler::cancelAll()
 {
     LockGuard lock(mScheduleMutex);
     uint32_t n = 0;
-    for (std::vector<std::list<std::shared_ptr<Transmission>>>::iterator scheduleIter = mSchedule.begin();
+    for (std::vector<NodeList>::iterator scheduleIter = mSchedule.begin();
          scheduleIter != mSchedule.end();
          ++scheduleIter)
     {
-
-        n += scheduleIter->size();
-        scheduleIter->clear();
+        while (scheduleIter->head != INVALID_NODE_INDEX)
+        {
+            removeNode(scheduleIter->head);
+            ++n;
+        }
     }
     return n;
 }
@@ -27,7 +27,7 @@
 #include "hal/System/MutexInterface.hpp"
 #include "dreamcast_constants.h"
 #include "Transmission.hpp"
-#include <list>
+#include "BlockPool.hpp"
 #include <vector>
 #include <memory>
 
@@ -47,6 +47,100 @@ public:
         PRIORITY_COUNT
     };
 
+protected:
+    //! Index of a node within the node pool
+    typedef uint16_t NodeIndex;
+
+    //! Intrusive schedule node; each node in use is linked into the time-ordered list of its
+    //! priority, the list of its recipient address, and the bucket of its transmission ID
+    struct Node
+    {
+        //! The scheduled transmission (nullptr when this node is free)
+        std::shared_ptr<Transmission> tx;
+        //! Previous node in the priority list
+        NodeIndex prev;
+        //! Next node in the priority list (or next free node when this node is free)
+        NodeIndex next;
+        //! Previous node with the same recipient address
+        NodeIndex recipientPrev;
+        //! Next node with the same recipient address
+        NodeIndex recipientNext;
+        //! Next node in the same transmission ID bucket
+        NodeIndex idNext;
+        //! Recipient address of the transmission, saved when linked
+        uint8_t recipientAddr;
+    };
+
+    //! Doubly linked list of nodes, ordered by next transmission time
+    struct NodeList
+    {
+        //! First (earliest) node in the list
+        NodeIndex head;
+        //! Last (latest) node in the list
+        NodeIndex tail;
+    };
+
+    //! Deadline and bus time reservation settings and state of a single priority
+    struct PriorityClass
+    {
+        //! Time after release by which each transmission of this priority should start
+        uint32_t relativeDeadlineUs;
+        //! Bus time reserved in each reservation period (0 when nothing is reserved)
+        uint32_t reservedUs;
+        //! The reservation period in microseconds
+        uint32_t reservationPeriodUs;
+        //! Reserved bus time left in the current period (negative when overdrawn)
+        int64_t budgetUs;
+        //! Start time of the current reservation period
+        uint64_t periodStartUs;
+    };
+
+    //! Number of transmissions queued at a single priority
+    struct QueueDepth
+    {
+        //! Current number of queued transmissions
+        uint16_t current;
+        //! Most transmissions queued at once
+        uint16_t highWaterMark;
+    };
+
+    //! Tracks the two earliest deadlines of pending transmissions, each from a different priority,
+    //! so that each priority can be checked against all others
+    struct EarliestDeadlines
+    {
+        //! The earliest deadline
+        uint64_t first;
+        //! The earliest deadline of any other priority
+        uint64_t second;
+        //! The priority of the earliest deadline
+        uint32_t firstPriority;
+
+        //! Constructor
+        EarliestDeadlines() : first(UINT64_MAX), second(UINT64_MAX), firstPriority(UINT32_MAX) {}
+
+        //! Adds the deadline of the first pending transmission of a priority
+        inline void add(uint64_t deadline, uint32_t priority)
+        {
+            if (deadline < first)
+            {
+                second = first;
+                first = deadline;
+                firstPriority = priority;
+            }
+            else if (deadline < second)
+            {
+                second = deadline;
+            }
+        }
+
+        //! @returns the earliest deadline of all priorities except the given one
+        inline uint64_t excluding(uint32_t priority) const
+        {
+            return (priority == firstPriority) ? second : first;
+        }
+    };
+
+public:
     //! Points to a schedule item within the current schedule
     class ScheduleItem
     {
@@ -55,18 +149,29 @@ public:
 
         public:
             //! Constructor
-            ScheduleItem() : mIsValid(false), mTime(0) {}
+            ScheduleItem() :
+                mIsValid(false),
+                mNode(nullptr),
+                mTx(nullptr),
+                mTxId(INVALID_TX_ID),
+                mNumCoalesced(0),
+                mTime(0)
+            {}
 
             //! @returns the transmission for this schedule item
-            std::shared_ptr<Transmission> getTx() {return mIsValid ? *mItemIter : nullptr;}
+            std::shared_ptr<Transmission> getTx() {return mIsValid ? mNode->tx : nullptr;}
 
         private:
-            //! Set to true iff iterators are valid
+            //! Set to true iff mNode is valid
             bool mIsValid;
-            //! The schedule group
-            std::vector<std::list<std::shared_ptr<Transmission>>>::iterator mScheduleIter;
-            //! The item within the schedule group
-            std::list<std::shared_ptr<Transmission>>::iterator mItemIter;
+            //! The node within the node pool
+            Node* mNode;
+            //! The transmission which was held by the node when peeked
+            const Transmission* mTx;
+            //! ID of the above transmission
+            uint32_t mTxId;
+            //! Number of superseded transmissions the above transmission replaced
+            uint32_t mNumCoalesced;
             //! The time at which this item was peeked
             uint64_t mTime;
     };
@@ -75,7 +180,13 @@ public:
     //! Default constructor
     //! @param[in] senderAddress  The sender address set in every packet added
     //! @param[in] max  The maximum accepted priority
-    PrioritizedTxScheduler(MutexInterface& m, uint8_t senderAddress, uint32_t max = (PRIORITY_COUNT-1));
+    //! @param[in] capacity  The maximum number of transmissions which may be queued at once
+    //! @param[in] poolSize  Number of transmissions and packets to preallocate
+    PrioritizedTxScheduler(MutexInterface& m,
+                           uint8_t senderAddress,
+                           uint32_t max = (PRIORITY_COUNT-1),
+                           uint32_t capacity = DEFAULT_MAX_QUEUED_TRANSMISSIONS,
+                           uint32_t poolSize = DEFAULT_POOL_SIZE);
 
     //! Virtual destructor
     virtual ~PrioritizedTxScheduler();
@@ -89,7 +200,7 @@ public:
     //! @param[in] expectedResponseNumPayloadWords  Number of payload words to expect in response
     //! @param[in] autoRepeatUs  How often to repeat this transmission in microseconds
     //! @param[in] autoRepeatEndTimeUs  If not 0, auto repeat will cancel after this time
-    //! @returns transmission ID
+    //! @returns transmission ID or INVALID_TX_ID if the schedule is full
     uint32_t add(uint8_t priority,
                  uint64_t txTime,
                  Transmitter* transmitter,
@@ -99,7 +210,70 @@ public:
                  uint32_t autoRepeatUs=0,
                  uint64_t autoRepeatEndTimeUs=0);
 
+    //! Add a transmission to the schedule which replaces, in place, any unsent transmission of
+    //! the same priority to the same recipient with the same command and function code
+    //! @param[in] priority  priority of this transmission (0 is highest priority)
+    //! @param[in] txTime  Time at which this should transmit in microseconds (ignored when an
+    //!                    unsent transmission is replaced - it keeps its place in the schedule)
+    //! @param[in] transmitter  Pointer to transmitter that is adding this
+    //! @param[in,out] packet  Packet data to send (internal data is moved upon calling this)
+    //! @param[in] expectResponse  true iff a response is expected after transmission
+    //! @param[in] expectedResponseNumPayloadWords  Number of payload words to expect in response
+    //! @returns transmission ID (the ID of the replaced transmission if one was replaced) or
+    //!          INVALID_TX_ID if the schedule is full
+    uint32_t addLatest(uint8_t priority,
+                       uint64_t txTime,
+                       Transmitter* transmitter,
+                       MaplePacket& packet,
+                       bool expectResponse,
+                       uint32_t expectedResponseNumPayloadWords=0);
+
+    //! Add a chain of dependent transmissions to the schedule; each step after the first is held
+    //! until continueChain() is called for the step before it
+    //! @param[in] priority  priority of this chain (0 is highest priority)
+    //! @param[in] txTime  Time at which the first step should transmit in microseconds
+    //! @param[in] transmitter  Pointer to transmitter that is adding this
+    //! @param[in,out] steps  The steps of the chain, all to the same recipient (packet data is
+    //!                       moved upon calling this)
+    //! @param[in] numSteps  Number of steps (must be > 0)
+    //! @returns transmission ID shared by every step or INVALID_TX_ID if the schedule is full
+    uint32_t addChain(uint8_t priority,
+                      uint64_t txTime,
+                      Transmitter* transmitter,
+                      TransmissionChainStep* steps,
+                      uint32_t numSteps);
+
+    //! Releases the step which follows the given one in its chain
+    //! @param[in] tx  The step which just completed with the expected response
+    //! @param[in] completionTime  The time the given step completed
+    void continueChain(const Transmission& tx, uint64_t completionTime);
+
+    //! Drops every step which follows the given one in its chain
+    //! @param[in] tx  The step which failed
+    void abortChain(const Transmission& tx);
+
+    //! Sets how long after its release each transmission of a priority may wait to start; a
+    //! transmission is released at its scheduled time, or when added if scheduled ASAP
+    //! @param[in] priority  The priority to configure
+    //! @param[in] relativeDeadlineUs  Time from release to deadline in microseconds; this applies
+    //!                                to transmissions added or repeated after this call
+    void setRelativeDeadline(uint8_t priority, uint32_t relativeDeadlineUs);
+
+    //! Reserves bus time for a priority. While a priority has reserved time left, its transmissions
+    //! are selected ahead of unreserved ones, and nothing of any priority is started if it would
+    //! make a pending transmission of this priority miss its deadline.
+    //! @param[in] priority  The priority to configure
+    //! @param[in] reservedUs  Bus time granted in each period (0 to remove the reservation)
+    //! @param[in] periodUs  The period over which reservedUs is granted in microseconds
+    void setReservation(uint8_t priority, uint32_t reservedUs, uint32_t periodUs);
+
     //! Peeks the next scheduled packet, given the current time
+    //!
+    //! Ready transmissions of priorities with reserved time left are selected first, earliest
+    //! deadline first, followed by the rest, earliest deadline first. Ties go to the higher
+    //! priority. A transmission isn't selected if it is expected to complete after the deadline of
+    //! a pending transmission which either has an earlier deadline or is of a priority with
+    //! reserved time left.
     //! @param[in] time  The current time
     //! @returns nullptr if no scheduled packet is available for the given time
     //! @returns the next scheduled item for the given current time
@@ -122,12 +296,52 @@ public:
     //! Count how many scheduled transmissions have a given recipient address
     //! @param[in] recipientAddr  The recipient address
     //! @returns the number of transmissions have the given recipient address
-    uint32_t countRecipients(uint8_t recipientAddr);
+    uint32_t countRecipients(uint8_t recipientAddr) const;
 
     //! Cancels all items in the schedule
     //! @returns number of transmissions successfully canceled
     uint32_t cancelAll();
 
+    //! @returns a new, empty packet allocated from this scheduler's packet pool
+    std::shared_ptr<MaplePacket> makePacket();
+
+    //! @returns usage statistics of the transmission pool
+    BlockPool::Stats getTransmissionPoolStats() const;
+
+    //! @returns usage statistics of the packet pool
+    BlockPool::Stats getPacketPoolStats() const;
+
+    //! @returns the number of priorities in this schedule
+    inline uint32_t getNumPriorities() const { return mSchedule.size(); }
+
+    //! @param[in] priority  A priority less than getNumPriorities()
+    //! @returns the number of transmissions currently queued at the given priority
+    inline uint32_t getQueueDepth(uint8_t priority) const
+    {
+        return mQueueDepths[priority].current;
+    }
+
+    //! @param[in] priority  A priority less than getNumPriorities()
+    //! @returns the most transmissions queued at once at the given priority since the last call
+    //!          to resetQueueDepthHighWaterMarks()
+    inline uint32_t getQueueDepthHighWaterMark(uint8_t priority) const
+    {
+        return mQueueDepths[priority].highWaterMark;
+    }
+
+    //! Sets the high water mark of each priority to its current queue depth
+    void resetQueueDepthHighWaterMarks();
+
+    //! @param[in] tx  A scheduled transmission
+    //! @returns the time the given transmission became or becomes ready to be sent
+    inline uint64_t getReleaseTime(const Transmission& tx) const
+    {
+        return tx.deadlineUs - mClasses[tx.priority].relativeDeadlineUs;
+    }
+
+    //! @returns the number of unsent transmissions which were replaced by addLatest()
+    inline uint32_t getNumCoalesced() const { return mNumCoalesced; }
+
     //! Computes the next time on a cadence
     //! @param[in] currentTime  The current time
     //! @param[in] period  The period at which this item is scheduled (must be > 0)
@@ -137,25 +351,132 @@ public:
                                            uint64_t period,
                                            uint64_t offset = 0);
 
+    //! Computes the expected bus time of a transmission
+    //! @param[in] numPayloadWords  Number of payload words written
+    //! @param[in] expectResponse  true iff a response is expected after transmission
+    //! @param[in] expectedResponseNumPayloadWords  Number of payload words to expect in response
+    //! @returns the expected duration from start of write to end of read in microseconds
+    static uint32_t computeTxDurationUs(uint32_t numPayloadWords,
+                                        bool expectResponse,
+                                        uint32_t expectedResponseNumPayloadWords);
+
 protected:
+    //! Allocates a transmission from the transmission pool
+    //! @param[in] transmissionId  ID of the transmission
+    //! @param[in] priority  priority of this transmission (0 is highest priority)
+    //! @param[in] txTime  Time at which this should transmit in microseconds
+    //! @param[in] transmitter  Pointer to transmitter that is adding this
+    //! @param[in,out] packet  Packet data to send (internal data is moved upon calling this)
+    //! @param[in] expectResponse  true iff a response is expected after transmission
+    //! @param[in] expectedResponseNumPayloadWords  Number of payload words to expect in response
+    //! @param[in] autoRepeatUs  How often to repeat this transmission in microseconds
+    //! @param[in] autoRepeatEndTimeUs  If not 0, auto repeat will cancel after this time
+    //! @returns the new transmission
+    std::shared_ptr<Transmission> makeTransmission(uint32_t transmissionId,
+                                                   uint8_t priority,
+                                                   uint64_t txTime,
+                                                   Transmitter* transmitter,
+                                                   MaplePacket& packet,
+                                                   bool expectResponse,
+                                                   uint32_t expectedResponseNumPayloadWords,
+                                                   uint32_t autoRepeatUs,
+                                                   uint64_t autoRepeatEndTimeUs);
+
     //! Add a transmission to the schedule
     //! @param[in] tx  The transmission to add
-    //! @returns transmission ID
+    //! @returns transmission ID or INVALID_TX_ID if the schedule is full
     uint32_t add(std::shared_ptr<Transmission> tx);
 
+    //! @param[in] step  A chain step which may be held in the schedule
+    //! @returns the index of the node holding the given chain step or INVALID_NODE_INDEX
+    NodeIndex findHeldStep(const Transmission* step) const;
+
+    //! Links a node into its priority list, after all nodes with the same or earlier time
+    //! @param[in] idx  Index of the node to link
+    void linkByTime(NodeIndex idx);
+
+    //! Unlinks a node from its priority list
+    //! @param[in] idx  Index of the node to unlink
+    void unlinkByTime(NodeIndex idx);
+
+    //! Unlinks a node from all lists and returns it to the free list
+    //! @param[in] idx  Index of the node to remove
+    void removeNode(NodeIndex idx);
+
+    //! @returns the scheduled transmission time of the node at the given index
+    inline uint64_t nodeTime(NodeIndex idx) const
+    {
+        return mNodePool[idx].tx->nextTxTimeUs;
+    }
+
+    //! Adds reserved time for every reservation period which has fully elapsed
+    //! @param[in,out] priorityClass  The priority class to replenish
+    //! @param[in] time  The current time
+    static void replenish(PriorityClass& priorityClass, uint64_t time);
+
+    //! @returns true iff the given priority has reserved bus time left
+    inline bool isReserved(uint32_t priority) const
+    {
+        return (mClasses[priority].reservedUs > 0 && mClasses[priority].budgetUs > 0);
+    }
+
 public:
     //! Use this for txTime if the packet needs to be sent ASAP
     static const uint64_t TX_TIME_ASAP = 0;
+    //! Scheduled time of a chain step which waits for the step before it
+    static const uint64_t TX_TIME_HELD = UINT64_MAX;
     //! Transmission ID to use in order to flag no ID
     static const uint32_t INVALID_TX_ID = 0;
+    //! Default maximum number of transmissions which may be queued at once
+    static const uint32_t DEFAULT_MAX_QUEUED_TRANSMISSIONS = 128;
+    //! Default number of transmissions and packets to preallocate
+    static const uint32_t DEFAULT_POOL_SIZE = 32;
+    //! Default reservation period
+    static const uint32_t DEFAULT_RESERVATION_PERIOD_US = 2000;
+    //! Default bus time reserved for the main peripheral in each reservation period; controller
+    //! polls are never scheduled to use more than half of the bus
+    static const uint32_t DEFAULT_MAIN_RESERVED_US = DEFAULT_RESERVATION_PERIOD_US / 2;
+    //! Default relative deadline of sub peripheral transmissions (about one video frame)
+    static const uint32_t DEFAULT_SUB_RELATIVE_DEADLINE_US = 16000;
 
 protected:
+    //! Node index used to flag the end of a list
+    static const NodeIndex INVALID_NODE_INDEX = 0xFFFF;
+    //! Space allowed in each pool block for the shared_ptr control block
+    static const uint32_t POOL_BLOCK_OVERHEAD = 8 * sizeof(void*);
+    //! Number of possible recipient addresses
+    static const uint32_t NUM_RECIPIENT_ADDRESSES = 256;
+
     //! Mutex used to serialize push/pop of external items
     MutexInterface& mScheduleMutex;
     //! The address of this sender
     const uint8_t mSenderAddress;
     //! The next transmission ID to set
     uint32_t mNextId;
-    //! The current schedule ordered by priority and time
-    std::vector<std::list<std::shared_ptr<Transmission>>> mSchedule;
+    //! Fixed-capacity pool of schedule nodes (never resized after construction)
+    std::vector<Node> mNodePool;
+    //! First free node in the pool
+    NodeIndex mFreeHead;
+    //! The current schedule, one time-ordered list for each priority
+    std::vector<NodeList> mSchedule;
+    //! Deadline and reservation settings for each priority
+    std::vector<PriorityClass> mClasses;
+    //! Queue depth of each priority
+    std::vector<QueueDepth> mQueueDepths;
+    //! Time passed to the last call to peekNext(), which is the release time of ASAP transmissions
+    uint64_t mLastPeekTimeUs;
+    //! Number of unsent transmissions which were replaced by addLatest()
+    uint32_t mNumCoalesced;
+    //! First node for each recipient address
+    NodeIndex mRecipientHeads[NUM_RECIPIENT_ADDRESSES];
+    //! Number of scheduled transmissions for each recipient address
+    uint16_t mRecipientCounts[NUM_RECIPIENT_ADDRESSES];
+    //! First node of each transmission ID bucket
+    std::vector<NodeIndex> mIdBuckets;
+    //! Mask applied to a transmission ID in order to select a bucket
+    uint32_t mIdBucketMask;
+    //! Pool which Transmission objects are allocated from
+    std::shared_ptr<BlockPool> mTransmissionPool;
+    //! Pool which MaplePacket objects are allocated from
+    std::shared_ptr<BlockPool> mPacketPool;
 };
\ No newline at end of file
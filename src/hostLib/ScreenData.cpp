@@ -24,8 +24,6 @@
 #include "ScreenData.hpp"
 #include <cstring>
 #include <assert.h>
-#include "hal/System/LockGuard.hpp"
-#include "utils.h"
 
 const uint32_t ScreenData::DEFAULT_SCREENS[ScreenData::NUM_DEFAULT_SCREENS][ScreenData::NUM_SCREEN_WORDS] = {
     {
@@ -62,9 +60,8 @@ const uint32_t ScreenData::DEFAULT_SCREENS[ScreenData::NUM_DEFAULT_SCREENS][Scre
     }
 };
 
-ScreenData::ScreenData(MutexInterface& mutex, uint32_t defaultScreenNum) :
-    mMutex(mutex),
-    mNewDataAvailable(false)
+ScreenData::ScreenData(uint32_t defaultScreenNum) :
+    mScreens()
 {
     if (defaultScreenNum > NUM_DEFAULT_SCREENS)
     {
@@ -76,17 +73,15 @@ ScreenData::ScreenData(MutexInterface& mutex, uint32_t defaultScreenNum) :
 
 void ScreenData::setData(const uint32_t* data, uint32_t startIndex, uint32_t numWords)
 {
-    assert(startIndex + numWords <= sizeof(mScreenData));
-    LockGuard lockGuard(mMutex);
-    if (lockGuard.isLocked())
+    assert(startIndex + numWords <= NUM_SCREEN_WORDS);
+    Screen& screen = mScreens.beginWrite();
+    if (numWords < NUM_SCREEN_WORDS)
     {
-        std::memcpy(mScreenData + startIndex, data, numWords * sizeof(uint32_t));
-        mNewDataAvailable = true;
-    }
-    else
-    {
-        DEBUG_PRINT("FAULT: failed to set screen data\n");
+        // Only part of the screen is changing; start from the current screen
+        screen = mScreens.getPublished();
     }
+    std::memcpy(screen.words + startIndex, data, numWords * sizeof(uint32_t));
+    mScreens.publish();
 }
 
 void ScreenData::setDataToADefault(uint32_t defaultScreenNum)
@@ -100,27 +95,16 @@ void ScreenData::setDataToADefault(uint32_t defaultScreenNum)
 
 void ScreenData::resetToDefault()
 {
-    std::memcpy(mScreenData, mDefaultScreen, sizeof(mScreenData));
     // Always force an update
-    mNewDataAvailable = true;
+    setData(mDefaultScreen);
 }
 
 bool ScreenData::isNewDataAvailable() const
 {
-    return mNewDataAvailable;
+    return mScreens.isNewDataAvailable();
 }
 
 void ScreenData::readData(uint32_t* out)
 {
-    LockGuard lockGuard(mMutex);
-    if (lockGuard.isLocked())
-    {
-        mNewDataAvailable = false;
-    }
-    else
-    {
-        DEBUG_PRINT("FAULT: failed to properly read screen data\n");
-    }
-    // Allow this to happen, even if locking failed
-    std::memcpy(out, mScreenData, sizeof(mScreenData));
+    std::memcpy(out, mScreens.read().words, sizeof(Screen::words));
 }
@@ -23,35 +23,38 @@
 
 #pragma once
 
-#include "hal/System/MutexInterface.hpp"
+#include "hal/System/TripleBuffer.hpp"
 #include <stdint.h>
 
 //! Contains monochrome screen data
 //! A screen is 48 bits wide and 32 bits tall
+//! Screens are set by a single producer and read by a single consumer, which may be on different
+//! cores; the consumer always reads a whole screen, as it was last set.
 class ScreenData
 {
     public:
         //! Constructor
-        //! @param[in] mutex  Reference to the mutex to use (critical section mutex recommended)
-        ScreenData(MutexInterface& mutex, uint32_t defaultScreenNum=0);
+        //! @param[in] defaultScreenNum  The default screen to initialize with
+        ScreenData(uint32_t defaultScreenNum=0);
 
-        //! Set the screen bits
+        //! Set the screen bits (producer only)
         //! @param[in] data  Screen words to set
         //! @param[in] startIndex  Starting screen word index (left to right, top to bottom)
         //! @param[in] numWords  Number of words to write
         void setData(const uint32_t* data, uint32_t startIndex=0, uint32_t numWords=NUM_SCREEN_WORDS);
 
-        //! Sets the current screen to one of the 4 defaults
+        //! Sets the current screen to one of the 4 defaults (producer only)
         //! @param[in] defaultScreenNum  The default screen number to set the screen to
         void setDataToADefault(uint32_t defaultScreenNum);
 
-        //! Resets the screen to its initialized default
+        //! Resets the screen to its initialized default (producer only)
         void resetToDefault();
 
+        //! Consumer only
         //! @returns true if new data is available since last call to readData
         bool isNewDataAvailable() const;
 
-        //! Copies screen data to the given array
+        //! Copies screen data to the given array (consumer only)
         //! @param[out] out  The array to write to (must be at least 48 words in length)
         void readData(uint32_t* out);
 
@@ -62,14 +65,16 @@ class ScreenData
         static const uint32_t NUM_DEFAULT_SCREENS = 4;
 
     private:
+        //! A whole screen
+        struct Screen
+        {
+            uint32_t words[NUM_SCREEN_WORDS];
+        };
+
         //! The default screen data on initialization and resetToDefault()
         static const uint32_t DEFAULT_SCREENS[NUM_DEFAULT_SCREENS][NUM_SCREEN_WORDS];
-        //! Mutex used to ensure integrity of data between multiple cores
-        MutexInterface& mMutex;
         //! Default screen to revert to on resetToDefault()
         uint32_t mDefaultScreen[NUM_SCREEN_WORDS];
-        //! The current screen data
-        uint32_t mScreenData[NUM_SCREEN_WORDS];
-        //! Flag set to true in setData and set to false in readData
-        bool mNewDataAvailable;
+        //! The current screen data, handed from producer to consumer
+        TripleBuffer<Screen> mScreens;
 };
@@ -45,10 +45,27 @@ struct Transmission
     const uint64_t autoRepeatEndTimeUs;
     //! The next time that this packet is to be transmitted
     uint64_t nextTxTimeUs;
+    //! The latest time that this packet should start to be transmitted; set by the scheduler
+    //! from the release time and the relative deadline of its priority
+    uint64_t deadlineUs;
     //! The packet to transmit
     std::shared_ptr<const MaplePacket> packet;
     //! The object that added this transmission (for callbacks)
     Transmitter* const transmitter;
+    //! The next step of the chain this is a part of (nullptr if this is the last or only step)
+    std::shared_ptr<Transmission> nextStep;
+    //! Minimum time from the completion of the previous step of the chain until this is sent
+    uint32_t stepGapUs;
+    //! Response command which lets the chain continue with nextStep
+    uint8_t continueCommand;
+    //! If not NO_COALESCE_KEY, a newer transmission with the same key replaces this one until it
+    //! is sent (see makeCoalesceKey())
+    uint64_t coalesceKey;
+    //! Number of superseded transmissions this one replaced
+    uint32_t numCoalesced;
+
+    //! Value of coalesceKey for transmissions which are never replaced
+    static const uint64_t NO_COALESCE_KEY = 0;
 
     Transmission(uint32_t transmissionId,
                  uint8_t priority,
@@ -66,13 +83,51 @@ struct Transmission
         autoRepeatUs(autoRepeatUs),
         autoRepeatEndTimeUs(autoRepeatEndTimeUs),
         nextTxTimeUs(nextTxTimeUs),
+        deadlineUs(nextTxTimeUs),
         packet(packet),
-        transmitter(transmitter)
+        transmitter(transmitter),
+        nextStep(nullptr),
+        stepGapUs(0),
+        continueCommand(0),
+        coalesceKey(NO_COALESCE_KEY),
+        numCoalesced(0)
     {}
 
+    //! @param[in] packet  A packet to be sent
+    //! @returns the coalescing key of the given packet, made from its recipient, command, and
+    //!          function code
+    static uint64_t makeCoalesceKey(const MaplePacket& packet)
+    {
+        uint32_t functionCode = (packet.payload.size() > 0) ? packet.payload[0] : 0;
+        // Top bit keeps this from ever matching NO_COALESCE_KEY
+        return (1ULL << 63)
+            | (static_cast<uint64_t>(packet.frame.recipientAddr) << 40)
+            | (static_cast<uint64_t>(packet.frame.command) << 32)
+            | functionCode;
+    }
+
     //! @returns the estimated completion time of this transmission
     uint64_t getNextCompletionTime(uint64_t executionTime)
     {
         return executionTime + txDurationUs;
     }
-};
\ No newline at end of file
+};
+
+//! Describes one step of a chain of dependent transmissions; each step is only sent once the
+//! previous step completed with the expected response, and the rest of the chain is dropped
+//! otherwise
+struct TransmissionChainStep
+{
+    //! The packet to send (internal data is moved when the chain is added)
+    MaplePacket* packet;
+    //! Set to true iff a response is expected after transmission
+    bool expectResponse;
+    //! Number of payload words to expect in response
+    uint32_t expectedResponseNumPayloadWords;
+    //! Response command which lets the chain continue past this step (ignored if no response is
+    //! expected)
+    uint8_t continueCommand;
+    //! Minimum time from the completion of the previous step until this is sent (ignored for the
+    //! first step)
+    uint32_t minGapUs;
+};
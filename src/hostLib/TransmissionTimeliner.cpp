@@ -24,8 +24,10 @@
 #include "TransmissionTimeliner.hpp"
 #include <assert.h>
 
-TransmissionTimeliner::TransmissionTimeliner(MapleBusInterface& bus, std::shared_ptr<PrioritizedTxScheduler> schedule):
-    mBus(bus), mSchedule(schedule), mCurrentTx(nullptr)
+TransmissionTimeliner::TransmissionTimeliner(MapleBusInterface& bus,
+                                             std::shared_ptr<PrioritizedTxScheduler> schedule,
+                                             BusStats* busStats):
+    mBus(bus), mSchedule(schedule), mCurrentTx(nullptr), mReceived(), mBusStats(busStats)
 {}
 
 TransmissionTimeliner::ReadStatus TransmissionTimeliner::readTask(uint64_t currentTimeUs)
@@ -37,8 +39,9 @@ TransmissionTimeliner::ReadStatus TransmissionTimeliner::readTask(uint64_t curre
     status.busPhase = busStatus.phase;
     if (status.busPhase == MapleBusInterface::Phase::READ_COMPLETE)
     {
-        status.received = std::make_shared<MaplePacket>(busStatus.readBuffer,
-                                                        busStatus.readBufferLen);
+        // No copy here - transmitters consume the bus receive buffer directly
+        mReceived.set(busStatus.readBuffer, busStatus.readBufferLen);
+        status.received = &mReceived;
         status.transmission = mCurrentTx;
         mCurrentTx = nullptr;
     }
@@ -50,6 +53,35 @@ TransmissionTimeliner::ReadStatus TransmissionTimeliner::readTask(uint64_t curre
         mCurrentTx = nullptr;
     }
 
+    if (mBusStats != nullptr
+        && (status.busPhase == MapleBusInterface::Phase::READ_COMPLETE
+            || status.busPhase == MapleBusInterface::Phase::WRITE_COMPLETE
+            || status.busPhase == MapleBusInterface::Phase::READ_FAILED
+            || status.busPhase == MapleBusInterface::Phase::WRITE_FAILED))
+    {
+        mBusStats->transferEnded(status.busPhase, busStatus.failureReason, currentTimeUs);
+    }
+
+    if (status.transmission != nullptr && status.transmission->nextStep != nullptr)
+    {
+        // The next step of a chain is released as soon as this step is validated so that it
+        // doesn't wait on the transmitter
+        bool stepComplete = (status.busPhase == MapleBusInterface::Phase::WRITE_COMPLETE);
+        if (status.received != nullptr)
+        {
+            stepComplete = (status.received->frame.command == status.transmission->continueCommand);
+        }
+
+        if (stepComplete)
+        {
+            mSchedule->continueChain(*status.transmission, currentTimeUs);
+        }
+        else
+        {
+            mSchedule->abortChain(*status.transmission);
+        }
+    }
+
     return status;
 }
 
@@ -65,6 +97,12 @@ std::shared_ptr<const Transmission> TransmissionTimeliner::writeTask(uint64_t cu
         {
             if (mBus.write(*txSent->packet, txSent->expectResponse))
             {
+                if (mBusStats != nullptr)
+                {
+                    // Taken before popItem() moves the times of a repeating transmission
+                    mBusStats->writeStarted(
+                        mSchedule->getReleaseTime(*txSent), txSent->deadlineUs, currentTimeUs);
+                }
                 mCurrentTx = txSent;
                 mSchedule->popItem(item);
             }
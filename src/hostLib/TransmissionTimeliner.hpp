@@ -24,8 +24,10 @@
 #pragma once
 
 #include "hal/MapleBus/MaplePacket.hpp"
+#include "hal/MapleBus/MaplePacketView.hpp"
 #include "hal/MapleBus/MapleBusInterface.hpp"
 #include "PrioritizedTxScheduler.hpp"
+#include "BusStats.hpp"
 
 class TransmissionTimeliner
 {
@@ -35,8 +37,9 @@ public:
     {
         //! The transmission associated with the data below
         std::shared_ptr<const Transmission> transmission;
-        //! Set to received packet or nullptr if nothing received
-        std::shared_ptr<const MaplePacket> received;
+        //! Set to a view of the received packet or nullptr if nothing received; this views the bus
+        //! receive buffer directly and is only valid until the next call to readTask()
+        const MaplePacketView* received;
         //! The phase of the maple bus
         MapleBusInterface::Phase busPhase;
 
@@ -51,7 +54,10 @@ public:
     //! Constructor
     //! @param[in] bus  The maple bus that scheduled transmissions are written to
     //! @param[in] schedule  The schedule to pop transmissions from
-    TransmissionTimeliner(MapleBusInterface& bus, std::shared_ptr<PrioritizedTxScheduler> schedule);
+    //! @param[in] busStats  Statistics to update for the bus or nullptr
+    TransmissionTimeliner(MapleBusInterface& bus,
+                          std::shared_ptr<PrioritizedTxScheduler> schedule,
+                          BusStats* busStats = nullptr);
 
     //! Read timeliner task - called periodically to process timeliner read events
     //! @param[in] currentTimeUs  The current time task is run
@@ -70,4 +76,8 @@ protected:
     std::shared_ptr<PrioritizedTxScheduler> mSchedule;
     //! The currently sending transmission
     std::shared_ptr<const Transmission> mCurrentTx;
+    //! View of the last received data, pointed to by ReadStatus::received
+    MaplePacketView mReceived;
+    //! Statistics to update for the bus or nullptr
+    BusStats* const mBusStats;
 };
\ No newline at end of file
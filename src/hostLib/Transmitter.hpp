@@ -26,8 +26,9 @@
 #include <stdint.h>
 #include <memory>
 
+#include "hal/MapleBus/MaplePacketView.hpp"
+
 struct Transmission;
-struct MaplePacket;
 
 class Transmitter
 {
@@ -48,8 +49,9 @@ public:
                           std::shared_ptr<const Transmission> tx) = 0;
 
     //! Called when a transmission is complete
-    //! @param[in] packet  The packet received or nullptr if this was write only transmission
+    //! @param[in] packet  The packet received or nullptr if this was write only transmission; this
+    //!                   views the bus receive buffer, so it is only valid until this returns
     //! @param[in] tx  The transmission that triggered this data
-    virtual void txComplete(std::shared_ptr<const MaplePacket> packet,
+    virtual void txComplete(const MaplePacketView* packet,
                             std::shared_ptr<const Transmission> tx) = 0;
 };
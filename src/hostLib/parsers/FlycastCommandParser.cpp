@@ -1,5 +1,6 @@
 #include "FlycastCommandParser.hpp"
 #include "hal/MapleBus/MaplePacket.hpp"
+#include "hal/Usb/CdcFrame.hpp"
 
 #include <stdio.h>
 #include <cctype>
@@ -9,6 +10,8 @@
 
 // Format: X[modifier-char]<cmd-data>\n
 // This parser must always return a single line of data
+// In binary mode, data of an X frame is a Maple packet as raw words, and the response is an X frame
+// holding either raw words or, with the text flag set, a failure string
 
 // Simple definition of a transmitter which just echos status and received data
 class FlycastEchoTransmitter : public Transmitter
@@ -21,34 +24,96 @@ public:
                           bool readFailed,
                           std::shared_ptr<const Transmission> tx) final
     {
-        if (writeFailed)
+        // Every command this replaced gets the same response
+        for (uint32_t i = 0; i <= tx->numCoalesced; ++i)
         {
-            printf("*failed write\n");
+            if (writeFailed)
+            {
+                printf("*failed write\n");
+            }
+            else
+            {
+                printf("*failed read\n");
+            }
         }
-        else
+    }
+
+    virtual void txComplete(const MaplePacketView* packet,
+                            std::shared_ptr<const Transmission> tx) final
+    {
+        // Every command this replaced gets the same response
+        for (uint32_t i = 0; i <= tx->numCoalesced; ++i)
         {
-            printf("*failed read\n");
+            printf(
+                "%02hhX %02hhX %02hhX %02hhX",
+                packet->frame.command,
+                packet->frame.recipientAddr,
+                packet->frame.senderAddr,
+                packet->frame.length);
+
+            for (uint32_t p : packet->payload)
+            {
+                printf(" %08lX", p);
+            }
+
+            printf("\n");
         }
     }
+} flycastEchoTransmitter;
+
+// Binary mode equivalent of FlycastEchoTransmitter which responds with frames
+class FlycastBinaryEchoTransmitter : public Transmitter
+{
+public:
+    virtual void txStarted(std::shared_ptr<const Transmission> tx) final
+    {}
 
-    virtual void txComplete(std::shared_ptr<const MaplePacket> packet,
+    virtual void txFailed(bool writeFailed,
+                          bool readFailed,
+                          std::shared_ptr<const Transmission> tx) final
+    {
+        // Every command this replaced gets the same response
+        for (uint32_t i = 0; i <= tx->numCoalesced; ++i)
+        {
+            if (writeFailed)
+            {
+                CdcFrame::writeString('X', "*failed write");
+            }
+            else
+            {
+                CdcFrame::writeString('X', "*failed read");
+            }
+        }
+    }
+
+    virtual void txComplete(const MaplePacketView* packet,
                             std::shared_ptr<const Transmission> tx) final
     {
-        printf(
-            "%02hhX %02hhX %02hhX %02hhX",
-            packet->frame.command,
-            packet->frame.recipientAddr,
-            packet->frame.senderAddr,
-            packet->frame.length);
-
-        for (uint32_t p : packet->payload)
+        uint32_t frameWord = packet->frame.toWord();
+        // Every command this replaced gets the same response
+        for (uint32_t i = 0; i <= tx->numCoalesced; ++i)
         {
-            printf(" %08lX", p);
+            CdcFrame::write('X',
+                            &frameWord,
+                            sizeof(frameWord),
+                            packet->payload.data(),
+                            packet->payload.size() * sizeof(uint32_t));
         }
+    }
+} flycastBinaryEchoTransmitter;
 
-        printf("\n");
+//! Prints a failure response in the same mode as the command
+static void printFailure(bool binary, const char* str)
+{
+    if (binary)
+    {
+        CdcFrame::writeString('X', str);
     }
-} flycastEchoTransmitter;
+    else
+    {
+        printf("%s\n", str);
+    }
+}
 
 FlycastCommandParser::FlycastCommandParser(
     SystemIdentification& identification,
@@ -202,6 +267,198 @@ void FlycastCommandParser::submit(const char* chars, uint32_t len)
             }
             return;
 
+            // XM prints memory pool statistics for each bus:
+            // <idx> tx <in use> <high water mark> <size> <failures> pkt <in use> <high water mark> <size> <failures> co <coalesced>
+            // where coalesced is the number of superseded commands replaced before being sent
+            case 'M' :
+            {
+                for (uint32_t i = 0; i < mNumSenders; ++i)
+                {
+                    BlockPool::Stats txStats = mSchedulers[i]->getTransmissionPoolStats();
+                    BlockPool::Stats pktStats = mSchedulers[i]->getPacketPoolStats();
+                    printf("%lu tx %lu %lu %lu %lu pkt %lu %lu %lu %lu co %lu\n",
+                           (long unsigned int)i,
+                           (long unsigned int)txStats.numInUse,
+                           (long unsigned int)txStats.highWaterMark,
+                           (long unsigned int)txStats.numBlocks,
+                           (long unsigned int)txStats.numFailures,
+                           (long unsigned int)pktStats.numInUse,
+                           (long unsigned int)pktStats.highWaterMark,
+                           (long unsigned int)pktStats.numBlocks,
+                           (long unsigned int)pktStats.numFailures,
+                           (long unsigned int)mSchedulers[i]->getNumCoalesced());
+                }
+            }
+            return;
+
+            // XL prints controller poll latency histograms for each player; one line per histogram:
+            // <idx> <name> <count> <min us> <avg us> <max us> <bucket counts...>
+            // where bucket 0 counts 0 us and bucket n counts [2^(n-1), 2^n) us
+            // XL- clears all latency histograms and prints the number of players cleared
+            case 'L' :
+            {
+                // Remove L
+                ++iter;
+                bool clear = (iter < eol && *iter == '-');
+                int count = 0;
+                for (std::shared_ptr<PlayerData>& playerData : mPlayerData)
+                {
+                    ControllerLatencyStats* stats = playerData->latencyStats;
+                    if (stats == nullptr)
+                    {
+                        continue;
+                    }
+
+                    if (clear)
+                    {
+                        stats->reset();
+                        ++count;
+                        continue;
+                    }
+
+                    const LatencyHistogram* histograms[] =
+                        {&stats->lag, &stats->bus, &stats->hid, &stats->total, &stats->jitter};
+                    const char* names[] = {"lag", "bus", "hid", "total", "jitter"};
+                    for (uint32_t i = 0; i < sizeof(histograms) / sizeof(histograms[0]); ++i)
+                    {
+                        const LatencyHistogram& h = *histograms[i];
+                        printf("%lu %s %lu %lu %lu %lu",
+                               (long unsigned int)playerData->playerIndex,
+                               names[i],
+                               (long unsigned int)h.getCount(),
+                               (long unsigned int)h.getMin(),
+                               (long unsigned int)h.getAverage(),
+                               (long unsigned int)h.getMax());
+                        for (uint32_t j = 0; j < LatencyHistogram::NUM_BUCKETS; ++j)
+                        {
+                            printf(" %lu", (long unsigned int)h.getBucket(j));
+                        }
+                        printf("\n");
+                    }
+                }
+
+                if (clear)
+                {
+                    printf("%i\n", count);
+                }
+            }
+            return;
+
+            // XU prints bus utilization statistics for each player; one line per bus:
+            // <idx> busy <us> idle <us> late <count> <min us> <avg us> <max us> <bucket counts...>
+            //   miss <count> depth <high water mark of each priority...>
+            //   wfail <count of each reason...> rfail <count of each reason...>
+            // where late is the histogram of release to write start (buckets as in XL), miss counts
+            // writes started after their deadline, and failure reasons are ordered as
+            // MapleBusInterface::FailureReason (none, crc, missing data, overflow, timeout)
+            // XU- clears all bus statistics and prints the number of buses cleared
+            case 'U' :
+            {
+                // Remove U
+                ++iter;
+                bool clear = (iter < eol && *iter == '-');
+                int count = 0;
+                for (std::shared_ptr<PlayerData>& playerData : mPlayerData)
+                {
+                    BusStats* stats = playerData->busStats;
+                    PrioritizedTxScheduler* scheduler = (playerData->playerIndex < mNumSenders)
+                        ? mSchedulers[playerData->playerIndex].get()
+                        : nullptr;
+                    if (stats == nullptr || scheduler == nullptr)
+                    {
+                        continue;
+                    }
+
+                    if (clear)
+                    {
+                        stats->reset();
+                        scheduler->resetQueueDepthHighWaterMarks();
+                        ++count;
+                        continue;
+                    }
+
+                    const LatencyHistogram& h = stats->lateness;
+                    printf("%lu busy %llu idle %llu late %lu %lu %lu %lu",
+                           (long unsigned int)playerData->playerIndex,
+                           (long long unsigned int)stats->getBusyUs(),
+                           (long long unsigned int)stats->getIdleUs(),
+                           (long unsigned int)h.getCount(),
+                           (long unsigned int)h.getMin(),
+                           (long unsigned int)h.getAverage(),
+                           (long unsigned int)h.getMax());
+                    for (uint32_t j = 0; j < LatencyHistogram::NUM_BUCKETS; ++j)
+                    {
+                        printf(" %lu", (long unsigned int)h.getBucket(j));
+                    }
+                    printf(" miss %lu depth", (long unsigned int)stats->getNumDeadlineMisses());
+                    for (uint32_t j = 0; j < scheduler->getNumPriorities(); ++j)
+                    {
+                        printf(" %lu", (long unsigned int)scheduler->getQueueDepthHighWaterMark(j));
+                    }
+                    printf(" wfail");
+                    for (uint32_t j = 0; j < BusStats::NUM_FAILURE_REASONS; ++j)
+                    {
+                        printf(" %lu",
+                               (long unsigned int)stats->getNumWriteFailures(
+                                   static_cast<MapleBusInterface::FailureReason>(j)));
+                    }
+                    printf(" rfail");
+                    for (uint32_t j = 0; j < BusStats::NUM_FAILURE_REASONS; ++j)
+                    {
+                        printf(" %lu",
+                               (long unsigned int)stats->getNumReadFailures(
+                                   static_cast<MapleBusInterface::FailureReason>(j)));
+                    }
+                    printf("\n");
+                }
+
+                if (clear)
+                {
+                    printf("%i\n", count);
+                }
+            }
+            return;
+
+            // XT prints controller poll timing for each player: <idx> <period us> <phase lock>
+            // XT <idx> <period us> [<phase lock 0|1>] sets controller poll timing for a player
+            case 'T' :
+            {
+                // Remove T
+                ++iter;
+                int idx = -1;
+                unsigned int periodUs = 0;
+                int phaseLock = 0;
+                int numArgs = (iter < eol) ? sscanf(iter, "%i %u %i", &idx, &periodUs, &phaseLock) : 0;
+                if (numArgs <= 0)
+                {
+                    for (std::shared_ptr<PlayerData>& playerData : mPlayerData)
+                    {
+                        const ControllerPollSettings* settings = playerData->pollSettings;
+                        if (settings != nullptr)
+                        {
+                            printf("%lu %lu %i\n",
+                                   (long unsigned int)playerData->playerIndex,
+                                   (long unsigned int)settings->getPeriodUs(),
+                                   settings->isPhaseLocked() ? 1 : 0);
+                        }
+                    }
+                }
+                else if (numArgs >= 2
+                         && idx >= 0
+                         && static_cast<std::size_t>(idx) < mPlayerData.size()
+                         && mPlayerData[idx]->pollSettings != nullptr)
+                {
+                    mPlayerData[idx]->pollSettings->setPeriodUs(periodUs);
+                    mPlayerData[idx]->pollSettings->setPhaseLock(numArgs >= 3 && phaseLock != 0);
+                    printf("1\n");
+                }
+                else
+                {
+                    printf("0\n");
+                }
+            }
+            return;
+
             // Reserved
             case ' ': // Fall through
             case '0': // Fall through
@@ -276,52 +533,124 @@ void FlycastCommandParser::submit(const char* chars, uint32_t len)
     if (valid)
     {
         MaplePacket packet(&words[0], words.size());
-        if (packet.isValid())
-        {
-            uint8_t sender = packet.frame.senderAddr;
-            int32_t idx = -1;
-            const uint8_t* senderAddress = mSenderAddresses;
+        schedule(packet, false);
+    }
+    else
+    {
+        printf("*failed missing data\n");
+    }
+}
 
-            if (mNumSenders == 1)
-            {
-                // Single player special case - always send to the one available, regardless of address
-                idx = 0;
-                packet.frame.senderAddr = *senderAddress;
-                packet.frame.recipientAddr = (packet.frame.recipientAddr & 0x3F) | *senderAddress;
-            }
-            else
+bool FlycastCommandParser::submitBinary(const uint8_t* data, uint32_t len)
+{
+    if (len == 0 || (len % sizeof(uint32_t)) != 0)
+    {
+        printFailure(true, "*failed missing data");
+        return true;
+    }
+
+    // Data isn't necessarily word aligned, so copy word by word
+    uint32_t frameWord;
+    memcpy(&frameWord, data, sizeof(frameWord));
+    MaplePacket packet(MaplePacket::Frame::fromWord(frameWord));
+    uint32_t numPayloadWords = (len / sizeof(uint32_t)) - 1;
+    packet.reservePayload(numPayloadWords);
+    for (uint32_t i = 0; i < numPayloadWords; ++i)
+    {
+        uint32_t word;
+        memcpy(&word, &data[(i + 1) * sizeof(uint32_t)], sizeof(word));
+        packet.appendPayload(word);
+    }
+
+    schedule(packet, true);
+    return true;
+}
+
+bool FlycastCommandParser::isSuperseding(const MaplePacket& packet)
+{
+    // LCD frames and vibration/timer conditions only matter as of the latest one; anything else
+    // (storage writes especially) must go out in full
+    if (packet.payload.size() == 0)
+    {
+        return false;
+    }
+    else if (packet.frame.command == COMMAND_SET_CONDITION)
+    {
+        return true;
+    }
+    else
+    {
+        return (packet.frame.command == COMMAND_BLOCK_WRITE && packet.payload[0] == DEVICE_FN_LCD);
+    }
+}
+
+void FlycastCommandParser::schedule(MaplePacket& packet, bool binary)
+{
+    if (packet.isValid())
+    {
+        uint8_t sender = packet.frame.senderAddr;
+        int32_t idx = -1;
+        const uint8_t* senderAddress = mSenderAddresses;
+
+        if (mNumSenders == 1)
+        {
+            // Single player special case - always send to the one available, regardless of address
+            idx = 0;
+            packet.frame.senderAddr = *senderAddress;
+            packet.frame.recipientAddr = (packet.frame.recipientAddr & 0x3F) | *senderAddress;
+        }
+        else
+        {
+            for (uint32_t i = 0; i < mNumSenders && idx < 0; ++i, ++senderAddress)
             {
-                for (uint32_t i = 0; i < mNumSenders && idx < 0; ++i, ++senderAddress)
+                if (sender == *senderAddress)
                 {
-                    if (sender == *senderAddress)
-                    {
-                        idx = i;
-                    }
+                    idx = i;
                 }
             }
+        }
+
+        if (idx >= 0)
+        {
+            Transmitter* transmitter = &flycastEchoTransmitter;
+            if (binary)
+            {
+                transmitter = &flycastBinaryEchoTransmitter;
+            }
 
-            if (idx >= 0)
+            uint32_t id = PrioritizedTxScheduler::INVALID_TX_ID;
+            if (isSuperseding(packet))
             {
-                mSchedulers[idx]->add(
+                id = mSchedulers[idx]->addLatest(
                     PrioritizedTxScheduler::EXTERNAL_TRANSMISSION_PRIORITY,
                     PrioritizedTxScheduler::TX_TIME_ASAP,
-                    &flycastEchoTransmitter,
+                    transmitter,
                     packet,
                     true);
             }
             else
             {
-                printf("*failed invalid sender\n");
+                id = mSchedulers[idx]->add(
+                    PrioritizedTxScheduler::EXTERNAL_TRANSMISSION_PRIORITY,
+                    PrioritizedTxScheduler::TX_TIME_ASAP,
+                    transmitter,
+                    packet,
+                    true);
+            }
+
+            if (id == PrioritizedTxScheduler::INVALID_TX_ID)
+            {
+                printFailure(binary, "*failed schedule full");
             }
         }
         else
         {
-            printf("*failed packet invalid\n");
+            printFailure(binary, "*failed invalid sender");
         }
     }
     else
     {
-        printf("*failed missing data\n");
+        printFailure(binary, "*failed packet invalid");
     }
 }
 
@@ -30,9 +30,23 @@ public:
     //! Called when newline reached; submit command and reset
     virtual void submit(const char* chars, uint32_t len) final;
 
+    //! Called when a binary X frame is received; data holds a Maple packet as raw words
+    virtual bool submitBinary(const uint8_t* data, uint32_t len) final;
+
     //! Prints help message for this command
     virtual void printHelp() final;
 
+private:
+    //! Routes a packet to the scheduler of its sender and reports any failure
+    //! @param[in,out] packet  The packet to schedule
+    //! @param[in] binary  true to respond with frames or false to respond with text
+    void schedule(MaplePacket& packet, bool binary);
+
+    //! @param[in] packet  A packet from flycast
+    //! @returns true iff the given packet supersedes any unsent packet with the same recipient,
+    //!          command, and function code
+    static bool isSuperseding(const MaplePacket& packet);
+
 private:
     SystemIdentification& mIdentification;
     std::shared_ptr<PrioritizedTxScheduler>* const mSchedulers;
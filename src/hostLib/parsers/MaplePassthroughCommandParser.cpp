@@ -47,12 +47,12 @@ public:
         }
     }
 
-    virtual void txComplete(std::shared_ptr<const MaplePacket> packet,
+    virtual void txComplete(const MaplePacketView* packet,
                             std::shared_ptr<const Transmission> tx) final
     {
         printf("%lu: complete {", (long unsigned int)tx->transmissionId);
         printf("%08lX", (long unsigned int)packet->frame.toWord());
-        for (std::vector<uint32_t>::const_iterator iter = packet->payload.begin();
+        for (MaplePacketView::Payload::const_iterator iter = packet->payload.begin();
              iter != packet->payload.end();
              ++iter)
         {
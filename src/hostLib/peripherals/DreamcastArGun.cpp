@@ -44,6 +44,6 @@ void DreamcastArGun::txFailed(bool writeFailed,
                               std::shared_ptr<const Transmission> tx)
 {}
 
-void DreamcastArGun::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastArGun::txComplete(const MaplePacketView* packet,
                                 std::shared_ptr<const Transmission> tx)
 {}
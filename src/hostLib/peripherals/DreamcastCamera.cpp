@@ -44,6 +44,6 @@ void DreamcastCamera::txFailed(bool writeFailed,
                                std::shared_ptr<const Transmission> tx)
 {}
 
-void DreamcastCamera::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastCamera::txComplete(const MaplePacketView* packet,
                                  std::shared_ptr<const Transmission> tx)
 {}
@@ -23,6 +23,7 @@
 
 #include "DreamcastController.hpp"
 #include "dreamcast_constants.h"
+#include "utils.h"
 #include <string.h>
 
 
@@ -32,16 +33,43 @@ DreamcastController::DreamcastController(uint8_t addr,
                                          PlayerData playerData) :
     DreamcastPeripheral("controller", addr, fd, scheduler, playerData.playerIndex),
     mGamepad(playerData.gamepad),
+    mClock(playerData.clock),
+    mLatencyStats(playerData.latencyStats),
+    mPollSettings(playerData.pollSettings),
+    mConditionDurationUs(PrioritizedTxScheduler::computeTxDurationUs(1, true, 3)),
     mWaitingForData(false),
-    mFirstTask(true),
-    mConditionTxId(0)
+    mConditionTxId(0),
+    mPeriodUs(0),
+    mOffsetUs(0),
+    mPhaseLocked(false),
+    mConnected(true)
 {
     mGamepad.controllerConnected();
 }
 
 DreamcastController::~DreamcastController()
 {
+    if (mConnected)
+    {
+        mGamepad.controllerDisconnected();
+    }
+}
+
+bool DreamcastController::suspend()
+{
+    // The condition poll was canceled along with everything else sent to this controller
+    mConditionTxId = 0;
+    mWaitingForData = false;
+    mConnected = false;
     mGamepad.controllerDisconnected();
+    return true;
+}
+
+void DreamcastController::resume()
+{
+    // Condition poll is rescheduled on the next task()
+    mConnected = true;
+    mGamepad.controllerConnected();
 }
 
 void DreamcastController::txStarted(std::shared_ptr<const Transmission> tx)
@@ -49,6 +77,14 @@ void DreamcastController::txStarted(std::shared_ptr<const Transmission> tx)
     if (mConditionTxId != 0 && tx->transmissionId == mConditionTxId)
     {
         mWaitingForData = true;
+
+        if (mLatencyStats != nullptr)
+        {
+            // The scheduler has already advanced the next time by one period
+            mLatencyStats->writeStarted(tx->nextTxTimeUs - tx->autoRepeatUs,
+                                        tx->autoRepeatUs,
+                                        mClock.getTimeUs());
+        }
     }
 }
 
@@ -59,16 +95,26 @@ void DreamcastController::txFailed(bool writeFailed,
     if (mConditionTxId != 0 && tx->transmissionId == mConditionTxId)
     {
         mWaitingForData = false;
+
+        if (mLatencyStats != nullptr)
+        {
+            mLatencyStats->failed();
+        }
     }
 }
 
-void DreamcastController::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastController::txComplete(const MaplePacketView* packet,
                                      std::shared_ptr<const Transmission> tx)
 {
     if (mWaitingForData && packet != nullptr)
     {
         mWaitingForData = false;
 
+        if (mLatencyStats != nullptr)
+        {
+            mLatencyStats->readComplete(mClock.getTimeUs());
+        }
+
         if (packet->frame.command == COMMAND_RESPONSE_DATA_XFER
             && packet->payload.size() >= 3
             && packet->payload[0] == DEVICE_FN_CONTROLLER)
@@ -77,17 +123,38 @@ void DreamcastController::txComplete(std::shared_ptr<const MaplePacket> packet,
             DreamcastControllerObserver::ControllerCondition controllerCondition;
             memcpy(&controllerCondition, &packet->payload[1], 2 * sizeof(uint32_t));
             mGamepad.setControllerCondition(controllerCondition);
+
+            if (mLatencyStats != nullptr)
+            {
+                mLatencyStats->hidSent(mClock.getTimeUs());
+            }
         }
     }
 }
 
 void DreamcastController::task(uint64_t currentTimeUs)
 {
-    if (mFirstTask)
+    uint32_t periodUs = 0;
+    uint64_t offsetUs = 0;
+    bool phaseLocked = computeCadence(currentTimeUs, periodUs, offsetUs);
+
+    if (needsReschedule(phaseLocked, periodUs, offsetUs))
     {
-        mFirstTask = false;
+        bool firstPoll = (mConditionTxId == 0);
+        if (mConditionTxId != 0)
+        {
+            mEndpointTxScheduler->cancelById(mConditionTxId);
+            mConditionTxId = 0;
+        }
+
         uint32_t payload[] = {DEVICE_FN_CONTROLLER};
-        uint64_t txTime = PrioritizedTxScheduler::computeNextTimeCadence(currentTimeUs, US_PER_CHECK);
+        uint64_t txTime =
+            PrioritizedTxScheduler::computeNextTimeCadence(currentTimeUs, periodUs, offsetUs);
+        if (firstPoll && !phaseLocked)
+        {
+            // Nothing to keep in phase with, so report condition right after (re)connect
+            txTime = currentTimeUs;
+        }
         mConditionTxId = mEndpointTxScheduler->add(
             txTime,
             this,
@@ -96,6 +163,79 @@ void DreamcastController::task(uint64_t currentTimeUs)
             1,
             true,
             3,
-            US_PER_CHECK);
+            periodUs);
+
+        mPeriodUs = periodUs;
+        mOffsetUs = offsetUs;
+        mPhaseLocked = phaseLocked;
+    }
+}
+
+bool DreamcastController::computeCadence(uint64_t currentTimeUs,
+                                         uint32_t& periodUs,
+                                         uint64_t& offsetUs)
+{
+    periodUs = US_PER_CHECK;
+    offsetUs = 0;
+    bool phaseLock = false;
+    if (mPollSettings != nullptr)
+    {
+        periodUs = mPollSettings->getPeriodUs();
+        phaseLock = mPollSettings->isPhaseLocked();
+    }
+
+    // Don't let condition polls take more than half of the bus
+    if (periodUs < mConditionDurationUs * 2)
+    {
+        periodUs = mConditionDurationUs * 2;
     }
+
+    uint32_t hostReadTimeUs = 0;
+    uint32_t hostReadIntervalUs = 0;
+    if (!phaseLock
+        || !mGamepad.getHostReadTiming(hostReadTimeUs, hostReadIntervalUs)
+        || hostReadIntervalUs == 0)
+    {
+        return false;
+    }
+
+    // Only a 32-bit time is given, so extend it using the current time
+    uint32_t hostReadAgeUs = static_cast<uint32_t>(currentTimeUs) - hostReadTimeUs;
+    if (hostReadAgeUs > currentTimeUs)
+    {
+        return false;
+    }
+    uint64_t hostReadUs = currentTimeUs - hostReadAgeUs;
+
+    // Every poll lands in the same place relative to host reads only if the period is a multiple
+    // of the host read interval
+    periodUs = INT_DIVIDE_CEILING(periodUs, hostReadIntervalUs) * hostReadIntervalUs;
+
+    // Start polls early enough that each response is processed just before a host read
+    offsetUs = hostReadUs + periodUs - ((mConditionDurationUs + PHASE_LOCK_MARGIN_US) % periodUs);
+
+    return true;
+}
+
+bool DreamcastController::needsReschedule(bool phaseLocked, uint32_t periodUs, uint64_t offsetUs)
+{
+    if (mConditionTxId == 0 || phaseLocked != mPhaseLocked || periodUs != mPeriodUs)
+    {
+        return true;
+    }
+
+    if (phaseLocked)
+    {
+        // Allow the measured host read time to jitter a bit before rescheduling
+        uint32_t phaseErrorUs = (offsetUs >= mOffsetUs)
+                                ? ((offsetUs - mOffsetUs) % periodUs)
+                                : ((mOffsetUs - offsetUs) % periodUs);
+        if (phaseErrorUs > (periodUs / 2))
+        {
+            phaseErrorUs = periodUs - phaseErrorUs;
+        }
+        return (phaseErrorUs > PHASE_LOCK_TOLERANCE_US);
+    }
+
+    return false;
 }
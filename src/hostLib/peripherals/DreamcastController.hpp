@@ -26,6 +26,9 @@
 #include "DreamcastPeripheral.hpp"
 #include "hal/Usb/DreamcastControllerObserver.hpp"
 #include "PlayerData.hpp"
+#include "ControllerLatencyStats.hpp"
+#include "ControllerPollSettings.hpp"
+#include "hal/System/ClockInterface.hpp"
 
 //! Handles communication with the Dreamcast controller peripheral
 class DreamcastController : public DreamcastPeripheral
@@ -56,9 +59,15 @@ class DreamcastController : public DreamcastPeripheral
                               std::shared_ptr<const Transmission> tx) final;
 
         //! Inherited from DreamcastPeripheral
-        virtual void txComplete(std::shared_ptr<const MaplePacket> packet,
+        virtual void txComplete(const MaplePacketView* packet,
                                 std::shared_ptr<const Transmission> tx) final;
 
+        //! Inherited from DreamcastPeripheral
+        virtual bool suspend() final;
+
+        //! Inherited from DreamcastPeripheral
+        virtual void resume() final;
+
         //! Inherited from DreamcastPeripheral
         inline uint32_t getFunctionCode() override final
         {
@@ -70,14 +79,45 @@ class DreamcastController : public DreamcastPeripheral
         static const uint32_t FUNCTION_CODE = DEVICE_FN_CONTROLLER;
 
     private:
-        //! Time between each controller state poll (in microseconds)
-        static const uint32_t US_PER_CHECK = 16000;
+        //! Computes the desired poll period and offset from settings and host timing
+        //! @param[in] currentTimeUs  The current time
+        //! @param[out] periodUs  The poll period
+        //! @param[out] offsetUs  A time on which the poll cadence should land
+        //! @returns true iff the poll cadence is locked to when the host reads reports
+        bool computeCadence(uint64_t currentTimeUs, uint32_t& periodUs, uint64_t& offsetUs);
+
+        //! @returns true iff the current condition poll needs to be rescheduled
+        bool needsReschedule(bool phaseLocked, uint32_t periodUs, uint64_t offsetUs);
+
+    private:
+        //! Time between each controller state poll when no poll settings are given (in microseconds)
+        static const uint32_t US_PER_CHECK = ControllerPollSettings::DEFAULT_PERIOD_US;
+        //! When phase locked, how long before the host reads a report that the condition should be
+        //! received, accounting for time to process the response
+        static const uint32_t PHASE_LOCK_MARGIN_US = 200;
+        //! When phase locked, how far the cadence may drift from the host read time before the
+        //! condition poll is rescheduled
+        static const uint32_t PHASE_LOCK_TOLERANCE_US = 250;
         //! The gamepad to write button presses to
         DreamcastControllerObserver& mGamepad;
+        //! Clock used to timestamp condition polls
+        ClockInterface& mClock;
+        //! Condition poll latency statistics or nullptr if not measured
+        ControllerLatencyStats* const mLatencyStats;
+        //! Condition poll settings or nullptr to use defaults
+        const ControllerPollSettings* const mPollSettings;
+        //! Expected bus time of each condition poll
+        const uint32_t mConditionDurationUs;
         //! True iff the controller is waiting for data
         bool mWaitingForData;
-        //! Initialized to true and set to false in task()
-        bool mFirstTask;
-        //! ID of the get condition transmission
+        //! ID of the get condition transmission or 0 if not scheduled
         uint32_t mConditionTxId;
+        //! Period of the scheduled condition poll
+        uint32_t mPeriodUs;
+        //! Offset of the scheduled condition poll
+        uint64_t mOffsetUs;
+        //! True iff the scheduled condition poll is locked to when the host reads reports
+        bool mPhaseLocked;
+        //! True iff the gamepad has been told that this controller is connected
+        bool mConnected;
 };
@@ -44,6 +44,6 @@ void DreamcastExMedia::txFailed(bool writeFailed,
                               std::shared_ptr<const Transmission> tx)
 {}
 
-void DreamcastExMedia::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastExMedia::txComplete(const MaplePacketView* packet,
                                 std::shared_ptr<const Transmission> tx)
 {}
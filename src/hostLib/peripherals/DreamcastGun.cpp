@@ -44,6 +44,6 @@ void DreamcastGun::txFailed(bool writeFailed,
                             std::shared_ptr<const Transmission> tx)
 {}
 
-void DreamcastGun::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastGun::txComplete(const MaplePacketView* packet,
                               std::shared_ptr<const Transmission> tx)
 {}
@@ -56,7 +56,7 @@ class DreamcastGun : public DreamcastPeripheral
                               std::shared_ptr<const Transmission> tx) final;
 
         //! Inherited from DreamcastPeripheral
-        virtual void txComplete(std::shared_ptr<const MaplePacket> packet,
+        virtual void txComplete(const MaplePacketView* packet,
                                 std::shared_ptr<const Transmission> tx) final;
 
         //! Inherited from DreamcastPeripheral
@@ -44,6 +44,6 @@ void DreamcastKeyboard::txFailed(bool writeFailed,
                                  std::shared_ptr<const Transmission> tx)
 {}
 
-void DreamcastKeyboard::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastKeyboard::txComplete(const MaplePacketView* packet,
                                    std::shared_ptr<const Transmission> tx)
 {}
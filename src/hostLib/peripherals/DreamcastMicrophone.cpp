@@ -44,6 +44,6 @@ void DreamcastMicrophone::txFailed(bool writeFailed,
                                    std::shared_ptr<const Transmission> tx)
 {}
 
-void DreamcastMicrophone::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastMicrophone::txComplete(const MaplePacketView* packet,
                                      std::shared_ptr<const Transmission> tx)
 {}
@@ -44,6 +44,6 @@ void DreamcastMouse::txFailed(bool writeFailed,
                               std::shared_ptr<const Transmission> tx)
 {}
 
-void DreamcastMouse::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastMouse::txComplete(const MaplePacketView* packet,
                                 std::shared_ptr<const Transmission> tx)
 {}
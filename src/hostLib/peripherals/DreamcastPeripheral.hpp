@@ -101,6 +101,15 @@ class DreamcastPeripheral : public Transmitter
         //! @returns the function definition of this peripheral
         inline const uint32_t& getFunctionDefinition() { return mFd; }
 
+        //! Called when the device this peripheral communicates with is disconnected, after all
+        //! transmissions to it have been canceled
+        //! @returns true iff this peripheral has released its connection and may later be
+        //!          restored through resume() if the same device reconnects
+        virtual bool suspend() { return false; }
+
+        //! Called when this peripheral is restored after a successful suspend()
+        virtual void resume() {}
+
     public:
         //! The maximum number of sub peripherals that a main peripheral can handle
         static const uint32_t MAX_SUB_PERIPHERALS = 5;
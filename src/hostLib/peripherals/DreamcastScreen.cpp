@@ -39,7 +39,7 @@ DreamcastScreen::DreamcastScreen(uint8_t addr,
 DreamcastScreen::~DreamcastScreen()
 {}
 
-void DreamcastScreen::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastScreen::txComplete(const MaplePacketView* packet,
                                  std::shared_ptr<const Transmission> tx)
 {
     if (mWaitingForData && packet != nullptr)
@@ -66,13 +66,8 @@ void DreamcastScreen::task(uint64_t currentTimeUs)
             uint32_t payload[numPayloadWords] = {DEVICE_FN_LCD, writeAddrWord, 0};
             mScreenData.readData(&payload[2]);
 
-            if (mTransmissionId > 0 && !mWaitingForData)
-            {
-                // Make sure previous tx is canceled in case it hasn't gone out yet
-                mEndpointTxScheduler->cancelById(mTransmissionId);
-            }
-
-            mTransmissionId = mEndpointTxScheduler->add(
+            // Replaces the previous write in case it hasn't gone out yet
+            mTransmissionId = mEndpointTxScheduler->addLatest(
                 PrioritizedTxScheduler::TX_TIME_ASAP,
                 this,
                 COMMAND_BLOCK_WRITE,
@@ -82,7 +77,8 @@ void DreamcastScreen::task(uint64_t currentTimeUs)
                 0);
             mNextCheckTime = currentTimeUs + US_PER_CHECK;
 
-            mUpdateRequired = false;
+            // Try again on the next check if the schedule was full
+            mUpdateRequired = (mTransmissionId == PrioritizedTxScheduler::INVALID_TX_ID);
         }
     }
 }
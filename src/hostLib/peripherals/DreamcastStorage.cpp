@@ -38,12 +38,14 @@ DreamcastStorage::DreamcastStorage(uint8_t addr,
     mClock(playerData.clock),
     mUsbFileSystem(playerData.fileSystem),
     mFileName{},
-    mReadState(READ_WRITE_IDLE),
-    mReadingTxId(0),
-    mReadingBlock(-1),
-    mReadPacket(nullptr),
-    mReadKillTime(0),
+    mCacheBlocks(),
+    mCacheUseCount(0),
+    mNumReadAheadBlocks(DEFAULT_READ_AHEAD_BLOCKS),
+    mWriteSeq(0),
+    mNumWriteFailures(0),
+    mNumWriteFailuresReported(0),
     mWriteState(READ_WRITE_IDLE),
+    mWritingCacheBlock(nullptr),
     mWritingTxId(0),
     mWritingBlock(0),
     mWriteBuffer(nullptr),
@@ -90,49 +92,60 @@ DreamcastStorage::~DreamcastStorage()
 
 void DreamcastStorage::task(uint64_t currentTimeUs)
 {
-    switch(mReadState)
+    // Queue requested reads in the order of their kill time so that the block which read() is
+    // waiting on goes out before any read ahead blocks
+    CacheBlock* nextBlock = nullptr;
+    bool scheduleFull = false;
+    do
     {
-        case READ_WRITE_STARTED:
+        nextBlock = nullptr;
+        for (uint32_t i = 0; i < NUM_CACHE_BLOCKS; ++i)
         {
-            uint32_t payload[2] = {FUNCTION_CODE, mReadingBlock};
-            mReadingTxId = mEndpointTxScheduler->add(
-                PrioritizedTxScheduler::TX_TIME_ASAP,
-                this,
-                COMMAND_BLOCK_READ,
-                payload,
-                2,
-                true,
-                130);
-            mReadState = READ_WRITE_SENT;
+            CacheBlock& block = mCacheBlocks[i];
+            if (block.state == CACHE_BLOCK_REQUESTED
+                && (nextBlock == nullptr || block.killTime < nextBlock->killTime))
+            {
+                nextBlock = &block;
+            }
+            else if (block.state == CACHE_BLOCK_SENT && currentTimeUs >= block.killTime)
+            {
+                // Timeout
+                mEndpointTxScheduler->cancelById(block.txId);
+                block.state = CACHE_BLOCK_FAILED;
+            }
         }
-        break;
 
-        case READ_WRITE_SENT:
+        if (nextBlock != nullptr)
         {
-            if (currentTimeUs >= mReadKillTime)
+            // Scheduled for now rather than ASAP so that a stream of reads can't starve write back
+            uint32_t payload[2] = {FUNCTION_CODE, nextBlock->blockNum};
+            MaplePacket packet({.command=COMMAND_BLOCK_READ}, payload, 2);
+            // Block data is received raw so that it lands in the cache without any byte swapping
+            packet.rawResponseIdx = 2;
+            nextBlock->txId = mEndpointTxScheduler->add(
+                currentTimeUs,
+                this,
+                packet,
+                true,
+                2 + BLOCK_SIZE_WORDS);
+            if (nextBlock->txId != PrioritizedTxScheduler::INVALID_TX_ID)
             {
-                // Timeout
-                mEndpointTxScheduler->cancelById(mReadingTxId);
-                mReadState = READ_WRITE_IDLE;
+                nextBlock->state = CACHE_BLOCK_SENT;
+            }
+            else
+            {
+                // Schedule is full - leave this and the rest requested for the next task
+                scheduleFull = true;
             }
         }
-        break;
-
-        case READ_WRITE_PROCESSING:
-            // Already processing, so no need to check timeout value
-            // FALL THROUGH
-        default:
-            break;
-    }
+    } while (nextBlock != nullptr && !scheduleFull);
 
     switch(mWriteState)
     {
-        case READ_WRITE_STARTED:
+        case READ_WRITE_IDLE:
         {
-            mWritePhase = 0;
-            mMinDurationBetweenWrites = DEFAULT_MIN_DURATION_US_BETWEEN_WRITES;
-            // Build the payload with write data
-            queueNextWritePhase();
+            // Write back whatever write() left behind
+            startNextWrite();
         }
         break;
 
@@ -140,20 +153,33 @@ void DreamcastStorage::task(uint64_t currentTimeUs)
         {
             if (currentTimeUs >= mWriteKillTime)
             {
-                // Timeout
+                // Timeout - commit whatever made it then report failure
                 mEndpointTxScheduler->cancelById(mWritingTxId);
+                mWriteBufferLen = -1;
                 mWritePhase = getWriteAccesCount();
                 queueWriteCommit();
             }
+            else if (mWritingTxId == PrioritizedTxScheduler::INVALID_TX_ID)
+            {
+                // The schedule was full when the write was queued
+                queueWriteChain();
+            }
+        }
+        break;
+
+        case WRITE_COMMIT_SENT:
+        {
+            // Don't interrupt commit process unless it never made it into the schedule
+            if (mWritingTxId == PrioritizedTxScheduler::INVALID_TX_ID)
+            {
+                queueWriteCommit();
+            }
         }
         break;
 
         case READ_WRITE_PROCESSING:
             // Already processing, so no need to check timeout value
             // FALL THROUGH
-        case WRITE_COMMIT_SENT:
-            // Don't interrupt commit process
-            // FALL THROUGH
         default:
             break;
     }
@@ -161,11 +187,12 @@ void DreamcastStorage::task(uint64_t currentTimeUs)
 
 void DreamcastStorage::txStarted(std::shared_ptr<const Transmission> tx)
 {
-    if (mReadState != READ_WRITE_IDLE && tx->transmissionId == mReadingTxId)
+    CacheBlock* block = findSentBlock(tx->transmissionId);
+    if (block != nullptr)
     {
-        mReadState = READ_WRITE_PROCESSING;
+        block->state = CACHE_BLOCK_PROCESSING;
     }
-    if (mWriteState != READ_WRITE_IDLE && tx->transmissionId == mWritingTxId)
+    if (mWriteState == READ_WRITE_SENT && tx->transmissionId == mWritingTxId)
     {
         mWriteState = READ_WRITE_PROCESSING;
     }
@@ -175,102 +202,128 @@ void DreamcastStorage::txFailed(bool writeFailed,
                                 bool readFailed,
                                 std::shared_ptr<const Transmission> tx)
 {
-    if (mReadState != READ_WRITE_IDLE && tx->transmissionId == mReadingTxId)
+    CacheBlock* block = findSentBlock(tx->transmissionId);
+    if (block != nullptr)
     {
         // Failure
-        mReadState = READ_WRITE_IDLE;
+        block->state = CACHE_BLOCK_FAILED;
     }
     if (mWriteState != READ_WRITE_IDLE && tx->transmissionId == mWritingTxId)
     {
-        // Failure
+        // Failure - the rest of the chain was already dropped by the scheduler
         mLastWriteTimeUs = mClock.getTimeUs();
-        mMinDurationBetweenWrites += DURATION_US_BETWEEN_WRITES_INC;
-        if (mLastWriteTimeUs + getWriteAccesCount() * mMinDurationBetweenWrites > mWriteKillTime)
-        {
-            mWriteBufferLen = -1;
-            mWriteState = READ_WRITE_IDLE;
-        }
-        else
-        {
-            // Try again
-            mWritePhase = 0;
-            queueNextWritePhase();
-        }
+        retryWrite();
     }
 }
 
-void DreamcastStorage::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastStorage::txComplete(const MaplePacketView* packet,
                                   std::shared_ptr<const Transmission> tx)
 {
-    if (mReadState != READ_WRITE_IDLE && tx->transmissionId == mReadingTxId)
+    CacheBlock* block = findSentBlock(tx->transmissionId);
+    if (block != nullptr)
     {
-        // Complete!
-        mReadPacket = packet;
-        mReadState = READ_WRITE_IDLE;
+        if (packet->frame.command == COMMAND_RESPONSE_DATA_XFER
+            && packet->payload.size() >= (2 + BLOCK_SIZE_WORDS))
+        {
+            // Complete! Block data was received raw, so it is already in file byte order
+            memcpy(block->data, &packet->payload[2], sizeof(block->data));
+            block->state = CACHE_BLOCK_VALID;
+        }
+        else
+        {
+            block->state = CACHE_BLOCK_FAILED;
+        }
     }
     if (mWriteState != READ_WRITE_IDLE && tx->transmissionId == mWritingTxId)
     {
-        mLastWriteTimeUs = mClock.getTimeUs();
         if (packet->frame.command == COMMAND_RESPONSE_ACK)
         {
-            if (++mWritePhase >= getWriteAccesCount())
+            if (tx->packet->frame.command == COMMAND_GET_LAST_ERROR)
+            {
+                // Complete! The gap before the next block is measured from the last write phase
+                writeComplete(mWriteBufferLen > 0);
+            }
+            else
             {
-                if (tx->packet->frame.command == COMMAND_GET_LAST_ERROR)
+                // The scheduler already released the next step of the chain
+                mLastWriteTimeUs = mClock.getTimeUs();
+                if (++mWritePhase >= getWriteAccesCount())
                 {
-                    // Complete!
-                    mWriteState = READ_WRITE_IDLE;
+                    mWriteState = WRITE_COMMIT_SENT;
                 }
                 else
                 {
-                    // Queue the message which commits the written data
-                    queueWriteCommit();
+                    mWriteState = READ_WRITE_SENT;
                 }
             }
-            else
-            {
-                // Queue up next phase
-                queueNextWritePhase();
-            }
         }
         else
         {
-            mMinDurationBetweenWrites += DURATION_US_BETWEEN_WRITES_INC;
-            if (mLastWriteTimeUs + getWriteAccesCount() * mMinDurationBetweenWrites > mWriteKillTime)
-            {
-                mWriteBufferLen = -1;
-                mWriteState = READ_WRITE_IDLE;
-            }
-            else
-            {
-                // Try again
-                mWritePhase = 0;
-                queueNextWritePhase();
-            }
+            // The rest of the chain was already dropped by the scheduler
+            mLastWriteTimeUs = mClock.getTimeUs();
+            retryWrite();
         }
     }
 }
 
-void DreamcastStorage::queueNextWritePhase()
+void DreamcastStorage::retryWrite()
 {
-    uint32_t numBlockWords = mWriteBufferLen / 4 / getWriteAccesCount();
-    uint32_t numPayloadWords = 2 + numBlockWords;
-    uint32_t payload[numPayloadWords] = {FUNCTION_CODE, mWritingBlock | ((uint32_t)mWritePhase << 16)};
+    mMinDurationBetweenWrites += DURATION_US_BETWEEN_WRITES_INC;
+    if (mWriteBufferLen < 0
+        || mLastWriteTimeUs + getWriteAccesCount() * mMinDurationBetweenWrites > mWriteKillTime)
+    {
+        mWriteBufferLen = -1;
+        writeComplete(false);
+    }
+    else
+    {
+        // Try again
+        mWritePhase = 0;
+        queueWriteChain();
+    }
+}
+
+void DreamcastStorage::queueWriteChain()
+{
+    const uint8_t numPhases = getWriteAccesCount();
+    assert(numPhases <= MAX_WRITE_PHASES);
+    uint32_t numBlockWords = mWriteBufferLen / 4 / numPhases;
     const uint32_t* pDataIn = static_cast<const uint32_t*>(mWriteBuffer);
-    pDataIn += (mWritePhase * numBlockWords);
-    uint32_t *pDataOut = &payload[2];
-    for (uint32_t i = 0; i < numBlockWords; ++i, ++pDataIn, ++pDataOut)
+
+    MaplePacket packets[MAX_WRITE_PHASES + 1];
+    TransmissionChainStep steps[MAX_WRITE_PHASES + 1];
+    for (uint8_t phase = 0; phase < numPhases; ++phase)
     {
-        *pDataOut = flipWordBytes(*pDataIn);
+        uint32_t payload[2] = {FUNCTION_CODE, mWritingBlock | ((uint32_t)phase << 16)};
+        MaplePacket& packet = packets[phase];
+        packet.frame.command = COMMAND_BLOCK_WRITE;
+        packet.setPayload(payload, 2);
+        packet.reservePayload(2 + numBlockWords);
+        // Data is sent raw, straight from the file bytes
+        packet.appendPayloadRaw(pDataIn + (phase * numBlockWords), numBlockWords);
+
+        steps[phase] = {.packet=&packet,
+                        .expectResponse=true,
+                        .expectedResponseNumPayloadWords=0,
+                        .continueCommand=COMMAND_RESPONSE_ACK,
+                        .minGapUs=mMinDurationBetweenWrites};
     }
 
-    mWritingTxId = mEndpointTxScheduler->add(
+    // COMMAND_GET_LAST_ERROR commits the written data right after the last phase is acknowledged
+    uint32_t commitPayload[2] = {FUNCTION_CODE, mWritingBlock | ((uint32_t)numPhases << 16)};
+    packets[numPhases].frame.command = COMMAND_GET_LAST_ERROR;
+    packets[numPhases].setPayload(commitPayload, 2);
+    steps[numPhases] = {.packet=&packets[numPhases],
+                        .expectResponse=true,
+                        .expectedResponseNumPayloadWords=0,
+                        .continueCommand=COMMAND_RESPONSE_ACK,
+                        .minGapUs=0};
+
+    mWritingTxId = mEndpointTxScheduler->addChain(
         mLastWriteTimeUs + mMinDurationBetweenWrites,
         this,
-        COMMAND_BLOCK_WRITE,
-        payload,
-        numPayloadWords,
-        true,
-        0);
+        steps,
+        numPhases + 1);
 
     mWriteState = READ_WRITE_SENT;
 }
@@ -313,36 +366,35 @@ int32_t DreamcastStorage::read(uint8_t blockNum,
                                uint16_t bufferLen,
                                uint32_t timeoutUs)
 {
-    assert(mReadState == READ_WRITE_IDLE);
-    // Set data
-    mReadingTxId = 0;
-    mReadingBlock = blockNum;
-    mReadPacket = nullptr;
-    mReadKillTime = mClock.getTimeUs() + timeoutUs;
-    // Commit it
-    mReadState = READ_WRITE_STARTED;
+    uint64_t killTime = mClock.getTimeUs() + timeoutUs;
+    int32_t numRead = 0;
 
     // Wait for maple bus state machine to finish read
     // I'm not too happy about this blocking operation, but it works
-    while(mReadState != READ_WRITE_IDLE && !mExiting);
+    while ((numRead = tryRead(blockNum, buffer, bufferLen, timeoutUs)) == 0
+           && !mExiting
+           && mClock.getTimeUs() < killTime);
 
-    int32_t numRead = -1;
-    if (mReadPacket)
+    // A block which is still in flight here is left to complete into the cache
+    return (numRead == 0) ? -1 : numRead;
+}
+
+int32_t DreamcastStorage::tryRead(uint8_t blockNum,
+                                  void* buffer,
+                                  uint16_t bufferLen,
+                                  uint32_t timeoutUs)
+{
+    bool failed = false;
+    CacheBlock* block = lookupBlock(blockNum, timeoutUs, failed);
+
+    int32_t numRead = failed ? -1 : 0;
+    if (block != nullptr)
     {
-        uint16_t copyLen = (bufferLen > (mReadPacket->payload.size() * 4)) ? (mReadPacket->payload.size() * 4) : bufferLen;
-        // Need to flip each word before copying
-        uint8_t* buffer8 = (uint8_t*)buffer;
-        for (uint32_t i = 2; i < (2U + (bufferLen / 4)); ++i)
-        {
-            uint32_t flippedWord = flipWordBytes(mReadPacket->payload[i]);
-            memcpy(buffer8, &flippedWord, 4);
-            buffer8 += 4;
-        }
+        uint16_t copyLen = (bufferLen > BLOCK_SIZE_BYTES) ? BLOCK_SIZE_BYTES : bufferLen;
+        memcpy(buffer, block->data, copyLen);
         numRead = copyLen;
     }
 
-    mReadPacket = nullptr;
-
     return numRead;
 }
 
@@ -351,29 +403,349 @@ int32_t DreamcastStorage::write(uint8_t blockNum,
                                 uint16_t bufferLen,
                                 uint32_t timeoutUs)
 {
-    if (!isReadOnly())
-    {
-        assert(mWriteState == READ_WRITE_IDLE);
-        assert(bufferLen % 4 == 0);
-        // Set data
-        mWritingBlock = blockNum;
-        mWriteBuffer = buffer;
-        mWriteBufferLen = bufferLen;
-        mWritingTxId = 0;
-        mWriteKillTime = mClock.getTimeUs() + timeoutUs;
+    uint64_t killTime = mClock.getTimeUs() + timeoutUs;
+    int32_t numWritten = 0;
+
+    // Only blocks while the current contents are fetched or when the cache is full of data which
+    // hasn't been written back yet
+    while ((numWritten = tryWrite(blockNum, buffer, bufferLen, timeoutUs)) == 0
+           && !mExiting
+           && mClock.getTimeUs() < killTime);
+
+    return (numWritten == 0) ? -1 : numWritten;
+}
+
+int32_t DreamcastStorage::tryWrite(uint8_t blockNum,
+                                   const void* buffer,
+                                   uint16_t bufferLen,
+                                   uint32_t timeoutUs)
+{
+    if (isReadOnly())
+    {
+        return -1;
+    }
+
+    assert(bufferLen % 4 == 0);
+    uint16_t copyLen = (bufferLen > BLOCK_SIZE_BYTES) ? BLOCK_SIZE_BYTES : bufferLen;
+
+    // The current contents are needed to skip unchanged data and to fill in the rest of a partial
+    // block
+    bool failed = false;
+    CacheBlock* current = lookupBlock(blockNum, timeoutUs, failed);
+    if (current == nullptr)
+    {
+        if (!failed)
+        {
+            // Still fetching
+            return 0;
+        }
+        else if (copyLen < BLOCK_SIZE_BYTES)
+        {
+            return -1;
+        }
+        // Otherwise, the whole block is replaced anyway
+    }
+    else if (memcmp(current->data, buffer, copyLen) == 0)
+    {
+        // Nothing changed - nothing to write
+        return copyLen;
+    }
+
+    CacheBlock* block = nullptr;
+    if (current != nullptr && current->state == CACHE_BLOCK_VALID)
+    {
+        block = current;
+    }
+    else
+    {
+        // The newest data for this block is still waiting to be written back, so this goes into a
+        // separate block which task() will write after it (or instead of it)
+        block = claimBlock();
+        if (block == nullptr)
+        {
+            // Wait for write back to free up a block
+            return 0;
+        }
+
+        if (current != nullptr && block != current)
+        {
+            memcpy(block->data, current->data, BLOCK_SIZE_BYTES);
+        }
+    }
+
+    memcpy(block->data, buffer, copyLen);
+    block->blockNum = blockNum;
+    block->txId = 0;
+    block->lastUsed = ++mCacheUseCount;
+    block->readAhead = false;
+    block->writeSeq = ++mWriteSeq;
+    // Commit it
+    block->state = CACHE_BLOCK_WRITE_PENDING;
+
+    return copyLen;
+}
+
+bool DreamcastStorage::flush(uint32_t timeoutUs)
+{
+    uint64_t killTime = mClock.getTimeUs() + timeoutUs;
+    int32_t result = 0;
+
+    while ((result = tryFlush()) == 0 && !mExiting && mClock.getTimeUs() < killTime);
+
+    return (result > 0);
+}
+
+int32_t DreamcastStorage::tryFlush()
+{
+    for (uint32_t i = 0; i < NUM_CACHE_BLOCKS; ++i)
+    {
+        CacheBlockState state = mCacheBlocks[i].state;
+        if (state == CACHE_BLOCK_WRITE_PENDING || state == CACHE_BLOCK_WRITING)
+        {
+            return 0;
+        }
+    }
+
+    uint32_t numWriteFailures = mNumWriteFailures;
+    if (numWriteFailures != mNumWriteFailuresReported)
+    {
+        mNumWriteFailuresReported = numWriteFailures;
+        return -1;
+    }
+
+    return 1;
+}
+
+DreamcastStorage::CacheBlock* DreamcastStorage::lookupBlock(uint8_t blockNum,
+                                                            uint32_t timeoutUs,
+                                                            bool& failed)
+{
+    failed = false;
+    uint64_t currentTimeUs = mClock.getTimeUs();
+    CacheBlock* block = requestBlock(blockNum, currentTimeUs + timeoutUs, false);
+
+    // Keep the bus busy with the blocks which will most likely be read next while the USB host
+    // is processing this one
+    for (uint32_t i = 1; i <= mNumReadAheadBlocks && (blockNum + i) < NUM_BLOCKS; ++i)
+    {
+        requestBlock(blockNum + i, currentTimeUs + (timeoutUs * (i + 1)), true);
+    }
+
+    if (block != nullptr)
+    {
+        CacheBlockState state = block->state;
+        if (state == CACHE_BLOCK_FAILED)
+        {
+            // Drop it so that the next lookup of this block tries again
+            block->state = CACHE_BLOCK_EMPTY;
+            block = nullptr;
+            failed = true;
+        }
+        else if (state != CACHE_BLOCK_VALID
+                 && state != CACHE_BLOCK_WRITE_PENDING
+                 && state != CACHE_BLOCK_WRITING)
+        {
+            // Still on its way
+            block = nullptr;
+        }
+    }
+
+    return block;
+}
+
+DreamcastStorage::CacheBlock* DreamcastStorage::findBlock(uint8_t blockNum)
+{
+    CacheBlock* found = nullptr;
+    for (uint32_t i = 0; i < NUM_CACHE_BLOCKS; ++i)
+    {
+        CacheBlock& block = mCacheBlocks[i];
+        if (block.state != CACHE_BLOCK_EMPTY
+            && block.blockNum == blockNum
+            && (found == nullptr || block.writeSeq > found->writeSeq))
+        {
+            found = &block;
+        }
+    }
+
+    if (found != nullptr)
+    {
+        // A write back may complete just as a newer write of the same block is accepted - the
+        // older copy is stale
+        for (uint32_t i = 0; i < NUM_CACHE_BLOCKS; ++i)
+        {
+            CacheBlock& block = mCacheBlocks[i];
+            CacheBlockState state = block.state;
+            if (&block != found
+                && block.blockNum == blockNum
+                && (state == CACHE_BLOCK_VALID || state == CACHE_BLOCK_FAILED))
+            {
+                block.state = CACHE_BLOCK_EMPTY;
+            }
+        }
+    }
+
+    return found;
+}
+
+DreamcastStorage::CacheBlock* DreamcastStorage::claimBlock()
+{
+    CacheBlock* failedBlock = nullptr;
+    CacheBlock* leastRecentBlock = nullptr;
+    for (uint32_t i = 0; i < NUM_CACHE_BLOCKS; ++i)
+    {
+        CacheBlock& block = mCacheBlocks[i];
+        CacheBlockState state = block.state;
+        if (state == CACHE_BLOCK_EMPTY)
+        {
+            return &block;
+        }
+        else if (state == CACHE_BLOCK_FAILED)
+        {
+            failedBlock = &block;
+        }
+        else if (state == CACHE_BLOCK_VALID
+                 && (leastRecentBlock == nullptr || block.lastUsed < leastRecentBlock->lastUsed))
+        {
+            leastRecentBlock = &block;
+        }
+    }
+
+    return (failedBlock != nullptr) ? failedBlock : leastRecentBlock;
+}
+
+DreamcastStorage::CacheBlock* DreamcastStorage::requestBlock(uint8_t blockNum,
+                                                             uint64_t killTime,
+                                                             bool readAhead)
+{
+    ++mCacheUseCount;
+
+    CacheBlock* block = findBlock(blockNum);
+    if (block != nullptr)
+    {
+        if (block->state != CACHE_BLOCK_FAILED || readAhead || !block->readAhead)
+        {
+            // Already cached or on its way
+            block->lastUsed = mCacheUseCount;
+            return block;
+        }
+        // A failed read ahead gets another try once the block is actually needed
+    }
+    else
+    {
+        block = claimBlock();
+    }
+
+    if (block != nullptr)
+    {
+        block->blockNum = blockNum;
+        block->txId = 0;
+        block->killTime = killTime;
+        block->lastUsed = mCacheUseCount;
+        block->readAhead = readAhead;
+        block->writeSeq = 0;
         // Commit it
-        mWriteState = READ_WRITE_STARTED;
+        block->state = CACHE_BLOCK_REQUESTED;
+    }
+
+    return block;
+}
+
+DreamcastStorage::CacheBlock* DreamcastStorage::findSentBlock(uint32_t txId)
+{
+    for (uint32_t i = 0; i < NUM_CACHE_BLOCKS; ++i)
+    {
+        CacheBlock& block = mCacheBlocks[i];
+        CacheBlockState state = block.state;
+        if ((state == CACHE_BLOCK_SENT || state == CACHE_BLOCK_PROCESSING) && block.txId == txId)
+        {
+            return &block;
+        }
+    }
+    return nullptr;
+}
 
-        // Wait for maple bus state machine to finish read
-        // I'm not too happy about this blocking operation, but it works
-        while(mWriteState != READ_WRITE_IDLE && !mExiting);
+void DreamcastStorage::startNextWrite()
+{
+    // Write back in the order data was accepted, skipping any block which was written again since
+    CacheBlock* nextBlock = nullptr;
+    bool superseded = false;
+    do
+    {
+        nextBlock = nullptr;
+        superseded = false;
+        for (uint32_t i = 0; i < NUM_CACHE_BLOCKS; ++i)
+        {
+            CacheBlock& block = mCacheBlocks[i];
+            if (block.state == CACHE_BLOCK_WRITE_PENDING
+                && (nextBlock == nullptr || block.writeSeq < nextBlock->writeSeq))
+            {
+                nextBlock = &block;
+            }
+        }
+
+        if (nextBlock != nullptr)
+        {
+            for (uint32_t i = 0; i < NUM_CACHE_BLOCKS && !superseded; ++i)
+            {
+                CacheBlock& block = mCacheBlocks[i];
+                superseded = (&block != nextBlock
+                              && block.state == CACHE_BLOCK_WRITE_PENDING
+                              && block.blockNum == nextBlock->blockNum);
+            }
+
+            if (superseded)
+            {
+                nextBlock->state = CACHE_BLOCK_EMPTY;
+            }
+        }
+    } while (superseded);
+
+    if (nextBlock != nullptr)
+    {
+        nextBlock->state = CACHE_BLOCK_WRITING;
+        mWritingCacheBlock = nextBlock;
+        mWritingBlock = nextBlock->blockNum;
+        mWriteBuffer = nextBlock->data;
+        mWriteBufferLen = BLOCK_SIZE_BYTES;
+        mWritingTxId = 0;
+        mWriteKillTime = mClock.getTimeUs() + WRITE_BACK_TIMEOUT_US;
+        mWritePhase = 0;
+        mMinDurationBetweenWrites = DEFAULT_MIN_DURATION_US_BETWEEN_WRITES;
+        // Build the payloads with write data
+        queueWriteChain();
+    }
+}
+
+void DreamcastStorage::writeComplete(bool success)
+{
+    CacheBlock* block = mWritingCacheBlock;
+    mWritingCacheBlock = nullptr;
+    mWriteState = READ_WRITE_IDLE;
+
+    if (block != nullptr)
+    {
+        bool superseded = false;
+        for (uint32_t i = 0; i < NUM_CACHE_BLOCKS && !superseded; ++i)
+        {
+            CacheBlock& other = mCacheBlocks[i];
+            superseded = (&other != block
+                          && other.state == CACHE_BLOCK_WRITE_PENDING
+                          && other.blockNum == block->blockNum);
+        }
+
+        if (!success)
+        {
+            // Only ever written here, so this doesn't need to be an atomic increment
+            mNumWriteFailures = mNumWriteFailures + 1;
+            DEBUG_PRINT("Storage write back of block %lu failed\n", (long unsigned int)block->blockNum);
+        }
 
-        return mWriteBufferLen;
+        // Keep a clean copy of what was written unless it is already outdated
+        block->state = (success && !superseded) ? CACHE_BLOCK_VALID : CACHE_BLOCK_EMPTY;
     }
-    return -1;
 }
 
-uint32_t DreamcastStorage::flipWordBytes(const uint32_t& word)
+void DreamcastStorage::setNumReadAheadBlocks(uint8_t numBlocks)
 {
-    return (word << 24) | (word << 8 & 0xFF0000) | (word >> 8 & 0xFF00) | (word >> 24);
+    mNumReadAheadBlocks = (numBlocks > MAX_READ_AHEAD_BLOCKS) ? MAX_READ_AHEAD_BLOCKS : numBlocks;
 }
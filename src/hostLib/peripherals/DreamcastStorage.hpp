@@ -31,21 +31,19 @@
 #include "hal/System/ClockInterface.hpp"
 
 //! Handles communication with the Dreamcast storage peripheral
-class DreamcastStorage : public DreamcastPeripheral, UsbFile
+class DreamcastStorage : public DreamcastPeripheral, public UsbFile
 {
     public:
-        //! The current state of the READ and WRITE state machines
+        //! The current state of the WRITE state machine
         enum ReadWriteState : uint8_t
         {
-            //! Read state machine is idle
+            //! Write state machine is idle
             READ_WRITE_IDLE = 0,
-            //! read() or write() has been executed, waiting for Maple Bus state machine to start r/w
-            READ_WRITE_STARTED,
-            //! The Maple Bus state machine has queued r/w
+            //! The Maple Bus state machine has queued write
             READ_WRITE_SENT,
             //! Write commit message was sent
             WRITE_COMMIT_SENT,
-            //! The Maple Bus state machine is currently processing r/w
+            //! The Maple Bus state machine is currently processing write
             READ_WRITE_PROCESSING
         };
 
@@ -75,7 +73,7 @@ class DreamcastStorage : public DreamcastPeripheral, UsbFile
                               std::shared_ptr<const Transmission> tx) final;
 
         //! Inherited from DreamcastPeripheral
-        virtual void txComplete(std::shared_ptr<const MaplePacket> packet,
+        virtual void txComplete(const MaplePacketView* packet,
                                 std::shared_ptr<const Transmission> tx) final;
 
         // The following are inherited from UsbFile
@@ -102,7 +100,22 @@ class DreamcastStorage : public DreamcastPeripheral, UsbFile
                              uint16_t bufferLen,
                              uint32_t timeoutUs) final;
 
+        //! Non-blocking read (must only be called from the core not operating maple bus)
+        //! Requests the given block and the blocks following it to be read into the block cache.
+        //! @param[in] blockNum  Block number to read (block is 512 bytes)
+        //! @param[out] buffer  Buffer output
+        //! @param[in] bufferLen  The length of buffer (but only up to 512 bytes will be written)
+        //! @param[in] timeoutUs  Timeout in microseconds for any newly requested block reads
+        //! @returns Positive value indicating how many bytes were read
+        //! @returns Zero if the block is not yet available
+        //! @returns Negative value if the read of this block failed or timed out
+        virtual int32_t tryRead(uint8_t blockNum,
+                                void* buffer,
+                                uint16_t bufferLen,
+                                uint32_t timeoutUs) final;
+
         //! Blocking write (must only be called from the core not operating maple bus)
+        //! Data is written back to the device in the background - use flush() to wait for it.
         //! @param[in] blockNum  Block number to write (block is 512 bytes)
         //! @param[in] buffer  Buffer
         //! @param[in] bufferLen  The length of buffer (but only up to 512 bytes will be written)
@@ -115,6 +128,31 @@ class DreamcastStorage : public DreamcastPeripheral, UsbFile
                               uint16_t bufferLen,
                               uint32_t timeoutUs) final;
 
+        //! Non-blocking write (must only be called from the core not operating maple bus)
+        //! The current contents of the block are fetched first so that unchanged data is skipped.
+        //! @param[in] blockNum  Block number to write (block is 512 bytes)
+        //! @param[in] buffer  Buffer
+        //! @param[in] bufferLen  The length of buffer (but only up to 512 bytes will be written)
+        //! @param[in] timeoutUs  Timeout in microseconds for any newly requested block reads
+        //! @returns Positive value indicating how many bytes were accepted
+        //! @returns Zero if the write may not be accepted yet
+        //! @returns Negative value if the write may not be accepted at all
+        virtual int32_t tryWrite(uint8_t blockNum,
+                                 const void* buffer,
+                                 uint16_t bufferLen,
+                                 uint32_t timeoutUs) final;
+
+        //! Blocking flush (must only be called from the core not operating maple bus)
+        //! @param[in] timeoutUs  Timeout in microseconds
+        //! @returns true iff all written data was committed to the device without error
+        virtual bool flush(uint32_t timeoutUs) final;
+
+        //! Non-blocking flush (must only be called from the core not operating maple bus)
+        //! @returns Positive value if all written data was committed to the device without error
+        //! @returns Zero if written data is still waiting to be committed
+        //! @returns Negative value if any write failed since the last flush
+        virtual int32_t tryFlush() final;
+
         //! @returns number of partitions on this device
         uint16_t getNumberOfPartitions() { return (mFd >> 24) + 1; }
         //! @returns the number of bytes per block of data
@@ -128,6 +166,12 @@ class DreamcastStorage : public DreamcastPeripheral, UsbFile
         //! @returns true iff CRC calculation is required for reads and writes
         bool isCrcRequired() { return ((mFd >> 6) & 0x01) != 0; }
 
+        //! Sets the number of blocks to read ahead of each requested block
+        //! @param[in] numBlocks  Number of blocks (limited to MAX_READ_AHEAD_BLOCKS)
+        void setNumReadAheadBlocks(uint8_t numBlocks);
+        //! @returns the number of blocks read ahead of each requested block
+        uint8_t getNumReadAheadBlocks() { return mNumReadAheadBlocks; }
+
         //! Inherited from DreamcastPeripheral
         inline uint32_t getFunctionCode() override final
         {
@@ -135,13 +179,105 @@ class DreamcastStorage : public DreamcastPeripheral, UsbFile
         }
 
     private:
-        //! Flips the endianness of a word
-        //! @param[in] word  Input word
-        //! @returns output word
-        static uint32_t flipWordBytes(const uint32_t& word);
+        //! Number of bytes in a single block
+        static const uint32_t BLOCK_SIZE_BYTES = 512;
+        //! Number of words in a single block
+        static const uint32_t BLOCK_SIZE_WORDS = BLOCK_SIZE_BYTES / sizeof(uint32_t);
+        //! Number of blocks in this storage device (as presented to USB)
+        static const uint32_t NUM_BLOCKS = 256;
+        //! Number of blocks held in the block cache
+        static const uint32_t NUM_CACHE_BLOCKS = 8;
 
-        //! Queues up write of the next chunk of data
-        void queueNextWritePhase();
+        //! The state of a single block in the block cache
+        enum CacheBlockState : uint8_t
+        {
+            //! Block holds no data (owned by read()/write())
+            CACHE_BLOCK_EMPTY = 0,
+            //! Block read was requested by read(), waiting for task() to queue it (owned by task())
+            CACHE_BLOCK_REQUESTED,
+            //! Block read is queued (owned by task())
+            CACHE_BLOCK_SENT,
+            //! Block read is currently being processed on the bus (owned by task())
+            CACHE_BLOCK_PROCESSING,
+            //! Block data is valid (owned by read()/write())
+            CACHE_BLOCK_VALID,
+            //! Block read failed or timed out (owned by read()/write())
+            CACHE_BLOCK_FAILED,
+            //! Block data was written by write(), waiting to be written back (owned by task())
+            CACHE_BLOCK_WRITE_PENDING,
+            //! Block data is currently being written back (owned by task())
+            CACHE_BLOCK_WRITING
+        };
+
+        //! A single block of the block cache
+        struct CacheBlock
+        {
+            //! The current state of this block which determines which side may access the data below
+            //! Data is never modified by task() while in a write state, so write() may compare
+            //! against it
+            std::atomic<CacheBlockState> state;
+            //! The block number this cache block holds
+            uint8_t blockNum;
+            //! Transmission ID of the read operation sent (or 0)
+            uint32_t txId;
+            //! Time at which the queued read must be killed
+            uint64_t killTime;
+            //! Last value of mCacheUseCount when this block was requested (only accessed by read())
+            uint32_t lastUsed;
+            //! True iff this block was requested as a read ahead (only accessed by read())
+            bool readAhead;
+            //! Value of mWriteSeq when this data was written by write() (0 when read from device)
+            uint32_t writeSeq;
+            //! Block data, stored raw in file byte order exactly as it is sent over maple bus
+            uint32_t data[BLOCK_SIZE_WORDS];
+        };
+
+        //! Looks up the newest cache block holding or fetching the given block number and drops any
+        //! stale copies of it
+        //! @param[in] blockNum  The block number to look up
+        //! @returns the newest cache block for the given block number
+        //! @returns nullptr if not found
+        CacheBlock* findBlock(uint8_t blockNum);
+
+        //! @returns a cache block which may be reused (owned by read()/write())
+        //! @returns nullptr if all cache blocks are busy
+        CacheBlock* claimBlock();
+
+        //! Finds the cache block for the given block number or requests it to be read if not found
+        //! @param[in] blockNum  The block number to look up
+        //! @param[in] killTime  Time at which the read must be killed if it is newly requested
+        //! @param[in] readAhead  True iff this block is only being read ahead
+        //! @returns the cache block for the given block number
+        //! @returns nullptr if all cache blocks are busy
+        CacheBlock* requestBlock(uint8_t blockNum, uint64_t killTime, bool readAhead);
+
+        //! Non-blocking lookup of the current contents of a block, requesting it (and the blocks
+        //! following it) to be read when not cached
+        //! @param[in] blockNum  The block number to look up
+        //! @param[in] timeoutUs  Timeout in microseconds for any newly requested block reads
+        //! @param[out] failed  Set to true iff the read of this block failed
+        //! @returns the cache block holding the current contents of the block
+        //! @returns nullptr if the block is not yet available or failed
+        CacheBlock* lookupBlock(uint8_t blockNum, uint32_t timeoutUs, bool& failed);
+
+        //! @param[in] txId  Transmission ID to look up
+        //! @returns the in-flight cache block which was read using the given transmission ID
+        //! @returns nullptr if not found
+        CacheBlock* findSentBlock(uint32_t txId);
+
+        //! Starts writing back the oldest pending block, if any
+        void startNextWrite();
+
+        //! Called once the current write back completes
+        //! @param[in] success  True iff data was committed to the device
+        void writeComplete(bool success);
+
+        //! Backs off then queues the current write back again from the first phase, or fails it if
+        //! there isn't enough time left
+        void retryWrite();
+
+        //! Queues up every write phase of the current block followed by its commit as one chain
+        void queueWriteChain();
 
         //! Queues transmission which commits the written set of data
         void queueWriteCommit();
@@ -153,6 +289,14 @@ class DreamcastStorage : public DreamcastPeripheral, UsbFile
         static const uint32_t DEFAULT_MIN_DURATION_US_BETWEEN_WRITES = 10000;
         //! Amount of time to increment time between writes after failure
         static const uint32_t DURATION_US_BETWEEN_WRITES_INC = 5000;
+        //! The maximum number of write phases per block which may be chained
+        static const uint8_t MAX_WRITE_PHASES = 8;
+        //! Amount of time a single block write back may take, including retries
+        static const uint32_t WRITE_BACK_TIMEOUT_US = 250000;
+        //! The default number of blocks to read ahead of each requested block
+        static const uint8_t DEFAULT_READ_AHEAD_BLOCKS = 3;
+        //! The maximum number of blocks which may be read ahead of each requested block
+        static const uint8_t MAX_READ_AHEAD_BLOCKS = NUM_CACHE_BLOCKS - 2;
 
     private:
         //! Initialized false and set to true when destructor called
@@ -164,32 +308,32 @@ class DreamcastStorage : public DreamcastPeripheral, UsbFile
         //! File name for this storage device
         char mFileName[12];
 
-        //! The current state in the read state machine
-        //! When READ_WRITE_IDLE: read() can read and write the data below
-        //! Otherwise: peripheral callbacks can read and write the data below
-        std::atomic<ReadWriteState> mReadState;
-
-        //! Transmission ID of the read operation sent (or 0)
-        uint32_t mReadingTxId;
-        //! The block number of the current read operation
-        uint8_t mReadingBlock;
-        //! Packet filled in as a result of a read operation
-        std::shared_ptr<const MaplePacket> mReadPacket;
-        //! Time at which read must be killed
-        uint64_t mReadKillTime;
-
-        //! The current state in the write state machine
-        //! When READ_WRITE_IDLE: write() can read and write the data below
-        //! Otherwise: peripheral callbacks can read and write the data below
-        std::atomic<ReadWriteState> mWriteState;
-
-        //! Transmission IDs of the 4 write operations sent (or 0)
+        //! Blocks held in the block cache
+        //! Each block's state determines whether read()/write() or peripheral callbacks may access it
+        CacheBlock mCacheBlocks[NUM_CACHE_BLOCKS];
+        //! Incremented on each block request in order to find the least recently used block
+        uint32_t mCacheUseCount;
+        //! Number of blocks to read ahead of each requested block
+        uint8_t mNumReadAheadBlocks;
+        //! Incremented on each accepted write in order to write back blocks in order
+        uint32_t mWriteSeq;
+        //! Number of failed write backs (only written by peripheral callbacks)
+        std::atomic<uint32_t> mNumWriteFailures;
+        //! Number of failed write backs already reported by flush()
+        uint32_t mNumWriteFailuresReported;
+
+        //! The current state in the write state machine (only accessed by peripheral callbacks)
+        ReadWriteState mWriteState;
+
+        //! The cache block currently being written back
+        CacheBlock* mWritingCacheBlock;
+        //! Transmission ID of the write chain or commit sent (or 0)
         uint32_t mWritingTxId;
         //! The block number of the current write operation
         uint8_t mWritingBlock;
         //! Pointer to the data to be written
         const void* mWriteBuffer;
-        //! Length of write buffer
+        //! Length of write buffer (set to -1 on failure)
         int32_t mWriteBufferLen;
         //! Time at which write must be killed
         uint64_t mWriteKillTime;
@@ -30,10 +30,18 @@ DreamcastTimer::DreamcastTimer(uint8_t addr,
                                PlayerData playerData) :
     DreamcastPeripheral("timer", addr, fd, scheduler, playerData.playerIndex),
     mGamepad(playerData.gamepad),
-    mButtonStatusId(0)
+    mButtonStatusId(PrioritizedTxScheduler::INVALID_TX_ID)
+{}
+
+DreamcastTimer::~DreamcastTimer()
+{}
+
+void DreamcastTimer::task(uint64_t currentTimeUs)
 {
-    // Poll only the upper VMU button states
-    if (addr & SUB_PERIPHERAL_ADDR_START_MASK)
+    // Poll only the upper VMU button states; this is tried again on each task while the schedule
+    // is full
+    if ((mAddr & SUB_PERIPHERAL_ADDR_START_MASK)
+        && mButtonStatusId == PrioritizedTxScheduler::INVALID_TX_ID)
     {
         uint32_t payload = FUNCTION_CODE;
         mButtonStatusId = mEndpointTxScheduler->add(
@@ -48,12 +56,6 @@ DreamcastTimer::DreamcastTimer(uint8_t addr,
     }
 }
 
-DreamcastTimer::~DreamcastTimer()
-{}
-
-void DreamcastTimer::task(uint64_t currentTimeUs)
-{}
-
 void DreamcastTimer::txStarted(std::shared_ptr<const Transmission> tx)
 {}
 
@@ -62,7 +64,7 @@ void DreamcastTimer::txFailed(bool writeFailed,
                               std::shared_ptr<const Transmission> tx)
 {}
 
-void DreamcastTimer::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastTimer::txComplete(const MaplePacketView* packet,
                                 std::shared_ptr<const Transmission> tx)
 {
     if (tx->transmissionId == mButtonStatusId
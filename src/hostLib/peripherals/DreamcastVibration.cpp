@@ -89,10 +89,11 @@ void DreamcastVibration::task(uint64_t currentTimeUs)
 {
     if (mFirst)
     {
-        mFirst = false;
-
         // Send some vibrations on connection
         send(currentTimeUs, 5, 0, 0, 250);
+
+        // Try again on the next task if the schedule was full
+        mFirst = (mTransmissionId == PrioritizedTxScheduler::INVALID_TX_ID);
     }
 }
 
@@ -110,7 +111,7 @@ void DreamcastVibration::txFailed(bool writeFailed,
 {
 }
 
-void DreamcastVibration::txComplete(std::shared_ptr<const MaplePacket> packet,
+void DreamcastVibration::txComplete(const MaplePacketView* packet,
                                     std::shared_ptr<const Transmission> tx)
 {
 }
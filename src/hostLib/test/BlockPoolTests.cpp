@@ -0,0 +1,164 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "MockMutex.hpp"
+
+#include "BlockPool.hpp"
+#include "PrioritizedTxScheduler.hpp"
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using ::testing::NiceMock;
+
+class BlockPoolTest : public ::testing::Test
+{
+    public:
+        BlockPoolTest() : mPool(std::make_shared<BlockPool>(mMutex, 20, 3)) {}
+
+    protected:
+        NiceMock<MockMutex> mMutex;
+        std::shared_ptr<BlockPool> mPool;
+};
+
+TEST_F(BlockPoolTest, allocateAndDeallocate)
+{
+    // Block size is rounded up for alignment
+    EXPECT_GE(mPool->getBlockSize(), 20);
+    EXPECT_EQ(mPool->getBlockSize() % sizeof(max_align_t), 0);
+
+    void* p1 = mPool->allocate(20);
+    void* p2 = mPool->allocate(1);
+    EXPECT_TRUE(mPool->owns(p1));
+    EXPECT_TRUE(mPool->owns(p2));
+    EXPECT_NE(p1, p2);
+
+    BlockPool::Stats stats = mPool->getStats();
+    EXPECT_EQ(stats.numBlocks, 3);
+    EXPECT_EQ(stats.numInUse, 2);
+    EXPECT_EQ(stats.highWaterMark, 2);
+    EXPECT_EQ(stats.numFailures, 0);
+
+    mPool->deallocate(p1);
+    // Last freed is first reused
+    void* p3 = mPool->allocate(8);
+    EXPECT_EQ(p3, p1);
+    mPool->deallocate(p2);
+    mPool->deallocate(p3);
+
+    stats = mPool->getStats();
+    EXPECT_EQ(stats.numInUse, 0);
+    EXPECT_EQ(stats.highWaterMark, 2);
+    EXPECT_EQ(stats.numFailures, 0);
+}
+
+TEST_F(BlockPoolTest, exhaustionFallsBackToHeap)
+{
+    void* p[4];
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        p[i] = mPool->allocate(16);
+        ASSERT_NE(p[i], nullptr);
+    }
+    EXPECT_TRUE(mPool->owns(p[2]));
+    EXPECT_FALSE(mPool->owns(p[3]));
+
+    // Too big to fit in a block
+    void* big = mPool->allocate(mPool->getBlockSize() + 1);
+    EXPECT_FALSE(mPool->owns(big));
+
+    BlockPool::Stats stats = mPool->getStats();
+    EXPECT_EQ(stats.numInUse, 3);
+    EXPECT_EQ(stats.highWaterMark, 3);
+    EXPECT_EQ(stats.numFailures, 2);
+
+    mPool->deallocate(big);
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        mPool->deallocate(p[i]);
+    }
+    EXPECT_EQ(mPool->getStats().numInUse, 0);
+}
+
+TEST_F(BlockPoolTest, allocateSharedKeepsPoolAlive)
+{
+    std::shared_ptr<BlockPool> pool = std::make_shared<BlockPool>(mMutex, sizeof(uint64_t) + 64, 2);
+    std::weak_ptr<BlockPool> weakPool = pool;
+    std::shared_ptr<uint64_t> value = std::allocate_shared<uint64_t>(PoolAllocator<uint64_t>(pool), 1234);
+    EXPECT_EQ(pool->getStats().numInUse, 1);
+    EXPECT_EQ(pool->getStats().numFailures, 0);
+
+    pool.reset();
+    EXPECT_FALSE(weakPool.expired());
+    EXPECT_EQ(*value, 1234);
+
+    value.reset();
+    EXPECT_TRUE(weakPool.expired());
+}
+
+TEST(PrioritizedTxSchedulerPoolTest, transmissionsAndPacketsComeFromPool)
+{
+    NiceMock<MockMutex> mutex;
+    PrioritizedTxScheduler scheduler(mutex, 0x00, 2, 16, 4);
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        MaplePacket packet({.command=0x0B, .recipientAddr=0x01}, 0x00000002);
+        EXPECT_NE(scheduler.add(0, i, nullptr, packet, true, 130), 0u);
+    }
+    std::shared_ptr<MaplePacket> response = scheduler.makePacket();
+
+    BlockPool::Stats txStats = scheduler.getTransmissionPoolStats();
+    EXPECT_EQ(txStats.numBlocks, 4);
+    EXPECT_EQ(txStats.numInUse, 3);
+    EXPECT_EQ(txStats.numFailures, 0);
+    BlockPool::Stats pktStats = scheduler.getPacketPoolStats();
+    EXPECT_EQ(pktStats.numInUse, 4);
+    EXPECT_EQ(pktStats.numFailures, 0);
+
+    // Popped transmissions are returned to the pool once released
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        PrioritizedTxScheduler::ScheduleItem item = scheduler.peekNext(i);
+        EXPECT_NE(scheduler.popItem(item), nullptr);
+    }
+    response.reset();
+
+    txStats = scheduler.getTransmissionPoolStats();
+    EXPECT_EQ(txStats.numInUse, 0);
+    EXPECT_EQ(txStats.highWaterMark, 3);
+    pktStats = scheduler.getPacketPoolStats();
+    EXPECT_EQ(pktStats.numInUse, 0);
+    EXPECT_EQ(pktStats.highWaterMark, 4);
+
+    // Exceeding the pool still works, but the failure is counted
+    std::vector<std::shared_ptr<MaplePacket>> packets;
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        packets.push_back(scheduler.makePacket());
+    }
+    EXPECT_EQ(scheduler.getPacketPoolStats().numFailures, 1);
+}
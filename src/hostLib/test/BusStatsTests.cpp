@@ -0,0 +1,91 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "BusStats.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(BusStatsTest, busyAndIdleTime)
+{
+    // --- SETUP ---
+    BusStats stats;
+
+    // --- TEST EXECUTION ---
+    stats.writeStarted(1000, 1000, 1000);
+    stats.transferEnded(MapleBusInterface::Phase::READ_COMPLETE, MapleBusInterface::FailureReason::NONE, 1300);
+    stats.writeStarted(2000, 2000, 2000);
+    stats.transferEnded(MapleBusInterface::Phase::WRITE_COMPLETE, MapleBusInterface::FailureReason::NONE, 2100);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(stats.getBusyUs(), 400);
+    EXPECT_EQ(stats.getIdleUs(), 700);
+}
+
+TEST(BusStatsTest, latenessAndDeadlineMisses)
+{
+    // --- SETUP ---
+    BusStats stats;
+
+    // --- TEST EXECUTION ---
+    // On time, late but within deadline, then past deadline
+    stats.writeStarted(1000, 1500, 1000);
+    stats.transferEnded(MapleBusInterface::Phase::READ_COMPLETE, MapleBusInterface::FailureReason::NONE, 1300);
+    stats.writeStarted(1300, 1800, 1600);
+    stats.transferEnded(MapleBusInterface::Phase::READ_COMPLETE, MapleBusInterface::FailureReason::NONE, 1900);
+    stats.writeStarted(1400, 1400, 1900);
+    stats.transferEnded(MapleBusInterface::Phase::READ_COMPLETE, MapleBusInterface::FailureReason::NONE, 2200);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(stats.lateness.getCount(), 3);
+    EXPECT_EQ(stats.lateness.getMin(), 0);
+    EXPECT_EQ(stats.lateness.getMax(), 500);
+    EXPECT_EQ(stats.getNumDeadlineMisses(), 1);
+}
+
+TEST(BusStatsTest, failuresCountedByReasonAndReset)
+{
+    // --- SETUP ---
+    BusStats stats;
+
+    // --- TEST EXECUTION ---
+    stats.writeStarted(0, 0, 100);
+    stats.transferEnded(MapleBusInterface::Phase::READ_FAILED, MapleBusInterface::FailureReason::CRC_INVALID, 400);
+    stats.writeStarted(400, 400, 400);
+    stats.transferEnded(MapleBusInterface::Phase::READ_FAILED, MapleBusInterface::FailureReason::TIMEOUT, 1400);
+    stats.writeStarted(1400, 1400, 1400);
+    stats.transferEnded(MapleBusInterface::Phase::WRITE_FAILED, MapleBusInterface::FailureReason::TIMEOUT, 1500);
+    uint32_t numCrcFailures = stats.getNumReadFailures(MapleBusInterface::FailureReason::CRC_INVALID);
+    uint32_t numReadTimeouts = stats.getNumReadFailures(MapleBusInterface::FailureReason::TIMEOUT);
+    uint32_t numWriteTimeouts = stats.getNumWriteFailures(MapleBusInterface::FailureReason::TIMEOUT);
+    stats.reset();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(numCrcFailures, 1);
+    EXPECT_EQ(numReadTimeouts, 1);
+    EXPECT_EQ(numWriteTimeouts, 1);
+    EXPECT_EQ(stats.getNumReadFailures(MapleBusInterface::FailureReason::TIMEOUT), 0);
+    EXPECT_EQ(stats.getBusyUs(), 0);
+    EXPECT_EQ(stats.getIdleUs(), 0);
+    EXPECT_EQ(stats.lateness.getCount(), 0);
+}
@@ -0,0 +1,208 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "hal/System/ByteRing.hpp"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(ByteRingTest, wrapsAroundInOrder)
+{
+    // --- SETUP ---
+    ByteRing<8> ring;
+    uint8_t out[8] = {};
+
+    // --- TEST EXECUTION ---
+    bool added1 = ring.write("abcde", 5);
+    uint32_t numRead1 = ring.read(out, 3);
+    // Wraps around the end of the buffer
+    bool added2 = ring.write("fghijk", 6);
+    const uint8_t* span = nullptr;
+    uint32_t spanLen = ring.peek(span);
+    uint32_t size = ring.size();
+    uint32_t numRead2 = ring.read(out + 3, 5);
+
+    // --- EXPECTATIONS ---
+    EXPECT_TRUE(added1);
+    EXPECT_EQ(numRead1, 3);
+    EXPECT_TRUE(added2);
+    // Only the contiguous part up to the end of the buffer is returned by peek()
+    EXPECT_EQ(spanLen, 5);
+    EXPECT_EQ(memcmp(span, "defgh", 5), 0);
+    EXPECT_EQ(size, 8);
+    EXPECT_EQ(numRead2, 5);
+    EXPECT_EQ(memcmp(out, "abcdefgh", 8), 0);
+    EXPECT_EQ(ring.size(), 3);
+}
+
+TEST(ByteRingTest, overflowDropsWholeWrites)
+{
+    // --- SETUP ---
+    ByteRing<8> ring;
+    uint8_t out[8] = {};
+
+    // --- TEST EXECUTION ---
+    bool added1 = ring.write("abcdef", 6);
+    bool added2 = ring.write("ghi", 3);
+    bool added3 = ring.write("gh", 2);
+    bool added4 = ring.write("x", 1);
+    uint32_t numRead = ring.read(out, sizeof(out));
+
+    // --- EXPECTATIONS ---
+    EXPECT_TRUE(added1);
+    EXPECT_FALSE(added2);
+    EXPECT_TRUE(added3);
+    EXPECT_FALSE(added4);
+    EXPECT_EQ(numRead, 8);
+    EXPECT_EQ(memcmp(out, "abcdefgh", 8), 0);
+}
+
+TEST(ByteRingTest, clearDropsPendingData)
+{
+    // --- SETUP ---
+    ByteRing<16> ring;
+    ring.write("abc", 3);
+
+    // --- TEST EXECUTION ---
+    ring.clear();
+    bool added = ring.write("0123456789abcdef", 16);
+
+    // --- EXPECTATIONS ---
+    EXPECT_TRUE(added);
+    EXPECT_EQ(ring.size(), 16);
+}
+
+TEST(ByteRingTest, producerAndConsumerOnSeparateThreads)
+{
+    // --- SETUP ---
+    static const uint32_t NUM_MESSAGES = 20000;
+    ByteRing<64> ring;
+    std::vector<uint8_t> received;
+    received.reserve(NUM_MESSAGES * 3);
+
+    // --- TEST EXECUTION ---
+    std::thread producer([&ring]()
+    {
+        for (uint32_t i = 0; i < NUM_MESSAGES; ++i)
+        {
+            uint8_t msg[3] = {static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8), 0xA5};
+            // Retry here only so that every message can be checked; real producers drop
+            while (!ring.write(msg, sizeof(msg)))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint8_t buffer[16];
+    while (received.size() < NUM_MESSAGES * 3)
+    {
+        uint32_t n = ring.read(buffer, sizeof(buffer));
+        if (n == 0)
+        {
+            std::this_thread::yield();
+        }
+        received.insert(received.end(), buffer, buffer + n);
+    }
+    producer.join();
+
+    // --- EXPECTATIONS ---
+    bool inOrder = true;
+    for (uint32_t i = 0; i < NUM_MESSAGES && inOrder; ++i)
+    {
+        inOrder = (received[i * 3] == static_cast<uint8_t>(i)
+                   && received[i * 3 + 1] == static_cast<uint8_t>(i >> 8)
+                   && received[i * 3 + 2] == 0xA5);
+    }
+    EXPECT_TRUE(inOrder);
+    EXPECT_EQ(ring.size(), 0);
+}
+
+TEST(ByteRingTest, serializedProducersOnSeparateThreads)
+{
+    // --- SETUP ---
+    static const uint32_t NUM_MESSAGES = 10000;
+    ByteRing<64> ring;
+    std::mutex producerMutex;
+    std::vector<uint8_t> received;
+    received.reserve(NUM_MESSAGES * 2 * 4);
+
+    // --- TEST EXECUTION ---
+    auto produce = [&ring, &producerMutex](uint8_t id)
+    {
+        for (uint32_t i = 0; i < NUM_MESSAGES; ++i)
+        {
+            uint8_t msg[4] = {id, static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8), 0xA5};
+            bool added = false;
+            while (!added)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(producerMutex);
+                    added = ring.write(msg, sizeof(msg));
+                }
+                if (!added)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    };
+    std::thread producer1(produce, 1);
+    std::thread producer2(produce, 2);
+
+    uint8_t buffer[16];
+    while (received.size() < NUM_MESSAGES * 2 * 4)
+    {
+        // The consumer never takes the producers' lock
+        uint32_t n = ring.read(buffer, sizeof(buffer));
+        if (n == 0)
+        {
+            std::this_thread::yield();
+        }
+        received.insert(received.end(), buffer, buffer + n);
+    }
+    producer1.join();
+    producer2.join();
+
+    // --- EXPECTATIONS ---
+    // Messages are never torn, and each producer's messages stay in order
+    bool intact = true;
+    uint32_t nextIndex[3] = {0, 0, 0};
+    for (uint32_t i = 0; i < received.size() && intact; i += 4)
+    {
+        uint8_t id = received[i];
+        uint32_t index = received[i + 1] | (received[i + 2] << 8);
+        intact = ((id == 1 || id == 2) && index == nextIndex[id] && received[i + 3] == 0xA5);
+        if (intact)
+        {
+            ++nextIndex[id];
+        }
+    }
+    EXPECT_TRUE(intact);
+    EXPECT_EQ(nextIndex[1], NUM_MESSAGES);
+    EXPECT_EQ(nextIndex[2], NUM_MESSAGES);
+}
@@ -0,0 +1,112 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "LoopbackClientBus.hpp"
+#include "RamSystemMemory.hpp"
+
+#include "clientLib/DreamcastMainPeripheral.hpp"
+#include "clientLib/DreamcastController.hpp"
+#include "clientLib/DreamcastPeripheral.hpp"
+#include "clientLib/DreamcastStorage.hpp"
+#include "hal/MapleBus/MaplePacket.hpp"
+#include "dreamcast_constants.h"
+#include "dreamcast_structures.h"
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+//! Local copy of the VMU memory size which may be bound to a reference
+static const uint32_t VMU_MEMORY_SIZE = client::DreamcastStorage::MEMORY_SIZE_BYTES;
+
+//! Client controller with a VMU attached, connected as player 1 on a bus which reads back the same
+//! GET_CONDITION request every time it is processed
+class ClientConditionResponseTest : public ::testing::Test
+{
+    public:
+        ClientConditionResponseTest() :
+            mBus(std::make_shared<LoopbackClientBus>()),
+            mMainPeripheral(
+                mBus,
+                0x20,
+                0xFF,
+                0x00,
+                "Dreamcast Controller",
+                "Version 1.010,1998/09/28,315-6211-AB   ,Analog Module : The 4th Edition.5/8  +DF",
+                43.0,
+                50.0),
+            mController(std::make_shared<client::DreamcastController>()),
+            mVmu(std::make_shared<client::DreamcastPeripheral>(
+                0x01,
+                0xFF,
+                0x00,
+                "Visual Memory",
+                "Version 1.005,1999/04/15,315-6208-03,SEGA Visual Memory System BIOS",
+                12.4,
+                13.0)),
+            mStorage(std::make_shared<client::DreamcastStorage>(
+                std::make_shared<RamSystemMemory>(VMU_MEMORY_SIZE), 0)),
+            mConditionRequest({.command=COMMAND_GET_CONDITION, .recipientAddr=0x20, .senderAddr=0x00},
+                              DEVICE_FN_CONTROLLER)
+        {
+            // Sub-peripherals are part of the lookup which used to be made for every request
+            mMainPeripheral.addFunction(mController);
+            mVmu->addFunction(mStorage);
+            mMainPeripheral.addSubPeripheral(mVmu);
+
+            // Connect as player 1
+            MaplePacket devInfo({.command=COMMAND_DEVICE_INFO_REQUEST, .recipientAddr=0x20, .senderAddr=0x00}, nullptr, 0);
+            MaplePacket out;
+            mMainPeripheral.dispensePacket(devInfo, out);
+
+            mBus->setRequest(mConditionRequest);
+        }
+
+    protected:
+        //! The words which the pre-serialized path wrote before
+        void expectSameAsDispensed()
+        {
+            MaplePacket out;
+            ASSERT_TRUE(mMainPeripheral.dispensePacket(mConditionRequest, out));
+            ASSERT_TRUE(mBus->write(out, true));
+            std::vector<uint32_t> dispensed(mBus->getWrittenWords(),
+                                            mBus->getWrittenWords() + mBus->getWrittenLen());
+
+            mMainPeripheral.task(0);
+            ASSERT_TRUE(mBus->wasSerialized());
+            std::vector<uint32_t> serialized(mBus->getWrittenWords(),
+                                             mBus->getWrittenWords() + mBus->getWrittenLen());
+
+            EXPECT_EQ(serialized, dispensed);
+        }
+
+        std::shared_ptr<LoopbackClientBus> mBus;
+        client::DreamcastMainPeripheral mMainPeripheral;
+        std::shared_ptr<client::DreamcastController> mController;
+        std::shared_ptr<client::DreamcastPeripheral> mVmu;
+        std::shared_ptr<client::DreamcastStorage> mStorage;
+        MaplePacket mConditionRequest;
+};
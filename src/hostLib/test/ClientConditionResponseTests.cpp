@@ -0,0 +1,48 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ClientConditionResponseTest.hpp"
+
+#include "dreamcast_constants.h"
+#include "dreamcast_structures.h"
+
+#include <gtest/gtest.h>
+
+TEST_F(ClientConditionResponseTest, serializedResponseMatchesDispensed)
+{
+    expectSameAsDispensed();
+
+    controller_condition_t condition = NEUTRAL_CONTROLLER_CONDITION;
+    condition.a = 0;
+    condition.rAnalogLR = 0xFF;
+    mController->setCondition(condition);
+    expectSameAsDispensed();
+
+    // Resend of the last response is the very same words
+    const uint32_t* lastWords = mBus->getWrittenWords();
+    MaplePacket resend({.command=COMMAND_RESPONSE_REQUEST_RESEND, .recipientAddr=0x20, .senderAddr=0x00}, nullptr, 0);
+    mBus->setRequest(resend);
+    mMainPeripheral.task(0);
+    EXPECT_TRUE(mBus->wasSerialized());
+    EXPECT_EQ(mBus->getWrittenWords(), lastWords);
+}
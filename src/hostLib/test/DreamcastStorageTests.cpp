@@ -0,0 +1,691 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "DreamcastMainNode.hpp"
+#include "DreamcastStorage.hpp"
+#include "PrioritizedTxScheduler.hpp"
+#include "PlayerData.hpp"
+#include "ScreenData.hpp"
+#include "dreamcast_constants.h"
+#include "configuration.h"
+
+#include "MockMapleBus.hpp"
+#include "MockClock.hpp"
+#include "MockMutex.hpp"
+#include "MockUsbFileSystem.hpp"
+#include "MockDreamcastControllerObserver.hpp"
+
+#include <memory>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::SaveArg;
+
+//! Simulates a controller with a VMU attached to its first sub peripheral slot, including the time
+//! each packet takes on the bus
+class DreamcastStorageTest : public ::testing::Test
+{
+    public:
+        DreamcastStorageTest() :
+            mScreenData(),
+            mPlayerData(0, mControllerObserver, mScreenData, mClock, mUsbFileSystem),
+            mScheduler(std::make_shared<PrioritizedTxScheduler>(mScheduleMutex, 0x00)),
+            mDreamcastMainNode(mMapleBus, mPlayerData, mScheduler),
+            mCurrentTimeUs(0),
+            mBusBusy(false),
+            mBusCompleteTimeUs(0),
+            mResponse{},
+            mResponseLen(0),
+            mVmuData{},
+            mNumBlockWrites(0),
+            mNumCommits(0),
+            mNumPhasesToReject(0),
+            mWriteLog(),
+            mStorage(nullptr)
+        {
+            for (uint32_t blockNum = 0; blockNum < NUM_BLOCKS; ++blockNum)
+            {
+                for (uint32_t i = 0; i < BLOCK_WORDS; ++i)
+                {
+                    mVmuData[blockNum][i] = blockWord(blockNum, i);
+                }
+            }
+        }
+
+    protected:
+        virtual void SetUp()
+        {
+            ON_CALL(mClock, getTimeUs()).WillByDefault(Invoke([this](){return mCurrentTimeUs;}));
+            ON_CALL(mUsbFileSystem, add(_)).WillByDefault(SaveArg<0>(&mStorage));
+            ON_CALL(mMapleBus, mockWrite(_, _, _)).WillByDefault(Invoke(this, &DreamcastStorageTest::busWrite));
+            ON_CALL(mMapleBus, processEvents(_))
+                .WillByDefault(Invoke(this, &DreamcastStorageTest::busProcessEvents));
+            ON_CALL(mMapleBus, isBusy()).WillByDefault(Invoke([this](){return mBusBusy;}));
+            ON_CALL(mMapleBus, startRead(_)).WillByDefault(Return(false));
+        }
+
+        bool busWrite(const MaplePacket& packet, bool expectResponse, uint64_t readTimeoutUs)
+        {
+            uint8_t recipientAddr = packet.frame.senderAddr;
+            uint8_t senderAddr = packet.frame.recipientAddr;
+            uint32_t* response = mResponse;
+            memset(mResponse, 0, sizeof(mResponse));
+
+            if (packet.frame.command == COMMAND_DEVICE_INFO_REQUEST)
+            {
+                mResponseLen = EXPECTED_DEVICE_INFO_PAYLOAD_WORDS + 1;
+                if (senderAddr == 0x20)
+                {
+                    // Controller, which reports the VMU in its first slot
+                    *response++ = MaplePacket::Frame{
+                        .command=COMMAND_RESPONSE_DEVICE_INFO,
+                        .recipientAddr=recipientAddr,
+                        .senderAddr=static_cast<uint8_t>(senderAddr | 0x01),
+                        .length=EXPECTED_DEVICE_INFO_PAYLOAD_WORDS}.toWord();
+                    *response++ = DEVICE_FN_CONTROLLER;
+                    *response++ = 0x000F06FE;
+                }
+                else
+                {
+                    // VMU with 512 byte blocks, 4 write phases, and 1 read phase
+                    *response++ = MaplePacket::Frame{
+                        .command=COMMAND_RESPONSE_DEVICE_INFO,
+                        .recipientAddr=recipientAddr,
+                        .senderAddr=senderAddr,
+                        .length=EXPECTED_DEVICE_INFO_PAYLOAD_WORDS}.toWord();
+                    *response++ = DEVICE_FN_STORAGE;
+                    *response++ = 0x000F4100;
+                }
+            }
+            else if (packet.frame.command == COMMAND_GET_CONDITION)
+            {
+                mResponseLen = 4;
+                *response++ = MaplePacket::Frame{
+                    .command=COMMAND_RESPONSE_DATA_XFER,
+                    .recipientAddr=recipientAddr,
+                    .senderAddr=static_cast<uint8_t>(senderAddr | 0x01),
+                    .length=3}.toWord();
+                *response++ = DEVICE_FN_CONTROLLER;
+                *response++ = 0xFFFFFFFF;
+                *response++ = 0x80808080;
+            }
+            else if (packet.frame.command == COMMAND_BLOCK_READ)
+            {
+                uint32_t blockNum = packet.payload[1] & 0xFF;
+                mResponseLen = 3 + BLOCK_WORDS;
+                *response++ = MaplePacket::Frame{
+                    .command=COMMAND_RESPONSE_DATA_XFER,
+                    .recipientAddr=recipientAddr,
+                    .senderAddr=senderAddr,
+                    .length=2 + BLOCK_WORDS}.toWord();
+                *response++ = DEVICE_FN_STORAGE;
+                *response++ = packet.payload[1];
+                for (uint32_t i = 0; i < BLOCK_WORDS; ++i)
+                {
+                    *response++ = busWord(mVmuData[blockNum][i], (2 + i) >= packet.rawResponseIdx);
+                }
+            }
+            else if (packet.frame.command == COMMAND_BLOCK_WRITE)
+            {
+                // 4 write phases of 32 words each
+                uint32_t blockNum = packet.payload[1] & 0xFF;
+                uint32_t phase = (packet.payload[1] >> 16) & 0xFF;
+                mWriteLog.push_back({mCurrentTimeUs, COMMAND_BLOCK_WRITE, phase});
+                if (mNumPhasesToReject > 0 && phase == 1)
+                {
+                    --mNumPhasesToReject;
+                    mResponseLen = 1;
+                    *response++ = MaplePacket::Frame{
+                        .command=COMMAND_RESPONSE_FILE_ERROR,
+                        .recipientAddr=recipientAddr,
+                        .senderAddr=senderAddr,
+                        .length=0}.toWord();
+                    return busStarted(packet);
+                }
+                for (uint32_t i = 2; i < packet.payload.size(); ++i)
+                {
+                    mVmuData[blockNum][(phase * 32) + (i - 2)] =
+                        busWord(packet.payload[i], i >= packet.rawPayloadIdx);
+                }
+                ++mNumBlockWrites;
+                mResponseLen = 1;
+                *response++ = MaplePacket::Frame{
+                    .command=COMMAND_RESPONSE_ACK,
+                    .recipientAddr=recipientAddr,
+                    .senderAddr=senderAddr,
+                    .length=0}.toWord();
+            }
+            else if (packet.frame.command == COMMAND_GET_LAST_ERROR)
+            {
+                mWriteLog.push_back({mCurrentTimeUs, COMMAND_GET_LAST_ERROR, (packet.payload[1] >> 16) & 0xFF});
+                ++mNumCommits;
+                mResponseLen = 1;
+                *response++ = MaplePacket::Frame{
+                    .command=COMMAND_RESPONSE_ACK,
+                    .recipientAddr=recipientAddr,
+                    .senderAddr=senderAddr,
+                    .length=0}.toWord();
+            }
+            else
+            {
+                mResponseLen = 0;
+            }
+
+            return busStarted(packet);
+        }
+
+        //! Marks the bus busy for as long as the given packet and the current response take
+        bool busStarted(const MaplePacket& packet)
+        {
+            uint64_t durationNs = packet.getTxTimeNs();
+            if (mResponseLen > 0)
+            {
+                durationNs += MaplePacket::getTxTimeNs(mResponseLen - 1, MAPLE_RESPONSE_NS_PER_BIT);
+            }
+            mBusBusy = true;
+            mBusCompleteTimeUs = mCurrentTimeUs + MAPLE_OPEN_LINE_CHECK_TIME_US + (durationNs / 1000);
+            return true;
+        }
+
+        MapleBusInterface::Status busProcessEvents(uint64_t currentTimeUs)
+        {
+            MapleBusInterface::Status status;
+            if (!mBusBusy)
+            {
+                status.phase = MapleBusInterface::Phase::IDLE;
+            }
+            else if (currentTimeUs < mBusCompleteTimeUs)
+            {
+                status.phase = MapleBusInterface::Phase::READ_IN_PROGRESS;
+            }
+            else
+            {
+                mBusBusy = false;
+                if (mResponseLen > 0)
+                {
+                    status.phase = MapleBusInterface::Phase::READ_COMPLETE;
+                    status.readBuffer = mResponse;
+                    status.readBufferLen = mResponseLen;
+                }
+                else
+                {
+                    status.phase = MapleBusInterface::Phase::WRITE_COMPLETE;
+                }
+            }
+            return status;
+        }
+
+        //! @returns the given word as it is seen on the other side of the bus, which only swaps
+        //!          bytes of words that aren't raw on either end
+        static uint32_t busWord(uint32_t word, bool raw)
+        {
+            return raw ? __builtin_bswap32(word) : word;
+        }
+
+        //! @returns the word the simulated VMU holds at the given block and word index
+        static uint32_t blockWord(uint32_t blockNum, uint32_t wordIdx)
+        {
+            return (blockNum << 16) | wordIdx;
+        }
+
+        //! Runs the node in steps up to the given time
+        void runUntil(uint64_t endTimeUs)
+        {
+            while (mCurrentTimeUs < endTimeUs)
+            {
+                step();
+            }
+        }
+
+        void step()
+        {
+            mDreamcastMainNode.task(mCurrentTimeUs);
+            mCurrentTimeUs += STEP_US;
+        }
+
+        //! Reads every block in order the same way the USB host does, each read only being issued
+        //! once the previous block has been transferred over USB
+        //! @returns the simulated time it took to read all blocks
+        uint64_t readAllBlocks(uint32_t& numFailures, uint32_t& numBadBlocks)
+        {
+            DreamcastStorage* storage = static_cast<DreamcastStorage*>(mStorage);
+            uint64_t startTimeUs = mCurrentTimeUs;
+            uint64_t nextUsbTimeUs = mCurrentTimeUs;
+            uint32_t blockNum = 0;
+            uint32_t buffer[BLOCK_WORDS];
+            numFailures = 0;
+            numBadBlocks = 0;
+
+            while (blockNum < NUM_BLOCKS && mCurrentTimeUs < startTimeUs + MAX_READ_ALL_TIME_US)
+            {
+                if (mCurrentTimeUs >= nextUsbTimeUs)
+                {
+                    int32_t numRead = storage->tryRead(blockNum, buffer, sizeof(buffer), READ_TIMEOUT_US);
+                    if (numRead > 0)
+                    {
+                        for (uint32_t i = 0; i < BLOCK_WORDS; ++i)
+                        {
+                            if (buffer[i] != __builtin_bswap32(blockWord(blockNum, i)))
+                            {
+                                ++numBadBlocks;
+                                break;
+                            }
+                        }
+                        ++blockNum;
+                        nextUsbTimeUs = mCurrentTimeUs + USB_BLOCK_TURNAROUND_US;
+                    }
+                    else if (numRead < 0)
+                    {
+                        // Host retries
+                        ++numFailures;
+                        nextUsbTimeUs = mCurrentTimeUs + USB_BLOCK_TURNAROUND_US;
+                    }
+                }
+                step();
+            }
+
+            uint32_t numBlocks = NUM_BLOCKS;
+            EXPECT_EQ(blockNum, numBlocks);
+            return mCurrentTimeUs - startTimeUs;
+        }
+
+        //! Calls the given non-blocking storage operation until it completes or the time limit elapses
+        //! @returns the result of the operation
+        template <typename T>
+        int32_t stepUntilDone(T operation, uint64_t maxDurationUs = 1000000)
+        {
+            uint64_t endTimeUs = mCurrentTimeUs + maxDurationUs;
+            int32_t result = 0;
+            while ((result = operation()) == 0 && mCurrentTimeUs < endTimeUs)
+            {
+                step();
+            }
+            return result;
+        }
+
+        //! Takes every free node of the schedule with transmissions which are never sent
+        //! @returns the number of transmissions added
+        uint32_t fillSchedule()
+        {
+            uint32_t numAdded = 0;
+            while (true)
+            {
+                MaplePacket packet({.command=COMMAND_GET_CONDITION, .recipientAddr=FILL_ADDR},
+                                   DEVICE_FN_CONTROLLER);
+                uint32_t id = mScheduler->add(PrioritizedTxScheduler::EXTERNAL_TRANSMISSION_PRIORITY,
+                                              FILL_TIME_US,
+                                              nullptr,
+                                              packet,
+                                              true);
+                if (id == PrioritizedTxScheduler::INVALID_TX_ID)
+                {
+                    return numAdded;
+                }
+                ++numAdded;
+            }
+        }
+
+        //! Fills the given buffer with the words the VMU is expected to hold after a write
+        static void fillBlock(uint32_t* buffer, uint32_t blockNum, uint32_t seed)
+        {
+            for (uint32_t i = 0; i < BLOCK_WORDS; ++i)
+            {
+                buffer[i] = __builtin_bswap32(blockWord(blockNum, i) ^ seed);
+            }
+        }
+
+        //! @returns true iff the simulated VMU block holds what fillBlock() generated with the given seed
+        bool vmuBlockMatches(uint32_t blockNum, uint32_t seed)
+        {
+            for (uint32_t i = 0; i < BLOCK_WORDS; ++i)
+            {
+                if (mVmuData[blockNum][i] != (blockWord(blockNum, i) ^ seed))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //! A write related packet as seen by the simulated VMU
+        struct WriteLogEntry
+        {
+            //! Time the packet started on the bus
+            uint64_t timeUs;
+            //! COMMAND_BLOCK_WRITE or COMMAND_GET_LAST_ERROR
+            uint8_t command;
+            //! The phase in the packet's location word
+            uint32_t phase;
+        };
+
+        //! Number of words in a VMU block
+        static const uint32_t BLOCK_WORDS = 128;
+        //! Number of blocks in a VMU
+        static const uint32_t NUM_BLOCKS = 256;
+        //! Simulation step
+        static const uint64_t STEP_US = 10;
+        //! Time between one block being read and the USB host requesting the next
+        static const uint64_t USB_BLOCK_TURNAROUND_US = 1000;
+        //! Timeout used by msc_disk for each read
+        static const uint32_t READ_TIMEOUT_US = 20000;
+        //! Time at which to give up on reading all blocks
+        static const uint64_t MAX_READ_ALL_TIME_US = 30000000;
+        //! Recipient of the transmissions added by fillSchedule()
+        static const uint8_t FILL_ADDR = 0x3F;
+        //! Time of the transmissions added by fillSchedule(), well past the end of any test
+        static const uint64_t FILL_TIME_US = 1000000000000ULL;
+
+        NiceMock<MockMutex> mScheduleMutex;
+        NiceMock<MockClock> mClock;
+        NiceMock<MockUsbFileSystem> mUsbFileSystem;
+        NiceMock<MockDreamcastControllerObserver> mControllerObserver;
+        NiceMock<MockMapleBus> mMapleBus;
+        ScreenData mScreenData;
+        PlayerData mPlayerData;
+        std::shared_ptr<PrioritizedTxScheduler> mScheduler;
+        DreamcastMainNode mDreamcastMainNode;
+        uint64_t mCurrentTimeUs;
+        bool mBusBusy;
+        uint64_t mBusCompleteTimeUs;
+        uint32_t mResponse[3 + BLOCK_WORDS];
+        uint32_t mResponseLen;
+        uint32_t mVmuData[NUM_BLOCKS][BLOCK_WORDS];
+        uint32_t mNumBlockWrites;
+        uint32_t mNumCommits;
+        //! Number of times to reject the second write phase
+        uint32_t mNumPhasesToReject;
+        std::vector<WriteLogEntry> mWriteLog;
+        UsbFile* mStorage;
+};
+
+TEST_F(DreamcastStorageTest, readAheadReducesFullReadTime)
+{
+    // --- SETUP ---
+    // Let the controller and VMU connect
+    runUntil(100000);
+    ASSERT_NE(mStorage, nullptr);
+    DreamcastStorage* storage = static_cast<DreamcastStorage*>(mStorage);
+
+    // --- TEST EXECUTION ---
+    uint32_t numFailuresBefore = 0;
+    uint32_t numBadBlocksBefore = 0;
+    storage->setNumReadAheadBlocks(0);
+    uint64_t durationBeforeUs = readAllBlocks(numFailuresBefore, numBadBlocksBefore);
+
+    uint32_t numFailuresAfter = 0;
+    uint32_t numBadBlocksAfter = 0;
+    storage->setNumReadAheadBlocks(DreamcastStorage::DEFAULT_READ_AHEAD_BLOCKS);
+    uint64_t durationAfterUs = readAllBlocks(numFailuresAfter, numBadBlocksAfter);
+
+    printf("DreamcastStorage full read: %.1f ms without read ahead, %.1f ms with %lu block read ahead\n",
+           durationBeforeUs / 1000.0,
+           durationAfterUs / 1000.0,
+           (long unsigned int)DreamcastStorage::DEFAULT_READ_AHEAD_BLOCKS);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(numFailuresBefore, 0);
+    EXPECT_EQ(numBadBlocksBefore, 0);
+    EXPECT_EQ(numFailuresAfter, 0);
+    EXPECT_EQ(numBadBlocksAfter, 0);
+    EXPECT_LT(durationAfterUs, durationBeforeUs);
+}
+
+TEST_F(DreamcastStorageTest, writeAcknowledgedBeforeCommitThenFlushed)
+{
+    // --- SETUP ---
+    runUntil(100000);
+    ASSERT_NE(mStorage, nullptr);
+    DreamcastStorage* storage = static_cast<DreamcastStorage*>(mStorage);
+    uint32_t buffer[BLOCK_WORDS];
+    fillBlock(buffer, 7, 0x5A5A5A5A);
+
+    // --- TEST EXECUTION ---
+    int32_t numWritten = stepUntilDone(
+        [&](){return storage->tryWrite(7, buffer, sizeof(buffer), READ_TIMEOUT_US);});
+    uint32_t numCommitsAtAck = mNumCommits;
+    int32_t flushResult = stepUntilDone([&](){return storage->tryFlush();});
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(numWritten, sizeof(buffer));
+    EXPECT_EQ(numCommitsAtAck, 0);
+    EXPECT_EQ(flushResult, 1);
+    EXPECT_EQ(mNumCommits, 1);
+    EXPECT_TRUE(vmuBlockMatches(7, 0x5A5A5A5A));
+}
+
+TEST_F(DreamcastStorageTest, writeOfUnchangedBlockSkipped)
+{
+    // --- SETUP ---
+    runUntil(100000);
+    ASSERT_NE(mStorage, nullptr);
+    DreamcastStorage* storage = static_cast<DreamcastStorage*>(mStorage);
+    uint32_t buffer[BLOCK_WORDS];
+    fillBlock(buffer, 12, 0);
+
+    // --- TEST EXECUTION ---
+    int32_t numWritten = stepUntilDone(
+        [&](){return storage->tryWrite(12, buffer, sizeof(buffer), READ_TIMEOUT_US);});
+    int32_t flushResult = stepUntilDone([&](){return storage->tryFlush();});
+    runUntil(mCurrentTimeUs + 100000);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(numWritten, sizeof(buffer));
+    EXPECT_EQ(flushResult, 1);
+    EXPECT_EQ(mNumBlockWrites, 0);
+    EXPECT_EQ(mNumCommits, 0);
+}
+
+TEST_F(DreamcastStorageTest, writesOfSameBlockCoalesce)
+{
+    // --- SETUP ---
+    runUntil(100000);
+    ASSERT_NE(mStorage, nullptr);
+    DreamcastStorage* storage = static_cast<DreamcastStorage*>(mStorage);
+    uint32_t buffer[BLOCK_WORDS];
+    fillBlock(buffer, 20, 0x11111111);
+    uint32_t buffer2[BLOCK_WORDS];
+    fillBlock(buffer2, 20, 0x22222222);
+
+    // --- TEST EXECUTION ---
+    int32_t numWritten = stepUntilDone(
+        [&](){return storage->tryWrite(20, buffer, sizeof(buffer), READ_TIMEOUT_US);});
+    // Second write lands before the first had a chance to go out
+    int32_t numWritten2 = storage->tryWrite(20, buffer2, sizeof(buffer2), READ_TIMEOUT_US);
+    int32_t flushResult = stepUntilDone([&](){return storage->tryFlush();});
+
+    uint32_t readBuffer[BLOCK_WORDS];
+    int32_t numRead = stepUntilDone(
+        [&](){return storage->tryRead(20, readBuffer, sizeof(readBuffer), READ_TIMEOUT_US);});
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(numWritten, sizeof(buffer));
+    EXPECT_EQ(numWritten2, sizeof(buffer2));
+    EXPECT_EQ(flushResult, 1);
+    EXPECT_EQ(mNumCommits, 1);
+    EXPECT_TRUE(vmuBlockMatches(20, 0x22222222));
+    EXPECT_EQ(numRead, sizeof(readBuffer));
+    EXPECT_EQ(memcmp(readBuffer, buffer2, sizeof(readBuffer)), 0);
+}
+
+TEST_F(DreamcastStorageTest, fullWriteOnlyCommitsChangedBlocks)
+{
+    // --- SETUP ---
+    runUntil(100000);
+    ASSERT_NE(mStorage, nullptr);
+    DreamcastStorage* storage = static_cast<DreamcastStorage*>(mStorage);
+    uint32_t buffer[BLOCK_WORDS];
+    uint64_t startTimeUs = mCurrentTimeUs;
+
+    // --- TEST EXECUTION ---
+    // Copy a whole file over where only a handful of blocks differ, the way a save is usually
+    // copied back onto a memory unit
+    uint32_t numAccepted = 0;
+    for (uint32_t blockNum = 0; blockNum < NUM_BLOCKS; ++blockNum)
+    {
+        fillBlock(buffer, blockNum, ((blockNum % 64) == 3) ? 0xA5A5A5A5 : 0);
+        if (stepUntilDone(
+            [&](){return storage->tryWrite(blockNum, buffer, sizeof(buffer), READ_TIMEOUT_US);}) > 0)
+        {
+            ++numAccepted;
+        }
+    }
+    uint64_t acceptedTimeUs = mCurrentTimeUs;
+    int32_t flushResult = stepUntilDone([&](){return storage->tryFlush();});
+    uint64_t flushedTimeUs = mCurrentTimeUs;
+
+    printf("DreamcastStorage full write with 4 changed blocks: %.1f ms to accept, %.1f ms to flush\n",
+           (acceptedTimeUs - startTimeUs) / 1000.0,
+           (flushedTimeUs - startTimeUs) / 1000.0);
+
+    // --- EXPECTATIONS ---
+    uint32_t numBlocks = NUM_BLOCKS;
+    EXPECT_EQ(numAccepted, numBlocks);
+    EXPECT_EQ(flushResult, 1);
+    EXPECT_EQ(mNumCommits, 4);
+    for (uint32_t blockNum = 0; blockNum < NUM_BLOCKS; ++blockNum)
+    {
+        EXPECT_TRUE(vmuBlockMatches(blockNum, ((blockNum % 64) == 3) ? 0xA5A5A5A5 : 0));
+    }
+}
+
+TEST_F(DreamcastStorageTest, writePhasesChainedIntoCommit)
+{
+    // --- SETUP ---
+    runUntil(100000);
+    ASSERT_NE(mStorage, nullptr);
+    DreamcastStorage* storage = static_cast<DreamcastStorage*>(mStorage);
+    uint32_t buffer[BLOCK_WORDS];
+    static const uint32_t NUM_WRITTEN_BLOCKS = 4;
+    uint64_t minGapUs = DreamcastStorage::DEFAULT_MIN_DURATION_US_BETWEEN_WRITES;
+
+    // --- TEST EXECUTION ---
+    for (uint32_t blockNum = 0; blockNum < NUM_WRITTEN_BLOCKS; ++blockNum)
+    {
+        fillBlock(buffer, blockNum, 0x3C3C3C3C);
+        stepUntilDone(
+            [&](){return storage->tryWrite(blockNum, buffer, sizeof(buffer), READ_TIMEOUT_US);});
+    }
+    int32_t flushResult = stepUntilDone([&](){return storage->tryFlush();});
+
+    // Measured from commit to commit so that the reads made by tryWrite() are left out
+    if (mWriteLog.size() == NUM_WRITTEN_BLOCKS * 5)
+    {
+        printf("DreamcastStorage write back: %.1f ms per block\n",
+               (mWriteLog.back().timeUs - mWriteLog[4].timeUs) / 1000.0 / (NUM_WRITTEN_BLOCKS - 1));
+    }
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(flushResult, 1);
+    ASSERT_EQ(mWriteLog.size(), NUM_WRITTEN_BLOCKS * 5);
+    for (uint32_t i = 0; i < mWriteLog.size(); ++i)
+    {
+        const WriteLogEntry& entry = mWriteLog[i];
+        EXPECT_EQ(entry.phase, i % 5);
+        if ((i % 5) == 4)
+        {
+            // Commit goes out as soon as the last phase is acknowledged
+            EXPECT_EQ(entry.command, COMMAND_GET_LAST_ERROR);
+            EXPECT_LT(entry.timeUs - mWriteLog[i - 1].timeUs, 2000);
+        }
+        else
+        {
+            EXPECT_EQ(entry.command, COMMAND_BLOCK_WRITE);
+            if (i > 0)
+            {
+                // Write phases, including the first phase of the next block, are kept apart
+                uint64_t lastPhaseTimeUs = mWriteLog[i - (((i % 5) == 0) ? 2 : 1)].timeUs;
+                EXPECT_GE(entry.timeUs - lastPhaseTimeUs, minGapUs);
+            }
+        }
+    }
+    for (uint32_t blockNum = 0; blockNum < NUM_WRITTEN_BLOCKS; ++blockNum)
+    {
+        EXPECT_TRUE(vmuBlockMatches(blockNum, 0x3C3C3C3C));
+    }
+}
+
+TEST_F(DreamcastStorageTest, rejectedWritePhaseAbortsChainThenRetries)
+{
+    // --- SETUP ---
+    runUntil(100000);
+    ASSERT_NE(mStorage, nullptr);
+    DreamcastStorage* storage = static_cast<DreamcastStorage*>(mStorage);
+    uint32_t buffer[BLOCK_WORDS];
+    fillBlock(buffer, 9, 0x0F0F0F0F);
+    mNumPhasesToReject = 1;
+
+    // --- TEST EXECUTION ---
+    stepUntilDone([&](){return storage->tryWrite(9, buffer, sizeof(buffer), READ_TIMEOUT_US);});
+    int32_t flushResult = stepUntilDone([&](){return storage->tryFlush();});
+
+    // --- EXPECTATIONS ---
+    // Phases 2, 3, and the commit of the first attempt never went out
+    EXPECT_EQ(flushResult, 1);
+    ASSERT_EQ(mWriteLog.size(), 7);
+    EXPECT_EQ(mWriteLog[1].phase, 1);
+    EXPECT_EQ(mWriteLog[2].command, COMMAND_BLOCK_WRITE);
+    EXPECT_EQ(mWriteLog[2].phase, 0);
+    EXPECT_EQ(mWriteLog[6].command, COMMAND_GET_LAST_ERROR);
+    EXPECT_EQ(mNumCommits, 1);
+    EXPECT_TRUE(vmuBlockMatches(9, 0x0F0F0F0F));
+}
+
+TEST_F(DreamcastStorageTest, writeBackWaitsForRoomInFullSchedule)
+{
+    // --- SETUP ---
+    runUntil(100000);
+    ASSERT_NE(mStorage, nullptr);
+    DreamcastStorage* storage = static_cast<DreamcastStorage*>(mStorage);
+    uint32_t buffer[BLOCK_WORDS];
+    // Block is read into the cache while there is still room
+    ASSERT_GT(stepUntilDone(
+        [&](){return storage->tryRead(9, buffer, sizeof(buffer), READ_TIMEOUT_US);}), 0);
+    // Read ahead finishes so that nothing else frees up a node
+    runUntil(mCurrentTimeUs + 50000);
+    fillBlock(buffer, 9, 0x3C3C3C3C);
+    ASSERT_GT(fillSchedule(), 0);
+
+    // --- TEST EXECUTION ---
+    int32_t numWritten = stepUntilDone(
+        [&](){return storage->tryWrite(9, buffer, sizeof(buffer), READ_TIMEOUT_US);});
+    runUntil(mCurrentTimeUs + 50000);
+    uint32_t numBlockWritesWhileFull = mNumBlockWrites;
+    mScheduler->cancelByRecipient(FILL_ADDR);
+    int32_t flushResult = stepUntilDone([&](){return storage->tryFlush();});
+
+    // --- EXPECTATIONS ---
+    // Nothing could be queued while full, then the write went out once there was room
+    EXPECT_EQ(numWritten, sizeof(buffer));
+    EXPECT_EQ(numBlockWritesWhileFull, 0);
+    EXPECT_EQ(flushResult, 1);
+    EXPECT_EQ(mNumCommits, 1);
+    EXPECT_TRUE(vmuBlockMatches(9, 0x3C3C3C3C));
+}
@@ -0,0 +1,406 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "MockMutex.hpp"
+#include "MockClock.hpp"
+#include "MockUsbFileSystem.hpp"
+#include "MockDreamcastControllerObserver.hpp"
+
+#include "FlycastCommandParser.hpp"
+#include "ControllerLatencyStats.hpp"
+#include "ControllerPollSettings.hpp"
+#include "BusStats.hpp"
+#include "ScreenData.hpp"
+#include "PrioritizedTxScheduler.hpp"
+#include "hal/Usb/CdcFrame.hpp"
+#include "dreamcast_constants.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <string.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using ::testing::NiceMock;
+
+class FlycastTestIdentification : public SystemIdentification
+{
+    public:
+        std::uint32_t getSerialSize() override { return 4; }
+        void getSerial(char* buffer, std::uint32_t bufflen) override { strncpy(buffer, "1234", bufflen); }
+};
+
+class FlycastCommandParserTest : public ::testing::Test
+{
+    public:
+        FlycastCommandParserTest() :
+            mScheduler(std::make_shared<PrioritizedTxScheduler>(mMutex, SENDER_ADDRESS)),
+            mParser(mIdentification, &mScheduler, &SENDER_ADDRESS, 1, {}, {})
+        {}
+
+    protected:
+        //! @returns the next transmission added to the scheduler by the parser
+        std::shared_ptr<Transmission> popTransmission()
+        {
+            PrioritizedTxScheduler::ScheduleItem item = mScheduler->peekNext(0);
+            return mScheduler->popItem(item);
+        }
+
+        //! @returns a packet with incrementing payload words
+        static MaplePacket makePacket(uint8_t command, uint8_t numWords)
+        {
+            MaplePacket packet({.command=command, .recipientAddr=0x01, .senderAddr=SENDER_ADDRESS});
+            for (uint32_t i = 0; i < numWords; ++i)
+            {
+                packet.appendPayload(0x01020304 * (i + 1));
+            }
+            return packet;
+        }
+
+        //! @returns packet as raw words, frame word first
+        static std::vector<uint32_t> toWords(const MaplePacket& packet)
+        {
+            std::vector<uint32_t> words;
+            words.push_back(packet.frame.toWord());
+            words.insert(words.end(), packet.payload.begin(), packet.payload.end());
+            return words;
+        }
+
+        //! @returns packet encoded as a binary X frame
+        static std::vector<uint8_t> encodePacket(const MaplePacket& packet)
+        {
+            std::vector<uint32_t> words = toWords(packet);
+            std::vector<uint8_t> frame(CdcFrame::OVERHEAD_SIZE + words.size() * sizeof(uint32_t));
+            uint32_t len = CdcFrame::encode(
+                &frame[0], frame.size(), 'X', &words[0], words.size() * sizeof(uint32_t));
+            EXPECT_EQ(len, frame.size());
+            return frame;
+        }
+
+        static const uint8_t SENDER_ADDRESS;
+
+        NiceMock<MockMutex> mMutex;
+        FlycastTestIdentification mIdentification;
+        std::shared_ptr<PrioritizedTxScheduler> mScheduler;
+        FlycastCommandParser mParser;
+};
+
+const uint8_t FlycastCommandParserTest::SENDER_ADDRESS = 0x00;
+
+TEST_F(FlycastCommandParserTest, binaryLoopback)
+{
+    // --- SETUP ---
+    // A 48 word LCD write goes out and a 130 word block read response comes back
+    MaplePacket request = makePacket(COMMAND_BLOCK_WRITE, 50);
+    MaplePacket response = makePacket(COMMAND_RESPONSE_DATA_XFER, 130);
+    std::vector<uint8_t> requestFrame = encodePacket(request);
+
+    // --- TEST EXECUTION ---
+    // Decode as the TTY parser would, then pass data along to the flycast parser
+    uint32_t frameLen = 0;
+    char cmd = '\0';
+    uint32_t dataOffset = 0;
+    uint32_t dataLen = 0;
+    CdcFrame::DecodeResult result = CdcFrame::decode(
+        &requestFrame[0], requestFrame.size(), frameLen, cmd, dataOffset, dataLen);
+    ASSERT_EQ(result, CdcFrame::DECODE_OK);
+    bool handled = mParser.submitBinary(&requestFrame[dataOffset], dataLen);
+    std::shared_ptr<Transmission> tx = popTransmission();
+    ASSERT_NE(tx, nullptr);
+    ASSERT_NE(tx->transmitter, nullptr);
+
+    MaplePacketView responseView(response);
+    ::testing::internal::CaptureStdout();
+    tx->transmitter->txComplete(&responseView, tx);
+    std::string output = ::testing::internal::GetCapturedStdout();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(frameLen, requestFrame.size());
+    EXPECT_EQ(cmd, 'X');
+    EXPECT_TRUE(handled);
+    EXPECT_EQ(toWords(*tx->packet), toWords(request));
+
+    const uint8_t* outputBytes = reinterpret_cast<const uint8_t*>(output.data());
+    result = CdcFrame::decode(outputBytes, output.size(), frameLen, cmd, dataOffset, dataLen);
+    ASSERT_EQ(result, CdcFrame::DECODE_OK);
+    EXPECT_EQ(frameLen, output.size());
+    EXPECT_EQ(cmd, 'X');
+    std::vector<uint32_t> responseWords(dataLen / sizeof(uint32_t));
+    memcpy(&responseWords[0], &outputBytes[dataOffset], dataLen);
+    EXPECT_EQ(responseWords, toWords(response));
+}
+
+TEST_F(FlycastCommandParserTest, binaryFailureRespondsWithTextFrame)
+{
+    // --- SETUP ---
+    MaplePacket request = makePacket(COMMAND_BLOCK_READ, 2);
+    std::vector<uint32_t> words = toWords(request);
+
+    // --- TEST EXECUTION ---
+    bool handled = mParser.submitBinary(
+        reinterpret_cast<const uint8_t*>(&words[0]), words.size() * sizeof(uint32_t));
+    std::shared_ptr<Transmission> tx = popTransmission();
+    ASSERT_NE(tx, nullptr);
+
+    ::testing::internal::CaptureStdout();
+    tx->transmitter->txFailed(false, true, tx);
+    std::string output = ::testing::internal::GetCapturedStdout();
+
+    // --- EXPECTATIONS ---
+    EXPECT_TRUE(handled);
+    uint32_t frameLen = 0;
+    char cmd = '\0';
+    uint32_t dataOffset = 0;
+    uint32_t dataLen = 0;
+    CdcFrame::DecodeResult result = CdcFrame::decode(
+        reinterpret_cast<const uint8_t*>(output.data()), output.size(), frameLen, cmd, dataOffset, dataLen);
+    ASSERT_EQ(result, CdcFrame::DECODE_OK);
+    EXPECT_EQ(static_cast<uint8_t>(cmd), 'X' | CdcFrame::TEXT_FLAG);
+    EXPECT_EQ(output.substr(dataOffset, dataLen), "*failed read");
+}
+
+TEST_F(FlycastCommandParserTest, binaryPartialWordFails)
+{
+    // --- SETUP ---
+    const uint8_t data[] = {0x02, 0x00, 0x01, 0x0B, 0x02, 0x00};
+
+    // --- TEST EXECUTION ---
+    ::testing::internal::CaptureStdout();
+    bool handled = mParser.submitBinary(data, sizeof(data));
+    std::string output = ::testing::internal::GetCapturedStdout();
+
+    // --- EXPECTATIONS ---
+    EXPECT_TRUE(handled);
+    EXPECT_EQ(popTransmission(), nullptr);
+    uint32_t frameLen = 0;
+    char cmd = '\0';
+    uint32_t dataOffset = 0;
+    uint32_t dataLen = 0;
+    CdcFrame::DecodeResult result = CdcFrame::decode(
+        reinterpret_cast<const uint8_t*>(output.data()), output.size(), frameLen, cmd, dataOffset, dataLen);
+    ASSERT_EQ(result, CdcFrame::DECODE_OK);
+    EXPECT_EQ(static_cast<uint8_t>(cmd), 'X' | CdcFrame::TEXT_FLAG);
+    EXPECT_EQ(output.substr(dataOffset, dataLen), "*failed missing data");
+}
+
+TEST_F(FlycastCommandParserTest, textLoopback)
+{
+    // --- SETUP ---
+    MaplePacket response = makePacket(COMMAND_RESPONSE_DATA_XFER, 2);
+    const char* command = "X 0C010002 00000002 00000000\n";
+
+    // --- TEST EXECUTION ---
+    mParser.submit(command, strlen(command) - 1);
+    std::shared_ptr<Transmission> tx = popTransmission();
+    ASSERT_NE(tx, nullptr);
+
+    MaplePacketView responseView(response);
+    ::testing::internal::CaptureStdout();
+    tx->transmitter->txComplete(&responseView, tx);
+    std::string output = ::testing::internal::GetCapturedStdout();
+
+    // --- EXPECTATIONS ---
+    std::vector<uint32_t> expectedWords = {0x0C010002, 0x00000002, 0x00000000};
+    EXPECT_EQ(toWords(*tx->packet), expectedWords);
+    EXPECT_EQ(output, "08 01 00 02 01020304 02040608\n");
+}
+
+TEST_F(FlycastCommandParserTest, supersededCommandsCoalesced)
+{
+    // --- SETUP ---
+    MaplePacket response = makePacket(COMMAND_RESPONSE_ACK, 0);
+    const char* commands[] = {
+        "X 0E010002 00000100 10000000\n", // vibration
+        "X 0C010002 00000002 00000000\n", // storage write
+        "X 0E010002 00000100 10E00000\n", // vibration, superseding the first
+        "X 0C010002 00000002 00000001\n", // storage write of another block
+        "X 0E010002 00000100 00000000\n"  // vibration stop, superseding the others
+    };
+
+    // --- TEST EXECUTION ---
+    for (const char* command : commands)
+    {
+        mParser.submit(command, strlen(command) - 1);
+    }
+    std::vector<std::shared_ptr<Transmission>> txs;
+    std::shared_ptr<Transmission> tx;
+    while ((tx = popTransmission()) != nullptr)
+    {
+        txs.push_back(tx);
+    }
+
+    MaplePacketView responseView(response);
+    ::testing::internal::CaptureStdout();
+    txs[0]->transmitter->txComplete(&responseView, txs[0]);
+    std::string output = ::testing::internal::GetCapturedStdout();
+
+    // --- EXPECTATIONS ---
+    // Vibration keeps the place of the first one but only the latest condition goes out
+    ASSERT_EQ(txs.size(), 3);
+    std::vector<uint32_t> expectedWords = {0x0E010002, 0x00000100, 0x00000000};
+    EXPECT_EQ(toWords(*txs[0]->packet), expectedWords);
+    EXPECT_EQ(txs[0]->numCoalesced, 2);
+    EXPECT_EQ(txs[1]->packet->frame.command, COMMAND_BLOCK_WRITE);
+    EXPECT_EQ(txs[2]->packet->frame.command, COMMAND_BLOCK_WRITE);
+    EXPECT_EQ(mScheduler->getNumCoalesced(), 2);
+    // Still one response for each command sent
+    EXPECT_EQ(output, "07 01 00 00\n07 01 00 00\n07 01 00 00\n");
+}
+
+TEST_F(FlycastCommandParserTest, latencyHistogramsDumpAndClear)
+{
+    // --- SETUP ---
+    NiceMock<MockDreamcastControllerObserver> observer;
+    NiceMock<MockClock> clock;
+    NiceMock<MockUsbFileSystem> usbFileSystem;
+    ScreenData screenData;
+    ControllerLatencyStats stats;
+    std::vector<std::shared_ptr<PlayerData>> playerData = {
+        std::make_shared<PlayerData>(0, observer, screenData, clock, usbFileSystem, &stats)
+    };
+    FlycastCommandParser parser(mIdentification, &mScheduler, &SENDER_ADDRESS, 1, playerData, {});
+    stats.writeStarted(16000, 16000, 16020);
+    stats.readComplete(16334);
+    stats.hidSent(16339);
+    const char dumpCommand[] = "XL";
+    const char clearCommand[] = "XL-";
+
+    // --- TEST EXECUTION ---
+    ::testing::internal::CaptureStdout();
+    parser.submit(dumpCommand, strlen(dumpCommand));
+    std::string dump = ::testing::internal::GetCapturedStdout();
+    ::testing::internal::CaptureStdout();
+    parser.submit(clearCommand, strlen(clearCommand));
+    std::string cleared = ::testing::internal::GetCapturedStdout();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(
+        dump,
+        "0 lag 1 20 20 20 0 0 0 0 0 1 0 0 0 0 0 0 0 0 0 0 0 0\n"
+        "0 bus 1 314 314 314 0 0 0 0 0 0 0 0 0 1 0 0 0 0 0 0 0 0\n"
+        "0 hid 1 5 5 5 0 0 0 1 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n"
+        "0 total 1 339 339 339 0 0 0 0 0 0 0 0 0 1 0 0 0 0 0 0 0 0\n"
+        "0 jitter 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n");
+    EXPECT_EQ(cleared, "1\n");
+    EXPECT_EQ(stats.total.getCount(), 0);
+}
+
+TEST_F(FlycastCommandParserTest, busStatsDumpAndClear)
+{
+    // --- SETUP ---
+    NiceMock<MockDreamcastControllerObserver> observer;
+    NiceMock<MockClock> clock;
+    NiceMock<MockUsbFileSystem> usbFileSystem;
+    ScreenData screenData;
+    BusStats stats;
+    std::vector<std::shared_ptr<PlayerData>> playerData = {
+        std::make_shared<PlayerData>(0, observer, screenData, clock, usbFileSystem, nullptr, nullptr, &stats)
+    };
+    FlycastCommandParser parser(mIdentification, &mScheduler, &SENDER_ADDRESS, 1, playerData, {});
+    MaplePacket packet = makePacket(COMMAND_GET_CONDITION, 1);
+    mScheduler->add(1, PrioritizedTxScheduler::TX_TIME_ASAP, nullptr, packet, true);
+    stats.writeStarted(16000, 16000, 16020);
+    stats.transferEnded(MapleBusInterface::Phase::READ_COMPLETE, MapleBusInterface::FailureReason::NONE, 16334);
+    stats.writeStarted(17000, 17000, 17000);
+    stats.transferEnded(MapleBusInterface::Phase::READ_FAILED, MapleBusInterface::FailureReason::TIMEOUT, 18000);
+    const char dumpCommand[] = "XU";
+    const char clearCommand[] = "XU-";
+
+    // --- TEST EXECUTION ---
+    ::testing::internal::CaptureStdout();
+    parser.submit(dumpCommand, strlen(dumpCommand));
+    std::string dump = ::testing::internal::GetCapturedStdout();
+    popTransmission();
+    ::testing::internal::CaptureStdout();
+    parser.submit(clearCommand, strlen(clearCommand));
+    std::string cleared = ::testing::internal::GetCapturedStdout();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(
+        dump,
+        "0 busy 1314 idle 666 late 2 0 10 20 1 0 0 0 0 1 0 0 0 0 0 0 0 0 0 0 0 0"
+        " miss 1 depth 0 1 0 wfail 0 0 0 0 0 rfail 0 0 0 0 1\n");
+    EXPECT_EQ(cleared, "1\n");
+    EXPECT_EQ(stats.getBusyUs(), 0);
+    EXPECT_EQ(mScheduler->getQueueDepthHighWaterMark(1), 0);
+}
+
+TEST_F(FlycastCommandParserTest, pollTimingSetAndPrint)
+{
+    // --- SETUP ---
+    NiceMock<MockDreamcastControllerObserver> observer;
+    NiceMock<MockClock> clock;
+    NiceMock<MockUsbFileSystem> usbFileSystem;
+    ScreenData screenData;
+    ControllerPollSettings settings;
+    std::vector<std::shared_ptr<PlayerData>> playerData = {
+        std::make_shared<PlayerData>(0, observer, screenData, clock, usbFileSystem, nullptr, &settings)
+    };
+    FlycastCommandParser parser(mIdentification, &mScheduler, &SENDER_ADDRESS, 1, playerData, {});
+    const char setCommand[] = "XT 0 2000 1";
+    const char clampCommand[] = "XT 0 10";
+    const char badPlayerCommand[] = "XT 1 2000";
+    const char printCommand[] = "XT";
+
+    // --- TEST EXECUTION ---
+    ::testing::internal::CaptureStdout();
+    parser.submit(setCommand, strlen(setCommand));
+    parser.submit(printCommand, strlen(printCommand));
+    parser.submit(clampCommand, strlen(clampCommand));
+    parser.submit(printCommand, strlen(printCommand));
+    parser.submit(badPlayerCommand, strlen(badPlayerCommand));
+    std::string output = ::testing::internal::GetCapturedStdout();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(output, "1\n0 2000 1\n1\n0 1000 0\n0\n");
+}
+
+TEST(CdcFrameTest, decodeIncompleteAndCorrupt)
+{
+    // --- SETUP ---
+    const uint32_t word = 0x12345678;
+    uint8_t frame[CdcFrame::OVERHEAD_SIZE + sizeof(word)];
+    uint32_t len = CdcFrame::encode(frame, sizeof(frame), 'X', &word, sizeof(word));
+    uint32_t frameLen = 0;
+    char cmd = '\0';
+    uint32_t dataOffset = 0;
+    uint32_t dataLen = 0;
+
+    // --- TEST EXECUTION ---
+    CdcFrame::DecodeResult partialResult =
+        CdcFrame::decode(frame, sizeof(frame) - 1, frameLen, cmd, dataOffset, dataLen);
+    frame[5] ^= 0x01;
+    CdcFrame::DecodeResult corruptResult =
+        CdcFrame::decode(frame, sizeof(frame), frameLen, cmd, dataOffset, dataLen);
+    CdcFrame::DecodeResult unsyncedResult =
+        CdcFrame::decode(&frame[1], sizeof(frame) - 1, frameLen, cmd, dataOffset, dataLen);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(len, sizeof(frame));
+    EXPECT_EQ(partialResult, CdcFrame::DECODE_INCOMPLETE);
+    EXPECT_EQ(corruptResult, CdcFrame::DECODE_INVALID);
+    EXPECT_EQ(unsyncedResult, CdcFrame::DECODE_INVALID);
+}
@@ -0,0 +1,103 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "LatencyHistogram.hpp"
+#include "ControllerLatencyStats.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(LatencyHistogramTest, bucketsArePowersOfTwo)
+{
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(0), 0);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(1), 1);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(2), 2);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(3), 2);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(4), 3);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(313), 9);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(16000), 14);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(65535), 16);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(65536), 17);
+    EXPECT_EQ(LatencyHistogram::getBucketIndex(UINT32_MAX), 17);
+}
+
+TEST(LatencyHistogramTest, tracksMinMaxAndAverage)
+{
+    // --- SETUP ---
+    LatencyHistogram histogram;
+
+    // --- TEST EXECUTION ---
+    histogram.add(100);
+    histogram.add(300);
+    histogram.add(320);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(histogram.getCount(), 3);
+    EXPECT_EQ(histogram.getMin(), 100);
+    EXPECT_EQ(histogram.getMax(), 320);
+    EXPECT_EQ(histogram.getAverage(), 240);
+    EXPECT_EQ(histogram.getBucket(7), 1);
+    EXPECT_EQ(histogram.getBucket(9), 2);
+
+    // --- TEST EXECUTION ---
+    histogram.reset();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(histogram.getCount(), 0);
+    EXPECT_EQ(histogram.getMin(), 0);
+    EXPECT_EQ(histogram.getMax(), 0);
+    EXPECT_EQ(histogram.getAverage(), 0);
+    EXPECT_EQ(histogram.getBucket(9), 0);
+}
+
+TEST(ControllerLatencyStatsTest, timestampsEachStage)
+{
+    // --- SETUP ---
+    ControllerLatencyStats stats;
+
+    // --- TEST EXECUTION ---
+    // First poll scheduled at 16000, written 20 us late, read 314 us later, sent 5 us after that
+    stats.writeStarted(16000, 16000, 16020);
+    stats.readComplete(16334);
+    stats.hidSent(16339);
+    // Second poll written 8 us late, but it fails
+    stats.writeStarted(32000, 16000, 32008);
+    stats.failed();
+    stats.readComplete(33000);
+    stats.hidSent(33000);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(stats.lag.getCount(), 2);
+    EXPECT_EQ(stats.lag.getMax(), 20);
+    EXPECT_EQ(stats.lag.getMin(), 8);
+    EXPECT_EQ(stats.bus.getCount(), 1);
+    EXPECT_EQ(stats.bus.getMax(), 314);
+    EXPECT_EQ(stats.hid.getCount(), 1);
+    EXPECT_EQ(stats.hid.getMax(), 5);
+    EXPECT_EQ(stats.total.getCount(), 1);
+    EXPECT_EQ(stats.total.getMax(), 339);
+    // 15988 us between the two writes is 12 us off of the period
+    EXPECT_EQ(stats.jitter.getCount(), 1);
+    EXPECT_EQ(stats.jitter.getMax(), 12);
+}
@@ -0,0 +1,596 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "LogStructuredSystemMemory.hpp"
+#include "NonVolatilePicoSystemMemory.hpp"
+
+#include "clientLib/DreamcastStorage.hpp"
+
+#include "FakeFlash.hpp"
+#include "MockClock.hpp"
+#include "NullMutex.hpp"
+
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+class LogStructuredSystemMemoryTest : public ::testing::Test
+{
+    public:
+        LogStructuredSystemMemoryTest() :
+            mTimeUs(1000),
+            mFlash(FLASH_SIZE),
+            mMemory(nullptr),
+            mNumBlockWrites(0)
+        {}
+
+    protected:
+        virtual void SetUp()
+        {
+            ON_CALL(mClock, getTimeUs()).WillByDefault(Invoke([this](){return mTimeUs;}));
+        }
+
+        //! Creates memory over what is currently in flash
+        void createMemory(uint32_t regionSize = REGION_SIZE,
+                          const uint8_t* initialImage = nullptr,
+                          uint32_t pinnedSize = 0)
+        {
+            uint32_t offset = REGION_OFFSET;
+            uint32_t size = MEMORY_SIZE;
+            mMemory = std::make_shared<LogStructuredSystemMemory>(
+                mFlash, mMutex, mClock, offset, regionSize, size, initialImage, pinnedSize);
+        }
+
+        //! Writes a full VMU block, the same way client storage does
+        void writeBlock(SystemMemory& memory, uint16_t blockNum, const uint8_t* data)
+        {
+            uint32_t size = BLOCK_SIZE;
+            EXPECT_TRUE(memory.write(blockNum * BLOCK_SIZE, data, size));
+            ++mNumBlockWrites;
+        }
+
+        //! Copies a VMU block out of memory
+        static void readBlock(SystemMemory& memory, uint16_t blockNum, uint8_t* data)
+        {
+            uint32_t size = BLOCK_SIZE;
+            memcpy(data, memory.read(blockNum * BLOCK_SIZE, size), BLOCK_SIZE);
+        }
+
+        //! Copies all of memory out
+        static std::vector<uint8_t> readAll(SystemMemory& memory)
+        {
+            std::vector<uint8_t> data(MEMORY_SIZE);
+            for (uint32_t offset = 0; offset < MEMORY_SIZE; offset += BLOCK_SIZE)
+            {
+                uint32_t size = BLOCK_SIZE;
+                const uint8_t* mem = memory.read(offset, size);
+                EXPECT_EQ(size, 512u);
+                memcpy(&data[offset], mem, size);
+            }
+            return data;
+        }
+
+        //! Processes until everything is committed
+        template <typename T>
+        void commitAll(T& memory)
+        {
+            mTimeUs += 1000000;
+            for (uint32_t i = 0; i < 10000 && memory.isCommitPending(); ++i)
+            {
+                memory.process();
+            }
+            EXPECT_FALSE(memory.isCommitPending());
+        }
+
+        //! Fills a buffer with a pattern
+        static void fill(uint8_t* data, uint32_t size, uint32_t seed)
+        {
+            for (uint32_t i = 0; i < size; ++i)
+            {
+                seed = seed * 1664525 + 1013904223;
+                data[i] = static_cast<uint8_t>(seed >> 24);
+            }
+        }
+
+        //! Simulates a game saving a file of the given number of blocks the way the Dreamcast does:
+        //! data blocks from the given block down, then the FAT, then the directory
+        void saveFile(SystemMemory& memory,
+                      uint16_t firstBlock,
+                      uint16_t numBlocks,
+                      uint32_t seed,
+                      uint16_t dirEntry = 0)
+        {
+            uint8_t block[BLOCK_SIZE];
+            uint8_t fat[BLOCK_SIZE];
+            readBlock(memory, FAT_BLOCK_NO, fat);
+            uint16_t* fatEntries = reinterpret_cast<uint16_t*>(fat);
+            for (uint16_t i = 0; i < numBlocks; ++i)
+            {
+                uint16_t blockNum = firstBlock - i;
+                fill(block, sizeof(block), seed + i);
+                writeBlock(memory, blockNum, block);
+                fatEntries[blockNum] = (i + 1 < numBlocks) ? (blockNum - 1) : 0xFFFA;
+            }
+            writeBlock(memory, FAT_BLOCK_NO, fat);
+
+            uint8_t dir[BLOCK_SIZE];
+            readBlock(memory, FILE_INFO_BLOCK_NO, dir);
+            // 32 byte directory entry with file type, name, timestamp, and size
+            uint8_t* entry = &dir[dirEntry * 32];
+            fill(entry, 32, seed);
+            entry[0] = 0x33;
+            entry[24] = static_cast<uint8_t>(numBlocks);
+            writeBlock(memory, FILE_INFO_BLOCK_NO, dir);
+        }
+
+        //! Formats memory then fills most of it with saves which never change again
+        template <typename T>
+        void formatAndFill(std::shared_ptr<T> memory)
+        {
+            std::shared_ptr<client::DreamcastStorage> storage =
+                std::make_shared<client::DreamcastStorage>(memory, 0);
+            ASSERT_TRUE(storage->format());
+            commitAll(*memory);
+            for (uint16_t i = 0; i < NUM_COLD_FILES; ++i)
+            {
+                saveFile(*memory, FIRST_SAVE_BLOCK_NO - (i * COLD_FILE_BLOCKS), COLD_FILE_BLOCKS, 1000 + i, i + 1);
+                commitAll(*memory);
+            }
+        }
+
+        static const uint32_t FLASH_SIZE = 512 * 1024;
+        static const uint32_t REGION_OFFSET = 64 * 1024;
+        static const uint32_t REGION_SIZE = 256 * 1024;
+        //! Smallest region allowed for 256 blocks
+        static const uint32_t MIN_REGION_SIZE = 39 * 4096;
+        static const uint32_t LEGACY_OFFSET = 384 * 1024;
+        static const uint32_t MEMORY_SIZE = client::DreamcastStorage::MEMORY_SIZE_BYTES;
+        static const uint32_t BLOCK_SIZE = 512;
+        static const uint16_t FAT_BLOCK_NO = client::DreamcastStorage::FAT_BLOCK_NO;
+        static const uint16_t FILE_INFO_BLOCK_NO = client::DreamcastStorage::FILE_INFO_BLOCK_NO;
+        static const uint16_t SYSTEM_BLOCK_NO = client::DreamcastStorage::SYSTEM_BLOCK_NO;
+        static const uint32_t SYSTEM_AREA_SIZE = client::DreamcastStorage::SYSTEM_AREA_SIZE_BYTES;
+        static const uint16_t FIRST_SAVE_BLOCK_NO = 199;
+        static const uint16_t NUM_COLD_FILES = 12;
+        //! Along with FAT and directory, each save fits in the cache
+        static const uint16_t COLD_FILE_BLOCKS = 14;
+
+        uint64_t mTimeUs;
+        NiceMock<MockClock> mClock;
+        NullMutex mMutex;
+        FakeFlash mFlash;
+        std::shared_ptr<LogStructuredSystemMemory> mMemory;
+        uint32_t mNumBlockWrites;
+};
+
+TEST_F(LogStructuredSystemMemoryTest, blocksSurviveRemount)
+{
+    // --- SETUP ---
+    createMemory();
+    uint8_t block[BLOCK_SIZE];
+
+    // --- TEST EXECUTION ---
+    for (uint16_t i = 0; i < 14; ++i)
+    {
+        fill(block, sizeof(block), i);
+        writeBlock(*mMemory, i * 13 % 256, block);
+    }
+    // Rewrite a couple of them so that there is more than one copy in flash
+    fill(block, sizeof(block), 50);
+    writeBlock(*mMemory, 0, block);
+    writeBlock(*mMemory, 13, block);
+    commitAll(*mMemory);
+    std::vector<uint8_t> before = readAll(*mMemory);
+    createMemory();
+    std::vector<uint8_t> after = readAll(*mMemory);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(before, after);
+    EXPECT_EQ(mFlash.mNumErases, 0u);
+    EXPECT_EQ(mFlash.mNumBadPrograms, 0u);
+    // 2 data pages + 1 slot header for each of the 14 blocks, plus the header of each sector opened
+    EXPECT_EQ(mFlash.mNumPagePrograms, 14u * 3 + 2);
+    // Nothing is left to do after remount
+    EXPECT_FALSE(mMemory->isCommitPending());
+}
+
+TEST_F(LogStructuredSystemMemoryTest, unchangedWriteSkipsFlash)
+{
+    // --- SETUP ---
+    createMemory();
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 1);
+    writeBlock(*mMemory, 10, block);
+    commitAll(*mMemory);
+    mFlash.resetCounts();
+    memset(block, 0xFF, sizeof(block));
+
+    // --- TEST EXECUTION ---
+    uint8_t changed[BLOCK_SIZE];
+    readBlock(*mMemory, 10, changed);
+    changed[7] ^= 0x01;
+    writeBlock(*mMemory, 10, changed);
+    changed[7] ^= 0x01;
+    writeBlock(*mMemory, 10, changed);
+    // Never written and still erased
+    writeBlock(*mMemory, 11, block);
+    commitAll(*mMemory);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(mFlash.mNumErases, 0u);
+    EXPECT_EQ(mFlash.mNumPagePrograms, 0u);
+}
+
+TEST_F(LogStructuredSystemMemoryTest, importsLegacyImage)
+{
+    // --- SETUP ---
+    std::vector<uint8_t> image(MEMORY_SIZE, 0xFF);
+    for (uint16_t i = 200; i < 256; ++i)
+    {
+        fill(&image[i * BLOCK_SIZE], BLOCK_SIZE, i);
+    }
+    mFlash.preload(LEGACY_OFFSET, image.data(), MEMORY_SIZE);
+
+    // --- TEST EXECUTION ---
+    createMemory(REGION_SIZE, mFlash.read(LEGACY_OFFSET));
+    std::vector<uint8_t> imported = readAll(*mMemory);
+    commitAll(*mMemory);
+    uint32_t importPrograms = mFlash.mNumPagePrograms;
+    // Once the log exists, the legacy image is no longer looked at
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 5);
+    writeBlock(*mMemory, 200, block);
+    memcpy(&image[200 * BLOCK_SIZE], block, BLOCK_SIZE);
+    commitAll(*mMemory);
+    createMemory(REGION_SIZE, mFlash.read(LEGACY_OFFSET));
+    std::vector<uint8_t> remounted = readAll(*mMemory);
+
+    // --- EXPECTATIONS ---
+    // Only blocks which aren't blank are logged
+    EXPECT_EQ(importPrograms, 56u * 3 + 8);
+    EXPECT_EQ(remounted, image);
+    EXPECT_FALSE(mMemory->isCommitPending());
+    EXPECT_EQ(imported.size(), image.size());
+}
+
+TEST_F(LogStructuredSystemMemoryTest, wearIsSpreadAcrossSectors)
+{
+    // --- SETUP ---
+    // The same saves are done with memory mapped 1:1 onto its own flash for comparison
+    createMemory();
+    uint32_t legacyOffset = LEGACY_OFFSET;
+    uint32_t memorySize = MEMORY_SIZE;
+    FakeFlash legacyFlash(FLASH_SIZE);
+    std::shared_ptr<NonVolatilePicoSystemMemory> legacyMemory =
+        std::make_shared<NonVolatilePicoSystemMemory>(legacyFlash, mMutex, mClock, legacyOffset, memorySize);
+    formatAndFill(mMemory);
+    formatAndFill(legacyMemory);
+    commitAll(*mMemory);
+    commitAll(*legacyMemory);
+    mFlash.resetCounts();
+    legacyFlash.resetCounts();
+    const uint32_t numSaves = 500;
+
+    // --- TEST EXECUTION ---
+    // A game repeatedly saving over its own 10 block file
+    mNumBlockWrites = 0;
+    for (uint32_t i = 0; i < numSaves; ++i)
+    {
+        saveFile(*mMemory, 9, 10, i);
+        commitAll(*mMemory);
+        saveFile(*legacyMemory, 9, 10, i);
+        commitAll(*legacyMemory);
+    }
+    // Blocks 9-0, FAT, and directory; FAT doesn't change from one save to the next
+    const uint32_t numChangedBlocks = numSaves * 11;
+    const uint32_t firstSector = REGION_OFFSET / FlashInterface::SECTOR_SIZE;
+    const uint32_t numSectors = REGION_SIZE / FlashInterface::SECTOR_SIZE;
+    uint32_t minErases = UINT32_MAX;
+    uint32_t maxErases = 0;
+    for (uint32_t i = firstSector; i < firstSector + numSectors; ++i)
+    {
+        minErases = std::min(minErases, mFlash.mSectorEraseCounts[i]);
+        maxErases = std::max(maxErases, mFlash.mSectorEraseCounts[i]);
+    }
+    uint32_t legacyMaxErases = 0;
+    for (uint32_t count : legacyFlash.mSectorEraseCounts)
+    {
+        legacyMaxErases = std::max(legacyMaxErases, count);
+    }
+    // Each changed block is ideally 2 page programs
+    double writeAmplification =
+        static_cast<double>(mFlash.mNumPagePrograms) / (numChangedBlocks * 2);
+    double legacyWriteAmplification =
+        static_cast<double>(legacyFlash.mNumPagePrograms) / (numChangedBlocks * 2);
+
+    printf("VMU log after %lu saves: sector erases %lu-%lu (1:1 mapping: up to %lu), "
+           "write amplification %.2f (1:1 mapping: %.2f)\n",
+           (unsigned long)numSaves,
+           (unsigned long)minErases,
+           (unsigned long)maxErases,
+           (unsigned long)legacyMaxErases,
+           writeAmplification,
+           legacyWriteAmplification);
+
+    // --- EXPECTATIONS ---
+    // Every sector is erased in turn
+    EXPECT_GT(minErases, 0u);
+    EXPECT_LE(maxErases - minErases, 1u);
+    EXPECT_LT(maxErases * 10, legacyMaxErases);
+    // A slot costs 3 pages for 2 pages of data, and about half of the log holds live blocks which
+    // get moved each time around
+    EXPECT_LT(writeAmplification, 3.0);
+    EXPECT_EQ(mFlash.mNumBadPrograms, 0u);
+    std::vector<uint8_t> before = readAll(*mMemory);
+    EXPECT_EQ(before, readAll(*legacyMemory));
+    createMemory();
+    EXPECT_EQ(readAll(*mMemory), before);
+}
+
+TEST_F(LogStructuredSystemMemoryTest, powerLossKeepsOldOrNewBlocks)
+{
+    // --- SETUP ---
+    // Smallest region with enough saves that the log wraps, so garbage collection and erases are
+    // part of the save
+    createMemory(MIN_REGION_SIZE);
+    formatAndFill(mMemory);
+    commitAll(*mMemory);
+    for (uint32_t i = 0; i < 40; ++i)
+    {
+        saveFile(*mMemory, 9, 10, i);
+        commitAll(*mMemory);
+    }
+    const std::vector<uint8_t> baseline = mFlash.mMemory;
+    const std::vector<uint8_t> oldImage = readAll(*mMemory);
+    mFlash.resetCounts();
+    saveFile(*mMemory, 9, 10, 7777);
+    const std::vector<uint8_t> newImage = readAll(*mMemory);
+    commitAll(*mMemory);
+    const uint32_t numOps = mFlash.mNumErases + mFlash.mNumPagePrograms;
+
+    // --- TEST EXECUTION ---
+    uint32_t numBadBlocks = 0;
+    uint32_t numBadRecoveries = 0;
+    uint32_t numBadPrograms = 0;
+    for (uint32_t cut = 0; cut <= numOps; ++cut)
+    {
+        mFlash.mMemory = baseline;
+        mFlash.resetCounts();
+        createMemory(MIN_REGION_SIZE);
+        saveFile(*mMemory, 9, 10, 7777);
+        mFlash.losePowerAfter(cut);
+        mTimeUs += 1000000;
+        for (uint32_t i = 0; i < 1000 && mMemory->isCommitPending(); ++i)
+        {
+            mMemory->process();
+        }
+        mFlash.restorePower();
+
+        createMemory(MIN_REGION_SIZE);
+        std::vector<uint8_t> recovered = readAll(*mMemory);
+        for (uint16_t block = 0; block < MEMORY_SIZE / BLOCK_SIZE; ++block)
+        {
+            const uint32_t offset = block * BLOCK_SIZE;
+            if (memcmp(&recovered[offset], &oldImage[offset], BLOCK_SIZE) != 0
+                && memcmp(&recovered[offset], &newImage[offset], BLOCK_SIZE) != 0)
+            {
+                ++numBadBlocks;
+            }
+        }
+
+        // The save can be done again after recovery
+        saveFile(*mMemory, 9, 10, 7777);
+        commitAll(*mMemory);
+        createMemory(MIN_REGION_SIZE);
+        if (readAll(*mMemory) != newImage)
+        {
+            ++numBadRecoveries;
+        }
+        numBadPrograms += mFlash.mNumBadPrograms;
+    }
+
+    // --- EXPECTATIONS ---
+    EXPECT_GT(numOps, 33u);
+    EXPECT_EQ(numBadBlocks, 0u);
+    EXPECT_EQ(numBadRecoveries, 0u);
+    EXPECT_EQ(numBadPrograms, 0u);
+}
+
+TEST_F(LogStructuredSystemMemoryTest, readsComeFromFlashUnlessWritten)
+{
+    // --- SETUP ---
+    createMemory();
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 8);
+    writeBlock(*mMemory, 10, block);
+    commitAll(*mMemory);
+
+    // --- TEST EXECUTION ---
+    uint32_t size = BLOCK_SIZE;
+    const uint8_t* before = mMemory->read(10 * BLOCK_SIZE, size);
+    bool beforeInFlash = (before >= mFlash.read(0) && before < mFlash.read(0) + FLASH_SIZE);
+    block[0] ^= 0xFF;
+    writeBlock(*mMemory, 10, block);
+    size = BLOCK_SIZE;
+    const uint8_t* pending = mMemory->read(10 * BLOCK_SIZE, size);
+    bool pendingInFlash = (pending >= mFlash.read(0) && pending < mFlash.read(0) + FLASH_SIZE);
+    bool pendingMatches = (memcmp(pending, block, BLOCK_SIZE) == 0);
+    commitAll(*mMemory);
+    size = BLOCK_SIZE;
+    const uint8_t* after = mMemory->read(10 * BLOCK_SIZE, size);
+    bool afterInFlash = (after >= mFlash.read(0) && after < mFlash.read(0) + FLASH_SIZE);
+    // Reads stop at the end of a block
+    size = BLOCK_SIZE;
+    mMemory->read(BLOCK_SIZE - 4, size);
+
+    // --- EXPECTATIONS ---
+    EXPECT_TRUE(beforeInFlash);
+    EXPECT_FALSE(pendingInFlash);
+    EXPECT_TRUE(pendingMatches);
+    EXPECT_TRUE(afterInFlash);
+    EXPECT_EQ(memcmp(after, block, BLOCK_SIZE), 0);
+    EXPECT_EQ(size, 4u);
+}
+
+TEST_F(LogStructuredSystemMemoryTest, flashNotReadWhileBusy)
+{
+    // --- SETUP ---
+    createMemory();
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 9);
+    writeBlock(*mMemory, 100, block);
+    commitAll(*mMemory);
+    writeBlock(*mMemory, 8, block);
+
+    // --- MOCKING ---
+    uint32_t cachedReadSize = 0;
+    uint32_t flashReadSize = BLOCK_SIZE;
+    uint32_t erasedReadSize = 0;
+    uint32_t partialWriteSize = 0;
+    bool partialWriteSuccess = true;
+    mFlash.mOnOperation = [&]()
+    {
+        if (cachedReadSize == 0)
+        {
+            cachedReadSize = BLOCK_SIZE;
+            mMemory->read(8 * BLOCK_SIZE, cachedReadSize);
+            flashReadSize = BLOCK_SIZE;
+            mMemory->read(100 * BLOCK_SIZE, flashReadSize);
+            erasedReadSize = BLOCK_SIZE;
+            mMemory->read(101 * BLOCK_SIZE, erasedReadSize);
+            partialWriteSize = 4;
+            partialWriteSuccess = mMemory->write(100 * BLOCK_SIZE, block, partialWriteSize);
+        }
+    };
+
+    // --- TEST EXECUTION ---
+    mMemory->process();
+    mFlash.mOnOperation = nullptr;
+    uint32_t idleReadSize = BLOCK_SIZE;
+    mMemory->read(100 * BLOCK_SIZE, idleReadSize);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(cachedReadSize, 512u);
+    EXPECT_EQ(flashReadSize, 0u);
+    EXPECT_EQ(erasedReadSize, 512u);
+    EXPECT_FALSE(partialWriteSuccess);
+    EXPECT_EQ(partialWriteSize, 0u);
+    EXPECT_EQ(idleReadSize, 512u);
+    EXPECT_FALSE(mMemory->isCommitPending());
+}
+
+TEST_F(LogStructuredSystemMemoryTest, systemAreaReadWhileBusy)
+{
+    // --- SETUP ---
+    createMemory(REGION_SIZE, nullptr, SYSTEM_AREA_SIZE);
+    uint8_t fat[BLOCK_SIZE];
+    fill(fat, sizeof(fat), 11);
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 12);
+    writeBlock(*mMemory, FAT_BLOCK_NO, fat);
+    writeBlock(*mMemory, 100, block);
+    commitAll(*mMemory);
+    // Pinned blocks are loaded back out of the log
+    createMemory(REGION_SIZE, nullptr, SYSTEM_AREA_SIZE);
+    writeBlock(*mMemory, 8, block);
+
+    // --- MOCKING ---
+    uint32_t fatReadSize = 0;
+    bool fatMatches = false;
+    uint32_t mediaInfoReadSize = 0;
+    uint32_t dirReadSize = 0;
+    uint32_t dataReadSize = BLOCK_SIZE;
+    uint32_t fatWriteSize = 0;
+    bool fatWriteSuccess = false;
+    mFlash.mOnOperation = [&]()
+    {
+        if (fatReadSize == 0)
+        {
+            fatReadSize = BLOCK_SIZE;
+            const uint8_t* mem = mMemory->read(FAT_BLOCK_NO * BLOCK_SIZE, fatReadSize);
+            fatMatches = (mem != nullptr && memcmp(mem, fat, BLOCK_SIZE) == 0);
+            mediaInfoReadSize = BLOCK_SIZE;
+            mMemory->read(SYSTEM_BLOCK_NO * BLOCK_SIZE, mediaInfoReadSize);
+            dirReadSize = BLOCK_SIZE;
+            mMemory->read(FILE_INFO_BLOCK_NO * BLOCK_SIZE, dirReadSize);
+            dataReadSize = BLOCK_SIZE;
+            mMemory->read(100 * BLOCK_SIZE, dataReadSize);
+            fat[0] = 0x5A;
+            fatWriteSize = 4;
+            fatWriteSuccess = mMemory->write(FAT_BLOCK_NO * BLOCK_SIZE, fat, fatWriteSize);
+        }
+    };
+
+    // --- TEST EXECUTION ---
+    mMemory->process();
+    mFlash.mOnOperation = nullptr;
+    commitAll(*mMemory);
+    createMemory();
+    uint8_t remountedFat[BLOCK_SIZE];
+    readBlock(*mMemory, FAT_BLOCK_NO, remountedFat);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(fatReadSize, 512u);
+    EXPECT_TRUE(fatMatches);
+    EXPECT_EQ(mediaInfoReadSize, 512u);
+    EXPECT_EQ(dirReadSize, 512u);
+    // Data blocks which were committed to flash still can't be read until flash is free
+    EXPECT_EQ(dataReadSize, 0u);
+    EXPECT_TRUE(fatWriteSuccess);
+    EXPECT_EQ(fatWriteSize, 4u);
+    EXPECT_EQ(memcmp(remountedFat, fat, BLOCK_SIZE), 0);
+}
+
+TEST_F(LogStructuredSystemMemoryTest, writeStopsWhenCacheIsFull)
+{
+    // --- SETUP ---
+    createMemory();
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 10);
+    const uint16_t numCached = LogStructuredSystemMemory::NUM_CACHED_BLOCKS;
+
+    // --- TEST EXECUTION ---
+    for (uint16_t i = 0; i < numCached; ++i)
+    {
+        writeBlock(*mMemory, i, block);
+    }
+    uint32_t size = BLOCK_SIZE;
+    bool fullSuccess = mMemory->write(numCached * BLOCK_SIZE, block, size);
+    uint32_t fullSize = size;
+    commitAll(*mMemory);
+    size = BLOCK_SIZE;
+    bool retrySuccess = mMemory->write(numCached * BLOCK_SIZE, block, size);
+    commitAll(*mMemory);
+
+    // --- EXPECTATIONS ---
+    EXPECT_FALSE(fullSuccess);
+    EXPECT_EQ(fullSize, 0u);
+    EXPECT_TRUE(retrySuccess);
+}
@@ -0,0 +1,246 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "DreamcastMainNode.hpp"
+#include "PrioritizedTxScheduler.hpp"
+#include "PlayerData.hpp"
+#include "ScreenData.hpp"
+#include "dreamcast_constants.h"
+
+#include "hal/MapleBus/MapleBusInterface.hpp"
+#include "hal/System/MutexInterface.hpp"
+#include "hal/System/ClockInterface.hpp"
+#include "hal/Usb/DreamcastControllerObserver.hpp"
+#include "hal/Usb/UsbFileSystem.hpp"
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <stdlib.h>
+
+#include <gtest/gtest.h>
+
+// Every allocation made through global operator new in this executable is counted here
+static std::atomic<uint64_t> gNumAllocations(0);
+
+void* operator new(std::size_t size)
+{
+    ++gNumAllocations;
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    free(p);
+}
+
+// gmock allocates on every mocked call, so these tests use simple hand written fakes instead
+
+class FakeMutex : public MutexInterface
+{
+    public:
+        void lock() override {}
+        void unlock() override {}
+        int8_t tryLock() override {return 1;}
+};
+
+class FakeClock : public ClockInterface
+{
+    public:
+        uint64_t getTimeUs() const override {return 0;}
+};
+
+class FakeUsbFileSystem : public UsbFileSystem
+{
+    public:
+        void add(UsbFile* file) override {}
+        void remove(UsbFile* file) override {}
+};
+
+class FakeControllerObserver : public DreamcastControllerObserver
+{
+    public:
+        FakeControllerObserver() : mConnected(false), mNumConditions(0) {}
+        void setControllerCondition(const ControllerCondition& controllerCondition) override {++mNumConditions;}
+        void setSecondaryControllerCondition(const SecondaryControllerCondition& secondaryControllerCondition) override {}
+        void controllerConnected() override {mConnected = true;}
+        void controllerDisconnected() override {mConnected = false;}
+
+        bool mConnected;
+        uint32_t mNumConditions;
+};
+
+//! Maple bus which instantly responds as a controller with no sub peripherals attached
+class FakeControllerMapleBus : public MapleBusInterface
+{
+    public:
+        FakeControllerMapleBus() : mResponseLen(0) {}
+
+        bool write(const MaplePacket& packet,
+                   bool autostartRead,
+                   uint64_t readTimeoutUs=MAPLE_RESPONSE_TIMEOUT_US) override
+        {
+            // Respond from main peripheral to host on the same port
+            uint8_t recipientAddr = packet.frame.senderAddr;
+            uint8_t senderAddr = packet.frame.recipientAddr;
+            uint32_t* response = mResponse;
+            if (packet.frame.command == COMMAND_DEVICE_INFO_REQUEST)
+            {
+                mResponseLen = EXPECTED_DEVICE_INFO_PAYLOAD_WORDS + 1;
+                memset(mResponse, 0, sizeof(mResponse));
+                *response++ = MaplePacket::Frame{
+                    .command=COMMAND_RESPONSE_DEVICE_INFO,
+                    .recipientAddr=recipientAddr,
+                    .senderAddr=senderAddr,
+                    .length=EXPECTED_DEVICE_INFO_PAYLOAD_WORDS}.toWord();
+                *response++ = DEVICE_FN_CONTROLLER;
+                *response++ = 0x000F06FE;
+            }
+            else if (packet.frame.command == COMMAND_GET_CONDITION)
+            {
+                mResponseLen = 4;
+                *response++ = MaplePacket::Frame{
+                    .command=COMMAND_RESPONSE_DATA_XFER,
+                    .recipientAddr=recipientAddr,
+                    .senderAddr=senderAddr,
+                    .length=3}.toWord();
+                *response++ = DEVICE_FN_CONTROLLER;
+                *response++ = 0xFFFFFFFF;
+                *response++ = 0x80808080;
+            }
+            else
+            {
+                mResponseLen = 0;
+            }
+            return true;
+        }
+
+        bool startRead(uint64_t readTimeoutUs) override
+        {
+            return false;
+        }
+
+        Status processEvents(uint64_t currentTimeUs) override
+        {
+            Status status;
+            if (mResponseLen > 0)
+            {
+                status.phase = Phase::READ_COMPLETE;
+                status.readBuffer = mResponse;
+                status.readBufferLen = mResponseLen;
+                mResponseLen = 0;
+            }
+            else
+            {
+                status.phase = Phase::IDLE;
+            }
+            return status;
+        }
+
+        bool isBusy() override
+        {
+            return (mResponseLen > 0);
+        }
+
+    private:
+        uint32_t mResponse[EXPECTED_DEVICE_INFO_PAYLOAD_WORDS + 1];
+        uint32_t mResponseLen;
+};
+
+class MainNodeAllocationTest : public ::testing::Test
+{
+    public:
+        MainNodeAllocationTest() :
+            mScreenData(),
+            mPlayerData(0, mControllerObserver, mScreenData, mClock, mUsbFileSystem),
+            mScheduler(std::make_shared<PrioritizedTxScheduler>(mScheduleMutex, 0x00)),
+            mDreamcastMainNode(mBus, mPlayerData, mScheduler)
+        {}
+
+    protected:
+        //! Runs the node in 100 us steps up to the given time
+        void runUntil(uint64_t endTimeUs)
+        {
+            while (mCurrentTimeUs < endTimeUs)
+            {
+                mDreamcastMainNode.task(mCurrentTimeUs);
+                mCurrentTimeUs += 100;
+            }
+        }
+
+        FakeMutex mScheduleMutex;
+        FakeClock mClock;
+        FakeUsbFileSystem mUsbFileSystem;
+        FakeControllerObserver mControllerObserver;
+        FakeControllerMapleBus mBus;
+        ScreenData mScreenData;
+        PlayerData mPlayerData;
+        std::shared_ptr<PrioritizedTxScheduler> mScheduler;
+        DreamcastMainNode mDreamcastMainNode;
+        uint64_t mCurrentTimeUs = 0;
+};
+
+TEST_F(MainNodeAllocationTest, steadyStateControllerPollDoesNotAllocate)
+{
+    // --- SETUP ---
+    // Let the controller connect and start polling
+    runUntil(100000);
+    ASSERT_TRUE(mControllerObserver.mConnected);
+    uint32_t numConditionsBefore = mControllerObserver.mNumConditions;
+    ASSERT_GT(numConditionsBefore, 0);
+
+    // --- TEST EXECUTION ---
+    uint64_t numAllocationsBefore = gNumAllocations;
+    runUntil(1100000);
+    uint64_t numAllocationsAfter = gNumAllocations;
+
+    // --- EXPECTATIONS ---
+    // Controller should have been polled every 16 ms for a full second without a single allocation
+    EXPECT_GE(mControllerObserver.mNumConditions - numConditionsBefore, 62);
+    EXPECT_EQ(numAllocationsAfter - numAllocationsBefore, 0);
+}
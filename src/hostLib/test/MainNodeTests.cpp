@@ -54,7 +54,7 @@ class MockedDreamcastSubNode : public DreamcastSubNode
 
         MOCK_METHOD(void,
                     txComplete,
-                    (std::shared_ptr<const MaplePacket> packet,
+                    (const MaplePacketView* packet,
                         std::shared_ptr<const Transmission> tx),
                     (override));
 
@@ -95,11 +95,11 @@ class DreamcastMainNodeOverride : public DreamcastMainNode
         }
 
         //! Called from peripheralFactory below so we can test what function code it was called with
-        MOCK_METHOD(void, mockMethodPeripheralFactory, (const std::vector<uint32_t>& deviceInfoPayload));
+        MOCK_METHOD(void, mockMethodPeripheralFactory, (const MaplePacketView::Payload& deviceInfoPayload));
 
         //! This function overrides the real peripheral factory so that mock peripherals may be
         //! created.
-        uint32_t peripheralFactory(const std::vector<uint32_t>& deviceInfoPayload) override
+        uint32_t peripheralFactory(const MaplePacketView::Payload& deviceInfoPayload) override
         {
             mPeripherals = mPeripheralsToAdd;
             mockMethodPeripheralFactory(deviceInfoPayload);
@@ -135,8 +135,7 @@ class MainNodeTest : public ::testing::Test
         //! Sets up the DreamcastMainNode with mocked interfaces
         MainNodeTest() :
             mDreamcastControllerObserver(),
-            mMutex(),
-            mScreenData(mMutex),
+            mScreenData(),
             mPlayerData{0, mDreamcastControllerObserver, mScreenData, mClock, mUsbFileSystem},
             mMapleBus(),
             mPrioritizedTxScheduler(std::make_shared<PrioritizedTxScheduler>(mMutex2, 0x00)),
@@ -145,7 +144,6 @@ class MainNodeTest : public ::testing::Test
 
     protected:
         MockDreamcastControllerObserver mDreamcastControllerObserver;
-        MockMutex mMutex;
         MockMutex mMutex2;
         MockClock mClock;
         MockUsbFileSystem mUsbFileSystem;
@@ -27,6 +27,8 @@
 #include "MockMutex.hpp"
 
 #include "hal/MapleBus/MaplePacket.hpp"
+#include "hal/MapleBus/MaplePacketView.hpp"
+#include "hal/MapleBus/SerializedMaplePacket.hpp"
 
 #include <memory>
 #include <utility>
@@ -173,3 +175,151 @@ TEST(MaplePacketGettersTest, one)
     EXPECT_EQ(pkt.getNumTotalBits(), 360);
     EXPECT_EQ(pkt.getTxTimeNs(), 179520);
 }
+
+TEST(MaplePacketPayloadTest, largePayloadCopyAndMove)
+{
+    uint32_t payload[130];
+    for (uint32_t i = 0; i < 130; ++i)
+    {
+        payload[i] = 0x01010101 * i;
+    }
+    MaplePacket pkt1({.command=0x0C, .recipientAddr=0x01}, payload, 130);
+    EXPECT_EQ(pkt1.frame.length, 130);
+    ASSERT_EQ(pkt1.payload.size(), 130);
+    EXPECT_GE(pkt1.payload.capacity(), 130);
+
+    MaplePacket pkt2(pkt1);
+    EXPECT_EQ(pkt1, pkt2);
+    EXPECT_NE(pkt1.payload.data(), pkt2.payload.data());
+
+    const uint32_t* data = pkt2.payload.data();
+    MaplePacket pkt3(std::move(pkt2));
+    EXPECT_TRUE(pkt2.payload.empty());
+    EXPECT_EQ(pkt3.payload.data(), data);
+    EXPECT_EQ(pkt1, pkt3);
+    EXPECT_EQ(pkt3.payload[129], 0x81818181);
+}
+
+TEST(MaplePacketPayloadTest, appendAcrossInlineBoundary)
+{
+    MaplePacket pkt({.command=0x0C, .recipientAddr=0x01});
+    for (uint32_t i = 0; i < MaplePayload::NUM_INLINE_WORDS + 4; ++i)
+    {
+        pkt.appendPayload(i);
+    }
+    EXPECT_TRUE(pkt.isValid());
+    EXPECT_EQ(pkt.frame.length, MaplePayload::NUM_INLINE_WORDS + 4);
+    for (uint32_t i = 0; i < MaplePayload::NUM_INLINE_WORDS + 4; ++i)
+    {
+        EXPECT_EQ(pkt.payload[i], i);
+    }
+}
+
+TEST(MaplePacketPayloadTest, setKeepsStorage)
+{
+    uint32_t words[20] = {0x0C010013};
+    MaplePacket pkt(words, 20);
+    const uint32_t* data = pkt.payload.data();
+    uint32_t capacity = pkt.payload.capacity();
+
+    // Setting a smaller or equal packet shouldn't move storage
+    uint32_t words2[3] = {0x08000102, 0x00000001, 0x12345678};
+    pkt.set(words2, 3);
+    EXPECT_EQ(pkt.payload.data(), data);
+    EXPECT_EQ(pkt.payload.capacity(), capacity);
+    EXPECT_EQ(pkt.frame.toWord(), 0x08000102);
+    ASSERT_EQ(pkt.payload.size(), 2);
+    EXPECT_EQ(pkt.payload[1], 0x12345678);
+    EXPECT_TRUE(pkt.isValid());
+}
+
+TEST(MaplePacketPayloadTest, rawWordsTracked)
+{
+    uint32_t header[2] = {0x00000002, 0x00000010};
+    uint32_t data[3] = {0x11223344, 0x55667788, 0x99AABBCC};
+    MaplePacket pkt({.command=0x0C, .recipientAddr=0x01}, header, 2);
+    EXPECT_FALSE(pkt.hasRawPayload());
+
+    pkt.appendPayloadRaw(data, 3);
+    // Raw words are kept as given; they are only marked by index
+    EXPECT_TRUE(pkt.hasRawPayload());
+    EXPECT_EQ(pkt.rawPayloadIdx, 2);
+    ASSERT_EQ(pkt.payload.size(), 5);
+    EXPECT_EQ(pkt.payload[2], 0x11223344);
+    EXPECT_EQ(pkt.frame.length, 5);
+
+    // Copies keep the raw index, and it is part of the packet's identity
+    MaplePacket cpy(pkt);
+    EXPECT_EQ(cpy.rawPayloadIdx, 2);
+    EXPECT_TRUE(cpy == pkt);
+    MaplePacket swapped({.command=0x0C, .recipientAddr=0x01}, header, 2);
+    swapped.appendPayload(data, 3);
+    EXPECT_FALSE(swapped == pkt);
+
+    // Replacing the payload replaces raw data too
+    pkt.setPayload(header, 2);
+    EXPECT_FALSE(pkt.hasRawPayload());
+    pkt.appendPayloadRaw(data, 1);
+    pkt.rawResponseIdx = 2;
+    pkt.reset();
+    uint8_t noRaw = MaplePacket::NO_RAW_PAYLOAD;
+    EXPECT_FALSE(pkt.hasRawPayload());
+    EXPECT_EQ(pkt.rawResponseIdx, noRaw);
+}
+
+TEST(MaplePacketViewTest, viewsWordsInPlace)
+{
+    uint32_t words[4] = {0x08000103, 0x00000001, 0x12345678, 0x9ABCDEF0};
+    MaplePacketView view(words, 4);
+
+    // No copy is made - the payload points right into the given words
+    EXPECT_EQ(view.payload.data(), &words[1]);
+    ASSERT_EQ(view.payload.size(), 3);
+    EXPECT_EQ(view.payload[2], 0x9ABCDEF0);
+    EXPECT_EQ(view.frame.command, 0x08);
+    EXPECT_EQ(view.frame.recipientAddr, 0x00);
+    EXPECT_EQ(view.frame.senderAddr, 0x01);
+    EXPECT_EQ(view.frame.length, 3);
+
+    // A copy may be made when the packet must outlive the words
+    MaplePacket pkt = view.toPacket();
+    words[2] = 0;
+    EXPECT_EQ(pkt.frame.toWord(), 0x08000103);
+    ASSERT_EQ(pkt.payload.size(), 3);
+    EXPECT_EQ(pkt.payload[1], 0x12345678);
+}
+
+TEST(SerializedMaplePacketTest, matchesPacket)
+{
+    uint32_t payload[3] = {0x00000001, 0x12345678, 0x9ABCDEF0};
+    MaplePacket pkt({.command=0x08, .recipientAddr=0x00, .senderAddr=0x20}, payload, 3);
+    SerializedMaplePacket serialized(pkt);
+
+    ASSERT_EQ(serialized.getNumWords(), 6);
+    const uint32_t* words = serialized.getWords();
+    EXPECT_EQ(words[0], MaplePacket::flipWordBytes(pkt.getNumTotalBits()));
+    EXPECT_EQ(words[1], pkt.getFrameWord());
+    EXPECT_EQ(words[2], 0x00000001);
+    EXPECT_EQ(words[4], 0x9ABCDEF0);
+    // XOR of every byte of frame word and payload
+    EXPECT_EQ(words[5], 0x2A);
+    EXPECT_EQ(serialized.getCrc(), 0x2A);
+    EXPECT_EQ(serialized.getTxTimeNs(), pkt.getTxTimeNs());
+
+    MaplePacket deserialized;
+    serialized.get(deserialized);
+    EXPECT_EQ(deserialized, pkt);
+}
+
+TEST(SerializedMaplePacketTest, setAddressesUpdatesCrc)
+{
+    uint32_t payload[3] = {0x00000001, 0x12345678, 0x9ABCDEF0};
+    SerializedMaplePacket serialized;
+    serialized.set(MaplePacket::Frame::defaultFrame().toWord(), payload, 3);
+    serialized.setAddresses(0x20, 0x40);
+
+    MaplePacket pkt({.command=COMMAND_INVALID, .recipientAddr=0x40, .senderAddr=0x20}, payload, 3);
+    SerializedMaplePacket expected(pkt);
+    EXPECT_EQ(serialized.getFrameWord(), pkt.getFrameWord());
+    EXPECT_EQ(serialized.getCrc(), expected.getCrc());
+}
@@ -0,0 +1,524 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NonVolatilePicoSystemMemory.hpp"
+
+#include "clientLib/DreamcastStorage.hpp"
+
+#include "FakeFlash.hpp"
+#include "MockClock.hpp"
+#include "NullMutex.hpp"
+
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+class NonVolatilePicoSystemMemoryTest : public ::testing::Test
+{
+    public:
+        NonVolatilePicoSystemMemoryTest() :
+            mTimeUs(1000),
+            mFlash(FLASH_SIZE),
+            mMemory(nullptr)
+        {}
+
+    protected:
+        virtual void SetUp()
+        {
+            ON_CALL(mClock, getTimeUs()).WillByDefault(Invoke([this](){return mTimeUs;}));
+        }
+
+        //! Creates memory over what is currently in flash
+        void createMemory(uint32_t pinnedSize = 0)
+        {
+            uint32_t offset = MEMORY_OFFSET;
+            uint32_t size = MEMORY_SIZE;
+            mMemory = std::make_shared<NonVolatilePicoSystemMemory>(
+                mFlash, mMutex, mClock, offset, size, pinnedSize);
+        }
+
+        //! Writes a full VMU block, the same way client storage does
+        void writeBlock(uint16_t blockNum, const uint8_t* data)
+        {
+            uint32_t size = BLOCK_SIZE;
+            EXPECT_TRUE(mMemory->write(blockNum * BLOCK_SIZE, data, size));
+        }
+
+        //! Copies a VMU block out of memory
+        void readBlock(uint16_t blockNum, uint8_t* data)
+        {
+            uint32_t size = BLOCK_SIZE;
+            memcpy(data, mMemory->read(blockNum * BLOCK_SIZE, size), BLOCK_SIZE);
+        }
+
+        //! Lets the write delay elapse then processes until everything is committed
+        void commitAll()
+        {
+            mTimeUs += 1000000;
+            for (uint32_t i = 0; i < MEMORY_SIZE / FlashInterface::SECTOR_SIZE && mMemory->isCommitPending(); ++i)
+            {
+                mMemory->process();
+            }
+            EXPECT_FALSE(mMemory->isCommitPending());
+        }
+
+        //! @returns true iff flash holds what memory holds
+        bool flashMatchesMemory()
+        {
+            for (uint32_t offset = 0; offset < MEMORY_SIZE; offset += FlashInterface::SECTOR_SIZE)
+            {
+                uint32_t size = FlashInterface::SECTOR_SIZE;
+                const uint8_t* mem = mMemory->read(offset, size);
+                if (size != FlashInterface::SECTOR_SIZE
+                    || memcmp(&mFlash.mMemory[MEMORY_OFFSET + offset], mem, size) != 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //! Fills a buffer with a pattern
+        static void fill(uint8_t* data, uint32_t size, uint32_t seed)
+        {
+            for (uint32_t i = 0; i < size; ++i)
+            {
+                seed = seed * 1664525 + 1013904223;
+                data[i] = static_cast<uint8_t>(seed >> 24);
+            }
+        }
+
+        //! Simulates a game saving a file of the given number of blocks the way the Dreamcast does:
+        //! data blocks from the top of the user area down, then the FAT, then the directory
+        void saveFile(uint16_t numBlocks, uint32_t seed)
+        {
+            uint8_t block[BLOCK_SIZE];
+            uint8_t fat[BLOCK_SIZE];
+            readBlock(FAT_BLOCK_NO, fat);
+            uint16_t* fatEntries = reinterpret_cast<uint16_t*>(fat);
+            for (uint16_t i = 0; i < numBlocks; ++i)
+            {
+                uint16_t blockNum = FIRST_SAVE_BLOCK_NO - i;
+                fill(block, sizeof(block), seed + i);
+                writeBlock(blockNum, block);
+                fatEntries[blockNum] = (i + 1 < numBlocks) ? (blockNum - 1) : 0xFFFA;
+            }
+            writeBlock(FAT_BLOCK_NO, fat);
+
+            uint8_t dir[BLOCK_SIZE];
+            readBlock(FILE_INFO_BLOCK_NO, dir);
+            // 32 byte directory entry with file type, name, timestamp, and size
+            fill(dir, 32, seed);
+            dir[0] = 0x33;
+            dir[24] = static_cast<uint8_t>(numBlocks);
+            writeBlock(FILE_INFO_BLOCK_NO, dir);
+        }
+
+        static const uint32_t FLASH_SIZE = 256 * 1024;
+        static const uint32_t MEMORY_OFFSET = 128 * 1024;
+        static const uint32_t MEMORY_SIZE = client::DreamcastStorage::MEMORY_SIZE_BYTES;
+        static const uint32_t BLOCK_SIZE = 512;
+        static const uint16_t FAT_BLOCK_NO = client::DreamcastStorage::FAT_BLOCK_NO;
+        static const uint16_t FILE_INFO_BLOCK_NO = client::DreamcastStorage::FILE_INFO_BLOCK_NO;
+        static const uint16_t SYSTEM_BLOCK_NO = client::DreamcastStorage::SYSTEM_BLOCK_NO;
+        static const uint32_t SYSTEM_AREA_SIZE = client::DreamcastStorage::SYSTEM_AREA_SIZE_BYTES;
+        static const uint16_t FIRST_SAVE_BLOCK_NO = 199;
+
+        uint64_t mTimeUs;
+        NiceMock<MockClock> mClock;
+        NullMutex mMutex;
+        FakeFlash mFlash;
+        std::shared_ptr<NonVolatilePicoSystemMemory> mMemory;
+};
+
+TEST_F(NonVolatilePicoSystemMemoryTest, unchangedWriteSkipsFlash)
+{
+    // --- SETUP ---
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 1);
+    mFlash.preload(MEMORY_OFFSET + 10 * BLOCK_SIZE, block, sizeof(block));
+    createMemory();
+
+    // --- TEST EXECUTION ---
+    writeBlock(10, block);
+    bool pending = mMemory->isCommitPending();
+    commitAll();
+
+    // --- EXPECTATIONS ---
+    EXPECT_FALSE(pending);
+    EXPECT_EQ(mFlash.mNumErases, 0u);
+    EXPECT_EQ(mFlash.mNumPagePrograms, 0u);
+}
+
+TEST_F(NonVolatilePicoSystemMemoryTest, changeBackToFlashContentsSkipsFlash)
+{
+    // --- SETUP ---
+    uint8_t block[BLOCK_SIZE];
+    uint8_t original[BLOCK_SIZE];
+    fill(original, sizeof(original), 2);
+    mFlash.preload(MEMORY_OFFSET + 10 * BLOCK_SIZE, original, sizeof(original));
+    createMemory();
+    memcpy(block, original, sizeof(block));
+    block[3] ^= 0xFF;
+
+    // --- TEST EXECUTION ---
+    writeBlock(10, block);
+    bool pending = mMemory->isCommitPending();
+    writeBlock(10, original);
+    commitAll();
+
+    // --- EXPECTATIONS ---
+    EXPECT_TRUE(pending);
+    EXPECT_EQ(mFlash.mNumErases, 0u);
+    EXPECT_EQ(mFlash.mNumPagePrograms, 0u);
+}
+
+TEST_F(NonVolatilePicoSystemMemoryTest, clearingBitsProgramsOnlyChangedPage)
+{
+    // --- SETUP ---
+    uint8_t fat[BLOCK_SIZE];
+    memset(fat, 0xFF, sizeof(fat));
+    uint16_t* entries = reinterpret_cast<uint16_t*>(fat);
+    for (uint32_t i = 0; i < 200; ++i)
+    {
+        entries[i] = 0xFFFC;
+    }
+    mFlash.preload(MEMORY_OFFSET + FAT_BLOCK_NO * BLOCK_SIZE, fat, sizeof(fat));
+    createMemory();
+
+    // --- TEST EXECUTION ---
+    // 0xFFFC -> 0x00C4 only flips bits from 1 to 0
+    entries[197] = 0x00C4;
+    writeBlock(FAT_BLOCK_NO, fat);
+    commitAll();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(mFlash.mNumErases, 0u);
+    EXPECT_EQ(mFlash.mNumPagePrograms, 1u);
+    EXPECT_EQ(mFlash.mNumBadPrograms, 0u);
+    EXPECT_TRUE(flashMatchesMemory());
+}
+
+TEST_F(NonVolatilePicoSystemMemoryTest, settingBitsErasesAndReprogramsNonBlankPages)
+{
+    // --- SETUP ---
+    // Sector holding blocks 8-15 has data in blocks 8 and 10 (4 pages); the rest is erased
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 3);
+    mFlash.preload(MEMORY_OFFSET + 8 * BLOCK_SIZE, block, sizeof(block));
+    mFlash.preload(MEMORY_OFFSET + 10 * BLOCK_SIZE, block, sizeof(block));
+    createMemory();
+
+    // --- TEST EXECUTION ---
+    block[0] = 0xFF;
+    block[1] = 0x00;
+    writeBlock(8, block);
+    commitAll();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(mFlash.mNumErases, 1u);
+    EXPECT_EQ(mFlash.mNumPagePrograms, 4u);
+    EXPECT_EQ(mFlash.mNumBadPrograms, 0u);
+    EXPECT_TRUE(flashMatchesMemory());
+}
+
+TEST_F(NonVolatilePicoSystemMemoryTest, commitDelayedUntilWriterMovesOn)
+{
+    // --- SETUP ---
+    createMemory();
+    uint8_t block[BLOCK_SIZE];
+
+    // --- TEST EXECUTION ---
+    // Rewriting the same sector keeps delaying its commit
+    uint32_t numEarlyErases = 0;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        fill(block, sizeof(block), 10 + i);
+        writeBlock(8, block);
+        mTimeUs += 100000;
+        mMemory->process();
+        numEarlyErases += mFlash.mNumErases;
+    }
+    uint32_t programsBeforeMove = mFlash.mNumPagePrograms;
+    // Moving on to another sector allows the first to commit right away
+    writeBlock(16, block);
+    mMemory->process();
+    uint32_t programsAfterMove = mFlash.mNumPagePrograms;
+    bool pendingAfterMove = mMemory->isCommitPending();
+    commitAll();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(numEarlyErases, 0u);
+    EXPECT_EQ(programsBeforeMove, 0u);
+    EXPECT_EQ(programsAfterMove, 2u);
+    EXPECT_TRUE(pendingAfterMove);
+    EXPECT_EQ(mFlash.mNumErases, 0u);
+    EXPECT_EQ(mFlash.mNumPagePrograms, 4u);
+    EXPECT_TRUE(flashMatchesMemory());
+}
+
+TEST_F(NonVolatilePicoSystemMemoryTest, typicalVmuSavePatterns)
+{
+    // --- SETUP ---
+    // Freshly formatted VMU
+    createMemory();
+    std::shared_ptr<client::DreamcastStorage> storage =
+        std::make_shared<client::DreamcastStorage>(mMemory, 0);
+    ASSERT_TRUE(storage->format());
+    commitAll();
+    mFlash.resetCounts();
+    // Blocks 199 down to 190 land in sectors 24 and 23, FAT and directory in sector 31
+    const uint32_t numSaveBlocks = 10;
+    const uint32_t numSectorsTouched = 3;
+
+    // --- TEST EXECUTION ---
+    saveFile(numSaveBlocks, 100);
+    commitAll();
+    uint32_t newSaveErases = mFlash.mNumErases;
+    uint32_t newSavePrograms = mFlash.mNumPagePrograms;
+    uint32_t dataSectorErases = mFlash.mSectorEraseCounts[(MEMORY_OFFSET / 4096) + 24]
+                                + mFlash.mSectorEraseCounts[(MEMORY_OFFSET / 4096) + 23];
+    mFlash.resetCounts();
+
+    saveFile(numSaveBlocks, 100);
+    commitAll();
+    uint32_t sameSaveErases = mFlash.mNumErases;
+    uint32_t sameSavePrograms = mFlash.mNumPagePrograms;
+    mFlash.resetCounts();
+
+    saveFile(numSaveBlocks, 200);
+    commitAll();
+    uint32_t overwriteErases = mFlash.mNumErases;
+    uint32_t overwritePrograms = mFlash.mNumPagePrograms;
+
+    printf("VMU new save: %lu erases, %lu page programs; same save again: %lu erases, %lu page programs; "
+           "overwrite: %lu erases, %lu page programs (previously %lu erases, %lu page programs each)\n",
+           (unsigned long)newSaveErases,
+           (unsigned long)newSavePrograms,
+           (unsigned long)sameSaveErases,
+           (unsigned long)sameSavePrograms,
+           (unsigned long)overwriteErases,
+           (unsigned long)overwritePrograms,
+           (unsigned long)numSectorsTouched,
+           (unsigned long)(numSectorsTouched * 4096 / 256));
+
+    // --- EXPECTATIONS ---
+    // New data goes into erased flash, so only the FAT/directory sector may need an erase
+    EXPECT_EQ(dataSectorErases, 0u);
+    EXPECT_LE(newSaveErases, 1u);
+    EXPECT_LE(newSavePrograms, numSaveBlocks * 2 + 16);
+    // Saving the same thing again doesn't touch flash
+    EXPECT_EQ(sameSaveErases, 0u);
+    EXPECT_EQ(sameSavePrograms, 0u);
+    EXPECT_LE(overwriteErases, numSectorsTouched);
+    EXPECT_EQ(mFlash.mNumBadPrograms, 0u);
+    EXPECT_TRUE(flashMatchesMemory());
+}
+
+TEST_F(NonVolatilePicoSystemMemoryTest, readsComeFromFlashUnlessWritten)
+{
+    // --- SETUP ---
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 4);
+    mFlash.preload(MEMORY_OFFSET + 10 * BLOCK_SIZE, block, sizeof(block));
+    createMemory();
+
+    // --- TEST EXECUTION ---
+    uint32_t size = BLOCK_SIZE;
+    const uint8_t* before = mMemory->read(10 * BLOCK_SIZE, size);
+    block[0] ^= 0xFF;
+    writeBlock(10, block);
+    size = BLOCK_SIZE;
+    const uint8_t* pending = mMemory->read(10 * BLOCK_SIZE, size);
+    bool pendingMatches = (memcmp(pending, block, BLOCK_SIZE) == 0);
+    commitAll();
+    size = BLOCK_SIZE;
+    const uint8_t* after = mMemory->read(10 * BLOCK_SIZE, size);
+    // Reads stop at the end of a sector
+    size = BLOCK_SIZE;
+    mMemory->read(FlashInterface::SECTOR_SIZE - 4, size);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(before, mFlash.read(MEMORY_OFFSET + 10 * BLOCK_SIZE));
+    EXPECT_NE(pending, before);
+    EXPECT_TRUE(pendingMatches);
+    EXPECT_EQ(after, before);
+    EXPECT_EQ(memcmp(after, block, BLOCK_SIZE), 0);
+    EXPECT_EQ(size, 4u);
+}
+
+TEST_F(NonVolatilePicoSystemMemoryTest, flashNotReadWhileBusy)
+{
+    // --- SETUP ---
+    createMemory();
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 5);
+    writeBlock(8, block);
+    mTimeUs += 1000000;
+
+    // --- MOCKING ---
+    uint32_t cachedReadSize = 0;
+    uint32_t uncachedReadSize = BLOCK_SIZE;
+    uint32_t uncachedWriteSize = 0;
+    bool uncachedWriteSuccess = true;
+    mFlash.mOnOperation = [&]()
+    {
+        if (cachedReadSize == 0)
+        {
+            cachedReadSize = BLOCK_SIZE;
+            mMemory->read(8 * BLOCK_SIZE, cachedReadSize);
+            uncachedReadSize = BLOCK_SIZE;
+            mMemory->read(100 * BLOCK_SIZE, uncachedReadSize);
+            uncachedWriteSize = BLOCK_SIZE;
+            uncachedWriteSuccess = mMemory->write(100 * BLOCK_SIZE, block, uncachedWriteSize);
+        }
+    };
+
+    // --- TEST EXECUTION ---
+    mMemory->process();
+    mFlash.mOnOperation = nullptr;
+    uint32_t idleReadSize = BLOCK_SIZE;
+    mMemory->read(100 * BLOCK_SIZE, idleReadSize);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(cachedReadSize, 512u);
+    EXPECT_EQ(uncachedReadSize, 0u);
+    EXPECT_FALSE(uncachedWriteSuccess);
+    EXPECT_EQ(uncachedWriteSize, 0u);
+    EXPECT_EQ(idleReadSize, 512u);
+    EXPECT_FALSE(mMemory->isCommitPending());
+}
+
+TEST_F(NonVolatilePicoSystemMemoryTest, systemAreaReadWhileBusy)
+{
+    // --- SETUP ---
+    uint8_t fat[BLOCK_SIZE];
+    fill(fat, sizeof(fat), 11);
+    mFlash.preload(MEMORY_OFFSET + FAT_BLOCK_NO * BLOCK_SIZE, fat, sizeof(fat));
+    createMemory(SYSTEM_AREA_SIZE);
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 12);
+    writeBlock(8, block);
+    mTimeUs += 1000000;
+
+    // --- MOCKING ---
+    uint32_t fatReadSize = 0;
+    bool fatMatches = false;
+    uint32_t mediaInfoReadSize = 0;
+    uint32_t dirReadSize = 0;
+    uint32_t dataReadSize = BLOCK_SIZE;
+    uint32_t fatWriteSize = 0;
+    bool fatWriteSuccess = false;
+    mFlash.mOnOperation = [&]()
+    {
+        if (fatReadSize == 0)
+        {
+            fatReadSize = BLOCK_SIZE;
+            const uint8_t* mem = mMemory->read(FAT_BLOCK_NO * BLOCK_SIZE, fatReadSize);
+            fatMatches = (mem != nullptr && memcmp(mem, fat, BLOCK_SIZE) == 0);
+            mediaInfoReadSize = BLOCK_SIZE;
+            mMemory->read(SYSTEM_BLOCK_NO * BLOCK_SIZE, mediaInfoReadSize);
+            dirReadSize = BLOCK_SIZE;
+            mMemory->read(FILE_INFO_BLOCK_NO * BLOCK_SIZE, dirReadSize);
+            dataReadSize = BLOCK_SIZE;
+            mMemory->read(100 * BLOCK_SIZE, dataReadSize);
+            fat[0] = 0x5A;
+            fatWriteSize = BLOCK_SIZE;
+            fatWriteSuccess = mMemory->write(FAT_BLOCK_NO * BLOCK_SIZE, fat, fatWriteSize);
+        }
+    };
+
+    // --- TEST EXECUTION ---
+    mMemory->process();
+    mFlash.mOnOperation = nullptr;
+    commitAll();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(fatReadSize, 512u);
+    EXPECT_TRUE(fatMatches);
+    EXPECT_EQ(mediaInfoReadSize, 512u);
+    EXPECT_EQ(dirReadSize, 512u);
+    // Data blocks which aren't cached still can't be read until flash is free
+    EXPECT_EQ(dataReadSize, 0u);
+    EXPECT_TRUE(fatWriteSuccess);
+    EXPECT_EQ(fatWriteSize, 512u);
+    EXPECT_EQ(mFlash.mMemory[MEMORY_OFFSET + FAT_BLOCK_NO * BLOCK_SIZE], 0x5A);
+    EXPECT_TRUE(flashMatchesMemory());
+}
+
+TEST_F(NonVolatilePicoSystemMemoryTest, flashLeftAloneRightAfterRead)
+{
+    // --- SETUP ---
+    createMemory();
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 6);
+    writeBlock(8, block);
+    mTimeUs += 1000000;
+
+    // --- TEST EXECUTION ---
+    uint32_t size = BLOCK_SIZE;
+    mMemory->read(100 * BLOCK_SIZE, size);
+    mMemory->process();
+    uint32_t programsRightAfterRead = mFlash.mNumPagePrograms;
+    mTimeUs += NonVolatilePicoSystemMemory::READ_HOLD_US;
+    mMemory->process();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(programsRightAfterRead, 0u);
+    EXPECT_EQ(mFlash.mNumPagePrograms, 2u);
+}
+
+TEST_F(NonVolatilePicoSystemMemoryTest, writeStopsWhenCacheIsFull)
+{
+    // --- SETUP ---
+    createMemory();
+    uint8_t block[BLOCK_SIZE];
+    fill(block, sizeof(block), 7);
+    const uint32_t blocksPerSector = FlashInterface::SECTOR_SIZE / BLOCK_SIZE;
+    const uint32_t numCached = NonVolatilePicoSystemMemory::NUM_CACHED_SECTORS;
+
+    // --- TEST EXECUTION ---
+    for (uint32_t i = 0; i < numCached; ++i)
+    {
+        writeBlock(i * blocksPerSector, block);
+    }
+    uint32_t size = BLOCK_SIZE;
+    bool fullSuccess = mMemory->write(numCached * blocksPerSector * BLOCK_SIZE, block, size);
+    uint32_t fullSize = size;
+    commitAll();
+    size = BLOCK_SIZE;
+    bool retrySuccess = mMemory->write(numCached * blocksPerSector * BLOCK_SIZE, block, size);
+    commitAll();
+
+    // --- EXPECTATIONS ---
+    EXPECT_FALSE(fullSuccess);
+    EXPECT_EQ(fullSize, 0u);
+    EXPECT_TRUE(retrySuccess);
+    EXPECT_TRUE(flashMatchesMemory());
+}
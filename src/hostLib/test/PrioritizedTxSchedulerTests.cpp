@@ -28,6 +28,8 @@
 
 #include "PrioritizedTxScheduler.hpp"
 
+#include <algorithm>
+#include <list>
 #include <memory>
 
 #include <gtest/gtest.h>
@@ -38,16 +40,34 @@ using ::testing::Return;
 using ::testing::SetArgReferee;
 using ::testing::DoAll;
 
-class PrioritizedTxSchedulerUnitTest : public PrioritizedTxScheduler
+//! Holds the mutex in a base class so that it outlives the scheduler and its pools
+struct MockMutexHolder
+{
+    MockMutex mMutex;
+};
+
+class PrioritizedTxSchedulerUnitTest : public MockMutexHolder, public PrioritizedTxScheduler
 {
     public:
-        MockMutex mMutex;
+        PrioritizedTxSchedulerUnitTest(): MockMutexHolder(), PrioritizedTxScheduler(mMutex, 0x00, 255)
+        {
+            // The lowest priority waits for anything of higher priority that is scheduled
+            setRelativeDeadline(255, LOWEST_PRIORITY_DEADLINE_US);
+        }
 
-        PrioritizedTxSchedulerUnitTest(): PrioritizedTxScheduler(mMutex, 0x00, 255) {}
+        static const uint32_t LOWEST_PRIORITY_DEADLINE_US = 1000000;
 
-        std::vector<std::list<std::shared_ptr<Transmission>>>& getSchedule()
+        std::vector<std::list<std::shared_ptr<Transmission>>> getSchedule()
         {
-            return mSchedule;
+            std::vector<std::list<std::shared_ptr<Transmission>>> schedule(mSchedule.size());
+            for (uint32_t i = 0; i < mSchedule.size(); ++i)
+            {
+                for (NodeIndex idx = mSchedule[i].head; idx != INVALID_NODE_INDEX; idx = mNodePool[idx].next)
+                {
+                    schedule[i].push_back(mNodePool[idx].tx);
+                }
+            }
+            return schedule;
         }
 };
 
@@ -582,3 +602,482 @@ TEST_F(TransmissionScheduleCancelTest, cancelAll)
     ASSERT_EQ(schedule.size(), 256);
     ASSERT_EQ(schedule[255].size(), 0);
 }
+
+TEST_F(TransmissionScheduleCancelTest, countRecipients)
+{
+    EXPECT_EQ(scheduler.countRecipients(0x01), 1);
+    EXPECT_EQ(scheduler.countRecipients(0x02), 2);
+    EXPECT_EQ(scheduler.countRecipients(0x03), 0);
+
+    EXPECT_EQ(scheduler.cancelById(3), 1);
+
+    EXPECT_EQ(scheduler.countRecipients(0x01), 1);
+    EXPECT_EQ(scheduler.countRecipients(0x02), 1);
+}
+
+TEST_F(TransmissionScheduleCancelTest, cancelAfterPeek)
+{
+    // Item canceled in between peek and pop should not be popped
+    PrioritizedTxScheduler::ScheduleItem scheduleItem = scheduler.peekNext(1);
+    ASSERT_NE(scheduleItem.getTx(), nullptr);
+    EXPECT_EQ(scheduleItem.getTx()->transmissionId, 1);
+    EXPECT_EQ(scheduler.cancelById(1), 1);
+    EXPECT_EQ(scheduler.popItem(scheduleItem), nullptr);
+
+    const std::vector<std::list<std::shared_ptr<Transmission>>> schedule = scheduler.getSchedule();
+    ASSERT_EQ(schedule[255].size(), 2);
+
+    std::list<std::shared_ptr<Transmission>>::const_iterator iter = schedule[255].cbegin();
+    EXPECT_EQ((*iter++)->transmissionId, 2);
+    EXPECT_EQ((*iter++)->transmissionId, 3);
+}
+
+TEST(TransmissionScheduleCapacityTest, full)
+{
+    MockMutex mutex;
+    PrioritizedTxScheduler scheduler(mutex, 0x00, 0, 2);
+    const uint32_t invalidId = PrioritizedTxScheduler::INVALID_TX_ID;
+
+    MaplePacket packet1({.command=0x11, .recipientAddr=0x01}, 0x99887766);
+    EXPECT_EQ(scheduler.add(0, 1, nullptr, packet1, false), 1);
+    MaplePacket packet2({.command=0x22, .recipientAddr=0x01}, 0x99887766);
+    EXPECT_EQ(scheduler.add(0, 2, nullptr, packet2, false), 2);
+    MaplePacket packet3({.command=0x33, .recipientAddr=0x01}, 0x99887766);
+    EXPECT_EQ(scheduler.add(0, 3, nullptr, packet3, false), invalidId);
+    EXPECT_EQ(scheduler.countRecipients(0x01), 2);
+
+    // Popping an item frees up space
+    PrioritizedTxScheduler::ScheduleItem scheduleItem = scheduler.peekNext(1);
+    std::shared_ptr<const Transmission> item = scheduler.popItem(scheduleItem);
+    ASSERT_NE(item, nullptr);
+    EXPECT_EQ(item->transmissionId, 1);
+    EXPECT_EQ(scheduler.add(0, 3, nullptr, packet3, false), 3);
+    EXPECT_EQ(scheduler.cancelAll(), 2);
+    EXPECT_EQ(scheduler.countRecipients(0x01), 0);
+}
+
+class TransmissionScheduleDeadlineTest : public TransmissionScheduleTest
+{
+    public:
+        TransmissionScheduleDeadlineTest() {}
+
+    protected:
+        //! Adds a transmission that takes 314 us on the bus
+        uint32_t addPoll(uint8_t priority, uint64_t txTime, uint8_t recipientAddr)
+        {
+            MaplePacket packet({.command=0x09, .recipientAddr=recipientAddr}, 0x00000001);
+            return scheduler.add(priority, txTime, nullptr, packet, true, 3);
+        }
+
+        //! Pops whatever is next at the given time
+        //! @returns the transmission ID popped or 0 if nothing was ready
+        uint32_t popNext(uint64_t time)
+        {
+            PrioritizedTxScheduler::ScheduleItem scheduleItem = scheduler.peekNext(time);
+            std::shared_ptr<const Transmission> item = scheduler.popItem(scheduleItem);
+            return (item != nullptr) ? item->transmissionId : 0;
+        }
+};
+
+TEST_F(TransmissionScheduleDeadlineTest, earliestDeadlineFirstAcrossPriorities)
+{
+    // --- SETUP ---
+    // Same relative deadlines, so the one released first is the most urgent
+    uint32_t laterHighId = addPoll(0, 1000, 0x01);
+    uint32_t earlierLowId = addPoll(3, 500, 0x02);
+
+    // --- TEST EXECUTION ---
+    uint32_t first = popNext(1000);
+    uint32_t second = popNext(1400);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(first, earlierLowId);
+    EXPECT_EQ(second, laterHighId);
+}
+
+TEST_F(TransmissionScheduleDeadlineTest, asapReleasedWhenAdded)
+{
+    // --- SETUP ---
+    uint32_t timedId = addPoll(3, 4000, 0x01);
+    scheduler.peekNext(5000);
+    uint32_t asapId = addPoll(0, PrioritizedTxScheduler::TX_TIME_ASAP, 0x02);
+
+    // --- TEST EXECUTION ---
+    std::shared_ptr<Transmission> asapTx = scheduler.getSchedule()[0].front();
+    uint32_t first = popNext(5000);
+    uint32_t second = popNext(5400);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(asapTx->deadlineUs, 5000);
+    EXPECT_EQ(first, timedId);
+    EXPECT_EQ(second, asapId);
+}
+
+TEST_F(TransmissionScheduleDeadlineTest, earlierDeadlineMayOverlapLaterPending)
+{
+    // --- SETUP ---
+    uint32_t pendingId = addPoll(0, 1100, 0x01);
+    uint32_t readyId = addPoll(3, 900, 0x02);
+
+    // --- TEST EXECUTION ---
+    // The ready one is more urgent, so it goes even though it runs past 1100
+    uint32_t first = popNext(1000);
+    uint32_t second = popNext(1314);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(first, readyId);
+    EXPECT_EQ(second, pendingId);
+}
+
+TEST_F(TransmissionScheduleDeadlineTest, reservedPendingIsNeverOverlapped)
+{
+    // --- SETUP ---
+    scheduler.setReservation(1, 1000, 2000);
+    uint32_t reservedId = addPoll(1, 1100, 0x01);
+    uint32_t readyId = addPoll(3, 900, 0x02);
+
+    // --- TEST EXECUTION ---
+    uint32_t blocked = popNext(1000);
+    uint32_t first = popNext(1100);
+    uint32_t second = popNext(1414);
+
+    // --- EXPECTATIONS ---
+    // More urgent, but it would make the reserved transmission late
+    EXPECT_EQ(blocked, 0);
+    EXPECT_EQ(first, reservedId);
+    EXPECT_EQ(second, readyId);
+}
+
+TEST_F(TransmissionScheduleDeadlineTest, reservedGoesFirstUntilBudgetRunsOut)
+{
+    // --- SETUP ---
+    // Room for 2 reserved transmissions per period
+    scheduler.setReservation(1, 600, 10000);
+    uint32_t unreservedId = addPoll(3, 0, 0x02);
+    uint32_t reservedIds[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        reservedIds[i] = addPoll(1, 100, 0x01);
+    }
+
+    // --- TEST EXECUTION ---
+    uint32_t popped[4];
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        popped[i] = popNext(100 + i * 314);
+    }
+    uint32_t reservedCount = scheduler.countRecipients(0x01);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(popped[0], reservedIds[0]);
+    EXPECT_EQ(popped[1], reservedIds[1]);
+    // Overdrawn, so the earlier deadline goes first
+    EXPECT_EQ(popped[2], unreservedId);
+    EXPECT_EQ(popped[3], reservedIds[2]);
+    EXPECT_EQ(reservedCount, 0);
+}
+
+TEST_F(TransmissionScheduleDeadlineTest, reservationReplenishedEachPeriod)
+{
+    // --- SETUP ---
+    scheduler.setReservation(1, 300, 1000);
+    uint32_t reservedId1 = addPoll(1, 0, 0x01);
+    uint32_t reservedId2 = addPoll(1, 0, 0x01);
+    // Higher priority with same deadline wins ties, so the reservation decides the order below
+    uint32_t unreservedId1 = addPoll(0, 0, 0x02);
+    uint32_t unreservedId2 = addPoll(0, 0, 0x02);
+
+    // --- TEST EXECUTION ---
+    uint32_t first = popNext(0);
+    uint32_t second = popNext(314);
+    uint32_t third = popNext(1000);
+    uint32_t fourth = popNext(1314);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(first, reservedId1);
+    EXPECT_EQ(second, unreservedId1);
+    // 314 of 300 us was used, so 286 us are left after the first period
+    EXPECT_EQ(third, reservedId2);
+    EXPECT_EQ(fourth, unreservedId2);
+}
+
+class TransmissionScheduleChainTest : public TransmissionScheduleTest
+{
+    public:
+        TransmissionScheduleChainTest() {}
+
+    protected:
+        //! Adds a chain of 3 steps to recipient 0x01 where each step after the first waits 500 us
+        //! after the step before it
+        uint32_t addChain(uint64_t txTime)
+        {
+            uint32_t payload = 0x00000001;
+            MaplePacket packets[3] = {
+                MaplePacket({.command=0x0C, .recipientAddr=0x01}, &payload, 1),
+                MaplePacket({.command=0x0C, .recipientAddr=0x01}, &payload, 1),
+                MaplePacket({.command=0x0D, .recipientAddr=0x01}, &payload, 1)
+            };
+            TransmissionChainStep steps[3];
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                steps[i] = {.packet=&packets[i],
+                            .expectResponse=true,
+                            .expectedResponseNumPayloadWords=0,
+                            .continueCommand=COMMAND_RESPONSE_ACK,
+                            .minGapUs=500};
+            }
+            return scheduler.addChain(0, txTime, nullptr, steps, 3);
+        }
+
+        //! Pops whatever is next at the given time
+        std::shared_ptr<const Transmission> popNext(uint64_t time)
+        {
+            PrioritizedTxScheduler::ScheduleItem scheduleItem = scheduler.peekNext(time);
+            return scheduler.popItem(scheduleItem);
+        }
+};
+
+TEST_F(TransmissionScheduleChainTest, nextStepHeldUntilContinued)
+{
+    // --- SETUP ---
+    uint32_t id = addChain(1000);
+
+    // --- TEST EXECUTION ---
+    std::shared_ptr<const Transmission> first = popNext(1000);
+    std::shared_ptr<const Transmission> whileHeld = popNext(5000);
+    scheduler.continueChain(*first, 5000);
+    std::shared_ptr<const Transmission> beforeGap = popNext(5499);
+    std::shared_ptr<const Transmission> second = popNext(5500);
+
+    // --- EXPECTATIONS ---
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first->transmissionId, id);
+    EXPECT_EQ(whileHeld, nullptr);
+    EXPECT_EQ(beforeGap, nullptr);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(second->transmissionId, id);
+    EXPECT_EQ(second.get(), first->nextStep.get());
+    EXPECT_EQ(scheduler.countRecipients(0x01), 1);
+}
+
+TEST_F(TransmissionScheduleChainTest, abortDropsRestOfChain)
+{
+    // --- SETUP ---
+    addChain(1000);
+
+    // --- TEST EXECUTION ---
+    std::shared_ptr<const Transmission> first = popNext(1000);
+    scheduler.abortChain(*first);
+
+    // --- EXPECTATIONS ---
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(scheduler.countRecipients(0x01), 0);
+    EXPECT_EQ(popNext(10000), nullptr);
+}
+
+TEST_F(TransmissionScheduleChainTest, cancelByIdDropsHeldStep)
+{
+    // --- SETUP ---
+    uint32_t id = addChain(1000);
+
+    // --- TEST EXECUTION ---
+    std::shared_ptr<const Transmission> first = popNext(1000);
+    uint32_t numCanceled = scheduler.cancelById(id);
+    // Step on the bus completes after the chain was canceled
+    scheduler.continueChain(*first, 1400);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(numCanceled, 1);
+    EXPECT_EQ(popNext(10000), nullptr);
+}
+
+TEST_F(TransmissionScheduleChainTest, queueDepthReturnsToZeroAfterChain)
+{
+    // --- SETUP ---
+    addChain(1000);
+    uint32_t depthBefore = scheduler.getQueueDepth(0);
+
+    // --- TEST EXECUTION ---
+    uint64_t time = 1000;
+    uint32_t numSteps = 0;
+    uint32_t maxDepth = 0;
+    std::shared_ptr<const Transmission> step;
+    while ((step = popNext(time)) != nullptr)
+    {
+        ++numSteps;
+        maxDepth = std::max(maxDepth, scheduler.getQueueDepth(0));
+        // Each step is acknowledged 100 us after it is sent
+        time += 100;
+        scheduler.continueChain(*step, time);
+        time += 500;
+    }
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(depthBefore, 1);
+    EXPECT_EQ(numSteps, 3);
+    // Held steps stay queued in the same node
+    EXPECT_EQ(maxDepth, 1);
+    EXPECT_EQ(scheduler.getQueueDepth(0), 0);
+}
+
+class TransmissionScheduleCoalesceTest : public TransmissionScheduleTest
+{
+    public:
+        TransmissionScheduleCoalesceTest() {}
+
+    protected:
+        //! Adds an LCD write of the given frame number which supersedes any before it
+        uint32_t addLcdWrite(uint64_t txTime, uint32_t frameNum, uint8_t recipientAddr = 0x01)
+        {
+            uint32_t payload[3] = {DEVICE_FN_LCD, 0, frameNum};
+            MaplePacket packet({.command=COMMAND_BLOCK_WRITE, .recipientAddr=recipientAddr}, payload, 3);
+            return scheduler.addLatest(0, txTime, nullptr, packet, true);
+        }
+
+        //! @returns the frame number of the LCD write popped at the given time or 0 if none
+        uint32_t popFrameNum(uint64_t time)
+        {
+            PrioritizedTxScheduler::ScheduleItem scheduleItem = scheduler.peekNext(time);
+            std::shared_ptr<const Transmission> tx = scheduler.popItem(scheduleItem);
+            return (tx != nullptr) ? tx->packet->payload[2] : 0;
+        }
+};
+
+TEST_F(TransmissionScheduleCoalesceTest, replacedInPlace)
+{
+    // --- SETUP ---
+    uint32_t id1 = addLcdWrite(100, 1);
+    uint32_t otherId = addLcdWrite(150, 10, 0x02);
+
+    // --- TEST EXECUTION ---
+    uint32_t id2 = addLcdWrite(200, 2);
+    uint32_t id3 = addLcdWrite(300, 3);
+
+    // --- EXPECTATIONS ---
+    // Time of the first is kept
+    EXPECT_EQ(id2, id1);
+    EXPECT_EQ(id3, id1);
+    EXPECT_NE(otherId, id1);
+    EXPECT_EQ(scheduler.countRecipients(0x01), 1);
+    EXPECT_EQ(scheduler.getNumCoalesced(), 2);
+    EXPECT_EQ(popFrameNum(100), 3);
+    EXPECT_EQ(popFrameNum(150), 10);
+    EXPECT_EQ(popFrameNum(10000), 0);
+}
+
+TEST_F(TransmissionScheduleCoalesceTest, sentTransmissionNotReplaced)
+{
+    // --- SETUP ---
+    uint32_t id1 = addLcdWrite(100, 1);
+    uint32_t first = popFrameNum(100);
+
+    // --- TEST EXECUTION ---
+    uint32_t id2 = addLcdWrite(200, 2);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(first, 1);
+    EXPECT_NE(id2, id1);
+    EXPECT_EQ(scheduler.getNumCoalesced(), 0);
+    EXPECT_EQ(popFrameNum(200), 2);
+}
+
+TEST_F(TransmissionScheduleCoalesceTest, replacedAfterPeekStaysScheduled)
+{
+    // --- SETUP ---
+    addLcdWrite(100, 1);
+    addLcdWrite(100, 2);
+    PrioritizedTxScheduler::ScheduleItem scheduleItem = scheduler.peekNext(100);
+    std::shared_ptr<const Transmission> peeked = scheduleItem.getTx();
+
+    // --- TEST EXECUTION ---
+    // Replaced while the peeked one is being written to the bus
+    addLcdWrite(100, 3);
+    std::shared_ptr<const Transmission> popped = scheduler.popItem(scheduleItem);
+    PrioritizedTxScheduler::ScheduleItem nextItem = scheduler.peekNext(500);
+    std::shared_ptr<const Transmission> next = scheduler.popItem(nextItem);
+
+    // --- EXPECTATIONS ---
+    // The peeked one responds for itself and the one it replaced, so the next only responds for
+    // itself
+    EXPECT_EQ(popped, nullptr);
+    ASSERT_NE(peeked, nullptr);
+    EXPECT_EQ(peeked->numCoalesced, 1);
+    ASSERT_NE(next, nullptr);
+    EXPECT_EQ(next->packet->payload[2], 3);
+    EXPECT_EQ(next->numCoalesced, 0);
+}
+
+TEST_F(TransmissionScheduleCoalesceTest, queueDepthReturnsToZeroAfterCoalesce)
+{
+    // --- SETUP ---
+    addLcdWrite(100, 1);
+    addLcdWrite(100, 2);
+    uint32_t depthAfterReplace = scheduler.getQueueDepth(0);
+    PrioritizedTxScheduler::ScheduleItem scheduleItem = scheduler.peekNext(100);
+
+    // --- TEST EXECUTION ---
+    // Replaced while the peeked one is being written to the bus, which leaves the replacement queued
+    addLcdWrite(100, 3);
+    scheduler.popItem(scheduleItem);
+    uint32_t depthAfterPeekedPop = scheduler.getQueueDepth(0);
+    uint32_t lastFrameNum = popFrameNum(500);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(depthAfterReplace, 1);
+    EXPECT_EQ(depthAfterPeekedPop, 1);
+    EXPECT_EQ(lastFrameNum, 3);
+    EXPECT_EQ(scheduler.getQueueDepth(0), 0);
+}
+
+TEST_F(TransmissionScheduleTest, queueDepthHighWaterMarkPerPriority)
+{
+    // --- SETUP ---
+    MaplePacket packet1({.command=0x01, .recipientAddr=0x01}, 0x00000001);
+    MaplePacket packet2({.command=0x01, .recipientAddr=0x01}, 0x00000001);
+    MaplePacket packet3({.command=0x01, .recipientAddr=0x01}, 0x00000001);
+    scheduler.add(0, 100, nullptr, packet1, true);
+    scheduler.add(0, 200, nullptr, packet2, true);
+    scheduler.add(1, 300, nullptr, packet3, true);
+
+    // --- TEST EXECUTION ---
+    PrioritizedTxScheduler::ScheduleItem item = scheduler.peekNext(100);
+    scheduler.popItem(item);
+    uint32_t highWaterMark0 = scheduler.getQueueDepthHighWaterMark(0);
+    scheduler.resetQueueDepthHighWaterMarks();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(highWaterMark0, 2);
+    EXPECT_EQ(scheduler.getQueueDepthHighWaterMark(0), 1);
+    EXPECT_EQ(scheduler.getQueueDepthHighWaterMark(1), 1);
+    EXPECT_EQ(scheduler.getQueueDepthHighWaterMark(2), 0);
+}
+
+TEST_F(TransmissionScheduleTest, queueDepthReturnsToZeroAfterAutoRepeat)
+{
+    // --- SETUP ---
+    MaplePacket repeatPacket({.command=0x09, .recipientAddr=0x01}, 0x00000001);
+    MaplePacket oneShotPacket({.command=0x01, .recipientAddr=0x01}, 0x00000001);
+    uint32_t repeatId = scheduler.add(0, 100, nullptr, repeatPacket, true, 3, 1000);
+    scheduler.add(0, 150, nullptr, oneShotPacket, true);
+
+    // --- TEST EXECUTION ---
+    uint32_t numPopped = 0;
+    for (uint64_t time = 100; time < 5000; time += 100)
+    {
+        PrioritizedTxScheduler::ScheduleItem item = scheduler.peekNext(time);
+        if (scheduler.popItem(item) != nullptr)
+        {
+            ++numPopped;
+        }
+    }
+    // Only the auto repeat transmission is left, and it is queued in the same node after each pop
+    uint32_t depthWhileRepeating = scheduler.getQueueDepth(0);
+    uint32_t numCanceled = scheduler.cancelById(repeatId);
+
+    // --- EXPECTATIONS ---
+    EXPECT_GT(numPopped, 2);
+    EXPECT_EQ(depthWhileRepeating, 1);
+    EXPECT_EQ(numCanceled, 1);
+    EXPECT_EQ(scheduler.getQueueDepth(0), 0);
+    EXPECT_EQ(scheduler.getQueueDepthHighWaterMark(0), 2);
+}
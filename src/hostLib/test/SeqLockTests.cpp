@@ -0,0 +1,160 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "hal/System/SeqLock.hpp"
+
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+//! Odd sized so that the last storage word is only partly used
+struct Report
+{
+    int8_t analog[6];
+    bool dpad[4];
+    uint32_t buttons;
+    uint8_t pad;
+};
+
+void fillReport(Report& report, uint32_t sequence)
+{
+    for (int8_t& a : report.analog)
+    {
+        a = static_cast<int8_t>(sequence);
+    }
+    for (bool& d : report.dpad)
+    {
+        d = ((sequence & 1) != 0);
+    }
+    report.buttons = sequence;
+    report.pad = static_cast<uint8_t>(sequence);
+}
+
+bool isWholeReport(const Report& report)
+{
+    for (const int8_t& a : report.analog)
+    {
+        if (a != static_cast<int8_t>(report.buttons))
+        {
+            return false;
+        }
+    }
+    for (const bool& d : report.dpad)
+    {
+        if (d != ((report.buttons & 1) != 0))
+        {
+            return false;
+        }
+    }
+    return (report.pad == static_cast<uint8_t>(report.buttons));
+}
+}
+
+TEST(SeqLockTest, loadReturnsLastStored)
+{
+    // --- SETUP ---
+    Report initial;
+    fillReport(initial, 3);
+    SeqLock<Report> lock(initial);
+    Report first;
+    Report second;
+
+    // --- TEST EXECUTION ---
+    bool loaded = lock.tryLoad(first);
+    Report next;
+    fillReport(next, 0x12345);
+    lock.store(next);
+    second = lock.load();
+
+    // --- EXPECTATIONS ---
+    EXPECT_TRUE(loaded);
+    EXPECT_EQ(first.buttons, 3);
+    EXPECT_TRUE(isWholeReport(first));
+    EXPECT_EQ(second.buttons, 0x12345);
+    EXPECT_TRUE(isWholeReport(second));
+}
+
+TEST(SeqLockTest, writerAndReaderOnSeparateThreads)
+{
+    // --- SETUP ---
+    static const uint32_t NUM_STORES = 500000;
+    Report initial;
+    fillReport(initial, 0);
+    SeqLock<Report> lock(initial);
+    std::atomic<bool> done(false);
+
+    // --- TEST EXECUTION ---
+    std::thread writer([&lock, &done]()
+    {
+        Report report;
+        for (uint32_t i = 1; i <= NUM_STORES; ++i)
+        {
+            fillReport(report, i);
+            lock.store(report);
+        }
+        done = true;
+    });
+
+    uint32_t numReads = 0;
+    uint32_t numRetries = 0;
+    uint32_t numTorn = 0;
+    uint32_t numBackwards = 0;
+    uint32_t last = 0;
+    bool finished = false;
+    while (!finished)
+    {
+        finished = done;
+        Report report;
+        if (!lock.tryLoad(report))
+        {
+            ++numRetries;
+            continue;
+        }
+        ++numReads;
+        if (!isWholeReport(report))
+        {
+            ++numTorn;
+        }
+        if (report.buttons < last)
+        {
+            ++numBackwards;
+        }
+        last = report.buttons;
+    }
+    writer.join();
+    Report final = lock.load();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(numTorn, 0);
+    EXPECT_EQ(numBackwards, 0);
+    EXPECT_EQ(final.buttons, NUM_STORES);
+    EXPECT_GT(numReads, 1);
+    printf("SeqLock: %u whole reads, %u retried reads during %u stores\n",
+           (unsigned)numReads,
+           (unsigned)numRetries,
+           (unsigned)NUM_STORES);
+}
@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SimulatedDreamcastController.hpp"
+
+// The emulated VMU has nowhere to display or beep, so these are ignored
+static void ignoreScreen(const uint32_t* screen, uint32_t len) {}
+static void ignoreSetTime(const client::DreamcastTimer::SetTime& setTime) {}
+static void ignoreSetPwm(uint8_t width, uint8_t down) {}
+
+//! Local copy of the VMU memory size which may be bound to a reference
+static const uint32_t VMU_MEMORY_SIZE = client::DreamcastStorage::MEMORY_SIZE_BYTES;
+
+SimulatedDreamcastController::SimulatedDreamcastController(const ClockInterface& clock) :
+    mMemory(std::make_shared<RamSystemMemory>(VMU_MEMORY_SIZE)),
+    mMainPeripheral(
+        nullptr, // Only needed by task() which is never called since the simulated bus drives it
+        0x20,
+        0xFF,
+        0x00,
+        "Dreamcast Controller",
+        "Version 1.010,1998/09/28,315-6211-AB   ,Analog Module : The 4th Edition.5/8  +DF",
+        43.0,
+        50.0),
+    mController(std::make_shared<client::DreamcastController>()),
+    mVmu(std::make_shared<client::DreamcastPeripheral>(
+        0x01,
+        0xFF,
+        0x00,
+        "Visual Memory",
+        "Version 1.005,1999/04/15,315-6208-03,SEGA Visual Memory System BIOS",
+        12.4,
+        13.0)),
+    mStorage(std::make_shared<client::DreamcastStorage>(mMemory, 0)),
+    mScreen(std::make_shared<client::DreamcastScreen>(ignoreScreen, 48, 32)),
+    mTimer(std::make_shared<client::DreamcastTimer>(clock, ignoreSetTime, ignoreSetPwm)),
+    mPuruPuruPack(std::make_shared<client::DreamcastPeripheral>(
+        0x02,
+        0xFF,
+        0x00,
+        "Puru Puru Pack",
+        "Version 1.000,1998/11/10,315-6211-AH   ,Vibration Motor:1 , Fm:4 - 30Hz ,Pow:7",
+        20.0,
+        160.0)),
+    mVibration(std::make_shared<client::DreamcastVibration>()),
+    mBus(mMainPeripheral)
+{
+    mMainPeripheral.addFunction(mController);
+
+    mVmu->addFunction(mStorage);
+    mVmu->addFunction(mScreen);
+    mVmu->addFunction(mTimer);
+    mMainPeripheral.addSubPeripheral(mVmu);
+
+    mPuruPuruPack->addFunction(mVibration);
+    mMainPeripheral.addSubPeripheral(mPuruPuruPack);
+}
@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "SimulatedMapleBus.hpp"
+#include "RamSystemMemory.hpp"
+#include "hal/System/ClockInterface.hpp"
+
+#include "clientLib/DreamcastMainPeripheral.hpp"
+#include "clientLib/DreamcastController.hpp"
+#include "clientLib/DreamcastStorage.hpp"
+#include "clientLib/DreamcastScreen.hpp"
+#include "clientLib/DreamcastTimer.hpp"
+#include "clientLib/DreamcastVibration.hpp"
+
+#include <memory>
+
+//! An emulated standard controller with a VMU in slot 1 and a vibration pack in slot 2, attached
+//! to a SimulatedMapleBus which a host node may be run against
+class SimulatedDreamcastController
+{
+    public:
+        //! Constructor
+        //! @param[in] clock  Clock used by the emulated VMU timer
+        SimulatedDreamcastController(const ClockInterface& clock);
+
+        //! @returns the bus that the emulated controller is attached to
+        inline SimulatedMapleBus& getBus() { return mBus; }
+
+        //! @returns the emulated controller function
+        inline client::DreamcastController& getController() { return *mController; }
+
+        //! @returns the emulated VMU storage function
+        inline client::DreamcastStorage& getStorage() { return *mStorage; }
+
+        //! @returns the memory backing the emulated VMU (storage blocks start at offset 0)
+        inline RamSystemMemory& getMemory() { return *mMemory; }
+
+        //! @returns the emulated vibration function
+        inline client::DreamcastVibration& getVibration() { return *mVibration; }
+
+    private:
+        //! Memory backing the emulated VMU
+        std::shared_ptr<RamSystemMemory> mMemory;
+        //! Main peripheral at address 0x20
+        client::DreamcastMainPeripheral mMainPeripheral;
+        //! Controller function of the main peripheral
+        std::shared_ptr<client::DreamcastController> mController;
+        //! VMU sub-peripheral at address 0x01
+        std::shared_ptr<client::DreamcastPeripheral> mVmu;
+        //! Storage function of the VMU
+        std::shared_ptr<client::DreamcastStorage> mStorage;
+        //! Screen function of the VMU
+        std::shared_ptr<client::DreamcastScreen> mScreen;
+        //! Timer function of the VMU
+        std::shared_ptr<client::DreamcastTimer> mTimer;
+        //! Vibration sub-peripheral at address 0x02
+        std::shared_ptr<client::DreamcastPeripheral> mPuruPuruPack;
+        //! Vibration function of the vibration pack
+        std::shared_ptr<client::DreamcastVibration> mVibration;
+        //! The bus the host communicates through
+        SimulatedMapleBus mBus;
+};
@@ -0,0 +1,196 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SimulatedMapleBus.hpp"
+#include "clientLib/DreamcastMainPeripheral.hpp"
+
+#include <string.h>
+
+SimulatedMapleBus::SimulatedMapleBus(client::DreamcastMainPeripheral& peripheral) :
+    mPeripheral(peripheral),
+    mConnected(true),
+    mCurrentTimeNs(0),
+    mActive(false),
+    mReadExpected(false),
+    mWriteEndNs(0),
+    mReadStartNs(0),
+    mReadEndNs(0),
+    mResponse(),
+    mReadBuffers(),
+    mReadLen(0),
+    mReadBufferIdx(0),
+    mNumTransactions(0),
+    mBusyTimeNs(0)
+{}
+
+bool SimulatedMapleBus::write(const MaplePacket& packet,
+                              bool autostartRead,
+                              uint64_t readTimeoutUs)
+{
+    if (mActive)
+    {
+        return false;
+    }
+
+    ++mNumTransactions;
+    mActive = true;
+    mReadExpected = autostartRead;
+    mReadLen = 0;
+
+    uint64_t writeTimeNs = packet.getTxTimeNs();
+    mWriteEndNs = mCurrentTimeNs + (MAPLE_OPEN_LINE_CHECK_TIME_US * 1000) + writeTimeNs;
+    mBusyTimeNs += writeTimeNs;
+
+    if (!mConnected)
+    {
+        // Nothing will ever answer
+        mReadEndNs = mWriteEndNs + (readTimeoutUs * 1000);
+        return true;
+    }
+
+    mResponse.reset();
+    bool responded = false;
+    if (packet.hasRawPayload())
+    {
+        // Raw words skip the byte swap on the host side but the peripheral's bus still swaps them
+        MaplePacket received(packet.frame, packet.payload.data(), packet.rawPayloadIdx);
+        received.appendPayloadFlipWords(&packet.payload.data()[packet.rawPayloadIdx],
+                                        packet.payload.size() - packet.rawPayloadIdx);
+        responded = mPeripheral.dispensePacket(received, mResponse);
+    }
+    else
+    {
+        responded = mPeripheral.dispensePacket(packet, mResponse);
+    }
+
+    if (!autostartRead)
+    {
+        return true;
+    }
+
+    if (responded && mResponse.payload.size() < (sizeof(mReadBuffers[0]) / sizeof(uint32_t)))
+    {
+        uint32_t* buffer = mReadBuffers[mReadBufferIdx];
+        buffer[0] = mResponse.getFrameWord();
+        if (mResponse.rawPayloadIdx != packet.rawResponseIdx)
+        {
+            // Words which are raw on only one side end up swapped, the same as over a real line
+            for (uint32_t i = 0; i < mResponse.payload.size(); ++i)
+            {
+                bool sentRaw = (i >= mResponse.rawPayloadIdx);
+                bool readRaw = (i >= packet.rawResponseIdx);
+                uint32_t word = mResponse.payload[i];
+                buffer[i + 1] = (sentRaw != readRaw) ? MaplePacket::flipWordBytes(word) : word;
+            }
+        }
+        else if (mResponse.payload.size() > 0)
+        {
+            memcpy(&buffer[1],
+                   mResponse.payload.data(),
+                   mResponse.payload.size() * sizeof(uint32_t));
+        }
+        mReadLen = mResponse.payload.size() + 1;
+
+        uint64_t readTimeNs =
+            MaplePacket::getTxTimeNs(mResponse.payload.size(), MAPLE_RESPONSE_NS_PER_BIT);
+        mReadStartNs = mWriteEndNs + MAPLE_RESPONSE_DELAY_NS;
+        mReadEndNs = mReadStartNs + readTimeNs;
+        mBusyTimeNs += readTimeNs;
+    }
+    else
+    {
+        mReadEndNs = mWriteEndNs + (readTimeoutUs * 1000);
+    }
+
+    return true;
+}
+
+bool SimulatedMapleBus::startRead(uint64_t readTimeoutUs)
+{
+    return false;
+}
+
+MapleBusInterface::Status SimulatedMapleBus::processEvents(uint64_t currentTimeUs)
+{
+    mCurrentTimeNs = currentTimeUs * 1000;
+
+    Status status;
+    status.failureReason = FailureReason::NONE;
+
+    if (!mActive)
+    {
+        status.phase = Phase::IDLE;
+    }
+    else if (mCurrentTimeNs < mWriteEndNs)
+    {
+        status.phase = Phase::WRITE_IN_PROGRESS;
+    }
+    else if (!mReadExpected)
+    {
+        status.phase = Phase::WRITE_COMPLETE;
+        mActive = false;
+    }
+    else if (mReadLen == 0)
+    {
+        if (mCurrentTimeNs < mReadEndNs)
+        {
+            status.phase = Phase::WAITING_FOR_READ_START;
+        }
+        else
+        {
+            status.phase = Phase::READ_FAILED;
+            status.failureReason = FailureReason::TIMEOUT;
+            mActive = false;
+        }
+    }
+    else if (mCurrentTimeNs < mReadStartNs)
+    {
+        status.phase = Phase::WAITING_FOR_READ_START;
+    }
+    else if (mCurrentTimeNs < mReadEndNs)
+    {
+        status.phase = Phase::READ_IN_PROGRESS;
+    }
+    else
+    {
+        status.phase = Phase::READ_COMPLETE;
+        status.readBuffer = mReadBuffers[mReadBufferIdx];
+        status.readBufferLen = mReadLen;
+        mReadBufferIdx ^= 1;
+        mReadLen = 0;
+        mActive = false;
+    }
+
+    return status;
+}
+
+bool SimulatedMapleBus::isBusy()
+{
+    return mActive;
+}
+
+void SimulatedMapleBus::setConnected(bool connected)
+{
+    mConnected = connected;
+}
@@ -0,0 +1,107 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "hal/MapleBus/MapleBusInterface.hpp"
+#include "hal/MapleBus/MaplePacket.hpp"
+
+#include <stdint.h>
+
+namespace client
+{
+class DreamcastMainPeripheral;
+}
+
+//! Host side Maple Bus which emulates a peripheral on the other end of the line
+//!
+//! Each write is delivered to a client::DreamcastMainPeripheral, and its response is returned
+//! through processEvents() only once the virtual time passed to processEvents() reaches the point
+//! at which the real bus would have received it. Timing is modeled using MAPLE_NS_PER_BIT for
+//! host writes, MAPLE_RESPONSE_DELAY_NS and MAPLE_RESPONSE_NS_PER_BIT for peripheral responses,
+//! and MAPLE_OPEN_LINE_CHECK_TIME_US before each write. Virtual time is simply the last time given
+//! to processEvents(), which the host must call before each write anyway.
+class SimulatedMapleBus : public MapleBusInterface
+{
+    public:
+        //! Constructor
+        //! @param[in] peripheral  The emulated main peripheral (with any sub-peripherals) which
+        //!                        responds to packets written to this bus
+        SimulatedMapleBus(client::DreamcastMainPeripheral& peripheral);
+
+        //! Inherited from MapleBusInterface
+        bool write(const MaplePacket& packet,
+                   bool autostartRead,
+                   uint64_t readTimeoutUs=MAPLE_RESPONSE_TIMEOUT_US) override;
+
+        //! Inherited from MapleBusInterface; not supported since this bus is always the host
+        bool startRead(uint64_t readTimeoutUs=std::numeric_limits<uint64_t>::max()) override;
+
+        //! Inherited from MapleBusInterface
+        Status processEvents(uint64_t currentTimeUs) override;
+
+        //! Inherited from MapleBusInterface
+        bool isBusy() override;
+
+        //! Simulates plugging in or unplugging the peripheral (plugged in by default)
+        //! @param[in] connected  When false, all reads time out without reaching the peripheral
+        void setConnected(bool connected);
+
+        //! @returns the number of write/read cycles started on this bus
+        inline uint32_t getNumTransactions() const { return mNumTransactions; }
+
+        //! @returns the total number of nanoseconds the line has been driven by either side
+        inline uint64_t getBusyTimeNs() const { return mBusyTimeNs; }
+
+    private:
+        //! The emulated peripheral
+        client::DreamcastMainPeripheral& mPeripheral;
+        //! True when the peripheral is plugged in
+        bool mConnected;
+        //! Last time passed to processEvents() in nanoseconds
+        uint64_t mCurrentTimeNs;
+        //! True while a write or write/read cycle is outstanding
+        bool mActive;
+        //! True when the outstanding write expects a response
+        bool mReadExpected;
+        //! Time at which the outstanding write completes
+        uint64_t mWriteEndNs;
+        //! Time at which the response start sequence is seen
+        uint64_t mReadStartNs;
+        //! Time at which the response is fully received or the read times out
+        uint64_t mReadEndNs;
+        //! Response packet built by the peripheral
+        MaplePacket mResponse;
+        //! Receive buffers (frame word followed by payload), alternated like the real bus so that
+        //! returned data remains valid until the following read completes
+        uint32_t mReadBuffers[2][256];
+        //! Number of valid words in the next receive buffer, 0 if no response is coming
+        uint32_t mReadLen;
+        //! Index of the receive buffer which the next response is written to
+        uint32_t mReadBufferIdx;
+        //! Number of write/read cycles started
+        uint32_t mNumTransactions;
+        //! Accumulated time the line was driven
+        uint64_t mBusyTimeNs;
+};
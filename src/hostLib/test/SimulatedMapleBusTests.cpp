@@ -0,0 +1,722 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SimulatedMapleBus.hpp"
+#include "SimulatedDreamcastController.hpp"
+#include "NullMutex.hpp"
+
+#include "DreamcastMainNode.hpp"
+#include "PrioritizedTxScheduler.hpp"
+#include "PlayerData.hpp"
+#include "ScreenData.hpp"
+#include "dreamcast_constants.h"
+#include "dreamcast_structures.h"
+#include "utils.h"
+
+#include "hal/System/ClockInterface.hpp"
+#include "hal/Usb/DreamcastControllerObserver.hpp"
+#include "hal/Usb/UsbFileSystem.hpp"
+
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+//! Clock which only moves when told to
+class SimulationClock : public ClockInterface
+{
+    public:
+        SimulationClock() : mTimeUs(0) {}
+        uint64_t getTimeUs() const override {return mTimeUs;}
+
+        uint64_t mTimeUs;
+};
+
+class SimulationUsbFileSystem : public UsbFileSystem
+{
+    public:
+        SimulationUsbFileSystem() : mFile(nullptr) {}
+        void add(UsbFile* file) override {mFile = file;}
+        void remove(UsbFile* file) override {mFile = nullptr;}
+
+        UsbFile* mFile;
+};
+
+//! Records when the A button was last seen pressed or released by the host and emulates a USB host
+//! which reads a report every millisecond
+class SimulationControllerObserver : public DreamcastControllerObserver
+{
+    public:
+        SimulationControllerObserver(const SimulationClock& clock) :
+            mClock(clock),
+            mConnected(false),
+            mAPressed(false),
+            mAChangedTimeUs(0),
+            mNumConditions(0),
+            mConditionTimeUs(0)
+        {}
+
+        //! @returns the time of the first USB host read at or after the given time
+        uint64_t getNextHostReadTime(uint64_t timeUs) const
+        {
+            return INT_DIVIDE_CEILING(timeUs - HOST_READ_PHASE_US, HOST_READ_INTERVAL_US)
+                * HOST_READ_INTERVAL_US + HOST_READ_PHASE_US;
+        }
+
+        bool getHostReadTiming(uint32_t& timeUs, uint32_t& intervalUs) override
+        {
+            uint64_t nowUs = mClock.getTimeUs();
+            if (nowUs < HOST_READ_PHASE_US)
+            {
+                return false;
+            }
+            timeUs = nowUs - ((nowUs - HOST_READ_PHASE_US) % HOST_READ_INTERVAL_US);
+            intervalUs = HOST_READ_INTERVAL_US;
+            return true;
+        }
+
+        void setControllerCondition(const ControllerCondition& controllerCondition) override
+        {
+            ++mNumConditions;
+            mConditionTimeUs = mClock.getTimeUs();
+            bool pressed = (controllerCondition.a == 0);
+            if (pressed != mAPressed)
+            {
+                mAPressed = pressed;
+                mAChangedTimeUs = mClock.getTimeUs();
+            }
+        }
+        void setSecondaryControllerCondition(const SecondaryControllerCondition& secondaryControllerCondition) override {}
+        void controllerConnected() override {mConnected = true;}
+        void controllerDisconnected() override {mConnected = false;}
+
+        //! The host reads reports 200 us into each USB frame
+        static const uint64_t HOST_READ_PHASE_US = 200;
+        static const uint64_t HOST_READ_INTERVAL_US = 1000;
+
+        const SimulationClock& mClock;
+        bool mConnected;
+        bool mAPressed;
+        uint64_t mAChangedTimeUs;
+        uint32_t mNumConditions;
+        uint64_t mConditionTimeUs;
+};
+
+//! Main node which counts how many times peripherals are created from device info
+class FactoryCountingMainNode : public DreamcastMainNode
+{
+    public:
+        FactoryCountingMainNode(MapleBusInterface& bus,
+                                PlayerData playerData,
+                                std::shared_ptr<PrioritizedTxScheduler> prioritizedTxScheduler) :
+            DreamcastMainNode(bus, playerData, prioritizedTxScheduler),
+            mNumFactoryCalls(0)
+        {}
+
+        uint32_t peripheralFactory(const MaplePacketView::Payload& deviceInfoPayload) override
+        {
+            ++mNumFactoryCalls;
+            return DreamcastMainNode::peripheralFactory(deviceInfoPayload);
+        }
+
+        uint32_t mNumFactoryCalls;
+};
+
+//! Keeps a number of external GET_CONDITION passthrough requests queued at all times, like a
+//! flycast client which sends X commands as fast as it can
+class PassthroughFlood : public Transmitter
+{
+    public:
+        PassthroughFlood(PrioritizedTxScheduler& scheduler, uint32_t depth) :
+            mScheduler(scheduler),
+            mDepth(depth),
+            mNumCompleted(0)
+        {}
+
+        //! Fills the queue
+        void start()
+        {
+            for (uint32_t i = 0; i < mDepth; ++i)
+            {
+                addRequest();
+            }
+        }
+
+        void txStarted(std::shared_ptr<const Transmission> tx) override {}
+
+        void txFailed(bool writeFailed, bool readFailed, std::shared_ptr<const Transmission> tx) override
+        {
+            addRequest();
+        }
+
+        void txComplete(const MaplePacketView* packet, std::shared_ptr<const Transmission> tx) override
+        {
+            ++mNumCompleted;
+            addRequest();
+        }
+
+        //! @returns the number of passthrough requests which received a response
+        inline uint32_t getNumCompleted() const { return mNumCompleted; }
+
+    private:
+        void addRequest()
+        {
+            MaplePacket packet({.command=COMMAND_GET_CONDITION, .recipientAddr=0x20}, DEVICE_FN_CONTROLLER);
+            mScheduler.add(PrioritizedTxScheduler::EXTERNAL_TRANSMISSION_PRIORITY,
+                           PrioritizedTxScheduler::TX_TIME_ASAP,
+                           this,
+                           packet,
+                           true,
+                           3);
+        }
+
+        PrioritizedTxScheduler& mScheduler;
+        const uint32_t mDepth;
+        uint32_t mNumCompleted;
+};
+
+class SimulatedMapleBusTest : public ::testing::Test
+{
+    public:
+        SimulatedMapleBusTest() : mSimulatedController(mClock) {}
+
+    protected:
+        SimulationClock mClock;
+        SimulatedDreamcastController mSimulatedController;
+};
+
+TEST_F(SimulatedMapleBusTest, conditionResponseFollowsBitTiming)
+{
+    // --- SETUP ---
+    SimulatedMapleBus& bus = mSimulatedController.getBus();
+    MaplePacket infoRequest(
+        MaplePacket::Frame{
+            .command=COMMAND_DEVICE_INFO_REQUEST,
+            .recipientAddr=0x20,
+            .senderAddr=0x00,
+            .length=0});
+    MaplePacket conditionRequest(
+        MaplePacket::Frame{
+            .command=COMMAND_GET_CONDITION,
+            .recipientAddr=0x20,
+            .senderAddr=0x00,
+            .length=1},
+        DEVICE_FN_CONTROLLER);
+    // The peripheral doesn't respond to anything else until device info is requested
+    bus.processEvents(0);
+    ASSERT_TRUE(bus.write(infoRequest, true));
+    MapleBusInterface::Status info = bus.processEvents(10000);
+    ASSERT_EQ(info.phase, MapleBusInterface::Phase::READ_COMPLETE);
+    ASSERT_EQ(info.readBufferLen, 29);
+    uint64_t busyTimeBeforeNs = bus.getBusyTimeNs();
+    // Write: 10 us open line check + 86 bits at 480 ns = 51.28 us
+    // Read: 50 ns response delay + 150 bits at 1750 ns = 262.55 us, completing at 313.83 us
+    const uint64_t startNs = 20000000;
+    uint64_t writeEndNs = startNs + MAPLE_OPEN_LINE_CHECK_TIME_US * 1000
+        + conditionRequest.getTxTimeNs();
+    uint64_t readEndNs = writeEndNs
+        + MAPLE_RESPONSE_DELAY_NS
+        + MaplePacket::getTxTimeNs(3, MAPLE_RESPONSE_NS_PER_BIT);
+
+    // --- TEST EXECUTION ---
+    EXPECT_EQ(bus.processEvents(startNs / 1000).phase, MapleBusInterface::Phase::IDLE);
+    ASSERT_TRUE(bus.write(conditionRequest, true));
+    EXPECT_TRUE(bus.isBusy());
+    EXPECT_FALSE(bus.write(conditionRequest, true));
+    MapleBusInterface::Status writing = bus.processEvents(writeEndNs / 1000);
+    MapleBusInterface::Status reading = bus.processEvents(readEndNs / 1000);
+    MapleBusInterface::Status complete = bus.processEvents(readEndNs / 1000 + 1);
+    MapleBusInterface::Status idle = bus.processEvents(readEndNs / 1000 + 2);
+
+    // --- EXPECTATIONS ---
+    // Sub-peripheral bits for the VMU (0x01) and vibration pack (0x02) are set by the controller
+    EXPECT_EQ(MaplePacket::Frame::getFrameSenderAddr(info.readBuffer[0]), 0x23);
+    EXPECT_EQ(writing.phase, MapleBusInterface::Phase::WRITE_IN_PROGRESS);
+    EXPECT_EQ(reading.phase, MapleBusInterface::Phase::READ_IN_PROGRESS);
+    ASSERT_EQ(complete.phase, MapleBusInterface::Phase::READ_COMPLETE);
+    ASSERT_EQ(complete.readBufferLen, 4);
+    MaplePacket::Frame frame = MaplePacket::Frame::fromWord(complete.readBuffer[0]);
+    EXPECT_EQ(frame.command, COMMAND_RESPONSE_DATA_XFER);
+    EXPECT_EQ(frame.recipientAddr, 0x00);
+    EXPECT_EQ(frame.length, 3);
+    EXPECT_EQ(complete.readBuffer[1], DEVICE_FN_CONTROLLER);
+    // The previous response remains intact in the other receive buffer
+    EXPECT_NE(complete.readBuffer, info.readBuffer);
+    EXPECT_EQ(info.readBufferLen, 29);
+    EXPECT_EQ(info.readBuffer[1], DEVICE_FN_CONTROLLER);
+    EXPECT_EQ(idle.phase, MapleBusInterface::Phase::IDLE);
+    EXPECT_FALSE(bus.isBusy());
+    EXPECT_EQ(bus.getNumTransactions(), 2);
+    EXPECT_EQ(bus.getBusyTimeNs() - busyTimeBeforeNs,
+              readEndNs - startNs - MAPLE_OPEN_LINE_CHECK_TIME_US * 1000 - MAPLE_RESPONSE_DELAY_NS);
+}
+
+TEST_F(SimulatedMapleBusTest, disconnectedPeripheralTimesOut)
+{
+    // --- SETUP ---
+    SimulatedMapleBus& bus = mSimulatedController.getBus();
+    bus.setConnected(false);
+    MaplePacket request(
+        MaplePacket::Frame{
+            .command=COMMAND_DEVICE_INFO_REQUEST,
+            .recipientAddr=0x20,
+            .senderAddr=0x00,
+            .length=0});
+
+    // --- TEST EXECUTION ---
+    bus.processEvents(0);
+    ASSERT_TRUE(bus.write(request, true, 500));
+    MapleBusInterface::Status waiting = bus.processEvents(500);
+    MapleBusInterface::Status failed = bus.processEvents(600);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(waiting.phase, MapleBusInterface::Phase::WAITING_FOR_READ_START);
+    EXPECT_EQ(failed.phase, MapleBusInterface::Phase::READ_FAILED);
+    EXPECT_EQ(failed.failureReason, MapleBusInterface::FailureReason::TIMEOUT);
+    EXPECT_FALSE(bus.isBusy());
+}
+
+//! Runs a full host DreamcastMainNode against the simulated controller
+class SimulatedMainNodeTest : public SimulatedMapleBusTest
+{
+    public:
+        SimulatedMainNodeTest() :
+            mControllerObserver(mClock),
+            mScreenData(),
+            mPlayerData(0,
+                        mControllerObserver,
+                        mScreenData,
+                        mClock,
+                        mUsbFileSystem,
+                        &mLatencyStats,
+                        &mPollSettings),
+            mScheduler(std::make_shared<PrioritizedTxScheduler>(mScheduleMutex, 0x00)),
+            mDreamcastMainNode(mSimulatedController.getBus(), mPlayerData, mScheduler)
+        {}
+
+    protected:
+        //! Runs the node in steps of STEP_US up to the given time
+        void runUntil(uint64_t endTimeUs)
+        {
+            while (mClock.mTimeUs < endTimeUs)
+            {
+                mDreamcastMainNode.task(mClock.mTimeUs);
+                mClock.mTimeUs += STEP_US;
+            }
+        }
+
+        //! Sets the A button on the emulated controller, then runs until the host sees it
+        //! @returns the number of microseconds it took for the host to see the change
+        uint64_t measureLatency(bool pressed)
+        {
+            controller_condition_t condition = NEUTRAL_CONTROLLER_CONDITION;
+            condition.a = pressed ? 0 : 1;
+            mSimulatedController.getController().setCondition(condition);
+            uint64_t startTimeUs = mClock.mTimeUs;
+            while (mControllerObserver.mAPressed != pressed && mClock.mTimeUs < startTimeUs + 100000)
+            {
+                runUntil(mClock.mTimeUs + STEP_US);
+            }
+            return mControllerObserver.mAChangedTimeUs - startTimeUs;
+        }
+
+        //! Toggles the A button at a variety of times then measures when the USB host reads it
+        //! @param[in] numSamples  Number of times to toggle the A button
+        //! @returns the average number of microseconds until the USB host read each change
+        uint64_t measureAverageUsbLatency(uint32_t numSamples)
+        {
+            uint64_t totalLatencyUs = 0;
+            for (uint32_t i = 0; i < numSamples; ++i)
+            {
+                runUntil(mClock.mTimeUs + 1000 + (i * 370) % 16000);
+                uint64_t startTimeUs = mClock.mTimeUs;
+                uint64_t latencyUs = measureLatency((i % 2) == 0);
+                uint64_t readTimeUs = mControllerObserver.getNextHostReadTime(startTimeUs + latencyUs);
+                totalLatencyUs += readTimeUs - startTimeUs;
+            }
+            return totalLatencyUs / numSamples;
+        }
+
+        //! Unplugs the emulated controller, runs until the host sees it removed, then runs with the
+        //! port empty for the given time
+        void unplug(uint64_t emptyUs)
+        {
+            mSimulatedController.getBus().setConnected(false);
+            uint64_t startTimeUs = mClock.mTimeUs;
+            while (mControllerObserver.mConnected && mClock.mTimeUs < startTimeUs + 1000000)
+            {
+                runUntil(mClock.mTimeUs + STEP_US);
+            }
+            runUntil(mClock.mTimeUs + emptyUs);
+        }
+
+        //! Plugs the emulated controller back in, then runs until the host sends a report
+        //! @returns the number of microseconds until the first report was sent
+        uint64_t measureReconnect()
+        {
+            mSimulatedController.getBus().setConnected(true);
+            uint64_t startTimeUs = mClock.mTimeUs;
+            uint32_t numConditionsBefore = mControllerObserver.mNumConditions;
+            while (mControllerObserver.mNumConditions == numConditionsBefore
+                   && mClock.mTimeUs < startTimeUs + 1000000)
+            {
+                runUntil(mClock.mTimeUs + STEP_US);
+            }
+            return mControllerObserver.mConditionTimeUs - startTimeUs;
+        }
+
+        static const uint64_t STEP_US = 10;
+
+        NullMutex mScheduleMutex;
+        SimulationUsbFileSystem mUsbFileSystem;
+        SimulationControllerObserver mControllerObserver;
+        ScreenData mScreenData;
+        ControllerLatencyStats mLatencyStats;
+        ControllerPollSettings mPollSettings;
+        PlayerData mPlayerData;
+        std::shared_ptr<PrioritizedTxScheduler> mScheduler;
+        FactoryCountingMainNode mDreamcastMainNode;
+};
+
+TEST_F(SimulatedMainNodeTest, detectsControllerAndSubPeripherals)
+{
+    // --- SETUP ---
+    const uint32_t vmuSize = client::DreamcastStorage::MEMORY_SIZE_BYTES;
+
+    // --- TEST EXECUTION ---
+    runUntil(1000000);
+
+    // --- EXPECTATIONS ---
+    EXPECT_TRUE(mControllerObserver.mConnected);
+    // The host storage peripheral exposes the VMU as a file once detected
+    ASSERT_NE(mUsbFileSystem.mFile, nullptr);
+    EXPECT_EQ(mUsbFileSystem.mFile->getFileSize(), vmuSize);
+    EXPECT_GT(mSimulatedController.getBus().getNumTransactions(), 0);
+}
+
+TEST_F(SimulatedMainNodeTest, conditionLatencyBoundedByPollPeriod)
+{
+    // --- SETUP ---
+    // The host controller peripheral polls condition every 16 ms
+    const uint64_t pollPeriodUs = 16000;
+    runUntil(1000000);
+    ASSERT_TRUE(mControllerObserver.mConnected);
+    uint64_t busyTimeBeforeNs = mSimulatedController.getBus().getBusyTimeNs();
+    uint64_t startTimeUs = mClock.mTimeUs;
+
+    // --- TEST EXECUTION ---
+    // Change input at a variety of phases relative to the poll cadence
+    const uint32_t numSamples = 64;
+    uint64_t minLatencyUs = UINT64_MAX;
+    uint64_t maxLatencyUs = 0;
+    uint64_t totalLatencyUs = 0;
+    for (uint32_t i = 0; i < numSamples; ++i)
+    {
+        runUntil(mClock.mTimeUs + 1000 + (i * 370) % pollPeriodUs);
+        uint64_t latencyUs = measureLatency((i % 2) == 0);
+        minLatencyUs = std::min(minLatencyUs, latencyUs);
+        maxLatencyUs = std::max(maxLatencyUs, latencyUs);
+        totalLatencyUs += latencyUs;
+    }
+    uint64_t elapsedUs = mClock.mTimeUs - startTimeUs;
+    uint64_t busyTimeNs = mSimulatedController.getBus().getBusyTimeNs() - busyTimeBeforeNs;
+
+    printf("Simulated condition latency: min %5lu us, avg %5lu us, max %5lu us, bus busy %4.1f%%\n",
+           (long unsigned int)minLatencyUs,
+           (long unsigned int)(totalLatencyUs / numSamples),
+           (long unsigned int)maxLatencyUs,
+           busyTimeNs / (elapsedUs * 10.0));
+
+    // --- EXPECTATIONS ---
+    // A change can at worst just miss a poll, then must wait for the next poll to complete
+    uint64_t conditionTxUs = (MAPLE_OPEN_LINE_CHECK_TIME_US * 1000
+                              + MaplePacket::getTxTimeNs(1, MAPLE_NS_PER_BIT)
+                              + MAPLE_RESPONSE_DELAY_NS
+                              + MaplePacket::getTxTimeNs(3, MAPLE_RESPONSE_NS_PER_BIT)) / 1000;
+    EXPECT_GE(minLatencyUs, conditionTxUs);
+    EXPECT_LE(maxLatencyUs, pollPeriodUs + conditionTxUs + 2 * STEP_US);
+}
+
+TEST_F(SimulatedMainNodeTest, latencyStatsCoverEachPoll)
+{
+    // --- SETUP ---
+    const uint64_t stepUs = STEP_US;
+    runUntil(100000);
+    ASSERT_TRUE(mControllerObserver.mConnected);
+    mLatencyStats.reset();
+
+    // --- TEST EXECUTION ---
+    runUntil(1100000);
+
+    // --- EXPECTATIONS ---
+    // One sample per 16 ms poll over a full second
+    EXPECT_GE(mLatencyStats.total.getCount(), 62);
+    EXPECT_LE(mLatencyStats.total.getCount(), 63);
+    EXPECT_EQ(mLatencyStats.lag.getCount(), mLatencyStats.total.getCount());
+    // Each response takes 313.83 us on the bus, seen at the next 10 us step
+    EXPECT_GE(mLatencyStats.bus.getMin(), 313);
+    EXPECT_LE(mLatencyStats.bus.getMax(), 313 + 2 * stepUs);
+    EXPECT_EQ(mLatencyStats.bus.getBucket(LatencyHistogram::getBucketIndex(313)),
+              mLatencyStats.bus.getCount());
+    // Condition is handed off in the same step it is read
+    EXPECT_EQ(mLatencyStats.hid.getMax(), 0);
+    // The node runs in 10 us steps, so polls are never more than a step off cadence
+    EXPECT_LE(mLatencyStats.lag.getMax(), stepUs);
+    EXPECT_LE(mLatencyStats.jitter.getMax(), stepUs);
+}
+
+TEST_F(SimulatedMainNodeTest, fastPhaseLockedPollingReducesUsbLatency)
+{
+    // --- SETUP ---
+    const uint32_t numSamples = 64;
+    runUntil(1000000);
+    ASSERT_TRUE(mControllerObserver.mConnected);
+
+    // --- TEST EXECUTION ---
+    uint64_t defaultLatencyUs = measureAverageUsbLatency(numSamples);
+    mPollSettings.setPeriodUs(1000);
+    runUntil(mClock.mTimeUs + 100000);
+    uint64_t fastLatencyUs = measureAverageUsbLatency(numSamples);
+    mPollSettings.setPhaseLock(true);
+    runUntil(mClock.mTimeUs + 100000);
+    uint64_t fastPhaseLockedLatencyUs = measureAverageUsbLatency(numSamples);
+
+    printf("Simulated input to USB read latency: 16 ms poll %5lu us, 1 ms poll %5lu us, "
+           "1 ms phase locked poll %5lu us\n",
+           (long unsigned int)defaultLatencyUs,
+           (long unsigned int)fastLatencyUs,
+           (long unsigned int)fastPhaseLockedLatencyUs);
+
+    // --- EXPECTATIONS ---
+    EXPECT_LT(fastLatencyUs, defaultLatencyUs);
+    EXPECT_LT(fastPhaseLockedLatencyUs, fastLatencyUs);
+    // On average, input waits half a poll period to be sampled and then arrives just before a read
+    EXPECT_LT(fastPhaseLockedLatencyUs, 1100);
+}
+
+TEST_F(SimulatedMainNodeTest, pollJitterBoundedUnderPassthroughFlood)
+{
+    // --- SETUP ---
+    const uint64_t stepUs = STEP_US;
+    mPollSettings.setPeriodUs(1000);
+    runUntil(1000000);
+    ASSERT_TRUE(mControllerObserver.mConnected);
+    PassthroughFlood flood(*mScheduler, 4);
+    flood.start();
+    runUntil(mClock.mTimeUs + 100000);
+    mLatencyStats.reset();
+    uint32_t completedBefore = flood.getNumCompleted();
+    uint64_t busyTimeBeforeNs = mSimulatedController.getBus().getBusyTimeNs();
+    uint64_t startTimeUs = mClock.mTimeUs;
+
+    // --- TEST EXECUTION ---
+    runUntil(mClock.mTimeUs + 1000000);
+    uint32_t numPassthrough = flood.getNumCompleted() - completedBefore;
+    uint64_t elapsedUs = mClock.mTimeUs - startTimeUs;
+    uint64_t busyTimeNs = mSimulatedController.getBus().getBusyTimeNs() - busyTimeBeforeNs;
+    mScheduler->cancelAll();
+
+    printf("Simulated 1 ms poll under passthrough flood: %lu polls, lag max %lu us, "
+           "jitter max %lu us, %lu passthrough responses, bus busy %4.1f%%\n",
+           (long unsigned int)mLatencyStats.lag.getCount(),
+           (long unsigned int)mLatencyStats.lag.getMax(),
+           (long unsigned int)mLatencyStats.jitter.getMax(),
+           (long unsigned int)numPassthrough,
+           busyTimeNs / (elapsedUs * 10.0));
+
+    // --- EXPECTATIONS ---
+    // Every poll keeps its cadence, never more than a step off
+    EXPECT_GE(mLatencyStats.lag.getCount(), 999);
+    EXPECT_LE(mLatencyStats.lag.getMax(), stepUs);
+    EXPECT_LE(mLatencyStats.jitter.getMax(), stepUs);
+    // Passthrough still gets the time between polls
+    EXPECT_GE(numPassthrough, 1500);
+}
+
+TEST_F(SimulatedMainNodeTest, vmuBlocksKeepFileByteOrderAcrossBus)
+{
+    // --- SETUP ---
+    runUntil(1000000);
+    ASSERT_NE(mUsbFileSystem.mFile, nullptr);
+    UsbFile* file = mUsbFileSystem.mFile;
+    RamSystemMemory& vmuMemory = mSimulatedController.getMemory();
+    const uint8_t writeBlockNum = 10;
+    const uint8_t readBlockNum = 20;
+    uint8_t written[512];
+    uint8_t stored[512];
+    for (uint32_t i = 0; i < sizeof(written); ++i)
+    {
+        written[i] = static_cast<uint8_t>(i * 7 + 3);
+        stored[i] = static_cast<uint8_t>(i * 13 + 5);
+    }
+    uint32_t size = sizeof(stored);
+    vmuMemory.write(readBlockNum * size, stored, size);
+    uint8_t readBack[512] = {};
+    const uint64_t timeLimitUs = mClock.mTimeUs + 1000000;
+
+    // --- TEST EXECUTION ---
+    int32_t writeResult = 0;
+    while ((writeResult = file->tryWrite(writeBlockNum, written, sizeof(written), 100000)) == 0
+           && mClock.mTimeUs < timeLimitUs)
+    {
+        runUntil(mClock.mTimeUs + STEP_US);
+    }
+    int32_t flushResult = 0;
+    while ((flushResult = file->tryFlush()) == 0 && mClock.mTimeUs < timeLimitUs)
+    {
+        runUntil(mClock.mTimeUs + STEP_US);
+    }
+    int32_t readResult = 0;
+    while ((readResult = file->tryRead(readBlockNum, readBack, sizeof(readBack), 100000)) == 0
+           && mClock.mTimeUs < timeLimitUs)
+    {
+        runUntil(mClock.mTimeUs + STEP_US);
+    }
+
+    // --- EXPECTATIONS ---
+    // File bytes match the bytes the VMU holds in both directions
+    EXPECT_GT(writeResult, 0);
+    EXPECT_GT(flushResult, 0);
+    ASSERT_GT(readResult, 0);
+    size = sizeof(written);
+    EXPECT_EQ(memcmp(vmuMemory.read(writeBlockNum * size, size), written, sizeof(written)), 0);
+    EXPECT_EQ(memcmp(readBack, stored, sizeof(stored)), 0);
+}
+
+TEST_F(SimulatedMainNodeTest, reconnectRestoresCachedPeripherals)
+{
+    // --- SETUP ---
+    const uint64_t pollPeriodUs = 16000;
+    const uint64_t probePeriodUs = DreamcastMainNode::PROBE_PERIOD_MIN_US;
+    runUntil(1000000);
+    ASSERT_TRUE(mControllerObserver.mConnected);
+    ASSERT_EQ(mDreamcastMainNode.mNumFactoryCalls, 1);
+
+    // --- TEST EXECUTION ---
+    const uint32_t numSamples = 16;
+    uint64_t totalQuickUs = 0;
+    uint64_t maxQuickUs = 0;
+    for (uint32_t i = 0; i < numSamples; ++i)
+    {
+        unplug(20000 + (i * 1370) % pollPeriodUs);
+        uint64_t reconnectUs = measureReconnect();
+        totalQuickUs += reconnectUs;
+        maxQuickUs = std::max(maxQuickUs, reconnectUs);
+        runUntil(mClock.mTimeUs + 100000);
+    }
+    unplug(5000000);
+    uint64_t longEmptyUs = measureReconnect();
+
+    printf("Simulated reconnect to first report: after brief unplug avg %5lu us, max %5lu us, "
+           "after 5 s empty %6lu us\n",
+           (long unsigned int)(totalQuickUs / numSamples),
+           (long unsigned int)maxQuickUs,
+           (long unsigned int)longEmptyUs);
+
+    // --- EXPECTATIONS ---
+    EXPECT_TRUE(mControllerObserver.mConnected);
+    // The same controller came back every time, so its peripherals were never created again
+    EXPECT_EQ(mDreamcastMainNode.mNumFactoryCalls, 1);
+    // Found by the next probe, then reported by a poll sent right away
+    EXPECT_LE(maxQuickUs, probePeriodUs + 2500);
+    EXPECT_LE(longEmptyUs, DreamcastMainNode::PROBE_PERIOD_MAX_US + 2500);
+}
+
+TEST_F(SimulatedMainNodeTest, emptyPortProbingBacksOff)
+{
+    // --- SETUP ---
+    runUntil(1000000);
+    ASSERT_TRUE(mControllerObserver.mConnected);
+    unplug(0);
+    SimulatedMapleBus& bus = mSimulatedController.getBus();
+
+    // --- TEST EXECUTION ---
+    uint32_t numTransactionsBefore = bus.getNumTransactions();
+    runUntil(mClock.mTimeUs + 64000);
+    uint32_t numEarlyProbes = bus.getNumTransactions() - numTransactionsBefore;
+    runUntil(mClock.mTimeUs + 5000000);
+    numTransactionsBefore = bus.getNumTransactions();
+    runUntil(mClock.mTimeUs + 1000000);
+    uint32_t numLateProbes = bus.getNumTransactions() - numTransactionsBefore;
+
+    // Each unanswered probe holds the bus until the read times out
+    printf("Simulated empty port probing: %lu probes in first 64 ms, %lu probes per second "
+           "after 5 s (was 62 per second)\n",
+           (long unsigned int)numEarlyProbes,
+           (long unsigned int)numLateProbes);
+
+    // --- EXPECTATIONS ---
+    EXPECT_GE(numEarlyProbes, 15);
+    EXPECT_LE(numLateProbes, 8);
+    EXPECT_FALSE(mControllerObserver.mConnected);
+}
+
+TEST_F(SimulatedMainNodeTest, probingResumesAfterScheduleFullDuringDisconnect)
+{
+    // --- SETUP ---
+    const uint8_t mainAddr = 0x20;
+    const uint8_t fillAddr = 0x3F;
+    const uint64_t fillTimeUs = 1000000000000ULL;
+    runUntil(1000000);
+    ASSERT_TRUE(mControllerObserver.mConnected);
+    unplug(20000);
+    // Wait for a probe to be in flight, so the only room for the next one is taken below
+    uint64_t startTimeUs = mClock.mTimeUs;
+    while (mScheduler->countRecipients(mainAddr) > 0 && mClock.mTimeUs < startTimeUs + 1000000)
+    {
+        runUntil(mClock.mTimeUs + STEP_US);
+    }
+    ASSERT_EQ(mScheduler->countRecipients(mainAddr), 0);
+    uint32_t numFilled = 0;
+    while (true)
+    {
+        MaplePacket packet({.command=COMMAND_GET_CONDITION, .recipientAddr=fillAddr},
+                           DEVICE_FN_CONTROLLER);
+        uint32_t id = mScheduler->add(PrioritizedTxScheduler::EXTERNAL_TRANSMISSION_PRIORITY,
+                                      fillTimeUs,
+                                      nullptr,
+                                      packet,
+                                      true);
+        if (id == PrioritizedTxScheduler::INVALID_TX_ID)
+        {
+            break;
+        }
+        ++numFilled;
+    }
+    ASSERT_GT(numFilled, 0);
+
+    // --- TEST EXECUTION ---
+    mSimulatedController.getBus().setConnected(true);
+    runUntil(mClock.mTimeUs + 200000);
+    bool connectedWhileFull = mControllerObserver.mConnected;
+    mScheduler->cancelByRecipient(fillAddr);
+    uint64_t reconnectUs = measureReconnect();
+
+    // --- EXPECTATIONS ---
+    // Nothing could be probed while every node was taken
+    EXPECT_FALSE(connectedWhileFull);
+    EXPECT_TRUE(mControllerObserver.mConnected);
+    EXPECT_LE(reconnectUs, DreamcastMainNode::PROBE_PERIOD_MAX_US + 2500);
+}
@@ -56,11 +56,11 @@ class DreamcastSubNodeOverride : public DreamcastSubNode
         }
 
         //! Called from peripheralFactory below so we can test what function code it was called with
-        MOCK_METHOD(void, mockMethodPeripheralFactory, (const std::vector<uint32_t>& deviceInfoPayload));
+        MOCK_METHOD(void, mockMethodPeripheralFactory, (const MaplePacketView::Payload& deviceInfoPayload));
 
         //! This function overrides the real peripheral factory so that mock peripherals may be
         //! created.
-        uint32_t peripheralFactory(const std::vector<uint32_t>& deviceInfoPayload) override
+        uint32_t peripheralFactory(const MaplePacketView::Payload& deviceInfoPayload) override
         {
             mPeripherals = mPeripheralsToAdd;
             mockMethodPeripheralFactory(deviceInfoPayload);
@@ -95,8 +95,7 @@ class SubNodeTest : public ::testing::Test
         //! Sets up the DreamcastMainNode with mocked interfaces
         SubNodeTest() :
             mDreamcastControllerObserver(),
-            mMutex(),
-            mScreenData(mMutex),
+            mScreenData(),
             mPlayerData{1, mDreamcastControllerObserver, mScreenData, mClock, mUsbFileSystem},
             mPrioritizedTxScheduler(std::make_shared<PrioritizedTxScheduler>(mMutex2, 0x00)),
             mEndpointTxScheduler(std::make_shared<EndpointTxScheduler>(
@@ -106,7 +105,6 @@ class SubNodeTest : public ::testing::Test
 
     protected:
         MockDreamcastControllerObserver mDreamcastControllerObserver;
-        MockMutex mMutex;
         MockMutex mMutex2;
         MockClock mClock;
         MockUsbFileSystem mUsbFileSystem;
@@ -150,7 +148,8 @@ TEST_F(SubNodeTest, handleDataCommandNoPeripheralsAdded)
         std::make_shared<Transmission>(0, 0, true, 123, 0, 0, 0, txPacket, nullptr);
 
     // --- TEST EXECUTION ---
-    mDreamcastSubNode.txComplete(packet, tx);
+    MaplePacketView packetView(*packet);
+    mDreamcastSubNode.txComplete(&packetView, tx);
 
     // --- EXPECTATIONS ---
     EXPECT_TRUE(mDreamcastSubNode.getPeripherals().empty());
@@ -173,7 +172,8 @@ TEST_F(SubNodeTest, handleDataCommandPeripheralAdded)
         std::make_shared<Transmission>(0, 0, true, 123, 0, 0, 0, txPacket, nullptr);
 
     // --- TEST EXECUTION ---
-    mDreamcastSubNode.txComplete(packet, tx);
+    MaplePacketView packetView(*packet);
+    mDreamcastSubNode.txComplete(&packetView, tx);
 
     // --- EXPECTATIONS ---
     EXPECT_EQ(mDreamcastSubNode.getPeripherals().size(), 1);
@@ -195,7 +195,8 @@ TEST_F(SubNodeTest, handleDataCommandInvalidPayloadSize)
     EXPECT_CALL(mDreamcastSubNode, mockMethodPeripheralFactory(_)).Times(0);
 
     // --- TEST EXECUTION ---
-    mDreamcastSubNode.txComplete(packet, tx);
+    MaplePacketView packetView(*packet);
+    mDreamcastSubNode.txComplete(&packetView, tx);
 
     // --- EXPECTATIONS ---
     EXPECT_TRUE(mDreamcastSubNode.getPeripherals().empty());
@@ -275,3 +276,29 @@ TEST_F(SubNodeTest, setConnectedDisconnectedToDisconnected)
     EXPECT_FALSE(mDreamcastSubNode.isConnected());
     EXPECT_EQ(mDreamcastSubNode.getPeripherals().size(), 2);
 }
+
+TEST_F(SubNodeTest, infoRequestRetriedWhenScheduleFull)
+{
+    // --- SETUP ---
+    // Schedule with room for a single transmission, which is already taken
+    std::shared_ptr<PrioritizedTxScheduler> scheduler =
+        std::make_shared<PrioritizedTxScheduler>(mMutex2, 0x00, PrioritizedTxScheduler::PRIORITY_COUNT - 1, 1);
+    const uint8_t recipientAddr = DreamcastPeripheral::getRecipientAddress(1, 0x01);
+    std::shared_ptr<EndpointTxScheduler> endpointTxScheduler =
+        std::make_shared<EndpointTxScheduler>(scheduler, 0, recipientAddr);
+    DreamcastSubNodeOverride subNode(0x01, endpointTxScheduler, mPlayerData);
+    const uint32_t invalidId = PrioritizedTxScheduler::INVALID_TX_ID;
+    MaplePacket packet({.command=COMMAND_GET_CONDITION, .recipientAddr=0x20}, DEVICE_FN_CONTROLLER);
+    ASSERT_NE(scheduler->add(0, 1000, nullptr, packet, true), invalidId);
+
+    // --- TEST EXECUTION ---
+    subNode.setConnected(true, 1000);
+    subNode.task(1010);
+    uint32_t numWhileFull = scheduler->countRecipients(recipientAddr);
+    scheduler->cancelByRecipient(0x20);
+    subNode.task(1020);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(numWhileFull, 0);
+    EXPECT_EQ(scheduler->countRecipients(recipientAddr), 1);
+}
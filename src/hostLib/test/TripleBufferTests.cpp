@@ -0,0 +1,154 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "hal/System/TripleBuffer.hpp"
+
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+//! Every word holds the same sequence number so that a torn value is easy to spot
+struct Frame
+{
+    uint32_t words[48];
+};
+
+void fillFrame(Frame& frame, uint32_t sequence)
+{
+    for (uint32_t& word : frame.words)
+    {
+        word = sequence;
+    }
+}
+
+bool isWholeFrame(const Frame& frame)
+{
+    for (const uint32_t& word : frame.words)
+    {
+        if (word != frame.words[0])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+TEST(TripleBufferTest, readerGetsLatestPublished)
+{
+    // --- SETUP ---
+    TripleBuffer<uint32_t> buffer(7);
+
+    // --- TEST EXECUTION ---
+    bool newAtStart = buffer.isNewDataAvailable();
+    uint32_t initial = buffer.read();
+    buffer.write(1);
+    buffer.write(2);
+    bool newAfterWrites = buffer.isNewDataAvailable();
+    uint32_t latest = buffer.read();
+    bool newAfterRead = buffer.isNewDataAvailable();
+
+    // --- EXPECTATIONS ---
+    EXPECT_FALSE(newAtStart);
+    EXPECT_EQ(initial, 7);
+    EXPECT_TRUE(newAfterWrites);
+    // Values which weren't read in time are skipped
+    EXPECT_EQ(latest, 2);
+    EXPECT_FALSE(newAfterRead);
+    EXPECT_EQ(buffer.getPublished(), 2);
+}
+
+TEST(TripleBufferTest, writerNeverTouchesHeldValue)
+{
+    // --- SETUP ---
+    TripleBuffer<uint32_t> buffer(0);
+    buffer.write(1);
+
+    // --- TEST EXECUTION ---
+    uint32_t& held = buffer.read();
+    // Many more publishes than there are buffers while the reader holds on
+    for (uint32_t i = 2; i < 10; ++i)
+    {
+        buffer.write(i);
+    }
+    uint32_t heldAfterWrites = held;
+    uint32_t latest = buffer.read();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(heldAfterWrites, 1);
+    EXPECT_EQ(latest, 9);
+}
+
+TEST(TripleBufferTest, producerAndConsumerOnSeparateThreads)
+{
+    // --- SETUP ---
+    static const uint32_t NUM_FRAMES = 200000;
+    Frame initial;
+    fillFrame(initial, 0);
+    TripleBuffer<Frame> buffer(initial);
+    std::atomic<bool> done(false);
+
+    // --- TEST EXECUTION ---
+    std::thread producer([&buffer, &done]()
+    {
+        for (uint32_t i = 1; i <= NUM_FRAMES; ++i)
+        {
+            fillFrame(buffer.beginWrite(), i);
+            buffer.publish();
+        }
+        done = true;
+    });
+
+    uint32_t numReads = 0;
+    uint32_t numTorn = 0;
+    uint32_t numBackwards = 0;
+    uint32_t last = 0;
+    bool finished = false;
+    while (!finished)
+    {
+        // Checked before reading so that the final frame is always read
+        finished = done;
+        const Frame& frame = buffer.read();
+        ++numReads;
+        if (!isWholeFrame(frame))
+        {
+            ++numTorn;
+        }
+        if (frame.words[0] < last)
+        {
+            ++numBackwards;
+        }
+        last = frame.words[0];
+    }
+    producer.join();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(numTorn, 0);
+    EXPECT_EQ(numBackwards, 0);
+    EXPECT_EQ(last, NUM_FRAMES);
+    EXPECT_GT(numReads, 1);
+}
@@ -0,0 +1,252 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "UsbCdcTtyParser.hpp"
+#include "hal/Usb/CdcFrame.hpp"
+
+#include "NullMutex.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+//! Clock which only moves when told to
+class ManualClock : public ClockInterface
+{
+    public:
+        ManualClock() : mTimeUs(0) {}
+        uint64_t getTimeUs() const override { return mTimeUs; }
+        uint64_t mTimeUs;
+};
+
+//! Command parser which records everything submitted to it
+class RecordingCommandParser : public CommandParser
+{
+    public:
+        RecordingCommandParser(ManualClock& clock) : mClock(clock), mSubmitDurationUs(0) {}
+
+        const char* getCommandChars() override { return "XY"; }
+
+        void submit(const char* chars, uint32_t len) override
+        {
+            mCommands.push_back(std::string(chars, len));
+            mClock.mTimeUs += mSubmitDurationUs;
+        }
+
+        bool submitBinary(const uint8_t* data, uint32_t len) override
+        {
+            mFrames.push_back(std::vector<uint8_t>(data, data + len));
+            mClock.mTimeUs += mSubmitDurationUs;
+            return true;
+        }
+
+        void printHelp() override {}
+
+        ManualClock& mClock;
+        uint32_t mSubmitDurationUs;
+        std::vector<std::string> mCommands;
+        std::vector<std::vector<uint8_t>> mFrames;
+};
+
+class UsbCdcTtyParserTest : public ::testing::Test
+{
+    public:
+        UsbCdcTtyParserTest() :
+            mCommandParser(std::make_shared<RecordingCommandParser>(mClock)),
+            mParser(mMutex, 'h', mClock)
+        {
+            mParser.addCommandParser(mCommandParser);
+        }
+
+    protected:
+        void addString(const std::string& str)
+        {
+            mParser.addChars(str.c_str(), str.size());
+        }
+
+        void addFrame(char cmd, const std::string& data)
+        {
+            std::vector<uint8_t> frame(CdcFrame::OVERHEAD_SIZE + data.size());
+            CdcFrame::encode(&frame[0], frame.size(), cmd, data.c_str(), data.size());
+            mParser.addChars(reinterpret_cast<const char*>(&frame[0]), frame.size());
+        }
+
+        NullMutex mMutex;
+        ManualClock mClock;
+        std::shared_ptr<RecordingCommandParser> mCommandParser;
+        UsbCdcTtyParser mParser;
+};
+
+TEST_F(UsbCdcTtyParserTest, processesAllReadyCommandsInOneCall)
+{
+    // --- TEST EXECUTION ---
+    addString("X1\r\nX2\n\n  Y3\nX4");
+    mParser.process();
+    std::vector<std::string> firstCommands = mCommandParser->mCommands;
+    addString("\r\n");
+    mParser.process();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(firstCommands, std::vector<std::string>({"X1", "X2", "Y3"}));
+    EXPECT_EQ(mCommandParser->mCommands, std::vector<std::string>({"X1", "X2", "Y3", "X4"}));
+}
+
+TEST_F(UsbCdcTtyParserTest, backspaceStopsAtCompleteCommand)
+{
+    // --- TEST EXECUTION ---
+    addString("X1\nab\x08\x08\x08\x08X2\nX12\x7F" "3\n");
+    mParser.process();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(mCommandParser->mCommands, std::vector<std::string>({"X1", "X2", "X13"}));
+}
+
+TEST_F(UsbCdcTtyParserTest, stopsOnceBudgetElapses)
+{
+    // --- SETUP ---
+    mParser.setProcessBudgetUs(250);
+    mCommandParser->mSubmitDurationUs = 100;
+
+    // --- TEST EXECUTION ---
+    addString("X1\nX2\nX3\nX4\nX5\n");
+    mParser.process();
+    uint32_t numFirst = mCommandParser->mCommands.size();
+    mParser.process();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(numFirst, 3);
+    EXPECT_EQ(mCommandParser->mCommands.size(), 5);
+}
+
+TEST_F(UsbCdcTtyParserTest, overflowDropsOnlyOverflowingCommand)
+{
+    // --- TEST EXECUTION ---
+    ::testing::internal::CaptureStdout();
+    addString("X1\n");
+    addString("X" + std::string(3000, 'A'));
+    addString("\nX2\n");
+    mParser.process();
+    std::string output = ::testing::internal::GetCapturedStdout();
+
+    // --- EXPECTATIONS ---
+    EXPECT_NE(output.find("Error: Command input overflow"), std::string::npos);
+    EXPECT_EQ(mCommandParser->mCommands, std::vector<std::string>({"X1", "X2"}));
+}
+
+TEST_F(UsbCdcTtyParserTest, commandsSurviveWrapAround)
+{
+    // --- SETUP ---
+    std::vector<std::string> expected;
+
+    // --- TEST EXECUTION ---
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        std::string command = "X" + std::to_string(i) + std::string(1 + (i * 37) % 150, 'a' + (i % 26));
+        expected.push_back(command);
+        addString(command + "\r\n");
+        if (i % 7 == 6)
+        {
+            mParser.process();
+        }
+    }
+    mParser.process();
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(mCommandParser->mCommands, expected);
+}
+
+TEST_F(UsbCdcTtyParserTest, binaryFramesAndModeSwitches)
+{
+    // --- TEST EXECUTION ---
+    ::testing::internal::CaptureStdout();
+    addString("#B\nX0\n");
+    mParser.process();
+    bool binaryAfterSwitch = mParser.isBinaryMode();
+    std::string ack = ::testing::internal::GetCapturedStdout();
+
+    // Garbage, then many frames split at odd boundaries so that some wrap around the ring
+    std::string stream = "junk";
+    for (uint32_t i = 0; i < 300; ++i)
+    {
+        std::string data(1 + (i * 13) % 40, static_cast<char>(i));
+        std::vector<uint8_t> frame(CdcFrame::OVERHEAD_SIZE + data.size());
+        CdcFrame::encode(&frame[0], frame.size(), 'X', data.c_str(), data.size());
+        stream.append(reinterpret_cast<const char*>(&frame[0]), frame.size());
+    }
+    for (uint32_t i = 0; i < stream.size(); i += 97)
+    {
+        addString(stream.substr(i, 97));
+        mParser.process();
+    }
+    uint32_t numFrames = mCommandParser->mFrames.size();
+    bool framesIntact = true;
+    for (uint32_t i = 0; i < numFrames && framesIntact; ++i)
+    {
+        framesIntact = (mCommandParser->mFrames[i]
+                        == std::vector<uint8_t>(1 + (i * 13) % 40, static_cast<uint8_t>(i)));
+    }
+
+    ::testing::internal::CaptureStdout();
+    addFrame('#', "T");
+    mParser.process();
+    ::testing::internal::GetCapturedStdout();
+    bool binaryAfterReturn = mParser.isBinaryMode();
+    addString("X5\n");
+    mParser.process();
+
+    // --- EXPECTATIONS ---
+    EXPECT_TRUE(binaryAfterSwitch);
+    EXPECT_EQ(ack.size(), CdcFrame::OVERHEAD_SIZE + 1);
+    EXPECT_EQ(numFrames, 300);
+    EXPECT_TRUE(framesIntact);
+    EXPECT_FALSE(binaryAfterReturn);
+    // X0 was sent before binary mode was acknowledged, so it is dropped
+    EXPECT_EQ(mCommandParser->mCommands, std::vector<std::string>({"X5"}));
+}
+
+TEST_F(UsbCdcTtyParserTest, textModeRequestDropsPartialFrame)
+{
+    // --- SETUP ---
+    ::testing::internal::CaptureStdout();
+    addString("#B\n");
+    mParser.process();
+    ::testing::internal::GetCapturedStdout();
+
+    // --- TEST EXECUTION ---
+    std::vector<uint8_t> frame(CdcFrame::OVERHEAD_SIZE + 4);
+    CdcFrame::encode(&frame[0], frame.size(), 'X', "abcd", 4);
+    mParser.addChars(reinterpret_cast<const char*>(&frame[0]), frame.size() - 1);
+    mParser.process();
+    mParser.requestTextMode();
+    mParser.process();
+    addString("X1\n");
+    mParser.process();
+
+    // --- EXPECTATIONS ---
+    EXPECT_FALSE(mParser.isBinaryMode());
+    EXPECT_TRUE(mCommandParser->mFrames.empty());
+    EXPECT_EQ(mCommandParser->mCommands, std::vector<std::string>({"X1"}));
+}
@@ -0,0 +1,233 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "hal/Usb/UsbFileTransfer.hpp"
+
+#include "MockClock.hpp"
+#include "MockUsbFile.hpp"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+class UsbFileTransferTest : public ::testing::Test
+{
+    public:
+        UsbFileTransferTest() :
+            mCurrentTimeUs(1000),
+            mTransfer(mClock),
+            mBuffer{}
+        {}
+
+    protected:
+        virtual void SetUp()
+        {
+            ON_CALL(mClock, getTimeUs()).WillByDefault(Invoke([this](){return mCurrentTimeUs;}));
+        }
+
+        uint64_t mCurrentTimeUs;
+        NiceMock<MockClock> mClock;
+        MockUsbFile mFile;
+        UsbFileTransfer mTransfer;
+        uint8_t mBuffer[512];
+};
+
+TEST_F(UsbFileTransferTest, readPendingUntilDataReady)
+{
+    // --- MOCKING ---
+    EXPECT_CALL(mFile, tryRead(5, mBuffer, 512, 20000))
+        .WillOnce(Return(0))
+        .WillOnce(Return(0))
+        .WillOnce(Return(512));
+
+    // --- TEST EXECUTION ---
+    int32_t result1 = mTransfer.read(&mFile, 5, mBuffer, 512, 20000);
+    bool pending1 = mTransfer.isPending();
+    mCurrentTimeUs += 10000;
+    int32_t result2 = mTransfer.read(&mFile, 5, mBuffer, 512, 20000);
+    mCurrentTimeUs += 5000;
+    int32_t result3 = mTransfer.read(&mFile, 5, mBuffer, 512, 20000);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(result1, 0);
+    EXPECT_TRUE(pending1);
+    EXPECT_EQ(result2, 0);
+    EXPECT_EQ(result3, 512);
+    EXPECT_FALSE(mTransfer.isPending());
+}
+
+TEST_F(UsbFileTransferTest, readTimesOutFromFirstCall)
+{
+    // --- MOCKING ---
+    EXPECT_CALL(mFile, tryRead(5, mBuffer, 512, 20000)).WillRepeatedly(Return(0));
+
+    // --- TEST EXECUTION ---
+    int32_t result1 = mTransfer.read(&mFile, 5, mBuffer, 512, 20000);
+    mCurrentTimeUs += 19999;
+    int32_t result2 = mTransfer.read(&mFile, 5, mBuffer, 512, 20000);
+    mCurrentTimeUs += 1;
+    int32_t result3 = mTransfer.read(&mFile, 5, mBuffer, 512, 20000);
+    bool pending3 = mTransfer.isPending();
+    // The host retrying the same block gets a fresh timeout
+    int32_t result4 = mTransfer.read(&mFile, 5, mBuffer, 512, 20000);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(result1, 0);
+    EXPECT_EQ(result2, 0);
+    EXPECT_EQ(result3, -1);
+    EXPECT_FALSE(pending3);
+    EXPECT_EQ(result4, 0);
+    EXPECT_TRUE(mTransfer.isPending());
+}
+
+TEST_F(UsbFileTransferTest, newRequestRestartsTimeout)
+{
+    // --- MOCKING ---
+    EXPECT_CALL(mFile, tryRead(5, _, _, _)).WillOnce(Return(0));
+    EXPECT_CALL(mFile, tryWrite(5, _, _, _)).WillOnce(Return(0)).WillOnce(Return(0));
+    EXPECT_CALL(mFile, tryWrite(6, _, _, _))
+        .WillOnce(Return(0))
+        .WillOnce(Return(0))
+        .WillOnce(Return(-1));
+
+    // --- TEST EXECUTION ---
+    int32_t result1 = mTransfer.read(&mFile, 5, mBuffer, 512, 20000);
+    mCurrentTimeUs += 15000;
+    // Same block in the other direction is a different request
+    int32_t result2 = mTransfer.write(&mFile, 5, mBuffer, 512, 20000);
+    mCurrentTimeUs += 15000;
+    int32_t result3 = mTransfer.write(&mFile, 5, mBuffer, 512, 20000);
+    int32_t result4 = mTransfer.write(&mFile, 6, mBuffer, 512, 20000);
+    mCurrentTimeUs += 19999;
+    int32_t result5 = mTransfer.write(&mFile, 6, mBuffer, 512, 20000);
+    // Failure from the file is passed straight through before the timeout elapses
+    int32_t result6 = mTransfer.write(&mFile, 6, mBuffer, 512, 20000);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(result1, 0);
+    EXPECT_EQ(result2, 0);
+    EXPECT_EQ(result3, 0);
+    EXPECT_EQ(result4, 0);
+    EXPECT_EQ(result5, 0);
+    EXPECT_EQ(result6, -1);
+    EXPECT_FALSE(mTransfer.isPending());
+}
+
+TEST_F(UsbFileTransferTest, cancelOnlyDropsMatchingFile)
+{
+    // --- SETUP ---
+    MockUsbFile otherFile;
+
+    // --- MOCKING ---
+    EXPECT_CALL(mFile, tryWrite(5, mBuffer, 512, 250000)).WillRepeatedly(Return(0));
+
+    // --- TEST EXECUTION ---
+    mTransfer.write(&mFile, 5, mBuffer, 512, 250000);
+    mTransfer.cancel(&otherFile);
+    bool pendingAfterOther = mTransfer.isPending();
+    mTransfer.cancel(&mFile);
+    bool pendingAfterFile = mTransfer.isPending();
+    mCurrentTimeUs += 250000;
+    // The timeout restarted since the old transfer was dropped
+    int32_t result = mTransfer.write(&mFile, 5, mBuffer, 512, 250000);
+
+    // --- EXPECTATIONS ---
+    EXPECT_TRUE(pendingAfterOther);
+    EXPECT_FALSE(pendingAfterFile);
+    EXPECT_EQ(result, 0);
+}
+
+TEST_F(UsbFileTransferTest, flushPendingUntilCommitted)
+{
+    // --- MOCKING ---
+    EXPECT_CALL(mFile, tryFlush())
+        .WillOnce(Return(0))
+        .WillOnce(Return(0))
+        .WillOnce(Return(1));
+    // Never blocks waiting for the write back
+    EXPECT_CALL(mFile, flush(_)).Times(0);
+
+    // --- TEST EXECUTION ---
+    int32_t result1 = mTransfer.flush(&mFile, 2000000);
+    bool pending1 = mTransfer.isPending();
+    mCurrentTimeUs += 1000000;
+    int32_t result2 = mTransfer.flush(&mFile, 2000000);
+    mCurrentTimeUs += 500000;
+    int32_t result3 = mTransfer.flush(&mFile, 2000000);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(result1, 0);
+    EXPECT_TRUE(pending1);
+    EXPECT_EQ(result2, 0);
+    EXPECT_EQ(result3, 1);
+    EXPECT_FALSE(mTransfer.isPending());
+}
+
+TEST_F(UsbFileTransferTest, flushFailsOnTimeoutOrWriteFailure)
+{
+    // --- MOCKING ---
+    EXPECT_CALL(mFile, tryFlush())
+        .WillOnce(Return(0))
+        .WillOnce(Return(0))
+        .WillOnce(Return(-1));
+
+    // --- TEST EXECUTION ---
+    int32_t result1 = mTransfer.flush(&mFile, 2000000);
+    mCurrentTimeUs += 2000000;
+    int32_t result2 = mTransfer.flush(&mFile, 2000000);
+    bool pending2 = mTransfer.isPending();
+    // A write which failed since the last flush is passed straight through
+    int32_t result3 = mTransfer.flush(&mFile, 2000000);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(result1, 0);
+    EXPECT_EQ(result2, -1);
+    EXPECT_FALSE(pending2);
+    EXPECT_EQ(result3, -1);
+    EXPECT_FALSE(mTransfer.isPending());
+}
+
+TEST_F(UsbFileTransferTest, flushAfterWriteRestartsTimeout)
+{
+    // --- MOCKING ---
+    EXPECT_CALL(mFile, tryWrite(5, _, _, _)).WillOnce(Return(0));
+    EXPECT_CALL(mFile, tryFlush()).WillOnce(Return(0)).WillOnce(Return(0));
+
+    // --- TEST EXECUTION ---
+    mTransfer.write(&mFile, 5, mBuffer, 512, 250000);
+    mCurrentTimeUs += 250000;
+    // Same file, but waiting on the write back is a different request
+    int32_t result1 = mTransfer.flush(&mFile, 2000000);
+    mCurrentTimeUs += 1999999;
+    int32_t result2 = mTransfer.flush(&mFile, 2000000);
+
+    // --- EXPECTATIONS ---
+    EXPECT_EQ(result1, 0);
+    EXPECT_EQ(result2, 0);
+    EXPECT_TRUE(mTransfer.isPending());
+}
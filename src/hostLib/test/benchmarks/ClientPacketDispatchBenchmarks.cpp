@@ -0,0 +1,160 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "clientLib/DreamcastMainPeripheral.hpp"
+#include "clientLib/DreamcastController.hpp"
+#include "clientLib/DreamcastPeripheral.hpp"
+#include "clientLib/DreamcastScreen.hpp"
+#include "clientLib/DreamcastStorage.hpp"
+#include "clientLib/DreamcastVibration.hpp"
+#include "hal/MapleBus/MaplePacket.hpp"
+#include "dreamcast_constants.h"
+#include "RamSystemMemory.hpp"
+#include "BenchmarkTimer.hpp"
+
+#include <memory>
+#include <stdio.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+// The timing here isn't pass/fail; it prints how many packets a client with a VMU and a vibration
+// pack attached can dispense per second when the host polls all of them round robin.
+
+//! Local copy of the VMU memory size which may be bound to a reference
+static const uint32_t VMU_MEMORY_SIZE = client::DreamcastStorage::MEMORY_SIZE_BYTES;
+
+static void ignoreScreen(const uint32_t* screen, uint32_t len) {}
+
+class ClientPacketDispatchBenchmark : public ::testing::Test
+{
+    public:
+        ClientPacketDispatchBenchmark() :
+            mMainPeripheral(
+                nullptr,
+                0x20,
+                0xFF,
+                0x00,
+                "Dreamcast Controller",
+                "Version 1.010,1998/09/28,315-6211-AB   ,Analog Module : The 4th Edition.5/8  +DF",
+                43.0,
+                50.0),
+            mVmu(std::make_shared<client::DreamcastPeripheral>(
+                0x01,
+                0xFF,
+                0x00,
+                "Visual Memory",
+                "Version 1.005,1999/04/15,315-6208-03,SEGA Visual Memory System BIOS",
+                12.4,
+                13.0)),
+            mPuruPuruPack(std::make_shared<client::DreamcastPeripheral>(
+                0x02,
+                0xFF,
+                0x00,
+                "Puru Puru Pack",
+                "Version 1.000,1998/11/10,315-6211-AH   ,Vibration Motor:1 , Fm:4 - 30Hz ,Pow:7",
+                20.0,
+                160.0))
+        {
+            mMainPeripheral.addFunction(std::make_shared<client::DreamcastController>());
+            mVmu->addFunction(std::make_shared<client::DreamcastStorage>(
+                std::make_shared<RamSystemMemory>(VMU_MEMORY_SIZE), 0));
+            mVmu->addFunction(std::make_shared<client::DreamcastScreen>(ignoreScreen, 48, 32));
+            mMainPeripheral.addSubPeripheral(mVmu);
+            mPuruPuruPack->addFunction(std::make_shared<client::DreamcastVibration>());
+            mMainPeripheral.addSubPeripheral(mPuruPuruPack);
+
+            // Connect all peripherals as player 1
+            const uint8_t addrs[3] = {0x20, 0x01, 0x02};
+            MaplePacket out;
+            for (uint8_t addr : addrs)
+            {
+                MaplePacket devInfo(
+                    {.command=COMMAND_DEVICE_INFO_REQUEST, .recipientAddr=addr, .senderAddr=0x00},
+                    nullptr,
+                    0);
+                mMainPeripheral.dispensePacket(devInfo, out);
+            }
+        }
+
+    protected:
+        client::DreamcastMainPeripheral mMainPeripheral;
+        std::shared_ptr<client::DreamcastPeripheral> mVmu;
+        std::shared_ptr<client::DreamcastPeripheral> mPuruPuruPack;
+};
+
+TEST_F(ClientPacketDispatchBenchmark, dispensePacket)
+{
+    static const uint32_t NUM_REPEATS = 100000;
+    static const uint32_t NUM_PACKETS = 5;
+    const MaplePacket packets[NUM_PACKETS] = {
+        MaplePacket({.command=COMMAND_GET_CONDITION, .recipientAddr=0x20, .senderAddr=0x00},
+                    DEVICE_FN_CONTROLLER),
+        MaplePacket({.command=COMMAND_GET_MEMORY_INFORMATION, .recipientAddr=0x01, .senderAddr=0x00},
+                    DEVICE_FN_STORAGE),
+        MaplePacket({.command=COMMAND_GET_CONDITION, .recipientAddr=0x02, .senderAddr=0x00},
+                    DEVICE_FN_VIBRATION),
+        // Function which the VMU doesn't have
+        MaplePacket({.command=COMMAND_GET_CONDITION, .recipientAddr=0x01, .senderAddr=0x00},
+                    DEVICE_FN_TIMER),
+        // Nothing attached at this address
+        MaplePacket({.command=COMMAND_GET_CONDITION, .recipientAddr=0x04, .senderAddr=0x00},
+                    DEVICE_FN_STORAGE)
+    };
+    const uint8_t expectedCommands[NUM_PACKETS] = {
+        COMMAND_RESPONSE_DATA_XFER,
+        COMMAND_RESPONSE_DATA_XFER,
+        COMMAND_RESPONSE_DATA_XFER,
+        COMMAND_RESPONSE_FUNCTION_CODE_NOT_SUPPORTED,
+        COMMAND_INVALID
+    };
+
+    MaplePacket out;
+    out.reservePayload(256);
+    uint32_t numResponses = 0;
+    BenchmarkTimer timer;
+    for (uint32_t r = 0; r < NUM_REPEATS; ++r)
+    {
+        for (uint32_t i = 0; i < NUM_PACKETS; ++i)
+        {
+            if (mMainPeripheral.dispensePacket(packets[i], out))
+            {
+                ++numResponses;
+            }
+        }
+    }
+    double ns = timer.elapsedNs();
+
+    EXPECT_EQ(numResponses, NUM_REPEATS * (NUM_PACKETS - 1));
+    for (uint32_t i = 0; i < NUM_PACKETS; ++i)
+    {
+        out.reset();
+        mMainPeripheral.dispensePacket(packets[i], out);
+        EXPECT_EQ(out.frame.command, expectedCommands[i]) << "packet " << i;
+    }
+
+    printf("Client dispensePacket: %6.1f ns per packet, %5.2f M packets per second\n",
+           ns / (NUM_REPEATS * NUM_PACKETS),
+           (NUM_REPEATS * NUM_PACKETS) * 1000.0 / ns);
+}
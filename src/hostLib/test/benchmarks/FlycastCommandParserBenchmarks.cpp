@@ -0,0 +1,217 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "NullMutex.hpp"
+#include "BenchmarkTimer.hpp"
+
+#include "FlycastCommandParser.hpp"
+#include "PrioritizedTxScheduler.hpp"
+#include "hal/Usb/CdcFrame.hpp"
+#include "dreamcast_constants.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+// These aren't pass/fail timing tests; they print the number of bytes each packet takes on the CDC
+// link in text and binary mode along with the time the parser takes to handle each.
+
+class FlycastBenchmarkIdentification : public SystemIdentification
+{
+    public:
+        std::uint32_t getSerialSize() override { return 4; }
+        void getSerial(char* buffer, std::uint32_t bufflen) override { strncpy(buffer, "1234", bufflen); }
+};
+
+//! Benchmark parameter: number of payload words in the request and in the response
+struct FlycastBenchmarkParam
+{
+    const char* name;
+    uint8_t requestCommand;
+    uint8_t numRequestWords;
+    uint8_t numResponseWords;
+};
+
+class FlycastCommandParserBenchmark : public ::testing::TestWithParam<FlycastBenchmarkParam>
+{
+    public:
+        FlycastCommandParserBenchmark() :
+            mScheduler(std::make_shared<PrioritizedTxScheduler>(mMutex, SENDER_ADDRESS)),
+            mParser(mIdentification, &mScheduler, &SENDER_ADDRESS, 1, {}, {})
+        {}
+
+    protected:
+        //! @returns a packet with incrementing payload words
+        static MaplePacket makePacket(uint8_t command, uint8_t numWords)
+        {
+            MaplePacket packet({.command=command, .recipientAddr=0x01, .senderAddr=SENDER_ADDRESS});
+            for (uint32_t i = 0; i < numWords; ++i)
+            {
+                packet.appendPayload(0x89ABCDEF * (i + 1));
+            }
+            return packet;
+        }
+
+        //! @returns the transmission added by the parser
+        std::shared_ptr<Transmission> popTransmission()
+        {
+            PrioritizedTxScheduler::ScheduleItem item = mScheduler->peekNext(0);
+            return mScheduler->popItem(item);
+        }
+
+        //! Full speed USB bulk transfers top out around 1.2 MB/s
+        static double wireUs(uint32_t numBytes)
+        {
+            return numBytes / 1.2;
+        }
+
+        static const uint8_t SENDER_ADDRESS;
+        static const uint32_t NUM_REPEATS = 1000;
+
+        NullMutex mMutex;
+        FlycastBenchmarkIdentification mIdentification;
+        std::shared_ptr<PrioritizedTxScheduler> mScheduler;
+        FlycastCommandParser mParser;
+};
+
+const uint8_t FlycastCommandParserBenchmark::SENDER_ADDRESS = 0x00;
+
+TEST_P(FlycastCommandParserBenchmark, textVsBinary)
+{
+    const FlycastBenchmarkParam& param = GetParam();
+    MaplePacket request = makePacket(param.requestCommand, param.numRequestWords);
+    MaplePacket responsePacket = makePacket(COMMAND_RESPONSE_DATA_XFER, param.numResponseWords);
+    MaplePacketView response(responsePacket);
+
+    // Text request as sent by flycast (parser sees the line without its EOL)
+    std::string textRequest = "X";
+    char wordStr[10];
+    snprintf(wordStr, sizeof(wordStr), " %08lX", (long unsigned int)request.frame.toWord());
+    textRequest += wordStr;
+    for (uint32_t word : request.payload)
+    {
+        snprintf(wordStr, sizeof(wordStr), " %08lX", (long unsigned int)word);
+        textRequest += wordStr;
+    }
+    textRequest += "\n";
+
+    // Binary request
+    std::vector<uint32_t> requestWords;
+    requestWords.push_back(request.frame.toWord());
+    requestWords.insert(requestWords.end(), request.payload.begin(), request.payload.end());
+    std::vector<uint8_t> binaryRequest(CdcFrame::OVERHEAD_SIZE + requestWords.size() * sizeof(uint32_t));
+    CdcFrame::encode(&binaryRequest[0],
+                     binaryRequest.size(),
+                     'X',
+                     &requestWords[0],
+                     requestWords.size() * sizeof(uint32_t));
+
+    // Text: parse the request, then format the response
+    std::shared_ptr<Transmission> textTx;
+    BenchmarkTimer timer;
+    for (uint32_t i = 0; i < NUM_REPEATS; ++i)
+    {
+        mParser.submit(textRequest.c_str(), textRequest.size() - 1);
+        textTx = popTransmission();
+        ASSERT_NE(textTx, nullptr);
+    }
+    double textParseUs = timer.usPerOp(NUM_REPEATS);
+
+    ::testing::internal::CaptureStdout();
+    timer.restart();
+    for (uint32_t i = 0; i < NUM_REPEATS; ++i)
+    {
+        textTx->transmitter->txComplete(&response, textTx);
+    }
+    fflush(stdout);
+    double textRespondUs = timer.usPerOp(NUM_REPEATS);
+    uint32_t textResponseSize = ::testing::internal::GetCapturedStdout().size() / NUM_REPEATS;
+
+    // Binary: decode and parse the request, then encode the response
+    std::shared_ptr<Transmission> binaryTx;
+    timer.restart();
+    for (uint32_t i = 0; i < NUM_REPEATS; ++i)
+    {
+        uint32_t frameLen = 0;
+        char cmd = '\0';
+        uint32_t dataOffset = 0;
+        uint32_t dataLen = 0;
+        ASSERT_EQ(CdcFrame::decode(&binaryRequest[0], binaryRequest.size(), frameLen, cmd, dataOffset, dataLen),
+                  CdcFrame::DECODE_OK);
+        ASSERT_TRUE(mParser.submitBinary(&binaryRequest[dataOffset], dataLen));
+        binaryTx = popTransmission();
+        ASSERT_NE(binaryTx, nullptr);
+    }
+    double binaryParseUs = timer.usPerOp(NUM_REPEATS);
+
+    ::testing::internal::CaptureStdout();
+    timer.restart();
+    for (uint32_t i = 0; i < NUM_REPEATS; ++i)
+    {
+        binaryTx->transmitter->txComplete(&response, binaryTx);
+    }
+    double binaryRespondUs = timer.usPerOp(NUM_REPEATS);
+    uint32_t binaryResponseSize = ::testing::internal::GetCapturedStdout().size() / NUM_REPEATS;
+
+    // Both must carry the same packet
+    EXPECT_EQ(textTx->packet->frame.toWord(), binaryTx->packet->frame.toWord());
+    EXPECT_EQ(textTx->packet->payload, binaryTx->packet->payload);
+
+    uint32_t textBytes = textRequest.size() + textResponseSize;
+    uint32_t binaryBytes = binaryRequest.size() + binaryResponseSize;
+    printf("Flycast %-10s text:   request %4lu B, response %4lu B, parse %6.2f us, respond %6.2f us, "
+           "wire %7.1f us\n",
+           param.name,
+           (unsigned long)textRequest.size(),
+           (unsigned long)textResponseSize,
+           textParseUs,
+           textRespondUs,
+           wireUs(textBytes));
+    printf("Flycast %-10s binary: request %4lu B, response %4lu B, parse %6.2f us, respond %6.2f us, "
+           "wire %7.1f us\n",
+           param.name,
+           (unsigned long)binaryRequest.size(),
+           (unsigned long)binaryResponseSize,
+           binaryParseUs,
+           binaryRespondUs,
+           wireUs(binaryBytes));
+    EXPECT_LT(binaryBytes, textBytes);
+}
+
+INSTANTIATE_TEST_SUITE_P(Packets,
+                         FlycastCommandParserBenchmark,
+                         ::testing::Values(
+                             // 48 word LCD write: function code, location, then 48 words of pixels
+                             FlycastBenchmarkParam{"LcdWrite", COMMAND_BLOCK_WRITE, 50, 0},
+                             // Block read: function code and location out, 130 words back
+                             FlycastBenchmarkParam{"BlockRead", COMMAND_BLOCK_READ, 2, 130}),
+                         [](const ::testing::TestParamInfo<FlycastBenchmarkParam>& info)
+                         {
+                             return std::string(info.param.name);
+                         });
@@ -0,0 +1,171 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NullMutex.hpp"
+#include "BenchmarkTimer.hpp"
+
+#include "PrioritizedTxScheduler.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdio.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+// These aren't pass/fail timing tests; they print the average cost of each scheduler operation at
+// a few different queue depths while checking that the schedule behaves as expected along the way.
+
+class PrioritizedTxSchedulerBenchmark : public ::testing::TestWithParam<uint32_t>
+{
+    public:
+        PrioritizedTxSchedulerBenchmark() : scheduler(mutex, 0x00, 2, 1024), mRand(0x12345678) {}
+
+    protected:
+        //! Simple LCG so that each run uses the same sequence
+        uint32_t nextRand()
+        {
+            mRand = mRand * 1664525 + 1013904223;
+            return mRand >> 8;
+        }
+
+        //! Fills the schedule with n items of mixed priority, time, and recipient
+        //! @returns the number of items added which don't auto repeat
+        uint32_t fill(uint32_t n)
+        {
+            uint32_t numOneShot = 0;
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                uint8_t priority = nextRand() % 3;
+                uint64_t txTime = 1000 + (nextRand() % 100000);
+                uint8_t recipientAddr = RECIPIENTS[nextRand() % NUM_RECIPIENTS];
+                MaplePacket packet({.command=0x09, .recipientAddr=recipientAddr}, 0x00000001);
+                // A handful of polling items repeat, like controller condition polls would
+                uint32_t autoRepeatUs = (i < NUM_AUTO_REPEAT) ? 16000 : 0;
+                uint32_t id = scheduler.add(priority, txTime, nullptr, packet, true, 3, autoRepeatUs);
+                EXPECT_NE(id, 0u);
+                if (autoRepeatUs == 0)
+                {
+                    ++numOneShot;
+                }
+            }
+            return numOneShot;
+        }
+
+        static const uint32_t NUM_RECIPIENTS = 6;
+        static const uint8_t RECIPIENTS[NUM_RECIPIENTS];
+        static const uint32_t NUM_AUTO_REPEAT = 8;
+        static const uint32_t NUM_REPEATS = 20;
+
+        NullMutex mutex;
+        PrioritizedTxScheduler scheduler;
+        uint32_t mRand;
+};
+
+const uint8_t PrioritizedTxSchedulerBenchmark::RECIPIENTS[NUM_RECIPIENTS] =
+    {0x20, 0x01, 0x02, 0x60, 0x41, 0xA0};
+
+TEST_P(PrioritizedTxSchedulerBenchmark, addPeekPopCancel)
+{
+    const uint32_t n = GetParam();
+    double addNs = 0;
+    double peekNs = 0;
+    double popNs = 0;
+    double cancelNs = 0;
+
+    for (uint32_t r = 0; r < NUM_REPEATS; ++r)
+    {
+        // Add
+        BenchmarkTimer timer;
+        uint32_t numOneShot = fill(n);
+        addNs += timer.nsPerOp(n);
+
+        // Peek while nothing is ready yet
+        timer.restart();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            PrioritizedTxScheduler::ScheduleItem item = scheduler.peekNext(i % 1000);
+            ASSERT_EQ(item.getTx(), nullptr);
+        }
+        peekNs += timer.nsPerOp(n);
+
+        // Peek and pop until only auto repeat items remain, advancing time as the bus would
+        uint64_t time = 0;
+        uint32_t numPopped = 0;
+        timer.restart();
+        while (numOneShot > 0)
+        {
+            PrioritizedTxScheduler::ScheduleItem item = scheduler.peekNext(time);
+            std::shared_ptr<Transmission> tx = scheduler.popItem(item);
+            if (tx != nullptr)
+            {
+                time += tx->txDurationUs;
+                ++numPopped;
+                if (tx->autoRepeatUs == 0)
+                {
+                    --numOneShot;
+                }
+            }
+            else
+            {
+                time += 100;
+            }
+        }
+        popNs += timer.nsPerOp(numPopped);
+
+        // Only auto repeat items remain, so top back up then cancel everything by recipient and ID
+        uint32_t numRemaining = 0;
+        for (uint32_t i = 0; i < NUM_RECIPIENTS; ++i)
+        {
+            numRemaining += scheduler.countRecipients(RECIPIENTS[i]);
+        }
+        EXPECT_EQ(numRemaining, std::min(n, (uint32_t)NUM_AUTO_REPEAT));
+        fill(n - numRemaining);
+
+        timer.restart();
+        uint32_t numCanceled = 0;
+        for (uint32_t i = 0; i < NUM_RECIPIENTS / 2; ++i)
+        {
+            numCanceled += scheduler.cancelByRecipient(RECIPIENTS[i]);
+        }
+        for (uint32_t id = 1; numCanceled < n; ++id)
+        {
+            numCanceled += scheduler.cancelById(id);
+        }
+        cancelNs += timer.nsPerOp(n);
+
+        EXPECT_EQ(numCanceled, n);
+        EXPECT_EQ(scheduler.cancelAll(), 0);
+    }
+
+    printf("PrioritizedTxScheduler %4lu queued: add %7.1f ns, peek %7.1f ns, pop %7.1f ns, cancel %7.1f ns\n",
+           (unsigned long)n,
+           addNs / NUM_REPEATS,
+           peekNs / NUM_REPEATS,
+           popNs / NUM_REPEATS,
+           cancelNs / NUM_REPEATS);
+}
+
+INSTANTIATE_TEST_SUITE_P(QueueDepth,
+                         PrioritizedTxSchedulerBenchmark,
+                         ::testing::Values(10, 100, 1000));
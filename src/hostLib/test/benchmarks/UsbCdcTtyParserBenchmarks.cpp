@@ -0,0 +1,204 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "UsbCdcTtyParser.hpp"
+#include "FlycastCommandParser.hpp"
+#include "PrioritizedTxScheduler.hpp"
+
+#include "NullMutex.hpp"
+#include "BenchmarkTimer.hpp"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+// These aren't pass/fail timing tests; they replay flycast's CDC traffic through the TTY parser and
+// print how long each command takes to reach the scheduler and how a backlog of commands drains.
+
+class TtyBenchmarkIdentification : public SystemIdentification
+{
+    public:
+        std::uint32_t getSerialSize() override { return 4; }
+        void getSerial(char* buffer, std::uint32_t bufflen) override { strncpy(buffer, "1234", bufflen); }
+};
+
+class SteadyClock : public ClockInterface
+{
+    public:
+        uint64_t getTimeUs() const override
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+};
+
+#define PIXELS_8 " 00000000 FFFFFFFF 0F0F0F0F F0F0F0F0 00000000 FFFFFFFF 0F0F0F0F F0F0F0F0"
+
+//! 8 frames of flycast traffic for a controller with a VMU: condition every frame, an LCD write on
+//! the first frame, and a VMU block read on the fifth
+static const char* const RECORDED_STREAM[] = {
+    "X 09200001 00000001\n",
+    "X 0C010032 00000004 00000000" PIXELS_8 PIXELS_8 PIXELS_8 PIXELS_8 PIXELS_8 PIXELS_8 "\n",
+    "X 09200001 00000001\n",
+    "X 09200001 00000001\n",
+    "X 09200001 00000001\n",
+    "X 09200001 00000001\n",
+    "X 0B010002 00000002 00000012\n",
+    "X 09200001 00000001\n",
+    "X 09200001 00000001\n",
+    "X 09200001 00000001\n"
+};
+
+static const uint32_t NUM_RECORDED_COMMANDS = sizeof(RECORDED_STREAM) / sizeof(RECORDED_STREAM[0]);
+
+class UsbCdcTtyParserBenchmark : public ::testing::Test
+{
+    public:
+        UsbCdcTtyParserBenchmark() :
+            mScheduler(std::make_shared<PrioritizedTxScheduler>(mMutex, SENDER_ADDRESS)),
+            mParser(mMutex, 'h', mClock)
+        {
+            mParser.addCommandParser(std::make_shared<FlycastCommandParser>(
+                mIdentification, &mScheduler, &SENDER_ADDRESS, 1,
+                std::vector<std::shared_ptr<PlayerData>>(),
+                std::vector<std::shared_ptr<DreamcastMainNode>>()));
+        }
+
+    protected:
+        //! @returns the number of transmissions the flycast parser scheduled, removing them
+        uint32_t popAll()
+        {
+            uint32_t count = 0;
+            PrioritizedTxScheduler::ScheduleItem item;
+            while ((item = mScheduler->peekNext(0)).getTx() != nullptr)
+            {
+                mScheduler->popItem(item);
+                ++count;
+            }
+            return count;
+        }
+
+        static const uint8_t SENDER_ADDRESS;
+        //! Full speed CDC delivers data to cdc_task() in packets of this size
+        static const uint32_t USB_PACKET_SIZE = 64;
+
+        NullMutex mMutex;
+        SteadyClock mClock;
+        TtyBenchmarkIdentification mIdentification;
+        std::shared_ptr<PrioritizedTxScheduler> mScheduler;
+        UsbCdcTtyParser mParser;
+};
+
+const uint8_t UsbCdcTtyParserBenchmark::SENDER_ADDRESS = 0x00;
+
+TEST_F(UsbCdcTtyParserBenchmark, replayRecordedStream)
+{
+    // --- SETUP ---
+    static const uint32_t NUM_REPLAYS = 500;
+    std::string stream;
+    for (uint32_t i = 0; i < NUM_RECORDED_COMMANDS; ++i)
+    {
+        stream += RECORDED_STREAM[i];
+    }
+
+    // --- TEST EXECUTION ---
+    uint32_t numScheduled = 0;
+    uint32_t numProcessCalls = 0;
+    BenchmarkTimer timer;
+    for (uint32_t replay = 0; replay < NUM_REPLAYS; ++replay)
+    {
+        for (uint32_t i = 0; i < stream.size(); i += USB_PACKET_SIZE)
+        {
+            uint32_t len = stream.size() - i;
+            if (len > USB_PACKET_SIZE)
+            {
+                len = USB_PACKET_SIZE;
+            }
+            mParser.addChars(&stream[i], len);
+            mParser.process();
+            ++numProcessCalls;
+            numScheduled += popAll();
+        }
+    }
+    double totalUs = timer.elapsedNs() / 1000;
+
+    // --- EXPECTATIONS ---
+    uint32_t numCommands = NUM_REPLAYS * NUM_RECORDED_COMMANDS;
+    printf("TTY replay: %lu commands (%lu bytes) in %lu USB packets, %.3f us per command\n",
+           (unsigned long)numCommands,
+           (unsigned long)(NUM_REPLAYS * stream.size()),
+           (unsigned long)numProcessCalls,
+           totalUs / numCommands);
+    EXPECT_EQ(numScheduled, numCommands);
+}
+
+TEST_F(UsbCdcTtyParserBenchmark, drainBacklog)
+{
+    // --- SETUP ---
+    static const uint32_t BACKLOG_SIZE = 60;
+    static const uint32_t NUM_REPEATS = 200;
+    const std::string command = RECORDED_STREAM[0];
+
+    for (uint32_t budgetUs : {0u, UsbCdcTtyParser::DEFAULT_PROCESS_BUDGET_US})
+    {
+        mParser.setProcessBudgetUs(budgetUs);
+
+        // --- TEST EXECUTION ---
+        uint32_t numScheduled = 0;
+        uint32_t numProcessCalls = 0;
+        double totalUs = 0;
+        for (uint32_t repeat = 0; repeat < NUM_REPEATS; ++repeat)
+        {
+            for (uint32_t i = 0; i < BACKLOG_SIZE; ++i)
+            {
+                mParser.addChars(command.c_str(), command.size());
+            }
+
+            uint32_t numRepeatScheduled = 0;
+            BenchmarkTimer timer;
+            while (numRepeatScheduled < BACKLOG_SIZE)
+            {
+                mParser.process();
+                ++numProcessCalls;
+                numRepeatScheduled += popAll();
+            }
+            totalUs += timer.elapsedNs() / 1000;
+            numScheduled += numRepeatScheduled;
+        }
+
+        // --- EXPECTATIONS ---
+        // A budget of 0 handles a single command per call, which is how process() used to behave
+        printf("TTY backlog of %lu, budget %3lu us: %5.1f process() calls to drain, %.3f us per command\n",
+               (unsigned long)BACKLOG_SIZE,
+               (unsigned long)budgetUs,
+               (double)numProcessCalls / NUM_REPEATS,
+               totalUs / numScheduled);
+        EXPECT_EQ(numScheduled, BACKLOG_SIZE * NUM_REPEATS);
+    }
+}
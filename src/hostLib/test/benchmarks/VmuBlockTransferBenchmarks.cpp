@@ -0,0 +1,205 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RamSystemMemory.hpp"
+
+#include "clientLib/DreamcastStorage.hpp"
+#include "hal/MapleBus/MaplePacket.hpp"
+#include "dreamcast_constants.h"
+#include "BenchmarkTimer.hpp"
+
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+// These aren't pass/fail timing tests; they print the CPU time spent on each VMU block as it is
+// handed between memory and a packet, raw as it is done now versus flipping each word as it was
+// done before raw payloads existed. With raw payloads, the bus moves block data untouched.
+
+static const uint32_t MEMORY_SIZE_BYTES = client::DreamcastStorage::MEMORY_SIZE_BYTES;
+
+class VmuBlockTransferBenchmark : public ::testing::Test
+{
+    public:
+        VmuBlockTransferBenchmark() :
+            mMemory(std::make_shared<RamSystemMemory>(MEMORY_SIZE_BYTES)),
+            mStorage(mMemory, 0)
+        {
+            uint32_t word = 0x12345678;
+            for (uint32_t offset = 0; offset < MEMORY_SIZE_BYTES; offset += 4)
+            {
+                word = word * 1664525 + 1013904223;
+                uint32_t size = sizeof(word);
+                mMemory->write(offset, &word, size);
+            }
+        }
+
+    protected:
+        //! @returns pointer to the words of the given block in memory
+        const uint32_t* blockWords(uint32_t blockNum)
+        {
+            uint32_t size = BLOCK_BYTES;
+            return reinterpret_cast<const uint32_t*>(mMemory->read(blockNum * BLOCK_BYTES, size));
+        }
+
+        static const uint32_t BLOCK_BYTES = 512;
+        static const uint32_t BLOCK_WORDS = 128;
+        static const uint32_t NUM_BLOCKS = 256;
+        static const uint32_t NUM_REPEATS = 200;
+
+        std::shared_ptr<RamSystemMemory> mMemory;
+        client::DreamcastStorage mStorage;
+};
+
+TEST_F(VmuBlockTransferBenchmark, clientBlockReadResponse)
+{
+    MaplePacket in({.command=COMMAND_BLOCK_READ, .recipientAddr=0x01, .senderAddr=0x00}, 0);
+    MaplePacket out;
+    out.reservePayload(2 + BLOCK_WORDS);
+
+    // Flipped copy of each word, as appendPayloadFlipWords() was used before
+    BenchmarkTimer timer;
+    for (uint32_t r = 0; r < NUM_REPEATS; ++r)
+    {
+        for (uint32_t blockNum = 0; blockNum < NUM_BLOCKS; ++blockNum)
+        {
+            uint32_t header[2] = {DEVICE_FN_STORAGE, blockNum};
+            out.setPayload(header, 2);
+            out.appendPayloadFlipWords(blockWords(blockNum), BLOCK_WORDS);
+        }
+    }
+    double flippedNs = timer.nsPerOp(NUM_REPEATS * NUM_BLOCKS);
+    uint32_t flippedWord = out.payload[2];
+
+    // Full handling of the command by client storage, which now appends raw words
+    uint32_t numHandled = 0;
+    timer.restart();
+    for (uint32_t r = 0; r < NUM_REPEATS; ++r)
+    {
+        for (uint32_t blockNum = 0; blockNum < NUM_BLOCKS; ++blockNum)
+        {
+            uint32_t payload[2] = {DEVICE_FN_STORAGE, blockNum};
+            in.setPayload(payload, 2);
+            out.reset();
+            if (mStorage.handlePacket(in, out))
+            {
+                ++numHandled;
+            }
+        }
+    }
+    double rawNs = timer.nsPerOp(NUM_REPEATS * NUM_BLOCKS);
+
+    EXPECT_EQ(numHandled, NUM_REPEATS * NUM_BLOCKS);
+    ASSERT_EQ(out.payload.size(), 2 + BLOCK_WORDS);
+    EXPECT_TRUE(out.hasRawPayload());
+    EXPECT_EQ(memcmp(&out.payload[2], blockWords(NUM_BLOCKS - 1), BLOCK_BYTES), 0);
+    EXPECT_EQ(flippedWord, MaplePacket::flipWordBytes(out.payload[2]));
+
+    printf("VMU client block read response: flipped %7.1f ns per block, raw (full command) %7.1f ns per block\n",
+           flippedNs,
+           rawNs);
+}
+
+TEST_F(VmuBlockTransferBenchmark, hostBlockReadAndWrite)
+{
+    uint32_t cache[BLOCK_WORDS];
+    MaplePacket packet;
+    packet.reservePayload(2 + BLOCK_WORDS);
+    uint32_t checksum = 0;
+
+    // Receive: flipping each word into the cache as before
+    BenchmarkTimer timer;
+    for (uint32_t r = 0; r < NUM_REPEATS; ++r)
+    {
+        for (uint32_t blockNum = 0; blockNum < NUM_BLOCKS; ++blockNum)
+        {
+            const uint32_t* received = blockWords(blockNum);
+            for (uint32_t i = 0; i < BLOCK_WORDS; ++i)
+            {
+                cache[i] = MaplePacket::flipWordBytes(received[i]);
+            }
+            checksum += cache[blockNum % BLOCK_WORDS];
+        }
+    }
+    double flippedReadNs = timer.nsPerOp(NUM_REPEATS * NUM_BLOCKS);
+
+    // Receive: raw words copied straight into the cache
+    timer.restart();
+    for (uint32_t r = 0; r < NUM_REPEATS; ++r)
+    {
+        for (uint32_t blockNum = 0; blockNum < NUM_BLOCKS; ++blockNum)
+        {
+            memcpy(cache, blockWords(blockNum), sizeof(cache));
+            checksum += cache[blockNum % BLOCK_WORDS];
+        }
+    }
+    double rawReadNs = timer.nsPerOp(NUM_REPEATS * NUM_BLOCKS);
+
+    // Send: the 4 write phases of each block, flipped as before
+    timer.restart();
+    for (uint32_t r = 0; r < NUM_REPEATS; ++r)
+    {
+        for (uint32_t blockNum = 0; blockNum < NUM_BLOCKS; ++blockNum)
+        {
+            for (uint32_t phase = 0; phase < 4; ++phase)
+            {
+                uint32_t header[2] = {DEVICE_FN_STORAGE, blockNum | (phase << 16)};
+                packet.setPayload(header, 2);
+                packet.appendPayloadFlipWords(&blockWords(blockNum)[phase * 32], 32);
+            }
+            checksum += packet.payload[2];
+        }
+    }
+    double flippedWriteNs = timer.nsPerOp(NUM_REPEATS * NUM_BLOCKS);
+
+    // Send: raw
+    timer.restart();
+    for (uint32_t r = 0; r < NUM_REPEATS; ++r)
+    {
+        for (uint32_t blockNum = 0; blockNum < NUM_BLOCKS; ++blockNum)
+        {
+            for (uint32_t phase = 0; phase < 4; ++phase)
+            {
+                uint32_t header[2] = {DEVICE_FN_STORAGE, blockNum | (phase << 16)};
+                packet.setPayload(header, 2);
+                packet.appendPayloadRaw(&blockWords(blockNum)[phase * 32], 32);
+            }
+            checksum += packet.payload[2];
+        }
+    }
+    double rawWriteNs = timer.nsPerOp(NUM_REPEATS * NUM_BLOCKS);
+
+    EXPECT_TRUE(packet.hasRawPayload());
+    EXPECT_EQ(memcmp(cache, blockWords(NUM_BLOCKS - 1), sizeof(cache)), 0);
+
+    printf("VMU host block read:  flipped %7.1f ns per block, raw %7.1f ns per block\n",
+           flippedReadNs,
+           rawReadNs);
+    printf("VMU host block write: flipped %7.1f ns per block, raw %7.1f ns per block (checksum %08lx)\n",
+           flippedWriteNs,
+           rawWriteNs,
+           (unsigned long)checksum);
+}
@@ -0,0 +1,69 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+
+//! Measures the host CPU time taken by a benchmark loop
+class BenchmarkTimer
+{
+    public:
+        //! Constructor which starts timing
+        BenchmarkTimer() :
+            mStart(std::chrono::steady_clock::now())
+        {}
+
+        //! Starts timing over
+        void restart()
+        {
+            mStart = std::chrono::steady_clock::now();
+        }
+
+        //! @returns the number of nanoseconds since timing started
+        double elapsedNs() const
+        {
+            std::chrono::steady_clock::duration d = std::chrono::steady_clock::now() - mStart;
+            return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+        }
+
+        //! @param[in] numOps  The number of operations executed since timing started
+        //! @returns the average number of nanoseconds per operation
+        double nsPerOp(uint32_t numOps) const
+        {
+            return elapsedNs() / numOps;
+        }
+
+        //! @param[in] numOps  The number of operations executed since timing started
+        //! @returns the average number of microseconds per operation
+        double usPerOp(uint32_t numOps) const
+        {
+            return nsPerOp(numOps) / 1000;
+        }
+
+    private:
+        //! The time at which timing started
+        std::chrono::steady_clock::time_point mStart;
+};
@@ -0,0 +1,166 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "hal/System/FlashInterface.hpp"
+
+#include <functional>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+//! NOR flash held in RAM which counts erase and program operations per sector
+class FakeFlash : public FlashInterface
+{
+    public:
+        //! Constructor - flash starts out erased
+        //! @param[in] size  Size of flash in bytes (multiple of SECTOR_SIZE)
+        FakeFlash(uint32_t size) :
+            mMemory(size, 0xFF),
+            mSectorEraseCounts(size / SECTOR_SIZE, 0),
+            mNumErases(0),
+            mNumPagePrograms(0),
+            mNumBadPrograms(0),
+            mOnOperation(),
+            mOpsUntilPowerLoss(NO_POWER_LOSS)
+        {}
+
+        const uint8_t* read(uint32_t offset) override
+        {
+            return &mMemory[offset];
+        }
+
+        void eraseSector(uint32_t offset) override
+        {
+            if (mOnOperation)
+            {
+                mOnOperation();
+            }
+            uint32_t len = SECTOR_SIZE;
+            if (!powerOp(len))
+            {
+                return;
+            }
+            memset(&mMemory[offset], 0xFF, len);
+            ++mSectorEraseCounts[offset / SECTOR_SIZE];
+            ++mNumErases;
+        }
+
+        void programPage(uint32_t offset, const uint8_t* data) override
+        {
+            if (mOnOperation)
+            {
+                mOnOperation();
+            }
+            uint32_t len = PAGE_SIZE;
+            if (!powerOp(len))
+            {
+                return;
+            }
+            for (uint32_t i = 0; i < len; ++i)
+            {
+                // Like real flash, programming may only flip bits from 1 to 0
+                if ((mMemory[offset + i] & data[i]) != data[i])
+                {
+                    ++mNumBadPrograms;
+                }
+                mMemory[offset + i] &= data[i];
+            }
+            ++mNumPagePrograms;
+        }
+
+        //! Sets flash contents directly, without counting anything
+        void preload(uint32_t offset, const void* data, uint32_t size)
+        {
+            memcpy(&mMemory[offset], data, size);
+        }
+
+        //! Resets all counters
+        void resetCounts()
+        {
+            memset(mSectorEraseCounts.data(), 0, mSectorEraseCounts.size() * sizeof(uint32_t));
+            mNumErases = 0;
+            mNumPagePrograms = 0;
+            mNumBadPrograms = 0;
+        }
+
+        //! Simulates loss of power: the given number of erase/program operations complete, the
+        //! one after that only completes halfway, and nothing after that has any effect
+        void losePowerAfter(uint32_t numOps)
+        {
+            mOpsUntilPowerLoss = numOps;
+        }
+
+        //! Makes flash operations work again after losePowerAfter()
+        void restorePower()
+        {
+            mOpsUntilPowerLoss = NO_POWER_LOSS;
+        }
+
+        //! @returns true iff power was lost
+        bool isPowerLost() const
+        {
+            return (mOpsUntilPowerLoss < 0);
+        }
+
+        //! Flash contents
+        std::vector<uint8_t> mMemory;
+        //! Number of erases of each sector
+        std::vector<uint32_t> mSectorEraseCounts;
+        //! Total number of sector erases
+        uint32_t mNumErases;
+        //! Total number of page programs
+        uint32_t mNumPagePrograms;
+        //! Number of page programs which tried to flip a bit from 0 to 1
+        uint32_t mNumBadPrograms;
+        //! When set, called at the start of each erase or program operation, i.e. while flash is busy
+        std::function<void()> mOnOperation;
+
+    private:
+        //! Counts down to power loss for an erase or program operation
+        //! @param[in,out] len  Number of bytes the operation affects, set to the number it completes
+        //! @returns true iff the operation has any effect
+        bool powerOp(uint32_t& len)
+        {
+            if (mOpsUntilPowerLoss == NO_POWER_LOSS)
+            {
+                return true;
+            }
+            else if (mOpsUntilPowerLoss < 0)
+            {
+                return false;
+            }
+            else if (mOpsUntilPowerLoss == 0)
+            {
+                len /= 2;
+            }
+            --mOpsUntilPowerLoss;
+            return true;
+        }
+
+        //! Value of mOpsUntilPowerLoss when power is never lost
+        static const int64_t NO_POWER_LOSS = INT64_MAX;
+        //! Number of operations left before power is lost, negative once it is lost
+        int64_t mOpsUntilPowerLoss;
+};
@@ -0,0 +1,132 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "hal/MapleBus/MapleBusInterface.hpp"
+#include "hal/MapleBus/MaplePacket.hpp"
+#include "hal/MapleBus/SerializedMaplePacket.hpp"
+
+#include <limits>
+#include <stdint.h>
+#include <string.h>
+
+//! Client side bus which reads back the same request every time it is processed
+class LoopbackClientBus : public MapleBusInterface
+{
+    public:
+        LoopbackClientBus() :
+            mRequest(),
+            mRequestLen(0),
+            mWriteBuffer(),
+            mWriteLen(0),
+            mSerialized(nullptr),
+            mNumWrites(0)
+        {}
+
+        //! Sets the request which every call to processEvents() completes reading
+        void setRequest(const MaplePacket& request)
+        {
+            mRequest[0] = request.getFrameWord();
+            memcpy(&mRequest[1], request.payload.data(), request.payload.size() * sizeof(uint32_t));
+            mRequestLen = request.payload.size() + 1;
+        }
+
+        bool write(const MaplePacket& packet,
+                   bool autostartRead,
+                   uint64_t readTimeoutUs=MAPLE_RESPONSE_TIMEOUT_US) override
+        {
+            // Laid out as MapleBus::write() lays out a packet without raw payload
+            uint32_t crc32 = packet.getFrameWord();
+            uint32_t len = 0;
+            mWriteBuffer[len++] = MaplePacket::flipWordBytes(packet.getNumTotalBits());
+            mWriteBuffer[len++] = packet.getFrameWord();
+            for (uint32_t i = 0; i < packet.payload.size(); ++i)
+            {
+                crc32 ^= packet.payload[i];
+                mWriteBuffer[len++] = packet.payload[i];
+            }
+            crc32 ^= (crc32 >> 16);
+            crc32 ^= (crc32 >> 8);
+            mWriteBuffer[len++] = (crc32 & 0xFF);
+            mWriteLen = len;
+            mSerialized = nullptr;
+            ++mNumWrites;
+            return true;
+        }
+
+        bool writeSerialized(const SerializedMaplePacket& packet,
+                             bool autostartRead,
+                             uint64_t readTimeoutUs=MAPLE_RESPONSE_TIMEOUT_US) override
+        {
+            // A real bus would start DMA right from the packet's words
+            mSerialized = &packet;
+            ++mNumWrites;
+            return true;
+        }
+
+        bool startRead(uint64_t readTimeoutUs=std::numeric_limits<uint64_t>::max()) override
+        {
+            return true;
+        }
+
+        Status processEvents(uint64_t currentTimeUs) override
+        {
+            Status status;
+            status.phase = Phase::READ_COMPLETE;
+            status.readBuffer = mRequest;
+            status.readBufferLen = mRequestLen;
+            return status;
+        }
+
+        bool isBusy() override
+        {
+            return false;
+        }
+
+        //! @returns the words of the last write, starting with the bit count
+        const uint32_t* getWrittenWords() const
+        {
+            return (mSerialized != nullptr) ? mSerialized->getWords() : mWriteBuffer;
+        }
+
+        //! @returns the number of words in the last write
+        uint32_t getWrittenLen() const
+        {
+            return (mSerialized != nullptr) ? mSerialized->getNumWords() : mWriteLen;
+        }
+
+        //! @returns true iff the last write was of a serialized packet
+        bool wasSerialized() const { return (mSerialized != nullptr); }
+
+        //! @returns the number of writes made
+        uint32_t getNumWrites() const { return mNumWrites; }
+
+    private:
+        uint32_t mRequest[8];
+        uint32_t mRequestLen;
+        uint32_t mWriteBuffer[256];
+        uint32_t mWriteLen;
+        const SerializedMaplePacket* mSerialized;
+        uint32_t mNumWrites;
+};
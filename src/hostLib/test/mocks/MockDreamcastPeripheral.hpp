@@ -49,7 +49,7 @@ class MockDreamcastPeripheral : public DreamcastPeripheral
 
         MOCK_METHOD(void,
                     txComplete,
-                    (std::shared_ptr<const MaplePacket> packet,
+                    (const MaplePacketView* packet,
                         std::shared_ptr<const Transmission> tx),
                     (override));
 
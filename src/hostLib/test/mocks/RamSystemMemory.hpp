@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2022-2025 James Smith of OrangeFox86
+// https://github.com/OrangeFox86/DreamcastControllerUsbPico
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "hal/System/SystemMemory.hpp"
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+//! System memory held entirely in RAM, initialized to 0xFF like erased flash
+class RamSystemMemory : public SystemMemory
+{
+    public:
+        RamSystemMemory(uint32_t size) : mMemory(size, 0xFF), mLastActivityTime(0) {}
+
+        uint32_t getMemorySize() override
+        {
+            return mMemory.size();
+        }
+
+        const uint8_t* read(uint32_t offset, uint32_t& size) override
+        {
+            size = clip(offset, size);
+            return (size > 0) ? &mMemory[offset] : nullptr;
+        }
+
+        bool write(uint32_t offset, const void* data, uint32_t& size) override
+        {
+            uint32_t requested = size;
+            size = clip(offset, size);
+            if (size > 0)
+            {
+                memcpy(&mMemory[offset], data, size);
+            }
+            return (size == requested);
+        }
+
+        uint64_t getLastActivityTime() override
+        {
+            return mLastActivityTime;
+        }
+
+    private:
+        //! @returns size limited to what is available past offset
+        uint32_t clip(uint32_t offset, uint32_t size) const
+        {
+            if (offset >= mMemory.size())
+            {
+                return 0;
+            }
+            uint32_t available = mMemory.size() - offset;
+            return (size < available) ? size : available;
+        }
+
+        std::vector<uint8_t> mMemory;
+        uint64_t mLastActivityTime;
+};
@@ -34,6 +34,8 @@
 #include "Mutex.hpp"
 #include "Clock.hpp"
 #include "NonVolatilePicoSystemMemory.hpp"
+#include "LogStructuredSystemMemory.hpp"
+#include "PicoFlash.hpp"
 
 #include "hal/System/LockGuard.hpp"
 #include "PassiveBuzzer.hpp"
@@ -82,10 +84,31 @@ void setPwmFn(uint8_t width, uint8_t down)
     }
 }
 
+PicoFlash flash;
+Mutex memMutex;
+Clock memClock;
+#define MEM_1_TO_1_OFFSET (PICO_FLASH_SIZE_BYTES - client::DreamcastStorage::MEMORY_SIZE_BYTES)
+#if CLIENT_VMU_LOG_STRUCTURED
+std::shared_ptr<LogStructuredSystemMemory> mem =
+    std::make_shared<LogStructuredSystemMemory>(
+        flash,
+        memMutex,
+        memClock,
+        MEM_1_TO_1_OFFSET - CLIENT_VMU_LOG_SIZE_BYTES,
+        CLIENT_VMU_LOG_SIZE_BYTES,
+        client::DreamcastStorage::MEMORY_SIZE_BYTES,
+        flash.read(MEM_1_TO_1_OFFSET),
+        client::DreamcastStorage::SYSTEM_AREA_SIZE_BYTES);
+#else
 std::shared_ptr<NonVolatilePicoSystemMemory> mem =
     std::make_shared<NonVolatilePicoSystemMemory>(
-        PICO_FLASH_SIZE_BYTES - client::DreamcastStorage::MEMORY_SIZE_BYTES,
-        client::DreamcastStorage::MEMORY_SIZE_BYTES);
+        flash,
+        memMutex,
+        memClock,
+        MEM_1_TO_1_OFFSET,
+        client::DreamcastStorage::MEMORY_SIZE_BYTES,
+        client::DreamcastStorage::SYSTEM_AREA_SIZE_BYTES);
+#endif
 
 // Second Core Process
 void core1()
@@ -34,7 +34,6 @@
 #include "MaplePassthroughCommandParser.hpp"
 #include "FlycastCommandParser.hpp"
 
-#include "CriticalSectionMutex.hpp"
 #include "Mutex.hpp"
 #include "Clock.hpp"
 #include "PicoIdentification.cpp"
@@ -70,8 +69,10 @@ void core1()
     int32_t mapleDirPins[MAX_DEVICES] = {
         P1_DIR_PIN, P2_DIR_PIN, P3_DIR_PIN, P4_DIR_PIN
     };
-    CriticalSectionMutex screenMutexes[numDevices];
     std::shared_ptr<ScreenData> screenData[numDevices];
+    std::shared_ptr<ControllerLatencyStats> latencyStats[numDevices];
+    std::shared_ptr<ControllerPollSettings> pollSettings[numDevices];
+    std::shared_ptr<BusStats> busStats[numDevices];
     std::vector<std::shared_ptr<PlayerData>> playerData;
     playerData.resize(numDevices);
     DreamcastControllerObserver** observers = get_usb_controller_observers();
@@ -83,12 +84,18 @@ void core1()
     Clock clock;
     for (uint32_t i = 0; i < numDevices; ++i)
     {
-        screenData[i] = std::make_shared<ScreenData>(screenMutexes[i], i);
+        screenData[i] = std::make_shared<ScreenData>(i);
+        latencyStats[i] = std::make_shared<ControllerLatencyStats>();
+        pollSettings[i] = std::make_shared<ControllerPollSettings>();
+        busStats[i] = std::make_shared<BusStats>();
         playerData[i] = std::make_shared<PlayerData>(i,
                                                      *(observers[i]),
                                                      *screenData[i],
                                                      clock,
-                                                     usb_msc_get_file_system());
+                                                     usb_msc_get_file_system(),
+                                                     latencyStats[i].get(),
+                                                     pollSettings[i].get(),
+                                                     busStats[i].get());
         buses[i] = create_maple_bus(maplePins[i], mapleDirPins[i], DIR_OUT_HIGH);
         schedulers[i] = std::make_shared<PrioritizedTxScheduler>(schedulerMutexes[i], MAPLE_HOST_ADDRESSES[i]);
         dreamcastMainNodes[i] = std::make_shared<DreamcastMainNode>(
@@ -99,7 +106,7 @@ void core1()
 
     // Initialize CDC to Maple Bus interfaces
     Mutex ttyParserMutex;
-    TtyParser* ttyParser = usb_cdc_create_parser(&ttyParserMutex, 'h');
+    TtyParser* ttyParser = usb_cdc_create_parser(&ttyParserMutex, 'h', &clock);
     ttyParser->addCommandParser(
         std::make_shared<MaplePassthroughCommandParser>(
             &schedulers[0], MAPLE_HOST_ADDRESSES, numDevices));